@@ -0,0 +1,70 @@
+#include "KeywordDetector.h"
+
+KeywordDetector::KeywordDetector() {
+    reset();
+}
+
+void KeywordDetector::configure( const Config& config ) {
+    config_ = config;
+
+    //clamp the window so it fits the history buffer
+    if( config_.averageSlices < 1 ) {
+        config_.averageSlices = 1;
+    }
+    else if( config_.averageSlices > MAX_AVERAGE_SLICES ) {
+        config_.averageSlices = MAX_AVERAGE_SLICES;
+    }
+
+    //release above trigger would never re-arm, so collapse it onto the trigger
+    if( config_.releaseThreshold > config_.triggerThreshold ) {
+        config_.releaseThreshold = config_.triggerThreshold;
+    }
+
+    reset();
+}
+
+void KeywordDetector::reset( void ) {
+    for( size_t ix = 0; ix < MAX_AVERAGE_SLICES; ix++ ) {
+        history_[ix] = 0;
+    }
+    historyIx_ = 0;
+    historyCount_ = 0;
+    historySum_ = 0;
+    smoothed_ = 0;
+    armed_ = true;
+}
+
+bool KeywordDetector::update( const float score, const uint32_t nowMs ) {
+    //running sum over a circular history - one add and one subtract per slice
+    historySum_ -= history_[historyIx_];
+    history_[historyIx_] = score;
+    historySum_ += score;
+    historyIx_ = (historyIx_ + 1) % config_.averageSlices;
+    if( historyCount_ < config_.averageSlices ) {
+        historyCount_++;
+    }
+
+    smoothed_ = historySum_ / historyCount_;
+
+    //hysteresis - only re-arm once the score has properly dropped away
+    if( !armed_ ) {
+        if( smoothed_ < config_.releaseThreshold ) {
+            armed_ = true;
+        }
+        return false;
+    }
+
+    if( smoothed_ <= config_.triggerThreshold ) {
+        return false;
+    }
+
+    //refractory period - swallow the edge but stay disarmed until the score drops
+    armed_ = false;
+    if( hasDetected_ && ((nowMs - lastDetectionMs_) < config_.refractoryMs) ) {
+        return false;
+    }
+
+    hasDetected_ = true;
+    lastDetectionMs_ = nowMs;
+    return true;
+}
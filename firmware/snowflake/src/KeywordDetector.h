@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+//Streaming detector that sits between the classifier and the keyword callback.
+//It is fed one score per slice and:
+// - smooths the posterior with a moving average over the last N slices
+// - only fires on a rising edge through the trigger threshold
+// - re-arms once the smoothed score falls below the release threshold (hysteresis)
+// - ignores any further triggers during the refractory period after a detection
+class KeywordDetector {
+public:
+    static constexpr size_t MAX_AVERAGE_SLICES = 8;
+
+    struct Config {
+        size_t averageSlices = 2;         //moving average length in slices, 1 disables smoothing
+        float triggerThreshold = 0.72f;   //smoothed score that must be exceeded to fire
+        float releaseThreshold = 0.4f;    //smoothed score that must be dropped below to re-arm
+        uint32_t refractoryMs = 1500;     //minimum time between two detections
+    };
+
+    KeywordDetector();
+
+    void configure( const Config& config );
+    const Config& config( void ) const { return config_; }
+
+    //forget all history, e.g. after the audio stream was interrupted
+    void reset( void );
+
+    //feed the score for the latest slice, returns true when a detection fires
+    bool update( const float score, const uint32_t nowMs );
+
+    float smoothedScore( void ) const { return smoothed_; }
+
+private:
+    Config config_;
+
+    float history_[MAX_AVERAGE_SLICES];
+    size_t historyIx_ = 0;
+    size_t historyCount_ = 0;
+    float historySum_ = 0;
+
+    float smoothed_ = 0;
+    bool armed_ = true;
+    bool hasDetected_ = false;
+    uint32_t lastDetectionMs_ = 0;
+};
@@ -1,6 +1,7 @@
 #include "AudioPlayer.h"
 #include "MP3Player.h"
 #include "minimp3/minimp3.h"
+#include "Trace.h"
 
 MP3Player::MP3Player( AudioPlayer* audioPlayer )
   : audioPlayer_(audioPlayer)
@@ -8,6 +9,7 @@ MP3Player::MP3Player( AudioPlayer* audioPlayer )
     os_queue_create(&queue_, sizeof(String*), 1, NULL);
 
     thread_ = new Thread("mp3Player", [this]()->os_thread_return_t{
+        TRACE_THREAD("mp3Player");
 
         while (1) {
             MP3PlayerQueueItem *item = NULL;
@@ -38,6 +40,7 @@ MP3Player::MP3Player( AudioPlayer* audioPlayer )
 void MP3Player::internalPlaySong( const String filename )
 {
     Log.info("MP3Player::internalPlaySong(%s)", filename.c_str());
+    TRACE_SCOPE("playSong");
 
     if( 0 == audioPlayer_->aquireLock() )
     {
@@ -65,7 +68,10 @@ void MP3Player::internalPlaySong( const String filename )
 
             do
             {
-                samples = mp3dec_decode_frame(&mp3d, mp3Data + mp3len, mp3Size - mp3len, pcm, &info);
+                {
+                    TRACE_SCOPE("decodeFrame");
+                    samples = mp3dec_decode_frame(&mp3d, mp3Data + mp3len, mp3Size - mp3len, pcm, &info);
+                }
                 if (samples > 0)
                 {
                     //log we are playing
@@ -83,6 +89,8 @@ void MP3Player::internalPlaySong( const String filename )
                     memcpy(&pcmFrames[pcmFramesLength], pcm, samples*2);
                     pcmFramesLength += samples;
                     if (pcmFramesLength > 576 * 3) { // 3 frames
+                        //blocks until the DMA has room for the frames
+                        TRACE_SCOPE("playBuffer");
                         audioPlayer_->playBuffer((const uint16_t *)pcmFrames, pcmFramesLength*2);
                         pcmFramesLength = 0;
                     }
@@ -116,6 +124,7 @@ bool MP3Player::readMP3File( const String filename, uint8_t** mp3Data, uint32_t*
     bool ok = false;
 
     Log.info("MP3Player::readMP3File(%s)", filename.c_str());
+    TRACE_SCOPE("readMP3File");
 
     // find the file in the assets
     auto assets = System.assetsAvailable();
@@ -1,5 +1,6 @@
 #include "RgbStrip.h"
 #include "LEDEffect.h"
+#include "Trace.h"
 
 #define PIXEL_PIN SPI
 #define PIXEL_COUNT 36
@@ -47,6 +48,7 @@ RgbStrip::RgbStrip()
     strip_ = new Adafruit_NeoPixel(PIXEL_COUNT, PIXEL_PIN, PIXEL_TYPE);
 
     thread_ = new Thread("rgbThread", [this]()->os_thread_return_t{
+        TRACE_THREAD("rgbThread");
 
         //Composed effects.
         // These are layered on top of each other in the order they are defined.
@@ -149,6 +151,8 @@ RgbStrip::RgbStrip()
 
             uint32_t timeNow = millis();
 
+            TRACE_BEGIN("frame");
+
             //process whichever mode is activated
             switch( mode_ )
             {
@@ -225,7 +229,12 @@ RgbStrip::RgbStrip()
                 strip_->setPixelColor(i, leds[i]);
             }
 
-            strip_->show();
+            {
+                TRACE_SCOPE("show");
+                strip_->show();
+            }
+
+            TRACE_END("frame");
 
             frameCount++;
 
@@ -244,6 +253,11 @@ RgbStrip::RgbStrip()
             {
                 delay( delayTime );
             }
+            else
+            {
+                //the frame took longer than the frame rate allows
+                TRACE_INSTANT("frameLate");
+            }
         }
     }, OS_THREAD_PRIORITY_NETWORK, OS_THREAD_STACK_SIZE_DEFAULT_NETWORK);
 }
@@ -0,0 +1,216 @@
+#include "Trace.h"
+
+#if TRACE_ENABLED
+
+#include "Particle.h"
+#include <atomic>
+
+static_assert((TRACE_BUFFER_EVENTS & (TRACE_BUFFER_EVENTS - 1)) == 0, "TRACE_BUFFER_EVENTS must be a power of 2");
+
+namespace {
+
+//a buffer that goes this long without an event drops the ones before, this is under the ~10.7 s a signed
+//difference of the cycle counter covers, so the time between two events that are kept is never ambiguous
+constexpr uint32_t MAX_GAP_MS = 10000;
+
+struct TraceEvent {
+    uint32_t cycles;
+    const char* name;
+    char phase;     //'B'egin, 'E'nd or 'i'nstant
+};
+
+struct TraceBuffer {
+    std::atomic<os_thread_t> owner;     //nullptr while free, not used for the interrupt buffer
+    const char* name;
+    std::atomic<uint32_t> head;         //number of events written
+    uint32_t first;                     //oldest event that's still valid
+    uint32_t lastMs;                    //millis() of the latest event
+    TraceEvent events[TRACE_BUFFER_EVENTS];
+};
+
+//[0] is shared by the interrupts, the rest are claimed by threads
+TraceBuffer buffers[1 + Tracer::MAX_THREADS];
+std::atomic<bool> recording(false);
+
+//DWT cycle counter
+volatile uint32_t* const DEMCR = (volatile uint32_t*)0xE000EDFC;
+volatile uint32_t* const DWT_CTRL = (volatile uint32_t*)0xE0001000;
+volatile uint32_t* const DWT_CYCCNT = (volatile uint32_t*)0xE0001004;
+
+inline uint32_t cycles( void ) {
+    return *DWT_CYCCNT;
+}
+
+//cycles from `from` to `to`, 0 if `to` is earlier: an interrupt that preempts record() between claiming
+//its slot and reading the counter can leave a slot stamped a little before the one ahead of it
+inline uint32_t cyclesBetween( const uint32_t from, const uint32_t to ) {
+    const int32_t delta = (int32_t)(to - from);
+    return delta > 0 ? (uint32_t)delta : 0;
+}
+
+//the buffer of the calling thread, claims a free one on the first call
+TraceBuffer* threadBuffer( const char* name ) {
+    const os_thread_t self = os_thread_current(nullptr);
+
+    for (size_t ix = 1; ix <= Tracer::MAX_THREADS; ix++) {
+        TraceBuffer& buffer = buffers[ix];
+        os_thread_t owner = buffer.owner.load(std::memory_order_acquire);
+        if (owner == nullptr && buffer.owner.compare_exchange_strong(owner, self)) {
+            buffer.name = name;
+            return &buffer;
+        }
+        if (owner == self) {
+            return &buffer;
+        }
+    }
+
+    return nullptr;
+}
+
+void record( const char* name, const char phase ) {
+    if (!recording.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    TraceBuffer* buffer = HAL_IsISR() ? &buffers[0] : threadBuffer(nullptr);
+    if (buffer == nullptr) {
+        return;
+    }
+
+    //a slot per event, so interrupts that preempt each other don't need a lock either
+    const uint32_t nowMs = millis();
+    const uint32_t ix = buffer->head.fetch_add(1, std::memory_order_relaxed);
+    //stamped right after the slot is claimed, so slots are in time order but for an interrupt landing on
+    //exactly these two lines (dump() takes the next slot's earlier stamp as no gap, see cyclesBetween)
+    const uint32_t now = cycles();
+    if (nowMs - buffer->lastMs > MAX_GAP_MS) {
+        buffer->first = ix;
+    }
+    buffer->lastMs = nowMs;
+
+    TraceEvent& event = buffer->events[ix & (TRACE_BUFFER_EVENTS - 1)];
+    event.cycles = now;
+    event.name = name;
+    event.phase = phase;
+}
+
+//trace_event timestamps are in microseconds, printed with ns decimals. Without 64 bit printf
+void printTimestamp( Print& out, const uint64_t ns ) {
+    const uint64_t us = ns / 1000;
+    const uint32_t seconds = (uint32_t)(us / 1000000);
+    if (seconds > 0) {
+        out.printf("%lu%06lu.%03u", (unsigned long)seconds, (unsigned long)(us % 1000000), (unsigned)(ns % 1000));
+    } else {
+        out.printf("%lu.%03u", (unsigned long)us, (unsigned)(ns % 1000));
+    }
+}
+
+} // namespace
+
+void Tracer::start( void ) {
+    *DEMCR |= (1UL << 24);  //TRCENA
+    *DWT_CTRL |= 1;         //CYCCNTENA
+    recording = true;
+}
+
+void Tracer::stop( void ) {
+    recording = false;
+}
+
+void Tracer::nameThread( const char* name ) {
+    TraceBuffer* buffer = threadBuffer(name);
+    if (buffer != nullptr) {
+        buffer->name = name;
+    }
+}
+
+void Tracer::begin( const char* name ) {
+    record(name, 'B');
+}
+
+void Tracer::end( const char* name ) {
+    record(name, 'E');
+}
+
+void Tracer::instant( const char* name ) {
+    record(name, 'i');
+}
+
+void Tracer::dump( Print& out ) {
+    const bool wasRecording = recording.exchange(false);
+    //let an event that was being written when recording stopped finish
+    delay(2);
+
+    const uint32_t nowCycles = cycles();
+    const uint64_t nowMs = System.millis();
+    const uint64_t nowNs = nowMs * 1000000;
+
+    out.print("{\"traceEvents\":[\r\n");
+    out.print("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"snowflake\"}}");
+
+    for (size_t bx = 0; bx <= MAX_THREADS; bx++) {
+        TraceBuffer& buffer = buffers[bx];
+        const uint32_t head = buffer.head.load(std::memory_order_acquire);
+        uint32_t first = buffer.first;
+        if (head - first > TRACE_BUFFER_EVENTS) {
+            first = head - TRACE_BUFFER_EVENTS;
+        }
+        if (head == first || (uint32_t)nowMs - buffer.lastMs > MAX_GAP_MS) {
+            continue;
+        }
+
+        const unsigned tid = bx + 1;
+        out.printf(",\r\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", tid);
+        if (bx == 0) {
+            out.print("irq");
+        } else if (buffer.name != nullptr) {
+            out.print(buffer.name);
+        } else {
+            out.printf("thread %u", tid);
+        }
+        out.print("\"}}");
+
+        //the counter wraps, so ages are added up from the gaps between events: the oldest event's age walking
+        //back from the newest, then printing oldest first, each event is a gap younger than the one before
+        uint64_t ageCycles = 0;
+        uint32_t newer = nowCycles;
+        for (uint32_t ix = head; ix != first; ix--) {
+            const uint32_t eventCycles = buffer.events[(ix - 1) & (TRACE_BUFFER_EVENTS - 1)].cycles;
+            ageCycles += cyclesBetween(eventCycles, newer);
+            newer = eventCycles;
+        }
+
+        for (uint32_t ix = first; ix != head; ix++) {
+            const TraceEvent& event = buffer.events[ix & (TRACE_BUFFER_EVENTS - 1)];
+            const uint64_t ageNs = ageCycles * 1000 / TRACE_CYCLES_PER_US;
+            out.printf(",\r\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":", event.name, event.phase, tid);
+            printTimestamp(out, ageNs < nowNs ? nowNs - ageNs : 0);
+            out.print(event.phase == 'i' ? ",\"s\":\"t\"}" : "}");
+
+            const uint32_t next = ix + 1 != head ? buffer.events[(ix + 1) & (TRACE_BUFFER_EVENTS - 1)].cycles : nowCycles;
+            ageCycles -= cyclesBetween(event.cycles, next);
+        }
+
+        buffer.first = head;
+    }
+
+    out.print("\r\n],\"displayTimeUnit\":\"ms\"}\r\n");
+
+    recording = wasRecording;
+}
+
+#endif // TRACE_ENABLED
+
+#if EI_CLASSIFIER_TRACE
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+//stages of run_classifier_continuous, see ei_classifier_porting.h. They go nowhere without TRACE_ENABLED,
+//but the classifier still calls them
+void ei_trace_begin(const char *name) {
+    TRACE_BEGIN(name);
+}
+
+void ei_trace_end(const char *name) {
+    TRACE_END(name);
+}
+#endif
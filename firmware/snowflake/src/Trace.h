@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+//Timeline tracing across threads and interrupts, to see what runs at the same time when e.g. the LEDs
+//frame late or the MP3 underruns while the keyword model runs. Build with TRACE_ENABLED=1 (see
+//build.mk), the macros below compile to nothing otherwise.
+// - every thread writes begin / end / instant events into a ring buffer of its own, the interrupts
+//   share one more. Writing an event takes no lock and doesn't block, the oldest events get
+//   overwritten
+// - events are stamped with the 32 bit DWT cycle counter (wraps every ~21 s at 200 MHz)
+// - Tracer::dump() prints the buffers in Chrome trace_event JSON, see tools/trace_to_json.py to pull
+//   it out of a serial log and open it in chrome://tracing or ui.perfetto.dev
+// - names must be string literals (only the pointer is stored)
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+
+//events per buffer, a power of 2. 12 bytes each
+#ifndef TRACE_BUFFER_EVENTS
+#define TRACE_BUFFER_EVENTS 256
+#endif
+
+//core clock, to turn the cycle counter into microseconds
+#ifndef TRACE_CYCLES_PER_US
+#define TRACE_CYCLES_PER_US 200
+#endif
+
+class Print;
+
+class Tracer {
+public:
+    //buffers for threads, plus one for the interrupts. Threads past this are not traced
+    static constexpr size_t MAX_THREADS = 7;
+
+    //enable the cycle counter and start recording, events before this are dropped
+    static void start( void );
+    static void stop( void );
+
+    //give the calling thread a buffer with a name for the trace, call at the top of the thread
+    //function. Threads that don't get one on their first event, named by their number
+    static void nameThread( const char* name );
+
+    static void begin( const char* name );
+    static void end( const char* name );
+    static void instant( const char* name );
+
+    //print the buffers, oldest event first per buffer, and clear them. Recording is paused while printing, don't
+    //call from an interrupt
+    static void dump( Print& out );
+};
+
+class TraceScope {
+public:
+    explicit TraceScope( const char* name ) : name_(name) {
+        Tracer::begin(name_);
+    }
+    ~TraceScope() {
+        Tracer::end(name_);
+    }
+
+private:
+    const char* name_;
+};
+
+#if TRACE_ENABLED
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_THREAD(name) Tracer::nameThread(name)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_BEGIN(name) Tracer::begin(name)
+#define TRACE_END(name) Tracer::end(name)
+#define TRACE_INSTANT(name) Tracer::instant(name)
+#else
+#define TRACE_THREAD(name)
+#define TRACE_SCOPE(name)
+#define TRACE_BEGIN(name)
+#define TRACE_END(name)
+#define TRACE_INSTANT(name)
+#endif
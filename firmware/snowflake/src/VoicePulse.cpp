@@ -1,5 +1,6 @@
 #include "VoicePulse.h"
 #include "Sparkle_inferencing.h"
+#include "Trace.h"
 
 #define VP_DBG 0
 #if VP_DBG
@@ -12,25 +13,77 @@
 
 static constexpr size_t sampleBufferSize = (EI_CLASSIFIER_SLICE_SIZE * 2);
 
+#if EI_CLASSIFIER_PROFILE_OPS
+//per-op timing of the keyword model, printed with the predictions (see build.mk)
+static EiOpProfiler opProfiler;
+#endif
+
+//one classifier context per keyword model, the DSP state and features live in the first one
+struct VoicePulse::Classifiers {
+    ei_classifier_context_t contexts[MAX_KEYWORDS] = { };
+    const ei_impulse_t* impulses[MAX_KEYWORDS] = { };
+    ei_impulse_result_t results[MAX_KEYWORDS] = { };
+};
+
 VoicePulse::VoicePulse(AudioPlayer* audioPlayer, VoicePulseDetectedCb callback, float threshold) :
-                        audioPlayer_(audioPlayer),
-                        callback_(callback),
-                        threshold_(threshold) {
+                        audioPlayer_(audioPlayer) {
+    KeywordDetector::Config config;
+    config.triggerThreshold = threshold;
+
+    //the compiled in model, classification 0: "sparkle", 1: "unknown"
+    addKeyword(&ei_default_impulse, ei_classifier_inferencing_categories[0],
+               [callback](const char*, float) {
+                    callback();
+               }, config);
+
     // Allocate buffer for audio samples
     sampleBuffer_ = (int16_t*)malloc(sampleBufferSize * sizeof(int16_t));
     SPARK_ASSERT(sampleBuffer_ != nullptr);
 
 }
 
+bool VoicePulse::addKeyword(const ei_impulse* impulse, const char* keyword, KeywordDetectedCb callback,
+                            const KeywordDetector::Config& config) {
+    if (thread_ != nullptr || keywordCount_ >= MAX_KEYWORDS) {
+        return false;
+    }
+
+    //find the output of the model that is the keyword
+    for (size_t ix = 0; ix < (size_t)impulse->label_count; ix++) {
+        if (strcmp(impulse->categories[ix], keyword) == 0) {
+            Keyword& kw = keywords_[keywordCount_++];
+            kw.impulse = impulse;
+            kw.label = impulse->categories[ix];
+            kw.labelIx = ix;
+            kw.detector.configure(config);
+            kw.callback = callback;
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void VoicePulse::start() {
     // Initialize the audio player
     audioPlayer_->setOutput(HAL_AUDIO_MODE_MONO, HAL_AUDIO_SAMPLE_RATE_16K, HAL_AUDIO_WORD_LEN_16);
 
-    // Initialize the classifier
+    // Initialize the classifier, and a context per keyword model
     run_classifier_init();
 
+    classifiers_ = new Classifiers();
+    SPARK_ASSERT(classifiers_ != nullptr);
+    for (size_t ix = 0; ix < keywordCount_; ix++) {
+        classifiers_->impulses[ix] = keywords_[ix].impulse;
+        run_classifier_init(&classifiers_->contexts[ix], keywords_[ix].impulse);
+    }
+#if EI_CLASSIFIER_PROFILE_OPS
+    ei_classifier_set_op_profiler(&opProfiler);
+#endif
+
     // Create voice thread
     thread_ = new Thread("VoicePulse", [this]()->os_thread_return_t{
+        TRACE_THREAD("VoicePulse");
 
         // Summary of inferencing settings (from model_metadata.h)
         VP_DBG_PRINTF("Inferencing settings:");
@@ -44,21 +97,26 @@ void VoicePulse::start() {
             //LOG(INFO, "voicePulse thread running...");
 
             // Get a slice of audio data
-            audioPlayer_->recordBuffer(sampleBuffer_, sampleBufferSize);
+            {
+                TRACE_SCOPE("recordBuffer");
+                audioPlayer_->recordBuffer(sampleBuffer_, sampleBufferSize);
+            }
+
+            //the rest of the loop, the classifier stages show up inside (EI_CLASSIFIER_TRACE)
+            TRACE_SCOPE("slice");
 
             VP_DBG_PRINTF("recordBuffer done");
 
-            // Run classifier
+            // Run classifier, the MFCC converts and preemphasizes straight from the PCM samples
             signal_t signal;
-            signal.total_length = EI_CLASSIFIER_SLICE_SIZE;
-            signal.get_data = [this](size_t offset, size_t length, float *out_ptr) -> int {
-                return this->microphone_audio_signal_get_data(offset, length, out_ptr);
-            };
+            numpy::signal_from_int16_buffer(sampleBuffer_, EI_CLASSIFIER_SLICE_SIZE, &signal);
 
             VP_DBG_PRINTF("signal.get_data done");
 
-            ei_impulse_result_t result = {0};
-            EI_IMPULSE_ERROR r = run_classifier_continuous(&signal, &result, false);
+            //the MFCC runs once, then every keyword model classifies the same features
+            ei_impulse_result_t* results = classifiers_->results;
+            EI_IMPULSE_ERROR r = run_classifier_continuous_multi(classifiers_->contexts, classifiers_->impulses,
+                                                                 keywordCount_, &signal, results, false);
             if (r != EI_IMPULSE_OK) {
                 VP_DBG_PRINTF("ERR: Failed to run classifier (%d)\r\n", r);
                 continue; 
@@ -66,23 +124,37 @@ void VoicePulse::start() {
 
             VP_DBG_PRINTF("run_classifier_continuous done");
 
+            // Run the detectors on every slice so a short peak is not missed and
+            // the latency is a single slice rather than a whole window
+            const uint32_t now = millis();
+            for (size_t ix = 0; ix < keywordCount_; ix++) {
+                Keyword& kw = keywords_[ix];
+                if (kw.detector.update(results[ix].classification[kw.labelIx].value, now)) {
+                    VP_DBG_PRINTF("Keyword %s detected, smoothed score %.3f", kw.label, kw.detector.smoothedScore());
+                    TRACE_INSTANT("keyword");
+                    kw.callback(kw.label, kw.detector.smoothedScore());
+                }
+            }
+
             if (++sliceCounter_ >= (EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW)) {
                 // print the predictions
-                LOG(ERROR,"TFLite: DSP: %d ms., Classification: %d ms., Anomaly: %d ms.",
-                    result.timing.dsp, result.timing.classification, result.timing.anomaly);
-                for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
-                    LOG(ERROR,"    Classification: %s: %.5f", result.classification[ix].label,
-                            result.classification[ix].value);
-                }
+                for (size_t ix = 0; ix < keywordCount_; ix++) {
+                    const ei_impulse_result_t& result = results[ix];
+                    LOG(ERROR,"TFLite (%s): DSP: %d ms., Classification: %d ms., Anomaly: %d ms.", keywords_[ix].label,
+                        result.timing.dsp, result.timing.classification, result.timing.anomaly);
+                    for (size_t lx = 0; lx < (size_t)keywords_[ix].impulse->label_count; lx++) {
+                        LOG(ERROR,"    Classification: %s: %.5f", result.classification[lx].label,
+                                result.classification[lx].value);
+                    }
 
-                // Indicate the recognition result
-                // classification,  0: "sparkle", 1: "unknown"
-                if (result.classification[0].value > threshold_) {
-                    callback_();
+        #if EI_CLASSIFIER_HAS_ANOMALY == 1
+                    VP_DBG_PRINTF("    anomaly score: %.3f\r\n", result.anomaly);
+        #endif
                 }
 
-        #if EI_CLASSIFIER_HAS_ANOMALY == 1
-                VP_DBG_PRINTF("    anomaly score: %.3f\r\n", result.anomaly);
+        #if EI_CLASSIFIER_PROFILE_OPS
+                opProfiler.Log();
+                opProfiler.Reset();
         #endif
 
                 sliceCounter_ = 0;
@@ -92,8 +164,3 @@ void VoicePulse::start() {
     }, OS_THREAD_PRIORITY_NETWORK, OS_THREAD_STACK_SIZE_DEFAULT);
     SPARK_ASSERT(thread_ != nullptr);
 }
-
-int VoicePulse::microphone_audio_signal_get_data(size_t offset, size_t length, float* out_ptr) {
-    numpy::int16_to_float(&sampleBuffer_[offset], out_ptr, length);
-    return 0;
-}
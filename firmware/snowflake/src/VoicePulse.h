@@ -2,24 +2,62 @@
 
 #include "Particle.h"
 #include "AudioPlayer.h"
+#include "KeywordDetector.h"
 #include <functional>
 
+struct ei_impulse;
+
 class VoicePulse {
     using VoicePulseDetectedCb = std::function<void()>;
+    //called with the label of the keyword and its smoothed score
+    using KeywordDetectedCb = std::function<void(const char* keyword, float score)>;
 
 public:
+    //models that can run next to each other on the shared MFCC front end
+    static constexpr size_t MAX_KEYWORDS = 4;
+
     VoicePulse(AudioPlayer* audioPlayer, VoicePulseDetectedCb callback, const float threshold = 0.5f);
 
     void start( void );
 
-private:
-    int microphone_audio_signal_get_data(size_t offset, size_t length, float* out_ptr);
+    //register another keyword model, call before start(). The impulse needs the same MFCC block
+    //as the default model, the DSP runs once per slice and every model classifies its output.
+    //keyword is the label of the model output to detect
+    bool addKeyword( const ei_impulse* impulse, const char* keyword, KeywordDetectedCb callback,
+                     const KeywordDetector::Config& config );
+
+    size_t keywordCount( void ) const {
+        return keywordCount_;
+    }
+    const char* keywordLabel( const size_t ix ) const {
+        return keywords_[ix].label;
+    }
+
+    //smoothing / hysteresis / refractory settings for the keyword detector, call before start()
+    void setDetectorConfig( const KeywordDetector::Config& config, const size_t ix = 0 ) {
+        keywords_[ix].detector.configure(config);
+    }
+    const KeywordDetector::Config& detectorConfig( const size_t ix = 0 ) const {
+        return keywords_[ix].detector.config();
+    }
 
 private:
+    struct Keyword {
+        const ei_impulse* impulse = nullptr;
+        const char* label = nullptr;
+        size_t labelIx = 0;
+        KeywordDetector detector;
+        KeywordDetectedCb callback = nullptr;
+    };
+
+    //classifier contexts and results, see VoicePulse.cpp
+    struct Classifiers;
+
     AudioPlayer* audioPlayer_ = nullptr;
     int16_t* sampleBuffer_ = nullptr;
-    VoicePulseDetectedCb callback_ = nullptr;
     int sliceCounter_ = 0;
-    float threshold_ = 0;
+    Keyword keywords_[MAX_KEYWORDS];
+    size_t keywordCount_ = 0;
+    Classifiers* classifiers_ = nullptr;
     Thread* thread_ = nullptr;
 };
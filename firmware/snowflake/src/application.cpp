@@ -8,6 +8,7 @@
 #include "MP3Player.h"
 #include "TonePlayer.h"
 #include "VoicePulse.h"
+#include "Trace.h"
 
 //#define DEBUG_STARTUP_DELAY
 #define SUPPORT_AUDIO_TONE
@@ -64,6 +65,13 @@ static bool sparkleMode = false;
 //voice pulse. threshold of .72 is somewhat arbitariily chosen from testing - it might be too high / low
 VoicePulse voicePulse = VoicePulse(&audioPlayer, sparkleDetectedCallback, 0.72f);
 
+//keyword detector tuning, read from settings at boot
+// kwsThreshold  - smoothed score needed to trigger (0..1)
+// kwsRelease    - smoothed score the output must fall below before it can trigger again (0..1)
+// kwsAverage    - number of slices (250ms each) in the moving average
+// kwsRefractory - minimum ms between two detections
+static void loadDetectorSettings( void );
+
 //list of songs to play and index of the current song
 std::vector<String> songs;
 uint32_t songIndex = 0;
@@ -87,6 +95,11 @@ void setup()
        delay(10000);
     #endif
 
+  #if TRACE_ENABLED
+      //record the timeline of the threads from here on, double click the button to print it
+      Tracer::start();
+  #endif
+
     rgbStrip = new RgbStrip();
 
     //load our settings file
@@ -150,6 +163,9 @@ void setup()
   #endif
 
   #ifdef SUPPORT_VOICE_DETECTION
+      //apply any detector tuning from the settings file
+      loadDetectorSettings();
+
       //start the voice pulse
       voicePulse.start();
   #endif
@@ -229,6 +245,11 @@ void loop()
 
             case 2:
                 Log.info("DOUBLE click");
+
+                #if TRACE_ENABLED
+                    //print the timeline over serial, see tools/trace_to_json.py
+                    Tracer::dump(Serial);
+                #endif
             break;
 
             case 3:
@@ -274,6 +295,35 @@ static void sparkleDetectedCallback( void ) {
     sparkleMode = sparkleEnable;
 }
 
+static void loadDetectorSettings( void ) {
+    KeywordDetector::Config config = voicePulse.detectorConfig();
+
+    String value = settings.get("kwsThreshold");
+    if (value.length() > 0) {
+        config.triggerThreshold = value.toFloat();
+    }
+
+    value = settings.get("kwsRelease");
+    if (value.length() > 0) {
+        config.releaseThreshold = value.toFloat();
+    }
+
+    value = settings.get("kwsAverage");
+    if (value.length() > 0) {
+        config.averageSlices = (size_t)value.toInt();
+    }
+
+    value = settings.get("kwsRefractory");
+    if (value.length() > 0) {
+        config.refractoryMs = (uint32_t)value.toInt();
+    }
+
+    voicePulse.setDetectorConfig(config);
+
+    Log.info("Keyword detector: threshold %.2f, release %.2f, average %u slices, refractory %lu ms",
+        config.triggerThreshold, config.releaseThreshold, (unsigned)config.averageSlices, (unsigned long)config.refractoryMs);
+}
+
 //Cloud Functions
 //Contributed by Github user: niabassey
 static int cloudMode(String command)
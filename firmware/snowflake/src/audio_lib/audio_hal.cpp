@@ -28,6 +28,7 @@ extern "C" {
 }
 
 #include "check.h"
+#include "Trace.h"
 
 #define SP_DMA_PAGE_SIZE        512ul   // 2 ~ 4096
 #define SP_DMA_PAGE_NUM         64      // 64x512 Byte = 32KB, around 1s for 16KHz sample rate and int16 word length
@@ -387,9 +388,18 @@ private:
         /* Clear Pending ISR */
         GDMA_ClearINT(GDMA_InitStruct->GDMA_Index, GDMA_InitStruct->GDMA_ChNum);
 
+#if TRACE_ENABLED
+        const u32 wasEmpty = sp_tx_info.tx_empty_flag;
+#endif
         sp_release_tx_page();
         tx_addr = (u32)sp_get_ready_tx_page();
         tx_length = sp_get_ready_tx_length();
+#if TRACE_ENABLED
+        // ran out of pages to play, zeros go out until the writer catches up (or at the end of a song)
+        if (!wasEmpty && sp_tx_info.tx_empty_flag) {
+            TRACE_INSTANT("spTxEmpty");
+        }
+#endif
         // GDMA_SetSrcAddr(GDMA_InitStruct->GDMA_Index, GDMA_InitStruct->GDMA_ChNum, tx_addr);
         // GDMA_SetBlkSize(GDMA_InitStruct->GDMA_Index, GDMA_InitStruct->GDMA_ChNum, tx_length>>2);
 
@@ -407,9 +417,18 @@ private:
         /* Clear Pending ISR */
         GDMA_ClearINT(GDMA_InitStruct->GDMA_Index, GDMA_InitStruct->GDMA_ChNum);
 
+#if TRACE_ENABLED
+        const u32 wasFull = sp_rx_info.rx_full_flag;
+#endif
         sp_release_rx_page();
         rx_addr = (u32)sp_get_free_rx_page();
         rx_length = sp_get_free_rx_length();
+#if TRACE_ENABLED
+        // no free page, samples are dropped until the reader catches up
+        if (!wasFull && sp_rx_info.rx_full_flag) {
+            TRACE_INSTANT("spRxFull");
+        }
+#endif
         // GDMA_SetDstAddr(GDMA_InitStruct->GDMA_Index, GDMA_InitStruct->GDMA_ChNum, rx_addr);
         // GDMA_SetBlkSize(GDMA_InitStruct->GDMA_Index, GDMA_InitStruct->GDMA_ChNum, rx_length>>2);
 
@@ -418,11 +437,13 @@ private:
     }
 
     static void sp_tx_complete(void* data) {
+        TRACE_SCOPE("spTxDma");
         AudioSerialPort* asp = (AudioSerialPort*)data;
         asp->sp_tx_complete_impl();
     }
 
     static void sp_rx_complete(void* data) {
+        TRACE_SCOPE("spRxDma");
         AudioSerialPort* asp = (AudioSerialPort*)data;
         asp->sp_rx_complete_impl();
     }
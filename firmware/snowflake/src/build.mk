@@ -7,6 +7,22 @@ CFLAGS+= -D__STATIC_FORCEINLINE="__attribute__((always_inline)) static inline"
 CFLAGS+= -DEI_PORTING_PARTICLE=1
 CFLAGS+= -DEIDSP_LOAD_CMSIS_DSP_SOURCES=1
 
+# run the DSP out of a fixed arena instead of the heap (the MFCC window peaks at ~30 KB)
+CFLAGS+= -DEIDSP_ARENA_SIZE=32768
+# ...as a static buffer, that the tensor arena of the keyword model shares
+CFLAGS+= -DEI_CLASSIFIER_MEMORY_PLAN=1
+
+# per-op profiling of the keyword model (cycle counts from the DWT, P2 runs at 200 MHz)
+#CFLAGS+= -DEI_CLASSIFIER_PROFILE_OPS=1 -DTF_LITE_USE_DWT_CYCCNT=1 -DTF_LITE_DWT_CLOCK_HZ=200000000
+
+# timeline trace of the threads, DMA interrupts and classifier stages (see Trace.h), double click the
+# button to print it over serial
+#CFLAGS+= -DTRACE_ENABLED=1 -DEI_CLASSIFIER_TRACE=1
+
+# the hand-written variants of the compiled keyword model (see ei_classifier_config.h): no RESHAPE
+# nodes, each conv + max pool pair as one node, weight tables reworked for the CMSIS-NN kernels
+#CFLAGS+= -DEI_CLASSIFIER_TFLITE_ELIDE_RESHAPES=1 -DEI_CLASSIFIER_TFLITE_FUSED_OPS=1 -DEI_CLASSIFIER_TFLITE_PACKED_WEIGHTS=1
+
 # add C and CPP files - if USRSRC is not empty, then add a slash
 CPPSRC += $(call target_files,$(USRSRC_SLASH),*.cpp)
 CSRC += $(call target_files,$(USRSRC_SLASH),*.c)
\ No newline at end of file
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_nn_dsp_emulation.h
+ * Description:  C versions of the DSP extension SIMD instructions the kernels use, so host builds
+ *               can run their ARM_MATH_DSP paths, see EI_CLASSIFIER_TFLITE_EMULATE_ARM_DSP
+ *
+ * Target Processor:  x86-64
+ * -------------------------------------------------------------------- */
+
+#ifndef _ARM_NN_DSP_EMULATION_H_
+#define _ARM_NN_DSP_EMULATION_H_
+
+#include <stdint.h>
+
+#if defined(ARM_MATH_DSP)
+#error "arm_nn_dsp_emulation.h must be included before ARM_MATH_DSP is defined"
+#endif
+
+/* Most of them are the C versions CMSIS-DSP has for cores without the extension (and with
+   ARM_MATH_DSP undefined, as it is here). This adds the ones it only has for MSVC */
+#include "edge-impulse-sdk/CMSIS/DSP/Include/dsp/none.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(_MSC_VER) && !defined(__GNUC_PYTHON__)
+#define __PKHBT(ARG1, ARG2, ARG3) \
+    ((((uint32_t)(ARG1)) & 0x0000FFFFUL) | ((((uint32_t)(ARG2)) << (ARG3)) & 0xFFFF0000UL))
+#define __PKHTB(ARG1, ARG2, ARG3) \
+    ((((uint32_t)(ARG1)) & 0xFFFF0000UL) | (((uint32_t)(((int32_t)(ARG2)) >> (ARG3))) & 0x0000FFFFUL))
+
+static inline uint32_t __SADD16(uint32_t op1, uint32_t op2)
+{
+    const uint32_t lo = (uint32_t)((int16_t)op1 + (int16_t)op2) & 0xFFFF;
+    const uint32_t hi = (uint32_t)((int16_t)(op1 >> 16) + (int16_t)(op2 >> 16)) & 0xFFFF;
+    return lo | (hi << 16);
+}
+
+static inline uint32_t __SXTAB16_RORn(uint32_t op1, uint32_t op2, uint32_t rotate)
+{
+    return __SXTAB16(op1, __ROR(op2, rotate));
+}
+#endif
+
+#if !defined(_MSC_VER) && !defined(__GNUC_PYTHON__) && !defined(__APPLE_CC__)
+static inline uint32_t __SXTB16_RORn(uint32_t op1, uint32_t rotate)
+{
+    return __SXTB16(__ROR(op1, rotate));
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ARM_NN_DSP_EMULATION_H_
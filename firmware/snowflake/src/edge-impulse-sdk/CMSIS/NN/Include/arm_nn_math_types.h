@@ -103,6 +103,12 @@ typedef int64_t q63_t;
 #endif
 #endif
 
+/* host builds with the DSP extension emulated, see EI_CLASSIFIER_TFLITE_EMULATE_ARM_DSP */
+#if defined(ARM_NN_EMULATE_DSP) && !defined(ARM_MATH_DSP)
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nn_dsp_emulation.h"
+#define ARM_MATH_DSP 1
+#endif
+
 #if __ARM_FEATURE_MVE
 #ifndef ARM_MATH_MVEI
 #define ARM_MATH_MVEI
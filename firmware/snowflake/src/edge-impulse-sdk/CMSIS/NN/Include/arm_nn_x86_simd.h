@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_nn_x86_simd.h
+ * Description:  x86 (SSE4.1 / AVX2) inner loops for the s8 kernels on host builds,
+ *               see EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86
+ *
+ * Target Processor:  x86-64
+ * -------------------------------------------------------------------- */
+
+#ifndef _ARM_NN_X86_SIMD_H_
+#define _ARM_NN_X86_SIMD_H_
+
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nn_math_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Only the integer multiply-accumulate, max and clamp loops are vectorized. Accumulation is
+ * exact in 32 bits and requantization stays in the scalar CMSIS-NN code, so the kernels give
+ * the same output as on the device, whichever instruction set is picked.
+ */
+typedef enum
+{
+    ARM_NN_X86_ISA_SCALAR = 0,
+    ARM_NN_X86_ISA_SSE41 = 1,
+    ARM_NN_X86_ISA_AVX2 = 2
+} arm_nn_x86_isa;
+
+/**
+ * @brief           Instruction set used by the kernels. Detected on the first call.
+ */
+arm_nn_x86_isa arm_nn_x86_get_isa(void);
+
+/**
+ * @brief           Limit the instruction set used by the kernels, e.g. to compare against the
+ *                  scalar loops. Values above what the CPU supports are lowered.
+ */
+void arm_nn_x86_set_isa(arm_nn_x86_isa isa);
+
+/**
+ * @brief           sum(lhs[i] * rhs[i]), s8 x s16 (im2col columns of the convolution)
+ */
+int32_t arm_nn_x86_dot_s8_s16(const q7_t *lhs, const q15_t *rhs, int32_t length);
+
+/**
+ * @brief           The four dot products of two lhs rows with two rhs columns, added to
+ *                  sum[0] (lhs_0.rhs_0), sum[1] (lhs_0.rhs_1), sum[2] (lhs_1.rhs_0), sum[3] (lhs_1.rhs_1)
+ */
+void arm_nn_x86_dot_2x2_s8_s16(
+    const q7_t *lhs_0, const q7_t *lhs_1, const q15_t *rhs_0, const q15_t *rhs_1, int32_t length, q31_t *sum);
+
+/**
+ * @brief           sum((lhs[i] + lhs_offset) * rhs[i]), s8 x s8
+ * @note            lhs_offset is the negated s8 zero point, range [-127, 128], so
+ *                  (lhs[i] + lhs_offset) fits in 16 bits
+ */
+int32_t arm_nn_x86_dot_s8(const q7_t *lhs, const q7_t *rhs, int32_t lhs_offset, int32_t length);
+
+/**
+ * @brief           The same dot product over one row of a block sparse matrix, see
+ *                  arm_nn_vec_mat_mult_t_block_sparse_s8. Only the blocks set in block_bitmap are
+ *                  read from rhs, which is advanced past them.
+ * @note            block_size must be a multiple of 4
+ */
+int32_t arm_nn_x86_dot_block_sparse_s8(const q7_t *lhs,
+                                       const q7_t **rhs,
+                                       const uint8_t *block_bitmap,
+                                       int32_t block_size,
+                                       int32_t block_count,
+                                       int32_t lhs_offset);
+
+/**
+ * @brief           acc[i] += (lhs[i] + lhs_offset) * rhs[i], elementwise (depthwise channels)
+ */
+void arm_nn_x86_mac_s8(int32_t *acc, const q7_t *lhs, const q7_t *rhs, int32_t lhs_offset, int32_t length);
+
+/**
+ * @brief           dst[i] = max(dst[i], src[i])
+ */
+void arm_nn_x86_max_s8(q7_t *dst, const q7_t *src, int32_t length);
+
+/**
+ * @brief           data[i] = min(max(data[i], act_min), act_max)
+ */
+void arm_nn_x86_clamp_s8(q7_t *data, int32_t length, int32_t act_min, int32_t act_max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ARM_NN_X86_SIMD_H_
@@ -341,6 +341,150 @@ arm_cmsis_nn_status arm_convolve_s8(const cmsis_nn_context *ctx,
  */
 int32_t arm_convolve_s8_get_buffer_size(const cmsis_nn_dims *input_dims, const cmsis_nn_dims *filter_dims);
 
+// Patched by Edge Impulse, convolution on weights reordered offline (compiled models)
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+/**
+ * @brief s8 convolution function on reordered weights
+ * @param[in]      filter_data    Filter data pointer, reordered by arm_convolve_s8_reorder_filter(). Data type: int8
+ *
+ * @details  Same as arm_convolve_s8(), other arguments included. The weights are sign extended
+ *           with two instructions per four weights instead of four, for the im2col matrix
+ *           multiplication and the left-over column. Use arm_convolve_s8_get_buffer_size() for
+ *           the buffer. Only available with the DSP extension (and no MVE).
+ */
+arm_cmsis_nn_status arm_convolve_s8_reordered(const cmsis_nn_context *ctx,
+                                              const cmsis_nn_conv_params *conv_params,
+                                              const cmsis_nn_per_channel_quant_params *quant_params,
+                                              const cmsis_nn_dims *input_dims,
+                                              const q7_t *input_data,
+                                              const cmsis_nn_dims *filter_dims,
+                                              const q7_t *filter_data,
+                                              const cmsis_nn_dims *bias_dims,
+                                              const int32_t *bias_data,
+                                              const cmsis_nn_dims *output_dims,
+                                              q7_t *output_data);
+#endif
+
+/**
+ * @brief Reorder s8 convolution weights for arm_convolve_s8_reordered(), e.g. when generating a model
+ *
+ * @param[in]       filter_dims    Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN]
+ * @param[in]       src            Weights in the [C_OUT, HK, WK, C_IN] order
+ * @param[out]      dst            Reordered weights, same size as src
+ *
+ * @details  Each group of four weights from the start of an output channel, (w0, w1, w2, w3), is stored
+ *           as (w0, w2, w1, w3). The last (HK * WK * C_IN) % 4 weights of a channel keep their order.
+ */
+void arm_convolve_s8_reorder_filter(const cmsis_nn_dims *filter_dims, const q7_t *src, q7_t *dst);
+
+// Patched by Edge Impulse, convolution fused with the max pool that follows it (compiled models)
+#if !defined(ARM_MATH_MVEI)
+/**
+ * @brief s8 convolution function with a fused 1x2 max pool
+ * @param[in]      conv_output_dims  Convolution output dimensions (not stored). Format: [N, H, W, C_OUT]
+ * @param[in]      output_dims       Pooled output dimensions. Format: [N, H, W_POOLED, C_OUT], where W_POOLED is
+ *                                   (W + 1) / 2 (SAME padding) or W / 2 (VALID padding)
+ * @param[out]     output_data       Pooled output data pointer. Data type: int8
+ *
+ * @return     <code>ARM_CMSIS_NN_ARG_ERROR</code> if the dimensions don't match a 1x2 max pool with stride 2
+ *             over the convolution output, or if H > 1 and W is odd.
+ *             <code>ARM_CMSIS_NN_SUCCESS</code> on successful completion.
+ *
+ * @details  Same as arm_convolve_s8() followed by a max pool with a 1x2 filter and 1x2 stride, other arguments
+ *           included, without storing the convolution output: the matrix multiplication computes two
+ *           neighbouring output pixels at a time, which are one pooling window. The output quantization of the
+ *           convolution is kept. Use arm_convolve_s8_max_pool_1x2_get_buffer_size() for the buffer.
+ */
+arm_cmsis_nn_status arm_convolve_s8_max_pool_1x2(const cmsis_nn_context *ctx,
+                                                 const cmsis_nn_conv_params *conv_params,
+                                                 const cmsis_nn_per_channel_quant_params *quant_params,
+                                                 const cmsis_nn_dims *input_dims,
+                                                 const q7_t *input_data,
+                                                 const cmsis_nn_dims *filter_dims,
+                                                 const q7_t *filter_data,
+                                                 const cmsis_nn_dims *bias_dims,
+                                                 const int32_t *bias_data,
+                                                 const cmsis_nn_dims *conv_output_dims,
+                                                 const cmsis_nn_dims *output_dims,
+                                                 q7_t *output_data);
+
+#if defined(ARM_MATH_DSP)
+/**
+ * @brief s8 convolution function on reordered weights with a fused 1x2 max pool
+ *
+ * @details  arm_convolve_s8_max_pool_1x2() on weights reordered by arm_convolve_s8_reorder_filter().
+ */
+arm_cmsis_nn_status arm_convolve_s8_reordered_max_pool_1x2(const cmsis_nn_context *ctx,
+                                                           const cmsis_nn_conv_params *conv_params,
+                                                           const cmsis_nn_per_channel_quant_params *quant_params,
+                                                           const cmsis_nn_dims *input_dims,
+                                                           const q7_t *input_data,
+                                                           const cmsis_nn_dims *filter_dims,
+                                                           const q7_t *filter_data,
+                                                           const cmsis_nn_dims *bias_dims,
+                                                           const int32_t *bias_data,
+                                                           const cmsis_nn_dims *conv_output_dims,
+                                                           const cmsis_nn_dims *output_dims,
+                                                           q7_t *output_data);
+#endif
+
+/**
+ * @brief Get the required buffer size for arm_convolve_s8_max_pool_1x2()
+ *
+ * @param[in]       input_dims            Input (activation) tensor dimensions. Format: [N, H, W, C_IN]
+ * @param[in]       filter_dims           Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN]
+ * @return          The function returns  required buffer size(bytes)
+ *
+ */
+int32_t arm_convolve_s8_max_pool_1x2_get_buffer_size(const cmsis_nn_dims *input_dims,
+                                                     const cmsis_nn_dims *filter_dims);
+#endif
+
+// Patched by Edge Impulse, convolution on packed s4 weights
+#if !defined(ARM_MATH_MVEI)
+/**
+ * @brief s8 convolution function on s4 weights
+ * @param[in]      filter_data    Filter data pointer, in the [C_OUT, HK, WK, C_IN] order and packed two values per
+ *                                byte, the even element in the low nibble (the TensorFlow Lite int4 layout).
+ *                                Data type: int4, symmetric
+ *
+ * @details  Same as arm_convolve_s8(), other arguments included, with the weights unpacked in the inner loop of the
+ *           matrix multiplication, so they take half the memory and half the memory bandwidth. With the DSP
+ *           extension, and HK * WK * C_IN even, eight weights are unpacked from a word for SMLAD. Use
+ *           arm_convolve_s8_get_buffer_size() for the buffer.
+ */
+arm_cmsis_nn_status arm_convolve_s4(const cmsis_nn_context *ctx,
+                                    const cmsis_nn_conv_params *conv_params,
+                                    const cmsis_nn_per_channel_quant_params *quant_params,
+                                    const cmsis_nn_dims *input_dims,
+                                    const q7_t *input_data,
+                                    const cmsis_nn_dims *filter_dims,
+                                    const q7_t *filter_data,
+                                    const cmsis_nn_dims *bias_dims,
+                                    const int32_t *bias_data,
+                                    const cmsis_nn_dims *output_dims,
+                                    q7_t *output_data);
+
+/**
+ * @brief s8 convolution function on s4 weights with a fused 1x2 max pool
+ *
+ * @details  arm_convolve_s8_max_pool_1x2() on weights packed as for arm_convolve_s4(). Use
+ *           arm_convolve_s8_max_pool_1x2_get_buffer_size() for the buffer.
+ */
+arm_cmsis_nn_status arm_convolve_s4_max_pool_1x2(const cmsis_nn_context *ctx,
+                                                 const cmsis_nn_conv_params *conv_params,
+                                                 const cmsis_nn_per_channel_quant_params *quant_params,
+                                                 const cmsis_nn_dims *input_dims,
+                                                 const q7_t *input_data,
+                                                 const cmsis_nn_dims *filter_dims,
+                                                 const q7_t *filter_data,
+                                                 const cmsis_nn_dims *bias_dims,
+                                                 const int32_t *bias_data,
+                                                 const cmsis_nn_dims *conv_output_dims,
+                                                 const cmsis_nn_dims *output_dims,
+                                                 q7_t *output_data);
+#endif
+
 /**
  * @brief Basic s16 convolution function
  * @param[in, out] ctx            Function context that contains the additional buffer if required by the function.
@@ -1502,6 +1646,56 @@ arm_cmsis_nn_status arm_fully_connected_s8(const cmsis_nn_context *ctx,
  */
 int32_t arm_fully_connected_s8_get_buffer_size(const cmsis_nn_dims *filter_dims);
 
+// Patched by Edge Impulse, fully connected on packed s4 weights
+/**
+ * @brief s8 Fully Connected function on s4 weights
+ * @param[in]      filter_data   Filter data pointer, [C, N] packed two values per byte, the even element in the
+ *                               low nibble (the TensorFlow Lite int4 layout). Data type: int4, symmetric
+ *
+ * @details  Same as arm_fully_connected_s8(), other arguments included, with the weights unpacked in the inner
+ *           loop. No buffer is needed.
+ */
+arm_cmsis_nn_status arm_fully_connected_s4(const cmsis_nn_context *ctx,
+                                           const cmsis_nn_fc_params *fc_params,
+                                           const cmsis_nn_per_tensor_quant_params *quant_params,
+                                           const cmsis_nn_dims *input_dims,
+                                           const q7_t *input_data,
+                                           const cmsis_nn_dims *filter_dims,
+                                           const q7_t *filter_data,
+                                           const cmsis_nn_dims *bias_dims,
+                                           const int32_t *bias_data,
+                                           const cmsis_nn_dims *output_dims,
+                                           q7_t *output_data);
+
+// Patched by Edge Impulse, fully connected on block sparse weights
+/**
+ * @brief s8 Fully Connected function on block sparse weights
+ * @param[in]      filter_data   Filter data pointer, the [C, N] filter cut into blocks of 1 x block_size, of which
+ *                               only the blocks set in block_bitmap are stored, row by row. Data type: int8
+ * @param[in]      block_bitmap  (N / block_size + 7) / 8 bytes per row, bit b (LSB first) set if block b of the row
+ *                               is stored
+ * @param[in]      block_size    Weights per block, a multiple of 4 that divides N
+ *
+ * @return     The function returns <code>ARM_CMSIS_NN_SUCCESS</code>, or <code>ARM_CMSIS_NN_ARG_ERROR</code> if
+ *             block_size doesn't fit the constraints above
+ *
+ * @details  Same as arm_fully_connected_s8(), other arguments included, with the blocks that aren't stored (all
+ *           zeros) skipped. No buffer is needed.
+ */
+arm_cmsis_nn_status arm_fully_connected_block_sparse_s8(const cmsis_nn_context *ctx,
+                                                        const cmsis_nn_fc_params *fc_params,
+                                                        const cmsis_nn_per_tensor_quant_params *quant_params,
+                                                        const cmsis_nn_dims *input_dims,
+                                                        const q7_t *input_data,
+                                                        const cmsis_nn_dims *filter_dims,
+                                                        const q7_t *filter_data,
+                                                        const uint8_t *block_bitmap,
+                                                        const int32_t block_size,
+                                                        const cmsis_nn_dims *bias_dims,
+                                                        const int32_t *bias_data,
+                                                        const cmsis_nn_dims *output_dims,
+                                                        q7_t *output_data);
+
 /**
  * @brief Basic s16 Fully Connected function.
  *
@@ -34,6 +34,11 @@
 #include "edge-impulse-sdk/CMSIS/DSP/Include/dsp/none.h"
 #include "edge-impulse-sdk/CMSIS/NN/Include/arm_nn_types.h"
 
+// Patched by Edge Impulse, x86 inner loops for host builds
+#if defined(ARM_NN_X86_SIMD)
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nn_x86_simd.h"
+#endif // ARM_NN_X86_SIMD
+
 #include <stdbool.h>
 
 #ifdef __cplusplus
@@ -59,6 +64,9 @@ extern "C" {
 // will result in lower scratch buffer usage.
 #define CH_IN_BLOCK_MVE (124)
 
+// Number of channels accumulated at a time in DW Conv(x86), sets the stack usage of the accumulators
+#define CH_IN_BLOCK_X86 (64)
+
 /**
  * @brief definition to pack four 8 bit values.
  */
@@ -435,6 +443,58 @@ arm_cmsis_nn_status arm_nn_vec_mat_mult_t_s8(const q7_t *lhs,
                                              const int32_t activation_max,
                                              const int32_t address_offset);
 
+// Patched by Edge Impulse, see arm_fully_connected_s4()
+/**
+ * @brief s8 Vector by s4 Matrix (transposed) multiplication
+ *
+ * @param[in]      rhs             Input right-hand side matrix (transposed), packed two s4 values per byte, the
+ *                                 even element in the low nibble. Rows are packed back to back, so with an odd
+ *                                 rhs_cols every other row starts halfway through a byte
+ *
+ * @details   Same arguments and result as arm_nn_vec_mat_mult_t_s8(), without rhs_offset (symmetric s4 weights)
+ *            and address_offset (always 1)
+ */
+arm_cmsis_nn_status arm_nn_vec_mat_mult_t_s4(const q7_t *lhs,
+                                             const q7_t *rhs,
+                                             const q31_t *bias,
+                                             q7_t *dst,
+                                             const int32_t lhs_offset,
+                                             const int32_t dst_offset,
+                                             const int32_t dst_multiplier,
+                                             const int32_t dst_shift,
+                                             const int32_t rhs_cols,
+                                             const int32_t rhs_rows,
+                                             const int32_t activation_min,
+                                             const int32_t activation_max);
+
+// Patched by Edge Impulse, see arm_fully_connected_block_sparse_s8()
+/**
+ * @brief s8 Vector by block sparse s8 Matrix (transposed) multiplication
+ *
+ * @param[in]      rhs             Input right-hand side matrix (transposed), the blocks of 1 x block_size set in
+ *                                 block_bitmap, row by row
+ * @param[in]      block_bitmap    (rhs_cols / block_size + 7) / 8 bytes per row, bit b (LSB first) set if block b
+ *                                 of the row is stored
+ * @param[in]      block_size      Weights per block, a multiple of 4 that divides rhs_cols
+ *
+ * @details   Same other arguments and result as arm_nn_vec_mat_mult_t_s8(), without rhs_offset (symmetric s8
+ *            weights) and address_offset (always 1)
+ */
+arm_cmsis_nn_status arm_nn_vec_mat_mult_t_block_sparse_s8(const q7_t *lhs,
+                                                          const q7_t *rhs,
+                                                          const uint8_t *block_bitmap,
+                                                          const int32_t block_size,
+                                                          const q31_t *bias,
+                                                          q7_t *dst,
+                                                          const int32_t lhs_offset,
+                                                          const int32_t dst_offset,
+                                                          const int32_t dst_multiplier,
+                                                          const int32_t dst_shift,
+                                                          const int32_t rhs_cols,
+                                                          const int32_t rhs_rows,
+                                                          const int32_t activation_min,
+                                                          const int32_t activation_max);
+
 /**
  * @brief s16 Vector by Matrix (transposed) multiplication
  *
@@ -709,6 +769,23 @@ __STATIC_FORCEINLINE void arm_nn_write_q7x4_ia(q7_t **in, q31_t value)
     *in += 4;
 }
 
+/**
+  @brief         Read one s4 value out of packed s4 data (two per byte, the even element in the low nibble).
+  @param[in]     in_s4       pointer to the packed data
+  @param[in]     index       element index
+  @return        sign extended value
+ */
+__STATIC_FORCEINLINE q7_t arm_nn_read_s4(const q7_t *in_s4, const int32_t index)
+{
+    const q7_t packed = in_s4[index >> 1];
+
+    if (index & 0x1)
+    {
+        return (q7_t)(packed >> 4);
+    }
+    return (q7_t)((q7_t)((uint8_t)packed << 4) >> 4);
+}
+
 /**
  * @brief           memset optimized for MVE
  * @param[in, out]  dst         Destination pointer
@@ -795,6 +872,34 @@ read_and_pad_reordered_with_offset(const q7_t *source, q31_t *out1, q31_t *out2,
     return source;
 }
 
+#ifndef ARM_MATH_BIG_ENDIAN
+/**
+ * @brief read one word of packed s4 data and expand it into four q15 words, in order, each value scaled by 16
+ *
+ * @details  The nibbles are masked into the top half of their bytes instead of being sign extended on their own,
+ *           which saves the shifts. Sums of products with these words are 16 times too large and exact, shift
+ *           them right by 4 once the accumulation is done.
+ */
+__STATIC_FORCEINLINE const q7_t *
+read_and_pad_s4_x16(const q7_t *source, q31_t *out1, q31_t *out2, q31_t *out3, q31_t *out4)
+{
+    const uint32_t inA = (uint32_t)arm_nn_read_q7x4_ia(&source);
+
+    /* (w0, w2, w4, w6) and (w1, w3, w5, w7), times 16 */
+    const q31_t even = __SXTB16((inA << 4) & 0xF0F0F0F0);
+    const q31_t even_ror = __SXTB16_RORn((inA << 4) & 0xF0F0F0F0, 8);
+    const q31_t odd = __SXTB16(inA & 0xF0F0F0F0);
+    const q31_t odd_ror = __SXTB16_RORn(inA & 0xF0F0F0F0, 8);
+
+    *out1 = (q31_t)__PKHBT(even, odd, 16);
+    *out2 = (q31_t)__PKHBT(even_ror, odd_ror, 16);
+    *out3 = (q31_t)__PKHTB(odd, even, 16);
+    *out4 = (q31_t)__PKHTB(odd_ror, even_ror, 16);
+
+    return source;
+}
+#endif
+
 #endif
 
 /**
@@ -870,6 +975,49 @@ q7_t *arm_nn_mat_mult_kernel_s8_s16(const q7_t *input_a,
                                     const int32_t *const output_bias,
                                     q7_t *out_0);
 
+// Patched by Edge Impulse, see arm_convolve_s8_reordered()
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+/**
+ * @brief Matrix-multiplication function for convolution with per-channel requantization, on weights
+ *        reordered by arm_convolve_s8_reorder_filter()
+ *
+ * @details   Same arguments and result as arm_nn_mat_mult_kernel_s8_s16()
+ */
+q7_t *arm_nn_mat_mult_kernel_s8_s16_reordered(const q7_t *input_a,
+                                              const q15_t *input_b,
+                                              const uint16_t output_ch,
+                                              const int32_t *out_shift,
+                                              const int32_t *out_mult,
+                                              const int32_t out_offset,
+                                              const int16_t activation_min,
+                                              const int16_t activation_max,
+                                              const uint16_t num_col_a,
+                                              const int32_t *const output_bias,
+                                              q7_t *out_0);
+#endif
+
+// Patched by Edge Impulse, see arm_convolve_s4()
+#if !defined(ARM_MATH_MVEI)
+/**
+ * @brief Matrix-multiplication function for convolution with per-channel requantization, on s4 weights
+ * @param[in]       input_a     pointer to the s4 weights, packed two per byte (the even element in the low
+ *                              nibble), one row of num_col_a weights per output channel
+ *
+ * @details   Same other arguments and result as arm_nn_mat_mult_kernel_s8_s16()
+ */
+q7_t *arm_nn_mat_mult_kernel_s4_s16(const q7_t *input_a,
+                                    const q15_t *input_b,
+                                    const uint16_t output_ch,
+                                    const int32_t *out_shift,
+                                    const int32_t *out_mult,
+                                    const int32_t out_offset,
+                                    const int16_t activation_min,
+                                    const int16_t activation_max,
+                                    const uint16_t num_col_a,
+                                    const int32_t *const output_bias,
+                                    q7_t *out_0);
+#endif
+
 /**
  * @brief Common softmax function for s8 input and s8 or s16 output
  * @param[in]  input          Pointer to the input tensor
@@ -42,27 +42,38 @@
  * @{
  */
 
+/* How convolve_s8() reads the weights */
+typedef enum
+{
+    /* s8, in the [C_OUT, HK, WK, C_IN] order */
+    CONV_FILTER_S8 = 0,
+    /* s8, reordered by arm_convolve_s8_reorder_filter() (DSP only) */
+    CONV_FILTER_S8_REORDERED = 1,
+    /* s4, in the [C_OUT, HK, WK, C_IN] order and packed two per byte (not MVE) */
+    CONV_FILTER_S4 = 2
+} conv_filter_format;
+
 /*
- * Basic s8 convolution function.
- *
- * Refer header file for details. Optimal use case for the DSP/MVE implementation is when input and output channels
- * are multiples of 4 or atleast greater than 4.
- *
+ * Basic s8 convolution, on weights in one of the conv_filter_format layouts. With pool_output_dims
+ * (not MVE) the output is max pooled 1x2 before it's stored, see arm_convolve_s8_max_pool_1x2().
  */
-
-arm_cmsis_nn_status arm_convolve_s8(const cmsis_nn_context *ctx,
-                                    const cmsis_nn_conv_params *conv_params,
-                                    const cmsis_nn_per_channel_quant_params *quant_params,
-                                    const cmsis_nn_dims *input_dims,
-                                    const q7_t *input_data,
-                                    const cmsis_nn_dims *filter_dims,
-                                    const q7_t *filter_data,
-                                    const cmsis_nn_dims *bias_dims,
-                                    const int32_t *bias_data,
-                                    const cmsis_nn_dims *output_dims,
-                                    q7_t *output_data)
+static arm_cmsis_nn_status convolve_s8(const cmsis_nn_context *ctx,
+                                       const cmsis_nn_conv_params *conv_params,
+                                       const cmsis_nn_per_channel_quant_params *quant_params,
+                                       const cmsis_nn_dims *input_dims,
+                                       const q7_t *input_data,
+                                       const cmsis_nn_dims *filter_dims,
+                                       const q7_t *filter_data,
+                                       const cmsis_nn_dims *bias_dims,
+                                       const int32_t *bias_data,
+                                       const cmsis_nn_dims *output_dims,
+                                       q7_t *output_data,
+                                       const cmsis_nn_dims *pool_output_dims,
+                                       const conv_filter_format filter_format)
 {
     (void)bias_dims;
+    (void)filter_format;
+    (void)pool_output_dims;
 
     if (ctx->buf == NULL && arm_convolve_s8_get_buffer_size(input_dims, filter_dims) > 0)
     {
@@ -201,6 +212,14 @@ arm_cmsis_nn_status arm_convolve_s8(const cmsis_nn_context *ctx,
         q15_t *two_column_buf = buffer_a;
         q7_t *out = output_data;
 
+        /* Fused max pool: the two output pixels of the GEMM are one pooling window, they go to pair_buf
+           and only their maximum is stored */
+        q7_t *pair_buf = NULL;
+        if (pool_output_dims)
+        {
+            pair_buf = (q7_t *)(buffer_a + 2 * input_ch * kernel_y * kernel_x);
+        }
+
         /* This part implements the im2col function */
         for (i_out_y = 0; i_out_y < output_y; i_out_y++)
         {
@@ -234,7 +253,40 @@ arm_cmsis_nn_status arm_convolve_s8(const cmsis_nn_context *ctx,
                 /* Computation is filed for every 2 columns */
                 if (two_column_buf == buffer_a + 2 * input_ch * kernel_y * kernel_x)
                 {
-                    out = arm_nn_mat_mult_kernel_s8_s16(filter_data,
+                    q7_t *dst = pair_buf ? pair_buf : out;
+                    if (filter_format == CONV_FILTER_S4)
+                    {
+                        dst = arm_nn_mat_mult_kernel_s4_s16(filter_data,
+                                                            buffer_a,
+                                                            output_ch,
+                                                            output_shift,
+                                                            output_mult,
+                                                            out_offset,
+                                                            out_activation_min,
+                                                            out_activation_max,
+                                                            input_ch * kernel_y * kernel_x,
+                                                            bias_data,
+                                                            dst);
+                    }
+                    else
+#if defined(ARM_MATH_DSP)
+                    if (filter_format == CONV_FILTER_S8_REORDERED)
+                    {
+                        dst = arm_nn_mat_mult_kernel_s8_s16_reordered(filter_data,
+                                                                      buffer_a,
+                                                                      output_ch,
+                                                                      output_shift,
+                                                                      output_mult,
+                                                                      out_offset,
+                                                                      out_activation_min,
+                                                                      out_activation_max,
+                                                                      input_ch * kernel_y * kernel_x,
+                                                                      bias_data,
+                                                                      dst);
+                    }
+                    else
+#endif
+                    dst = arm_nn_mat_mult_kernel_s8_s16(filter_data,
                                                         buffer_a,
                                                         output_ch,
                                                         output_shift,
@@ -244,7 +296,20 @@ arm_cmsis_nn_status arm_convolve_s8(const cmsis_nn_context *ctx,
                                                         out_activation_max,
                                                         input_ch * kernel_y * kernel_x,
                                                         bias_data,
-                                                        out);
+                                                        dst);
+
+                    if (pair_buf)
+                    {
+                        for (int32_t i_ch = 0; i_ch < output_ch; i_ch++)
+                        {
+                            out[i_ch] = MAX(pair_buf[i_ch], pair_buf[output_ch + i_ch]);
+                        }
+                        out += output_ch;
+                    }
+                    else
+                    {
+                        out = dst;
+                    }
 
                     /* counter reset */
                     two_column_buf = buffer_a;
@@ -252,8 +317,9 @@ arm_cmsis_nn_status arm_convolve_s8(const cmsis_nn_context *ctx,
             }
         }
 
-        /* left-over because odd number of output pixels */
-        if (two_column_buf != buffer_a)
+        /* left-over because odd number of output pixels. When pooled it's a window on its own with SAME
+           padding, and dropped with VALID padding */
+        if (two_column_buf != buffer_a && (pool_output_dims == NULL || 2 * pool_output_dims->w > output_x))
         {
             const q7_t *ker_a = filter_data;
             int i;
@@ -270,6 +336,21 @@ arm_cmsis_nn_status arm_convolve_s8(const cmsis_nn_context *ctx,
                 /* Point to the beginning of the im2col buffer where the input is available as a rearranged column */
                 const q15_t *ip_as_col = buffer_a;
 
+                if (filter_format == CONV_FILTER_S4)
+                {
+                    const int32_t row_length = input_ch * kernel_y * kernel_x;
+                    for (int32_t i_col = 0; i_col < row_length; i_col++)
+                    {
+                        sum += arm_nn_read_s4(filter_data, i * row_length + i_col) * ip_as_col[i_col];
+                    }
+                    sum = arm_nn_requantize(sum, output_mult[i], output_shift[i]);
+                    sum += out_offset;
+                    sum = MAX(sum, out_activation_min);
+                    sum = MIN(sum, out_activation_max);
+                    *out++ = (q7_t)sum;
+                    continue;
+                }
+
                 /* 4 multiply and accumulates are done in one loop. */
 #if defined(ARM_MATH_DSP)
                 uint16_t col_count = (input_ch * kernel_y * kernel_x) >> 2;
@@ -279,7 +360,14 @@ arm_cmsis_nn_status arm_convolve_s8(const cmsis_nn_context *ctx,
                     q31_t ker_a1, ker_a2;
                     q31_t ip_b1, ip_b2;
 
-                    ker_a = read_and_pad(ker_a, &ker_a1, &ker_a2);
+                    if (filter_format == CONV_FILTER_S8_REORDERED)
+                    {
+                        ker_a = read_and_pad_reordered(ker_a, &ker_a1, &ker_a2);
+                    }
+                    else
+                    {
+                        ker_a = read_and_pad(ker_a, &ker_a1, &ker_a2);
+                    }
 
                     ip_b1 = arm_nn_read_q15x2_ia(&ip_as_col);
                     sum = __SMLAD(ker_a1, ip_b1, sum);
@@ -290,6 +378,10 @@ arm_cmsis_nn_status arm_convolve_s8(const cmsis_nn_context *ctx,
                 }
                 /* Handle left over mac */
                 col_count = input_ch * kernel_y * kernel_x & 0x3;
+#elif defined(ARM_NN_X86_SIMD)
+                sum += arm_nn_x86_dot_s8_s16(ker_a, ip_as_col, input_ch * kernel_y * kernel_x);
+                ker_a += input_ch * kernel_y * kernel_x;
+                uint16_t col_count = 0;
 #else
                 uint16_t col_count = input_ch * kernel_y * kernel_x;
 #endif
@@ -311,13 +403,281 @@ arm_cmsis_nn_status arm_convolve_s8(const cmsis_nn_context *ctx,
 #endif // #if defined(ARM_MATH_MVEI)
         /* Advance to the next batch */
         input_data += (input_x * input_y * input_ch);
-        output_data += (output_x * output_y * output_ch);
+        if (pool_output_dims)
+        {
+            output_data += (pool_output_dims->w * pool_output_dims->h * output_ch);
+        }
+        else
+        {
+            output_data += (output_x * output_y * output_ch);
+        }
     }
 
     /* Return to application */
     return ARM_CMSIS_NN_SUCCESS;
 }
 
+/*
+ * Basic s8 convolution function.
+ *
+ * Refer header file for details. Optimal use case for the DSP/MVE implementation is when input and output channels
+ * are multiples of 4 or atleast greater than 4.
+ *
+ */
+
+arm_cmsis_nn_status arm_convolve_s8(const cmsis_nn_context *ctx,
+                                    const cmsis_nn_conv_params *conv_params,
+                                    const cmsis_nn_per_channel_quant_params *quant_params,
+                                    const cmsis_nn_dims *input_dims,
+                                    const q7_t *input_data,
+                                    const cmsis_nn_dims *filter_dims,
+                                    const q7_t *filter_data,
+                                    const cmsis_nn_dims *bias_dims,
+                                    const int32_t *bias_data,
+                                    const cmsis_nn_dims *output_dims,
+                                    q7_t *output_data)
+{
+    return convolve_s8(ctx,
+                       conv_params,
+                       quant_params,
+                       input_dims,
+                       input_data,
+                       filter_dims,
+                       filter_data,
+                       bias_dims,
+                       bias_data,
+                       output_dims,
+                       output_data,
+                       NULL,
+                       CONV_FILTER_S8);
+}
+
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+/*
+ * s8 convolution on weights reordered offline by arm_convolve_s8_reorder_filter().
+ *
+ * Refer header file for details.
+ *
+ */
+
+arm_cmsis_nn_status arm_convolve_s8_reordered(const cmsis_nn_context *ctx,
+                                              const cmsis_nn_conv_params *conv_params,
+                                              const cmsis_nn_per_channel_quant_params *quant_params,
+                                              const cmsis_nn_dims *input_dims,
+                                              const q7_t *input_data,
+                                              const cmsis_nn_dims *filter_dims,
+                                              const q7_t *filter_data,
+                                              const cmsis_nn_dims *bias_dims,
+                                              const int32_t *bias_data,
+                                              const cmsis_nn_dims *output_dims,
+                                              q7_t *output_data)
+{
+    return convolve_s8(ctx,
+                       conv_params,
+                       quant_params,
+                       input_dims,
+                       input_data,
+                       filter_dims,
+                       filter_data,
+                       bias_dims,
+                       bias_data,
+                       output_dims,
+                       output_data,
+                       NULL,
+                       CONV_FILTER_S8_REORDERED);
+}
+#endif // defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+
+#if !defined(ARM_MATH_MVEI)
+/*
+ * The GEMM works on pairs of consecutive output pixels, which are the pooling windows as long as
+ * no pair spans two output rows.
+ */
+static int32_t max_pool_1x2_dims_valid(const cmsis_nn_dims *conv_output_dims, const cmsis_nn_dims *output_dims)
+{
+    if (output_dims->n != conv_output_dims->n || output_dims->h != conv_output_dims->h ||
+        output_dims->c != conv_output_dims->c)
+    {
+        return 0;
+    }
+    if (conv_output_dims->h > 1 && (conv_output_dims->w & 0x1))
+    {
+        return 0;
+    }
+    /* SAME or VALID padding */
+    return output_dims->w == (conv_output_dims->w + 1) / 2 || output_dims->w == conv_output_dims->w / 2;
+}
+
+/*
+ * s8 convolution with a fused 1x2 max pool.
+ *
+ * Refer header file for details.
+ *
+ */
+
+arm_cmsis_nn_status arm_convolve_s8_max_pool_1x2(const cmsis_nn_context *ctx,
+                                                 const cmsis_nn_conv_params *conv_params,
+                                                 const cmsis_nn_per_channel_quant_params *quant_params,
+                                                 const cmsis_nn_dims *input_dims,
+                                                 const q7_t *input_data,
+                                                 const cmsis_nn_dims *filter_dims,
+                                                 const q7_t *filter_data,
+                                                 const cmsis_nn_dims *bias_dims,
+                                                 const int32_t *bias_data,
+                                                 const cmsis_nn_dims *conv_output_dims,
+                                                 const cmsis_nn_dims *output_dims,
+                                                 q7_t *output_data)
+{
+    if (!max_pool_1x2_dims_valid(conv_output_dims, output_dims))
+    {
+        return ARM_CMSIS_NN_ARG_ERROR;
+    }
+    return convolve_s8(ctx,
+                       conv_params,
+                       quant_params,
+                       input_dims,
+                       input_data,
+                       filter_dims,
+                       filter_data,
+                       bias_dims,
+                       bias_data,
+                       conv_output_dims,
+                       output_data,
+                       output_dims,
+                       CONV_FILTER_S8);
+}
+
+#if defined(ARM_MATH_DSP)
+arm_cmsis_nn_status arm_convolve_s8_reordered_max_pool_1x2(const cmsis_nn_context *ctx,
+                                                           const cmsis_nn_conv_params *conv_params,
+                                                           const cmsis_nn_per_channel_quant_params *quant_params,
+                                                           const cmsis_nn_dims *input_dims,
+                                                           const q7_t *input_data,
+                                                           const cmsis_nn_dims *filter_dims,
+                                                           const q7_t *filter_data,
+                                                           const cmsis_nn_dims *bias_dims,
+                                                           const int32_t *bias_data,
+                                                           const cmsis_nn_dims *conv_output_dims,
+                                                           const cmsis_nn_dims *output_dims,
+                                                           q7_t *output_data)
+{
+    if (!max_pool_1x2_dims_valid(conv_output_dims, output_dims))
+    {
+        return ARM_CMSIS_NN_ARG_ERROR;
+    }
+    return convolve_s8(ctx,
+                       conv_params,
+                       quant_params,
+                       input_dims,
+                       input_data,
+                       filter_dims,
+                       filter_data,
+                       bias_dims,
+                       bias_data,
+                       conv_output_dims,
+                       output_data,
+                       output_dims,
+                       CONV_FILTER_S8_REORDERED);
+}
+#endif // defined(ARM_MATH_DSP)
+
+/*
+ * s8 convolution on packed s4 weights.
+ *
+ * Refer header file for details.
+ *
+ */
+
+arm_cmsis_nn_status arm_convolve_s4(const cmsis_nn_context *ctx,
+                                    const cmsis_nn_conv_params *conv_params,
+                                    const cmsis_nn_per_channel_quant_params *quant_params,
+                                    const cmsis_nn_dims *input_dims,
+                                    const q7_t *input_data,
+                                    const cmsis_nn_dims *filter_dims,
+                                    const q7_t *filter_data,
+                                    const cmsis_nn_dims *bias_dims,
+                                    const int32_t *bias_data,
+                                    const cmsis_nn_dims *output_dims,
+                                    q7_t *output_data)
+{
+    return convolve_s8(ctx,
+                       conv_params,
+                       quant_params,
+                       input_dims,
+                       input_data,
+                       filter_dims,
+                       filter_data,
+                       bias_dims,
+                       bias_data,
+                       output_dims,
+                       output_data,
+                       NULL,
+                       CONV_FILTER_S4);
+}
+
+arm_cmsis_nn_status arm_convolve_s4_max_pool_1x2(const cmsis_nn_context *ctx,
+                                                 const cmsis_nn_conv_params *conv_params,
+                                                 const cmsis_nn_per_channel_quant_params *quant_params,
+                                                 const cmsis_nn_dims *input_dims,
+                                                 const q7_t *input_data,
+                                                 const cmsis_nn_dims *filter_dims,
+                                                 const q7_t *filter_data,
+                                                 const cmsis_nn_dims *bias_dims,
+                                                 const int32_t *bias_data,
+                                                 const cmsis_nn_dims *conv_output_dims,
+                                                 const cmsis_nn_dims *output_dims,
+                                                 q7_t *output_data)
+{
+    if (!max_pool_1x2_dims_valid(conv_output_dims, output_dims))
+    {
+        return ARM_CMSIS_NN_ARG_ERROR;
+    }
+    return convolve_s8(ctx,
+                       conv_params,
+                       quant_params,
+                       input_dims,
+                       input_data,
+                       filter_dims,
+                       filter_data,
+                       bias_dims,
+                       bias_data,
+                       conv_output_dims,
+                       output_data,
+                       output_dims,
+                       CONV_FILTER_S4);
+}
+
+int32_t arm_convolve_s8_max_pool_1x2_get_buffer_size(const cmsis_nn_dims *input_dims, const cmsis_nn_dims *filter_dims)
+{
+    /* im2col columns + one pair of output pixels */
+    return arm_convolve_s8_get_buffer_size(input_dims, filter_dims) + 2 * filter_dims->n * (int32_t)sizeof(q7_t);
+}
+#endif // !defined(ARM_MATH_MVEI)
+
+void arm_convolve_s8_reorder_filter(const cmsis_nn_dims *filter_dims, const q7_t *src, q7_t *dst)
+{
+    const int32_t row_length = filter_dims->h * filter_dims->w * filter_dims->c;
+
+    for (int32_t i_out_ch = 0; i_out_ch < filter_dims->n; i_out_ch++)
+    {
+        int32_t i = 0;
+        /* (w0, w1, w2, w3) -> (w0, w2, w1, w3), which read_and_pad_reordered() expands back to (w0, w1), (w2, w3) */
+        for (; i + 4 <= row_length; i += 4)
+        {
+            dst[i + 0] = src[i + 0];
+            dst[i + 1] = src[i + 2];
+            dst[i + 2] = src[i + 1];
+            dst[i + 3] = src[i + 3];
+        }
+        for (; i < row_length; i++)
+        {
+            dst[i] = src[i];
+        }
+        src += row_length;
+        dst += row_length;
+    }
+}
+
 int32_t arm_convolve_s8_get_buffer_size(const cmsis_nn_dims *input_dims, const cmsis_nn_dims *filter_dims)
 {
 #if defined(ARM_MATH_MVEI)
@@ -425,6 +425,74 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
         }
     }
 #endif
+#elif defined(ARM_NN_X86_SIMD)
+    (void)bias_dims;
+    const int32_t input_x = input_dims->w;
+    const int32_t input_y = input_dims->h;
+    const int32_t kernel_x = filter_dims->w;
+    const int32_t kernel_y = filter_dims->h;
+    const int32_t pad_x = dw_conv_params->padding.w;
+    const int32_t pad_y = dw_conv_params->padding.h;
+    const int32_t stride_x = dw_conv_params->stride.w;
+    const int32_t stride_y = dw_conv_params->stride.h;
+    const int32_t *output_shift = quant_params->shift;
+    const int32_t *output_mult = quant_params->multiplier;
+    const int32_t output_x = output_dims->w;
+    const int32_t output_y = output_dims->h;
+    const int32_t output_offset = dw_conv_params->output_offset;
+    const int32_t input_offset = dw_conv_params->input_offset;
+    const int32_t output_activation_min = dw_conv_params->activation.min;
+    const int32_t output_activation_max = dw_conv_params->activation.max;
+
+    /* Accumulate a block of channels at a time, one kernel tap after the other */
+    int32_t acc[CH_IN_BLOCK_X86];
+
+    for (int32_t i_out_y = 0; i_out_y < output_y; i_out_y++)
+    {
+        const int32_t base_idx_y = (i_out_y * stride_y) - pad_y;
+        const int32_t ker_y_start = MAX(0, -base_idx_y);
+        const int32_t ker_y_end = MIN(kernel_y, input_y - base_idx_y);
+
+        for (int32_t i_out_x = 0; i_out_x < output_x; i_out_x++)
+        {
+            const int32_t base_idx_x = (i_out_x * stride_x) - pad_x;
+            const int32_t ker_x_start = MAX(0, -base_idx_x);
+            const int32_t ker_x_end = MIN(kernel_x, input_x - base_idx_x);
+
+            for (int32_t i_ch = 0; i_ch < input_ch; i_ch += CH_IN_BLOCK_X86)
+            {
+                const int32_t ch_count = MIN(CH_IN_BLOCK_X86, input_ch - i_ch);
+
+                for (int32_t i = 0; i < ch_count; i++)
+                {
+                    acc[i] = bias ? bias[i_ch + i] : 0;
+                }
+
+                for (int32_t i_ker_y = ker_y_start; i_ker_y < ker_y_end; i_ker_y++)
+                {
+                    const int32_t idx_y = base_idx_y + i_ker_y;
+                    for (int32_t i_ker_x = ker_x_start; i_ker_x < ker_x_end; i_ker_x++)
+                    {
+                        const int32_t idx_x = base_idx_x + i_ker_x;
+                        arm_nn_x86_mac_s8(acc,
+                                          input + (idx_y * input_x + idx_x) * input_ch + i_ch,
+                                          kernel + (i_ker_y * kernel_x + i_ker_x) * input_ch + i_ch,
+                                          input_offset,
+                                          ch_count);
+                    }
+                }
+
+                for (int32_t i = 0; i < ch_count; i++)
+                {
+                    int32_t sum = arm_nn_requantize(acc[i], output_mult[i_ch + i], output_shift[i_ch + i]);
+                    sum += output_offset;
+                    sum = MAX(sum, output_activation_min);
+                    sum = MIN(sum, output_activation_max);
+                    *output++ = (q7_t)sum;
+                }
+            }
+        }
+    }
 #else
     /* Run the following code as reference implementation for Cortex-M0 and Cortex-M3 */
     return arm_depthwise_conv_s8(ctx,
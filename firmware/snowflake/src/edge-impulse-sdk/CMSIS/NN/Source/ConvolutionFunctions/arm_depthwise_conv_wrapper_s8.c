@@ -64,7 +64,7 @@ arm_cmsis_nn_status arm_depthwise_conv_wrapper_s8(const cmsis_nn_context *ctx,
     if (1 == dw_conv_params->ch_mult && input_dims->n == 1 && dw_conv_params->dilation.w == 1 &&
         dw_conv_params->dilation.h == 1)
     {
-#if !defined(ARM_MATH_MVEI)
+#if !defined(ARM_MATH_MVEI) && !defined(ARM_NN_X86_SIMD)
         if ((filter_dims->w == 3) && (filter_dims->h == 3) && (dw_conv_params->padding.h <= 1) &&
             (dw_conv_params->padding.w <= 1))
         {
@@ -0,0 +1,237 @@
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#if EI_CLASSIFIER_TFLITE_LOAD_CMSIS_NN_SOURCES
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_nn_mat_mult_kernel_s4_s16.c
+ * Description:  Matrix-multiplication function for convolution with packed s4 weights
+ *
+ * Target Processor:  Cortex-M cores
+ * -------------------------------------------------------------------- */
+
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+
+#if !defined(ARM_MATH_MVEI)
+
+static q7_t requantize_s8(q31_t acc,
+                          const int32_t out_mult,
+                          const int32_t out_shift,
+                          const int32_t out_offset,
+                          const int16_t activation_min,
+                          const int16_t activation_max)
+{
+    acc = arm_nn_requantize(acc, out_mult, out_shift);
+    acc += out_offset;
+    acc = MAX(acc, activation_min);
+    acc = MIN(acc, activation_max);
+    return (q7_t)acc;
+}
+
+/*
+ * Matrix-multiplication function for convolution with per-channel requantization, on s4 weights.
+ *
+ * Refer header file for details.
+ *
+ */
+
+q7_t *arm_nn_mat_mult_kernel_s4_s16(const q7_t *input_a,
+                                    const q15_t *input_b,
+                                    const uint16_t output_ch,
+                                    const int32_t *out_shift,
+                                    const int32_t *out_mult,
+                                    const int32_t out_offset,
+                                    const int16_t activation_min,
+                                    const int16_t activation_max,
+                                    const uint16_t num_col_a,
+                                    const int32_t *const output_bias,
+                                    q7_t *out_0)
+{
+    /* set up the second output pointers */
+    q7_t *out_1 = out_0 + output_ch;
+    const int32_t *bias = output_bias;
+
+    /* rows of A are indexed by element, with an odd num_col_a every other row starts halfway through a byte */
+    int32_t i_a0 = 0;
+
+    uint16_t row_count = output_ch / 2;
+    /* this loop over rows in A */
+    while (row_count)
+    {
+        /* setup pointers for B */
+        const q15_t *ip_b0 = input_b;
+        const q15_t *ip_b1 = ip_b0 + num_col_a;
+
+        const int32_t i_a1 = i_a0 + num_col_a;
+
+        q31_t ch_0_out_0 = 0;
+        q31_t ch_0_out_1 = 0;
+        q31_t ch_1_out_0 = 0;
+        q31_t ch_1_out_1 = 0;
+        /* Init accumulator with bias for channel N and N + 1 */
+        if (bias)
+        {
+            ch_0_out_0 = *bias;
+            ch_0_out_1 = *bias++;
+            ch_1_out_0 = *bias;
+            ch_1_out_1 = *bias++;
+        }
+
+        int32_t i_col = 0;
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_BIG_ENDIAN)
+        /* both rows start on a byte, 8 weights per word */
+        if ((num_col_a & 0x1) == 0)
+        {
+            const q7_t *ip_a0 = input_a + (i_a0 >> 1);
+            const q7_t *ip_a1 = input_a + (i_a1 >> 1);
+
+            /* the unpacked weights are 16 times too large, these are scaled down once at the end */
+            q31_t ch_0_out_0_x16 = 0;
+            q31_t ch_0_out_1_x16 = 0;
+            q31_t ch_1_out_0_x16 = 0;
+            q31_t ch_1_out_1_x16 = 0;
+
+            uint16_t col_count = num_col_a / 8;
+            /* accumulate over the vector */
+            while (col_count)
+            {
+                q31_t a0[4], a1[4];
+                ip_a0 = read_and_pad_s4_x16(ip_a0, &a0[0], &a0[1], &a0[2], &a0[3]);
+                ip_a1 = read_and_pad_s4_x16(ip_a1, &a1[0], &a1[1], &a1[2], &a1[3]);
+
+                for (int32_t i = 0; i < 4; i++)
+                {
+                    const q31_t b0 = arm_nn_read_q15x2_ia(&ip_b0);
+                    const q31_t b1 = arm_nn_read_q15x2_ia(&ip_b1);
+
+                    ch_0_out_0_x16 = __SMLAD(a0[i], b0, ch_0_out_0_x16);
+                    ch_0_out_1_x16 = __SMLAD(a0[i], b1, ch_0_out_1_x16);
+                    ch_1_out_0_x16 = __SMLAD(a1[i], b0, ch_1_out_0_x16);
+                    ch_1_out_1_x16 = __SMLAD(a1[i], b1, ch_1_out_1_x16);
+                }
+
+                col_count--;
+            } /* while over col_count */
+
+            ch_0_out_0 += ch_0_out_0_x16 >> 4;
+            ch_0_out_1 += ch_0_out_1_x16 >> 4;
+            ch_1_out_0 += ch_1_out_0_x16 >> 4;
+            ch_1_out_1 += ch_1_out_1_x16 >> 4;
+            i_col = num_col_a & ~0x7;
+        }
+#endif
+        for (; i_col < num_col_a; i_col++)
+        {
+            q7_t a0 = arm_nn_read_s4(input_a, i_a0 + i_col);
+            q15_t b0 = *ip_b0++;
+            q7_t a1 = arm_nn_read_s4(input_a, i_a1 + i_col);
+            q15_t b1 = *ip_b1++;
+
+            ch_0_out_0 += a0 * b0;
+            ch_0_out_1 += a0 * b1;
+            ch_1_out_0 += a1 * b0;
+            ch_1_out_1 += a1 * b1;
+        }
+
+        *out_0++ = requantize_s8(ch_0_out_0, *out_mult, *out_shift, out_offset, activation_min, activation_max);
+        *out_1++ = requantize_s8(ch_0_out_1, *out_mult, *out_shift, out_offset, activation_min, activation_max);
+        out_mult++;
+        out_shift++;
+
+        *out_0++ = requantize_s8(ch_1_out_0, *out_mult, *out_shift, out_offset, activation_min, activation_max);
+        *out_1++ = requantize_s8(ch_1_out_1, *out_mult, *out_shift, out_offset, activation_min, activation_max);
+        out_mult++;
+        out_shift++;
+
+        /* skip two rows */
+        i_a0 += 2 * num_col_a;
+        row_count--;
+    }
+
+    /* compute the last odd numbered row if any */
+    if (output_ch & 0x1)
+    {
+        /* setup pointers for B */
+        const q15_t *ip_b0 = input_b;
+        const q15_t *ip_b1 = ip_b0 + num_col_a;
+
+        q31_t ch_0_out_0 = 0;
+        q31_t ch_0_out_1 = 0;
+
+        /* load the bias */
+        if (bias)
+        {
+            ch_0_out_0 = *bias;
+            ch_0_out_1 = *bias++;
+        }
+
+        int32_t i_col = 0;
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_BIG_ENDIAN)
+        if ((num_col_a & 0x1) == 0)
+        {
+            const q7_t *ip_a0 = input_a + (i_a0 >> 1);
+            q31_t ch_0_out_0_x16 = 0;
+            q31_t ch_0_out_1_x16 = 0;
+
+            uint16_t col_count = num_col_a / 8;
+            while (col_count)
+            {
+                q31_t a0[4];
+                ip_a0 = read_and_pad_s4_x16(ip_a0, &a0[0], &a0[1], &a0[2], &a0[3]);
+
+                for (int32_t i = 0; i < 4; i++)
+                {
+                    const q31_t b0 = arm_nn_read_q15x2_ia(&ip_b0);
+                    const q31_t b1 = arm_nn_read_q15x2_ia(&ip_b1);
+
+                    ch_0_out_0_x16 = __SMLAD(a0[i], b0, ch_0_out_0_x16);
+                    ch_0_out_1_x16 = __SMLAD(a0[i], b1, ch_0_out_1_x16);
+                }
+
+                col_count--;
+            }
+
+            ch_0_out_0 += ch_0_out_0_x16 >> 4;
+            ch_0_out_1 += ch_0_out_1_x16 >> 4;
+            i_col = num_col_a & ~0x7;
+        }
+#endif
+        for (; i_col < num_col_a; i_col++)
+        {
+            q7_t a0 = arm_nn_read_s4(input_a, i_a0 + i_col);
+            q15_t b0 = *ip_b0++;
+            q15_t b1 = *ip_b1++;
+
+            ch_0_out_0 += a0 * b0;
+            ch_0_out_1 += a0 * b1;
+        }
+
+        *out_0++ = requantize_s8(ch_0_out_0, *out_mult, *out_shift, out_offset, activation_min, activation_max);
+        *out_1++ = requantize_s8(ch_0_out_1, *out_mult, *out_shift, out_offset, activation_min, activation_max);
+    }
+
+    out_0 += output_ch;
+
+    /* return the new output pointer with offset */
+    return out_0;
+}
+
+#endif // !defined(ARM_MATH_MVEI)
+
+#endif // EI_CLASSIFIER_TFLITE_LOAD_CMSIS_NN_SOURCES
@@ -109,6 +109,15 @@ q7_t *arm_nn_mat_mult_kernel_s8_s16(const q7_t *input_a,
             col_count--;
         } /* while over col_count */
         col_count = num_col_a & 0x3;
+#elif defined(ARM_NN_X86_SIMD)
+        q31_t sum[4] = {ch_0_out_0, ch_0_out_1, ch_1_out_0, ch_1_out_1};
+        arm_nn_x86_dot_2x2_s8_s16(ip_a0, ip_a1, ip_b0, ip_b1, num_col_a, sum);
+        ch_0_out_0 = sum[0];
+        ch_0_out_1 = sum[1];
+        ch_1_out_0 = sum[2];
+        ch_1_out_1 = sum[3];
+        ip_a0 += num_col_a;
+        uint16_t col_count = 0;
 #else
         uint16_t col_count = num_col_a;
 #endif
@@ -197,6 +206,11 @@ q7_t *arm_nn_mat_mult_kernel_s8_s16(const q7_t *input_a,
             col_count--;
         }
         col_count = num_col_a & 0x3;
+#elif defined(ARM_NN_X86_SIMD)
+        ch_0_out_0 += arm_nn_x86_dot_s8_s16(ip_a0, ip_b0, num_col_a);
+        ch_0_out_1 += arm_nn_x86_dot_s8_s16(ip_a0, ip_b1, num_col_a);
+        ip_a0 += num_col_a;
+        uint16_t col_count = 0;
 #else
         uint16_t col_count = num_col_a;
 #endif
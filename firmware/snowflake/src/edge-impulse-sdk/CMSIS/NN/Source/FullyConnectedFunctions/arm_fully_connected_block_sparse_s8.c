@@ -0,0 +1,100 @@
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#if EI_CLASSIFIER_TFLITE_LOAD_CMSIS_NN_SOURCES
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_fully_connected_block_sparse_s8
+ * Description:  Fully connected function compatible with TF Lite, on block sparse weights.
+ *
+ * Target Processor:  Cortex-M cores
+ *
+ * -------------------------------------------------------------------- */
+
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+
+/**
+ *  @ingroup groupNN
+ */
+
+/**
+ * @addtogroup FC
+ * @{
+ */
+
+/*
+ * S8 fully-connected layer function on block sparse weights for TensorFlow Lite
+ *
+ * Refer header file for details.
+ *
+ */
+
+arm_cmsis_nn_status arm_fully_connected_block_sparse_s8(const cmsis_nn_context *ctx,
+                                                        const cmsis_nn_fc_params *fc_params,
+                                                        const cmsis_nn_per_tensor_quant_params *quant_params,
+                                                        const cmsis_nn_dims *input_dims,
+                                                        const q7_t *input,
+                                                        const cmsis_nn_dims *filter_dims,
+                                                        const q7_t *kernel,
+                                                        const uint8_t *block_bitmap,
+                                                        const int32_t block_size,
+                                                        const cmsis_nn_dims *bias_dims,
+                                                        const int32_t *bias,
+                                                        const cmsis_nn_dims *output_dims,
+                                                        q7_t *output)
+{
+    (void)bias_dims;
+    (void)ctx;
+    (void)fc_params->filter_offset;
+
+    if (block_size <= 0 || (block_size & 0x3) != 0 || filter_dims->n % block_size != 0)
+    {
+        return ARM_CMSIS_NN_ARG_ERROR;
+    }
+
+    int32_t batch_cnt = input_dims->n;
+
+    while (batch_cnt)
+    {
+        arm_nn_vec_mat_mult_t_block_sparse_s8(input,
+                                              kernel,
+                                              block_bitmap,
+                                              block_size,
+                                              bias,
+                                              output,
+                                              fc_params->input_offset,
+                                              fc_params->output_offset,
+                                              quant_params->multiplier,
+                                              quant_params->shift,
+                                              filter_dims->n, /* col_dim or accum_depth */
+                                              output_dims->c, /* row_dim or output_depth */
+                                              fc_params->activation.min,
+                                              fc_params->activation.max);
+        input += filter_dims->n;
+        output += output_dims->c;
+        batch_cnt--;
+    }
+    return (ARM_CMSIS_NN_SUCCESS);
+}
+
+/**
+ * @} end of FC group
+ */
+
+#endif // EI_CLASSIFIER_TFLITE_LOAD_CMSIS_NN_SOURCES
@@ -408,6 +408,37 @@ arm_cmsis_nn_status arm_nn_mat_mult_nt_t_s8(const q7_t *lhs,
             dst_ptr += rhs_rows;
         }
     }
+#elif defined(ARM_NN_X86_SIMD)
+    for (int32_t rhs_rows_idx = 0; rhs_rows_idx < rhs_rows; rhs_rows_idx++)
+    {
+        const q7_t *lhs_ptr = &lhs[0];
+        q7_t *dst_ptr = &dst[rhs_rows_idx];
+
+        for (int32_t lhs_rows_idx = 0; lhs_rows_idx < lhs_rows; ++lhs_rows_idx)
+        {
+            q31_t res00 = 0;
+            if (bias)
+            {
+                res00 = bias[rhs_rows_idx];
+            }
+            res00 += arm_nn_x86_dot_s8(lhs_ptr, rhs, lhs_offset, rhs_cols);
+
+            // Quantize down
+            res00 = arm_nn_requantize(res00, dst_multipliers[rhs_rows_idx], dst_shifts[rhs_rows_idx]);
+
+            // Add offset
+            res00 += dst_offset;
+
+            // Clamp the result
+            res00 = MAX(res00, activation_min);
+            res00 = MIN(res00, activation_max);
+
+            dst_ptr[0] = (q7_t)res00;
+            dst_ptr += rhs_rows;
+            lhs_ptr += rhs_cols;
+        }
+        rhs += rhs_cols;
+    }
 #else
     for (int32_t rhs_rows_idx = 0; rhs_rows_idx <= (rhs_rows - 2); rhs_rows_idx += 2)
     {
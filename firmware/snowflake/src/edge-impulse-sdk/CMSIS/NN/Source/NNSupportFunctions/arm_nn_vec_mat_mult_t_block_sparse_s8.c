@@ -0,0 +1,134 @@
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#if EI_CLASSIFIER_TFLITE_LOAD_CMSIS_NN_SOURCES
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_nn_vec_mat_mult_t_block_sparse_s8
+ * Description:  s8 vector by block sparse s8 matrix (transposed) multiplication
+ *
+ * Target Processor:  Cortex-M
+ *
+ * -------------------------------------------------------------------- */
+
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+
+/**
+ * @ingroup groupSupport
+ */
+
+/**
+ * @addtogroup NNBasicMath
+ * @{
+ */
+
+/*
+ * s8 vector(lhs) by block sparse s8 matrix (transposed) multiplication
+ *
+ * Refer header file for details.
+ *
+ */
+arm_cmsis_nn_status arm_nn_vec_mat_mult_t_block_sparse_s8(const q7_t *lhs,
+                                                          const q7_t *rhs,
+                                                          const uint8_t *block_bitmap,
+                                                          const int32_t block_size,
+                                                          const q31_t *bias,
+                                                          q7_t *dst,
+                                                          const int32_t lhs_offset,
+                                                          const int32_t dst_offset,
+                                                          const int32_t dst_multiplier,
+                                                          const int32_t dst_shift,
+                                                          const int32_t rhs_cols,
+                                                          const int32_t rhs_rows,
+                                                          const int32_t activation_min,
+                                                          const int32_t activation_max)
+{
+    const int32_t block_count = rhs_cols / block_size;
+    const int32_t bitmap_stride = (block_count + 7) / 8;
+
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+    const int16_t lhs_offset_s16 = (int16_t)lhs_offset;
+    const uint32_t lhs_offset_s16x2 = __PKHBT(lhs_offset_s16, lhs_offset_s16, 16);
+#endif
+
+    for (int32_t i_row = 0; i_row < rhs_rows; i_row++)
+    {
+        q31_t res00 = 0;
+        if (bias)
+        {
+            res00 = *bias++;
+        }
+
+#if defined(ARM_NN_X86_SIMD)
+        res00 += arm_nn_x86_dot_block_sparse_s8(lhs, &rhs, block_bitmap, block_size, block_count, lhs_offset);
+#else
+        for (int32_t i_block = 0; i_block < block_count; i_block++)
+        {
+            /* blocks of zeros aren't stored */
+            if ((block_bitmap[i_block >> 3] & (1 << (i_block & 0x7))) == 0)
+            {
+                continue;
+            }
+
+            const q7_t *lhs_ptr = lhs + i_block * block_size;
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+            for (int32_t i = 0; i < block_size; i += 4)
+            {
+                int32_t vec_0 = arm_nn_read_q7x4_ia(&lhs_ptr);
+                int32_t vec_1 = __SXTAB16_RORn(lhs_offset_s16x2, (uint32_t)vec_0, 8);
+                vec_0 = __SXTAB16(lhs_offset_s16x2, vec_0);
+
+                int32_t ker_0 = arm_nn_read_q7x4_ia(&rhs);
+                int32_t ker_1 = __SXTB16_RORn((uint32_t)ker_0, 8);
+                ker_0 = __SXTB16(ker_0);
+
+                res00 = __SMLAD(ker_1, vec_1, res00);
+                res00 = __SMLAD(ker_0, vec_0, res00);
+            }
+#else
+            for (int32_t i = 0; i < block_size; i++)
+            {
+                const q31_t lhs_value = (int8_t)*lhs_ptr++ + lhs_offset;
+                res00 += lhs_value * (int8_t)*rhs++;
+            }
+#endif
+        }
+#endif
+
+        // Quantize down
+        res00 = arm_nn_requantize(res00, dst_multiplier, dst_shift);
+
+        // Add offset
+        res00 += dst_offset;
+
+        // Clamp the result
+        res00 = MAX(res00, activation_min);
+        res00 = MIN(res00, activation_max);
+
+        *dst++ = (q7_t)res00;
+        block_bitmap += bitmap_stride;
+    }
+
+    return ARM_CMSIS_NN_SUCCESS;
+}
+
+/**
+ * @} end of NNBasicMath group
+ */
+
+#endif // EI_CLASSIFIER_TFLITE_LOAD_CMSIS_NN_SOURCES
@@ -0,0 +1,134 @@
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#if EI_CLASSIFIER_TFLITE_LOAD_CMSIS_NN_SOURCES
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_nn_vec_mat_mult_t_s4
+ * Description:  s8 vector by s4 matrix (transposed) multiplication
+ *
+ * Target Processor:  Cortex-M
+ *
+ * -------------------------------------------------------------------- */
+
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+
+/**
+ * @ingroup groupSupport
+ */
+
+/**
+ * @addtogroup NNBasicMath
+ * @{
+ */
+
+/*
+ * s8 vector(lhs) by s4 matrix (transposed) multiplication
+ *
+ * Refer header file for details.
+ *
+ */
+arm_cmsis_nn_status arm_nn_vec_mat_mult_t_s4(const q7_t *lhs,
+                                             const q7_t *rhs,
+                                             const q31_t *bias,
+                                             q7_t *dst,
+                                             const int32_t lhs_offset,
+                                             const int32_t dst_offset,
+                                             const int32_t dst_multiplier,
+                                             const int32_t dst_shift,
+                                             const int32_t rhs_cols,
+                                             const int32_t rhs_rows,
+                                             const int32_t activation_min,
+                                             const int32_t activation_max)
+{
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_BIG_ENDIAN)
+    const q31_t lhs_offset_s16x2 = (q31_t)__PKHBT(lhs_offset, lhs_offset, 16);
+#endif
+
+    /* rows are indexed by element, with an odd rhs_cols every other row starts halfway through a byte */
+    int32_t i_rhs = 0;
+
+    for (int32_t i_row = 0; i_row < rhs_rows; i_row++)
+    {
+        q31_t res00 = 0;
+        if (bias)
+        {
+            res00 = *bias++;
+        }
+
+        int32_t i_col = 0;
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_BIG_ENDIAN)
+        /* the row starts on a byte, 8 weights per word */
+        if ((rhs_cols & 0x1) == 0)
+        {
+            const q7_t *lhs_ptr = lhs;
+            const q7_t *rhs_ptr = rhs + (i_rhs >> 1);
+
+            /* the unpacked weights are 16 times too large, this is scaled down once at the end */
+            q31_t res00_x16 = 0;
+
+            int32_t col_count = rhs_cols / 8;
+            while (col_count)
+            {
+                q31_t rhs_x16[4], lhs_s16[4];
+                rhs_ptr = read_and_pad_s4_x16(rhs_ptr, &rhs_x16[0], &rhs_x16[1], &rhs_x16[2], &rhs_x16[3]);
+                lhs_ptr = read_and_pad(lhs_ptr, &lhs_s16[0], &lhs_s16[1]);
+                lhs_ptr = read_and_pad(lhs_ptr, &lhs_s16[2], &lhs_s16[3]);
+
+                for (int32_t i = 0; i < 4; i++)
+                {
+                    res00_x16 = __SMLAD(rhs_x16[i], __QADD16(lhs_s16[i], lhs_offset_s16x2), res00_x16);
+                }
+
+                col_count--;
+            }
+
+            res00 += res00_x16 >> 4;
+            i_col = rhs_cols & ~0x7;
+        }
+#endif
+        for (; i_col < rhs_cols; i_col++)
+        {
+            const q31_t rhs_value0 = arm_nn_read_s4(rhs, i_rhs + i_col);
+            const q31_t lhs_value = (int8_t)lhs[i_col] + lhs_offset;
+
+            res00 += lhs_value * rhs_value0;
+        }
+
+        // Quantize down
+        res00 = arm_nn_requantize(res00, dst_multiplier, dst_shift);
+
+        // Add offset
+        res00 += dst_offset;
+
+        // Clamp the result
+        res00 = MAX(res00, activation_min);
+        res00 = MIN(res00, activation_max);
+
+        *dst++ = (q7_t)res00;
+        i_rhs += rhs_cols;
+    }
+
+    return ARM_CMSIS_NN_SUCCESS;
+}
+
+/**
+ * @} end of NNBasicMath group
+ */
+
+#endif // EI_CLASSIFIER_TFLITE_LOAD_CMSIS_NN_SOURCES
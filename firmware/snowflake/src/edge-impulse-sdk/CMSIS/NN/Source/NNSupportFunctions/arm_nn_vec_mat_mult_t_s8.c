@@ -295,6 +295,30 @@ arm_cmsis_nn_status arm_nn_vec_mat_mult_t_s8(const q7_t *lhs,
         dst += address_offset;
     }
 
+#elif defined(ARM_NN_X86_SIMD)
+    for (int32_t i_row = 0; i_row < rhs_rows; i_row++)
+    {
+        q31_t res00 = 0;
+        if (bias)
+        {
+            res00 = *bias++;
+        }
+        res00 += arm_nn_x86_dot_s8(lhs, rhs, lhs_offset, rhs_cols);
+
+        // Quantize down
+        res00 = arm_nn_requantize(res00, dst_multiplier, dst_shift);
+
+        // Add offset
+        res00 += dst_offset;
+
+        // Clamp the result
+        res00 = MAX(res00, activation_min);
+        res00 = MIN(res00, activation_max);
+
+        *dst = (q7_t)res00;
+        dst += address_offset;
+        rhs += rhs_cols;
+    }
 #else
 
     const int32_t row_loop_cnt = rhs_rows / 3;
@@ -0,0 +1,663 @@
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#if EI_CLASSIFIER_TFLITE_LOAD_CMSIS_NN_SOURCES && defined(ARM_NN_X86_SIMD)
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_nn_x86_simd.c
+ * Description:  x86 (SSE4.1 / AVX2) inner loops for the s8 kernels, with runtime dispatch
+ *
+ * Target Processor:  x86-64
+ * -------------------------------------------------------------------- */
+
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+
+#include <immintrin.h>
+
+#define ARM_NN_X86_SSE41 __attribute__((target("sse4.1")))
+#define ARM_NN_X86_AVX2 __attribute__((target("avx2")))
+
+// The AVX2 loops clear the upper halves of the ymm registers before they hand the tail to the
+// SSE4.1 loops (or return), mixing them with the non-VEX SSE code is very slow otherwise
+
+static int arm_nn_x86_isa_detected = -1;
+static int arm_nn_x86_isa_selected = -1;
+
+arm_nn_x86_isa arm_nn_x86_get_isa(void)
+{
+    if (arm_nn_x86_isa_selected < 0)
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            arm_nn_x86_isa_detected = ARM_NN_X86_ISA_AVX2;
+        }
+        else if (__builtin_cpu_supports("sse4.1"))
+        {
+            arm_nn_x86_isa_detected = ARM_NN_X86_ISA_SSE41;
+        }
+        else
+        {
+            arm_nn_x86_isa_detected = ARM_NN_X86_ISA_SCALAR;
+        }
+        arm_nn_x86_isa_selected = arm_nn_x86_isa_detected;
+    }
+    return (arm_nn_x86_isa)arm_nn_x86_isa_selected;
+}
+
+void arm_nn_x86_set_isa(arm_nn_x86_isa isa)
+{
+    (void)arm_nn_x86_get_isa();
+    arm_nn_x86_isa_selected = MIN((int)isa, arm_nn_x86_isa_detected);
+}
+
+/* Horizontal sums of the 32 bit lanes */
+
+ARM_NN_X86_SSE41 static inline int32_t hsum_epi32_sse41(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(v);
+}
+
+ARM_NN_X86_AVX2 static inline int32_t hsum_epi32_avx2(__m256i v)
+{
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+/*
+ * s8 x s16 dot products: sign extend lhs to 16 bits, pairwise multiply-add into 32 bits. The columns
+ * of the convolutions are short (kernel size x input channels), so the tail goes through the vector
+ * loop once more from zero padded copies instead of a scalar loop.
+ */
+
+static int32_t dot_s8_s16_scalar(const q7_t *lhs, const q15_t *rhs, int32_t length)
+{
+    int32_t sum = 0;
+    for (int32_t i = 0; i < length; i++)
+    {
+        sum += lhs[i] * rhs[i];
+    }
+    return sum;
+}
+
+ARM_NN_X86_SSE41 static int32_t dot_s8_s16_sse41(const q7_t *lhs, const q15_t *rhs, int32_t length)
+{
+    __m128i acc = _mm_setzero_si128();
+    int32_t i = 0;
+    for (; i <= length - 8; i += 8)
+    {
+        const __m128i a = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(lhs + i)));
+        const __m128i b = _mm_loadu_si128((const __m128i *)(rhs + i));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(a, b));
+    }
+    if (i < length)
+    {
+        q7_t lhs_tail[8] = {0};
+        q15_t rhs_tail[8] = {0};
+        memcpy(lhs_tail, lhs + i, (length - i) * sizeof(q7_t));
+        memcpy(rhs_tail, rhs + i, (length - i) * sizeof(q15_t));
+        const __m128i a = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)lhs_tail));
+        const __m128i b = _mm_loadu_si128((const __m128i *)rhs_tail);
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(a, b));
+    }
+    return hsum_epi32_sse41(acc);
+}
+
+ARM_NN_X86_AVX2 static int32_t dot_s8_s16_avx2(const q7_t *lhs, const q15_t *rhs, int32_t length)
+{
+    __m256i acc = _mm256_setzero_si256();
+    int32_t i = 0;
+    for (; i <= length - 16; i += 16)
+    {
+        const __m256i a = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(lhs + i)));
+        const __m256i b = _mm256_loadu_si256((const __m256i *)(rhs + i));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+    }
+    if (i < length)
+    {
+        q7_t lhs_tail[16] = {0};
+        q15_t rhs_tail[16] = {0};
+        memcpy(lhs_tail, lhs + i, (length - i) * sizeof(q7_t));
+        memcpy(rhs_tail, rhs + i, (length - i) * sizeof(q15_t));
+        const __m256i a = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)lhs_tail));
+        const __m256i b = _mm256_loadu_si256((const __m256i *)rhs_tail);
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+    }
+    const int32_t sum = hsum_epi32_avx2(acc);
+    _mm256_zeroupper();
+    return sum;
+}
+
+int32_t arm_nn_x86_dot_s8_s16(const q7_t *lhs, const q15_t *rhs, int32_t length)
+{
+    switch (arm_nn_x86_get_isa())
+    {
+    case ARM_NN_X86_ISA_AVX2:
+        return dot_s8_s16_avx2(lhs, rhs, length);
+    case ARM_NN_X86_ISA_SSE41:
+        return dot_s8_s16_sse41(lhs, rhs, length);
+    default:
+        return dot_s8_s16_scalar(lhs, rhs, length);
+    }
+}
+
+static void dot_2x2_s8_s16_scalar(
+    const q7_t *lhs_0, const q7_t *lhs_1, const q15_t *rhs_0, const q15_t *rhs_1, int32_t length, q31_t *sum)
+{
+    for (int32_t i = 0; i < length; i++)
+    {
+        sum[0] += lhs_0[i] * rhs_0[i];
+        sum[1] += lhs_0[i] * rhs_1[i];
+        sum[2] += lhs_1[i] * rhs_0[i];
+        sum[3] += lhs_1[i] * rhs_1[i];
+    }
+}
+
+ARM_NN_X86_SSE41 static void dot_2x2_s8_s16_sse41(
+    const q7_t *lhs_0, const q7_t *lhs_1, const q15_t *rhs_0, const q15_t *rhs_1, int32_t length, q31_t *sum)
+{
+    __m128i acc_00 = _mm_setzero_si128();
+    __m128i acc_01 = _mm_setzero_si128();
+    __m128i acc_10 = _mm_setzero_si128();
+    __m128i acc_11 = _mm_setzero_si128();
+    q7_t lhs_0_tail[8] = {0}, lhs_1_tail[8] = {0};
+    q15_t rhs_0_tail[8] = {0}, rhs_1_tail[8] = {0};
+
+    for (int32_t i = 0; i < length; i += 8)
+    {
+        const q7_t *a0_ptr = lhs_0 + i;
+        const q7_t *a1_ptr = lhs_1 + i;
+        const q15_t *b0_ptr = rhs_0 + i;
+        const q15_t *b1_ptr = rhs_1 + i;
+        if (length - i < 8)
+        {
+            memcpy(lhs_0_tail, a0_ptr, (length - i) * sizeof(q7_t));
+            memcpy(lhs_1_tail, a1_ptr, (length - i) * sizeof(q7_t));
+            memcpy(rhs_0_tail, b0_ptr, (length - i) * sizeof(q15_t));
+            memcpy(rhs_1_tail, b1_ptr, (length - i) * sizeof(q15_t));
+            a0_ptr = lhs_0_tail;
+            a1_ptr = lhs_1_tail;
+            b0_ptr = rhs_0_tail;
+            b1_ptr = rhs_1_tail;
+        }
+        const __m128i a0 = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)a0_ptr));
+        const __m128i a1 = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)a1_ptr));
+        const __m128i b0 = _mm_loadu_si128((const __m128i *)b0_ptr);
+        const __m128i b1 = _mm_loadu_si128((const __m128i *)b1_ptr);
+        acc_00 = _mm_add_epi32(acc_00, _mm_madd_epi16(a0, b0));
+        acc_01 = _mm_add_epi32(acc_01, _mm_madd_epi16(a0, b1));
+        acc_10 = _mm_add_epi32(acc_10, _mm_madd_epi16(a1, b0));
+        acc_11 = _mm_add_epi32(acc_11, _mm_madd_epi16(a1, b1));
+    }
+    sum[0] += hsum_epi32_sse41(acc_00);
+    sum[1] += hsum_epi32_sse41(acc_01);
+    sum[2] += hsum_epi32_sse41(acc_10);
+    sum[3] += hsum_epi32_sse41(acc_11);
+}
+
+ARM_NN_X86_AVX2 static void dot_2x2_s8_s16_avx2(
+    const q7_t *lhs_0, const q7_t *lhs_1, const q15_t *rhs_0, const q15_t *rhs_1, int32_t length, q31_t *sum)
+{
+    __m256i acc_00 = _mm256_setzero_si256();
+    __m256i acc_01 = _mm256_setzero_si256();
+    __m256i acc_10 = _mm256_setzero_si256();
+    __m256i acc_11 = _mm256_setzero_si256();
+    q7_t lhs_0_tail[16] = {0}, lhs_1_tail[16] = {0};
+    q15_t rhs_0_tail[16] = {0}, rhs_1_tail[16] = {0};
+
+    for (int32_t i = 0; i < length; i += 16)
+    {
+        const q7_t *a0_ptr = lhs_0 + i;
+        const q7_t *a1_ptr = lhs_1 + i;
+        const q15_t *b0_ptr = rhs_0 + i;
+        const q15_t *b1_ptr = rhs_1 + i;
+        if (length - i < 16)
+        {
+            memcpy(lhs_0_tail, a0_ptr, (length - i) * sizeof(q7_t));
+            memcpy(lhs_1_tail, a1_ptr, (length - i) * sizeof(q7_t));
+            memcpy(rhs_0_tail, b0_ptr, (length - i) * sizeof(q15_t));
+            memcpy(rhs_1_tail, b1_ptr, (length - i) * sizeof(q15_t));
+            a0_ptr = lhs_0_tail;
+            a1_ptr = lhs_1_tail;
+            b0_ptr = rhs_0_tail;
+            b1_ptr = rhs_1_tail;
+        }
+        const __m256i a0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)a0_ptr));
+        const __m256i a1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)a1_ptr));
+        const __m256i b0 = _mm256_loadu_si256((const __m256i *)b0_ptr);
+        const __m256i b1 = _mm256_loadu_si256((const __m256i *)b1_ptr);
+        acc_00 = _mm256_add_epi32(acc_00, _mm256_madd_epi16(a0, b0));
+        acc_01 = _mm256_add_epi32(acc_01, _mm256_madd_epi16(a0, b1));
+        acc_10 = _mm256_add_epi32(acc_10, _mm256_madd_epi16(a1, b0));
+        acc_11 = _mm256_add_epi32(acc_11, _mm256_madd_epi16(a1, b1));
+    }
+    sum[0] += hsum_epi32_avx2(acc_00);
+    sum[1] += hsum_epi32_avx2(acc_01);
+    sum[2] += hsum_epi32_avx2(acc_10);
+    sum[3] += hsum_epi32_avx2(acc_11);
+    _mm256_zeroupper();
+}
+
+void arm_nn_x86_dot_2x2_s8_s16(
+    const q7_t *lhs_0, const q7_t *lhs_1, const q15_t *rhs_0, const q15_t *rhs_1, int32_t length, q31_t *sum)
+{
+    switch (arm_nn_x86_get_isa())
+    {
+    case ARM_NN_X86_ISA_AVX2:
+        dot_2x2_s8_s16_avx2(lhs_0, lhs_1, rhs_0, rhs_1, length, sum);
+        break;
+    case ARM_NN_X86_ISA_SSE41:
+        dot_2x2_s8_s16_sse41(lhs_0, lhs_1, rhs_0, rhs_1, length, sum);
+        break;
+    default:
+        dot_2x2_s8_s16_scalar(lhs_0, lhs_1, rhs_0, rhs_1, length, sum);
+        break;
+    }
+}
+
+/* s8 x s8 dot product with lhs offset: (lhs + offset) is in [-255, 255], so it's done in 16 bits, zero padded tail */
+
+static int32_t dot_s8_scalar(const q7_t *lhs, const q7_t *rhs, int32_t lhs_offset, int32_t length)
+{
+    int32_t sum = 0;
+    for (int32_t i = 0; i < length; i++)
+    {
+        sum += (lhs[i] + lhs_offset) * rhs[i];
+    }
+    return sum;
+}
+
+ARM_NN_X86_SSE41 static int32_t dot_s8_sse41(const q7_t *lhs, const q7_t *rhs, int32_t lhs_offset, int32_t length)
+{
+    const __m128i offset = _mm_set1_epi16((int16_t)lhs_offset);
+    __m128i acc = _mm_setzero_si128();
+    int32_t i = 0;
+    for (; i <= length - 8; i += 8)
+    {
+        __m128i a = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(lhs + i)));
+        const __m128i b = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(rhs + i)));
+        a = _mm_add_epi16(a, offset);
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(a, b));
+    }
+    if (i < length)
+    {
+        q7_t lhs_tail[8] = {0};
+        q7_t rhs_tail[8] = {0};
+        memcpy(lhs_tail, lhs + i, length - i);
+        memcpy(rhs_tail, rhs + i, length - i);
+        __m128i a = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)lhs_tail));
+        const __m128i b = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)rhs_tail));
+        a = _mm_add_epi16(a, offset);
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(a, b));
+    }
+    return hsum_epi32_sse41(acc);
+}
+
+ARM_NN_X86_AVX2 static int32_t dot_s8_avx2(const q7_t *lhs, const q7_t *rhs, int32_t lhs_offset, int32_t length)
+{
+    const __m256i offset = _mm256_set1_epi16((int16_t)lhs_offset);
+    __m256i acc = _mm256_setzero_si256();
+    int32_t i = 0;
+    for (; i <= length - 16; i += 16)
+    {
+        __m256i a = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(lhs + i)));
+        const __m256i b = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(rhs + i)));
+        a = _mm256_add_epi16(a, offset);
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+    }
+    if (i < length)
+    {
+        q7_t lhs_tail[16] = {0};
+        q7_t rhs_tail[16] = {0};
+        memcpy(lhs_tail, lhs + i, length - i);
+        memcpy(rhs_tail, rhs + i, length - i);
+        __m256i a = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)lhs_tail));
+        const __m256i b = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)rhs_tail));
+        a = _mm256_add_epi16(a, offset);
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+    }
+    const int32_t sum = hsum_epi32_avx2(acc);
+    _mm256_zeroupper();
+    return sum;
+}
+
+int32_t arm_nn_x86_dot_s8(const q7_t *lhs, const q7_t *rhs, int32_t lhs_offset, int32_t length)
+{
+    switch (arm_nn_x86_get_isa())
+    {
+    case ARM_NN_X86_ISA_AVX2:
+        return dot_s8_avx2(lhs, rhs, lhs_offset, length);
+    case ARM_NN_X86_ISA_SSE41:
+        return dot_s8_sse41(lhs, rhs, lhs_offset, length);
+    default:
+        return dot_s8_scalar(lhs, rhs, lhs_offset, length);
+    }
+}
+
+/*
+ * The same dot product over the stored blocks of one block sparse row, one accumulator for the whole
+ * row. Blocks are a multiple of 4 long, a 4 byte tail is loaded into the low half of a register. The
+ * vector loops only visit the set bits of the bitmap, a branch per block mispredicts half the time at
+ * 50% sparsity.
+ */
+
+static int32_t dot_block_sparse_s8_scalar(const q7_t *lhs,
+                                          const q7_t **rhs,
+                                          const uint8_t *block_bitmap,
+                                          int32_t block_size,
+                                          int32_t block_count,
+                                          int32_t lhs_offset)
+{
+    const q7_t *rhs_ptr = *rhs;
+    int32_t sum = 0;
+    for (int32_t i_block = 0; i_block < block_count; i_block++)
+    {
+        if ((block_bitmap[i_block >> 3] & (1 << (i_block & 0x7))) == 0)
+        {
+            continue;
+        }
+        sum += dot_s8_scalar(lhs + i_block * block_size, rhs_ptr, lhs_offset, block_size);
+        rhs_ptr += block_size;
+    }
+    *rhs = rhs_ptr;
+    return sum;
+}
+
+ARM_NN_X86_SSE41 static int32_t dot_block_sparse_s8_sse41(const q7_t *lhs,
+                                                           const q7_t **rhs,
+                                                           const uint8_t *block_bitmap,
+                                                           int32_t block_size,
+                                                           int32_t block_count,
+                                                           int32_t lhs_offset)
+{
+    const __m128i offset = _mm_set1_epi16((int16_t)lhs_offset);
+    const q7_t *rhs_ptr = *rhs;
+    __m128i acc = _mm_setzero_si128();
+    for (int32_t i_byte = 0; i_byte < (block_count + 7) / 8; i_byte++)
+    {
+        for (uint32_t bits = block_bitmap[i_byte]; bits != 0; bits &= bits - 1)
+        {
+            const int32_t i_block = i_byte * 8 + __builtin_ctz(bits);
+            const q7_t *lhs_ptr = lhs + i_block * block_size;
+            int32_t i = 0;
+            for (; i <= block_size - 8; i += 8)
+            {
+                __m128i a = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(lhs_ptr + i)));
+                const __m128i b = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(rhs_ptr + i)));
+                a = _mm_add_epi16(a, offset);
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(a, b));
+            }
+            if (i < block_size)
+            {
+                int32_t lhs_4, rhs_4;
+                memcpy(&lhs_4, lhs_ptr + i, 4);
+                memcpy(&rhs_4, rhs_ptr + i, 4);
+                __m128i a = _mm_cvtepi8_epi16(_mm_cvtsi32_si128(lhs_4));
+                const __m128i b = _mm_cvtepi8_epi16(_mm_cvtsi32_si128(rhs_4));
+                a = _mm_add_epi16(a, offset);
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(a, b));
+            }
+            rhs_ptr += block_size;
+        }
+    }
+    *rhs = rhs_ptr;
+    return hsum_epi32_sse41(acc);
+}
+
+ARM_NN_X86_AVX2 static int32_t dot_block_sparse_s8_avx2(const q7_t *lhs,
+                                                         const q7_t **rhs,
+                                                         const uint8_t *block_bitmap,
+                                                         int32_t block_size,
+                                                         int32_t block_count,
+                                                         int32_t lhs_offset)
+{
+    const __m256i offset = _mm256_set1_epi16((int16_t)lhs_offset);
+    const q7_t *rhs_ptr = *rhs;
+    __m256i acc = _mm256_setzero_si256();
+    __m128i acc_tail = _mm_setzero_si128();
+    for (int32_t i_byte = 0; i_byte < (block_count + 7) / 8; i_byte++)
+    {
+        for (uint32_t bits = block_bitmap[i_byte]; bits != 0; bits &= bits - 1)
+        {
+            const int32_t i_block = i_byte * 8 + __builtin_ctz(bits);
+            const q7_t *lhs_ptr = lhs + i_block * block_size;
+            int32_t i = 0;
+            for (; i <= block_size - 16; i += 16)
+            {
+                __m256i a = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(lhs_ptr + i)));
+                const __m256i b = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(rhs_ptr + i)));
+                a = _mm256_add_epi16(a, offset);
+                acc = _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+            }
+            /* 4, 8 or 12 left, in the low half */
+            for (; i <= block_size - 8; i += 8)
+            {
+                __m128i a = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(lhs_ptr + i)));
+                const __m128i b = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(rhs_ptr + i)));
+                a = _mm_add_epi16(a, _mm256_castsi256_si128(offset));
+                acc_tail = _mm_add_epi32(acc_tail, _mm_madd_epi16(a, b));
+            }
+            if (i < block_size)
+            {
+                int32_t lhs_4, rhs_4;
+                memcpy(&lhs_4, lhs_ptr + i, 4);
+                memcpy(&rhs_4, rhs_ptr + i, 4);
+                __m128i a = _mm_cvtepi8_epi16(_mm_cvtsi32_si128(lhs_4));
+                const __m128i b = _mm_cvtepi8_epi16(_mm_cvtsi32_si128(rhs_4));
+                a = _mm_add_epi16(a, _mm256_castsi256_si128(offset));
+                acc_tail = _mm_add_epi32(acc_tail, _mm_madd_epi16(a, b));
+            }
+            rhs_ptr += block_size;
+        }
+    }
+    *rhs = rhs_ptr;
+    const int32_t sum = hsum_epi32_avx2(acc) + hsum_epi32_sse41(acc_tail);
+    _mm256_zeroupper();
+    return sum;
+}
+
+int32_t arm_nn_x86_dot_block_sparse_s8(const q7_t *lhs,
+                                       const q7_t **rhs,
+                                       const uint8_t *block_bitmap,
+                                       int32_t block_size,
+                                       int32_t block_count,
+                                       int32_t lhs_offset)
+{
+    switch (arm_nn_x86_get_isa())
+    {
+    case ARM_NN_X86_ISA_AVX2:
+        return dot_block_sparse_s8_avx2(lhs, rhs, block_bitmap, block_size, block_count, lhs_offset);
+    case ARM_NN_X86_ISA_SSE41:
+        return dot_block_sparse_s8_sse41(lhs, rhs, block_bitmap, block_size, block_count, lhs_offset);
+    default:
+        return dot_block_sparse_s8_scalar(lhs, rhs, block_bitmap, block_size, block_count, lhs_offset);
+    }
+}
+
+/* Elementwise multiply-accumulate into 32 bit accumulators */
+
+static void mac_s8_scalar(int32_t *acc, const q7_t *lhs, const q7_t *rhs, int32_t lhs_offset, int32_t length)
+{
+    for (int32_t i = 0; i < length; i++)
+    {
+        acc[i] += (lhs[i] + lhs_offset) * rhs[i];
+    }
+}
+
+ARM_NN_X86_SSE41 static void
+mac_s8_sse41(int32_t *acc, const q7_t *lhs, const q7_t *rhs, int32_t lhs_offset, int32_t length)
+{
+    const __m128i offset = _mm_set1_epi32(lhs_offset);
+    int32_t i = 0;
+    for (; i <= length - 4; i += 4)
+    {
+        int32_t lhs_4, rhs_4;
+        memcpy(&lhs_4, lhs + i, 4);
+        memcpy(&rhs_4, rhs + i, 4);
+        const __m128i a = _mm_add_epi32(_mm_cvtepi8_epi32(_mm_cvtsi32_si128(lhs_4)), offset);
+        const __m128i b = _mm_cvtepi8_epi32(_mm_cvtsi32_si128(rhs_4));
+        __m128i sum = _mm_loadu_si128((const __m128i *)(acc + i));
+        sum = _mm_add_epi32(sum, _mm_mullo_epi32(a, b));
+        _mm_storeu_si128((__m128i *)(acc + i), sum);
+    }
+    mac_s8_scalar(acc + i, lhs + i, rhs + i, lhs_offset, length - i);
+}
+
+ARM_NN_X86_AVX2 static void
+mac_s8_avx2(int32_t *acc, const q7_t *lhs, const q7_t *rhs, int32_t lhs_offset, int32_t length)
+{
+    const __m256i offset = _mm256_set1_epi32(lhs_offset);
+    int32_t i = 0;
+    for (; i <= length - 8; i += 8)
+    {
+        const __m256i a =
+            _mm256_add_epi32(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)(lhs + i))), offset);
+        const __m256i b = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)(rhs + i)));
+        __m256i sum = _mm256_loadu_si256((const __m256i *)(acc + i));
+        sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(a, b));
+        _mm256_storeu_si256((__m256i *)(acc + i), sum);
+    }
+    _mm256_zeroupper();
+    mac_s8_sse41(acc + i, lhs + i, rhs + i, lhs_offset, length - i);
+}
+
+void arm_nn_x86_mac_s8(int32_t *acc, const q7_t *lhs, const q7_t *rhs, int32_t lhs_offset, int32_t length)
+{
+    switch (arm_nn_x86_get_isa())
+    {
+    case ARM_NN_X86_ISA_AVX2:
+        mac_s8_avx2(acc, lhs, rhs, lhs_offset, length);
+        break;
+    case ARM_NN_X86_ISA_SSE41:
+        mac_s8_sse41(acc, lhs, rhs, lhs_offset, length);
+        break;
+    default:
+        mac_s8_scalar(acc, lhs, rhs, lhs_offset, length);
+        break;
+    }
+}
+
+/* Elementwise max and clamp, for pooling */
+
+static void max_s8_scalar(q7_t *dst, const q7_t *src, int32_t length)
+{
+    for (int32_t i = 0; i < length; i++)
+    {
+        dst[i] = MAX(dst[i], src[i]);
+    }
+}
+
+ARM_NN_X86_SSE41 static void max_s8_sse41(q7_t *dst, const q7_t *src, int32_t length)
+{
+    int32_t i = 0;
+    for (; i <= length - 16; i += 16)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+        const __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_max_epi8(a, b));
+    }
+    max_s8_scalar(dst + i, src + i, length - i);
+}
+
+ARM_NN_X86_AVX2 static void max_s8_avx2(q7_t *dst, const q7_t *src, int32_t length)
+{
+    int32_t i = 0;
+    for (; i <= length - 32; i += 32)
+    {
+        const __m256i a = _mm256_loadu_si256((const __m256i *)(dst + i));
+        const __m256i b = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_max_epi8(a, b));
+    }
+    _mm256_zeroupper();
+    max_s8_sse41(dst + i, src + i, length - i);
+}
+
+void arm_nn_x86_max_s8(q7_t *dst, const q7_t *src, int32_t length)
+{
+    switch (arm_nn_x86_get_isa())
+    {
+    case ARM_NN_X86_ISA_AVX2:
+        max_s8_avx2(dst, src, length);
+        break;
+    case ARM_NN_X86_ISA_SSE41:
+        max_s8_sse41(dst, src, length);
+        break;
+    default:
+        max_s8_scalar(dst, src, length);
+        break;
+    }
+}
+
+static void clamp_s8_scalar(q7_t *data, int32_t length, int32_t act_min, int32_t act_max)
+{
+    for (int32_t i = 0; i < length; i++)
+    {
+        data[i] = (q7_t)MIN(MAX(data[i], act_min), act_max);
+    }
+}
+
+ARM_NN_X86_SSE41 static void clamp_s8_sse41(q7_t *data, int32_t length, int32_t act_min, int32_t act_max)
+{
+    const __m128i vmin = _mm_set1_epi8((int8_t)act_min);
+    const __m128i vmax = _mm_set1_epi8((int8_t)act_max);
+    int32_t i = 0;
+    for (; i <= length - 16; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        v = _mm_min_epi8(_mm_max_epi8(v, vmin), vmax);
+        _mm_storeu_si128((__m128i *)(data + i), v);
+    }
+    clamp_s8_scalar(data + i, length - i, act_min, act_max);
+}
+
+ARM_NN_X86_AVX2 static void clamp_s8_avx2(q7_t *data, int32_t length, int32_t act_min, int32_t act_max)
+{
+    const __m256i vmin = _mm256_set1_epi8((int8_t)act_min);
+    const __m256i vmax = _mm256_set1_epi8((int8_t)act_max);
+    int32_t i = 0;
+    for (; i <= length - 32; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        v = _mm256_min_epi8(_mm256_max_epi8(v, vmin), vmax);
+        _mm256_storeu_si256((__m256i *)(data + i), v);
+    }
+    _mm256_zeroupper();
+    clamp_s8_sse41(data + i, length - i, act_min, act_max);
+}
+
+void arm_nn_x86_clamp_s8(q7_t *data, int32_t length, int32_t act_min, int32_t act_max)
+{
+    switch (arm_nn_x86_get_isa())
+    {
+    case ARM_NN_X86_ISA_AVX2:
+        clamp_s8_avx2(data, length, act_min, act_max);
+        break;
+    case ARM_NN_X86_ISA_SSE41:
+        clamp_s8_sse41(data, length, act_min, act_max);
+        break;
+    default:
+        clamp_s8_scalar(data, length, act_min, act_max);
+        break;
+    }
+}
+
+#endif // EI_CLASSIFIER_TFLITE_LOAD_CMSIS_NN_SOURCES && defined(ARM_NN_X86_SIMD)
@@ -48,6 +48,8 @@ static void compare_and_replace_if_larger_q7(q7_t *base, const q7_t *target, int
         target += 16;
         length -= 16;
     }
+#elif defined(ARM_NN_X86_SIMD)
+    arm_nn_x86_max_s8(base, target, length);
 #else
     q7_t *dst = base;
     const q7_t *src = target;
@@ -113,6 +115,8 @@ static void clamp_output(q7_t *source, int32_t length, const int32_t act_min, co
         vstrbq_p_s8(source, res, p);
         source += 16;
     }
+#elif defined(ARM_NN_X86_SIMD)
+    arm_nn_x86_clamp_s8(source, length, act_min, act_max);
 #else
     union arm_nnword in;
     int32_t cnt = length >> 2;
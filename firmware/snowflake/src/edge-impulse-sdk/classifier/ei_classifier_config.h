@@ -32,6 +32,36 @@
     #define EI_CLASSIFIER_TFLITE_LOAD_CMSIS_NN_SOURCES  1
 #endif
 
+// Host builds: run the CMSIS-NN s8 kernels instead of the TFLite reference kernels, with SSE4.1 / AVX2
+// inner loops picked at runtime. The outputs are bit-exact with CMSIS-NN on the device.
+#ifndef EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86
+#define EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86    0
+#endif
+
+#if EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86 == 1
+    #if !defined(__x86_64__) || !defined(__GNUC__)
+        #error "EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86 requires an x86-64 GCC or Clang build"
+    #endif
+    #undef EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN
+    #define EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN      1
+    #define ARM_NN_X86_SIMD                           1
+#endif
+
+// Host builds with EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86: also take the CMSIS-NN paths for cores
+// with the DSP extension, on C versions of its SIMD instructions (arm_nn_dsp_emulation.h), where they
+// come before the x86 loops. Slower, it's there to run the DSP-only kernels (e.g. for
+// EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS) in the host tests
+#ifndef EI_CLASSIFIER_TFLITE_EMULATE_ARM_DSP
+#define EI_CLASSIFIER_TFLITE_EMULATE_ARM_DSP        0
+#endif
+
+#if EI_CLASSIFIER_TFLITE_EMULATE_ARM_DSP == 1
+    #if EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86 != 1
+        #error "EI_CLASSIFIER_TFLITE_EMULATE_ARM_DSP requires EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86"
+    #endif
+    #define ARM_NN_EMULATE_DSP                        1
+#endif
+
 #ifndef EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN
 #if defined(__MBED__)
     #include "mbed_version.h"
@@ -52,7 +82,7 @@
 // CMSIS-NN falls back to reference kernels when __ARM_FEATURE_DSP and __ARM_FEATURE_MVE are not defined
 // we should never use those... So disable CMSIS-NN in that case and throw a warning
 #if EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN == 1
-    #if !defined(__ARM_FEATURE_DSP) && !defined(__ARM_FEATURE_MVE)
+    #if !defined(__ARM_FEATURE_DSP) && !defined(__ARM_FEATURE_MVE) && !defined(ARM_NN_X86_SIMD)
         #pragma message( \
             "CMSIS-NN enabled, but neither __ARM_FEATURE_DSP nor __ARM_FEATURE_MVE defined. Falling back.")
         #undef EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN
@@ -65,6 +95,44 @@
 #define EI_CLASSIFIER_TFLITE_LOAD_CMSIS_NN_SOURCES   1
 #endif
 
+// compiled (EON) models carry their conv weights reordered for the CMSIS-NN DSP kernels and their
+// fully connected bias with the input zero point folded in (see ei_packed_weights.h), instead of
+// the kernels reworking them on every inference. Off by default. Needs CMSIS-NN on a core with the
+// DSP extension and without MVE; the tables are written by tools/eon_weight_tables.py
+#ifndef EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+#define EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS         0
+#endif // EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+
+#if EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS == 1
+    #if EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN != 1 || (!defined(__ARM_FEATURE_DSP) && !defined(ARM_NN_EMULATE_DSP)) || \
+        defined(__ARM_FEATURE_MVE)
+        #error "EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS requires CMSIS-NN and __ARM_FEATURE_DSP (without MVE)"
+    #endif
+#endif
+
+// compiled (EON) models don't run their RESHAPE nodes: the output tensor of each one shares the
+// memory of its input, in a tensor layout planned for that. Off by default, which runs the graph
+// as the EON compiler generated it
+#ifndef EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
+#define EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES         0
+#endif // EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
+
+// compiled (EON) models run each CONV_2D + MAX_POOL_2D pair as one CONV_2D_MAX_POOL_2D node, which
+// pools the convolution output before it's stored. Off by default. Needs the CMSIS-NN kernels
+// without MVE, and EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES (the pair has a RESHAPE between them)
+#ifndef EI_CLASSIFIER_TFLITE_FUSED_OPS
+#define EI_CLASSIFIER_TFLITE_FUSED_OPS              0
+#endif // EI_CLASSIFIER_TFLITE_FUSED_OPS
+
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS == 1
+    #if EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN != 1 || defined(__ARM_FEATURE_MVE)
+        #error "EI_CLASSIFIER_TFLITE_FUSED_OPS requires CMSIS-NN (without MVE)"
+    #endif
+    #if EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES != 1
+        #error "EI_CLASSIFIER_TFLITE_FUSED_OPS requires EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES"
+    #endif
+#endif
+
 #ifndef EI_CLASSIFIER_TFLITE_ENABLE_ARC
 #ifdef CPU_ARC
 #define EI_CLASSIFIER_TFLITE_ENABLE_ARC             1
@@ -86,6 +154,52 @@
     #define ESP_NN                                  1
 #endif
 
+// number of TFLite interpreters (or EON models) kept alive between inferences, with their tensor
+// arenas and prepared kernels, instead of being set up again on every inference (one per model
+// that runs, e.g. VoicePulse keywords). 0 sets them up per inference; run_classifier_deinit() frees them
+#ifndef EI_CLASSIFIER_PERSISTENT_INTERPRETER
+#define EI_CLASSIFIER_PERSISTENT_INTERPRETER        0
+#endif // EI_CLASSIFIER_PERSISTENT_INTERPRETER
+
+// one static buffer for the whole impulse (see ei_memory_plan.h): the DSP scratch and the tensor
+// arena overlay each other, as they're never live at the same time. Sized from EIDSP_ARENA_SIZE
+// (the DSP phase) and the largest tensor arena + features (the inference phase)
+#ifndef EI_CLASSIFIER_MEMORY_PLAN
+#define EI_CLASSIFIER_MEMORY_PLAN                   0
+#endif // EI_CLASSIFIER_MEMORY_PLAN
+
+// TFLite (non-EON) models lay out their tensor arena with the OptimalMemoryPlanner, which searches
+// for a smaller plan than the default greedy one (within a fixed budget, see
+// optimal_memory_planner.h) at the cost of a slower AllocateTensors(). Best paired with
+// EI_CLASSIFIER_PERSISTENT_INTERPRETER, so that only runs once. EON models have their plan compiled in
+#ifndef EI_CLASSIFIER_TFLITE_OPTIMAL_MEMORY_PLANNER
+#define EI_CLASSIFIER_TFLITE_OPTIMAL_MEMORY_PLANNER 0
+#endif // EI_CLASSIFIER_TFLITE_OPTIMAL_MEMORY_PLANNER
+
+// continuous MFCC impulses with an int8 model normalize their features window straight into the
+// input tensor (see run_nn_inference_continuous_quantized), instead of into a float window that's
+// then quantized. Off by default; test/test_continuous_quantized.cpp checks it against the float window
+#ifndef EI_CLASSIFIER_CONTINUOUS_QUANTIZED_FEATURES
+#define EI_CLASSIFIER_CONTINUOUS_QUANTIZED_FEATURES 0
+#endif // EI_CLASSIFIER_CONTINUOUS_QUANTIZED_FEATURES
+
+// compiled (EON) models carry the weights of their conv and fully connected layers (but the first
+// one) as int4, two per byte, which halves their flash footprint and the flash reads per inference.
+// The CMSIS-NN kernels unpack them in their inner loops (arm_convolve_s4, arm_fully_connected_s4),
+// the reference kernels to a scratch buffer. The weights are requantized from the int8 ones, not
+// retrained (tools/eon_weight_tables.py), so check the accuracy; test/test_int4_weights.cpp only
+// compares them with the int8 model. The model has to be generated with the same setting
+#ifndef EI_CLASSIFIER_TFLITE_INT4_WEIGHTS
+#define EI_CLASSIFIER_TFLITE_INT4_WEIGHTS           0
+#endif // EI_CLASSIFIER_TFLITE_INT4_WEIGHTS
+
+// the stages of run_classifier_continuous (DSP, features window, inference) are reported as begin /
+// end events through ei_trace_begin() / ei_trace_end(), which the application implements (see
+// ei_classifier_porting.h), e.g. to put them on a timeline with its own threads
+#ifndef EI_CLASSIFIER_TRACE
+#define EI_CLASSIFIER_TRACE                         0
+#endif // EI_CLASSIFIER_TRACE
+
 // no include checks in the compiler? then just include metadata and then ops_define (optional if on EON model)
 #ifndef __has_include
     #include "model-parameters/model_metadata.h"
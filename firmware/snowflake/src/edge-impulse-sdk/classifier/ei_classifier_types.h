@@ -51,7 +51,12 @@ typedef struct {
     int anomaly;
     int64_t dsp_us;
     int64_t classification_us;
+    // part of classification_us spent setting up the model (arena, interpreter, kernel prepare),
+    // close to 0 with EI_CLASSIFIER_PERSISTENT_INTERPRETER once the model is set up
+    int64_t classification_setup_us;
     int64_t anomaly_us;
+    int gate;
+    int64_t gate_us;
 } ei_impulse_result_timing_t;
 
 typedef struct {
@@ -60,6 +65,7 @@ typedef struct {
     ei_impulse_result_classification_t classification[EI_CLASSIFIER_MAX_LABELS_COUNT];
     float anomaly;
     ei_impulse_result_timing_t timing;
+    bool gate_rejected;
 } ei_impulse_result_t;
 
 #endif // _EDGE_IMPULSE_RUN_CLASSIFIER_TYPES_H_
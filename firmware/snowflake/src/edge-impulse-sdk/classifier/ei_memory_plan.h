@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _EI_CLASSIFIER_MEMORY_PLAN_H_
+#define _EI_CLASSIFIER_MEMORY_PLAN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "model-parameters/model_metadata.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+#include "edge-impulse-sdk/dsp/config.hpp"
+#include "edge-impulse-sdk/dsp/memory.hpp"
+
+/**
+ * The memory of a run has two phases that are never live at the same time:
+ *
+ *   DSP phase:       features matrix + DSP scratch (frames, FFT buffers, ...)
+ *   inference phase: features matrix + tensor arena
+ *
+ * Both come from the DSP arena (see ei::memory), which is stack-like and is reset at the start
+ * of every run, so the tensor arena is allocated where the DSP scratch was. With
+ * EI_CLASSIFIER_MEMORY_PLAN the arena is one static buffer, sized for the larger of the two
+ * phases, instead of a DSP arena on the heap plus a tensor arena that's allocated per inference.
+ *
+ * This is not a lifetime plan computed from the impulse. The inference phase is computed (the
+ * features size and EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE), but the DSP phase is whatever
+ * EIDSP_ARENA_SIZE is set to, measured by hand with ei::memory::arena_stats().peak (see
+ * test/test_memory_plan.cpp, which checks the keyword model's DSP still fits). Can't be combined
+ * with EI_CLASSIFIER_PERSISTENT_INTERPRETER, whose tensor arena has to outlive the run.
+ */
+
+#if EI_CLASSIFIER_MEMORY_PLAN
+
+#if EIDSP_ARENA_SIZE <= 0
+#error "EI_CLASSIFIER_MEMORY_PLAN needs EIDSP_ARENA_SIZE, the peak of the DSP phase (see ei::memory::arena_stats)"
+#endif
+
+#if EI_CLASSIFIER_PERSISTENT_INTERPRETER > 0
+#error "EI_CLASSIFIER_MEMORY_PLAN cannot be combined with EI_CLASSIFIER_PERSISTENT_INTERPRETER, the tensor arena is reused by the DSP"
+#endif
+
+#ifdef EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE
+#define EI_MEMORY_PLAN_TENSOR_ARENA_SIZE EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE
+#else
+#define EI_MEMORY_PLAN_TENSOR_ARENA_SIZE 0
+#endif
+
+namespace ei {
+namespace memory_plan {
+
+    // bytes a block of `size` takes in the arena: header, worst case alignment padding, rounding
+    constexpr size_t block(size_t size, size_t alignment = 8) {
+        return 16 + (alignment > 8 ? alignment - 8 : 0) + ((size + 7) & ~(size_t)7);
+    }
+
+    constexpr size_t max(size_t a, size_t b) {
+        return a > b ? a : b;
+    }
+
+    constexpr size_t features_size = block(EI_CLASSIFIER_NN_INPUT_FRAME_SIZE * sizeof(float));
+    constexpr size_t tensor_arena_size = EI_MEMORY_PLAN_TENSOR_ARENA_SIZE > 0 ?
+        block(EI_MEMORY_PLAN_TENSOR_ARENA_SIZE, 16) : 0;
+
+    constexpr size_t dsp_phase_size = EIDSP_ARENA_SIZE;
+    constexpr size_t inference_phase_size = features_size + tensor_arena_size;
+    constexpr size_t total_size = max(dsp_phase_size, inference_phase_size);
+
+} // namespace memory_plan
+} // namespace ei
+
+/**
+ * Tensor arena allocator for the inferencing engines: from the DSP arena when the impulse runs
+ * in an arena scope, otherwise from the heap. A tensor arena that doesn't fit in the plan also
+ * goes to the heap, with a warning, as the plan is too small for the model.
+ */
+__attribute__((unused)) static void *ei_tensor_arena_calloc(size_t align, size_t size)
+{
+    const size_t fallbacks = ei::memory::arena_stats().fallbacks;
+    void *ptr = ei::memory::arena_aligned_calloc(align, size);
+    if (!ptr) {
+        if (ei::memory::arena_stats().fallbacks != fallbacks) {
+            ei::memory::arena_stats_t stats = ei::memory::arena_stats();
+            ei_printf("WARN: Tensor arena (%u bytes) does not fit in the memory plan (%u of %u bytes used), "
+                "allocating it on the heap\n", (unsigned)size, (unsigned)stats.used, (unsigned)stats.size);
+        }
+        ptr = ei_aligned_calloc(align, size);
+    }
+    return ptr;
+}
+
+__attribute__((unused)) static void ei_tensor_arena_free(void *ptr)
+{
+    if (ei::memory::arena_owns(ptr)) {
+        ei::memory::arena_free(ptr);
+    }
+    else {
+        ei_aligned_free(ptr);
+    }
+}
+
+/**
+ * Use the static buffer of the plan as the DSP arena, and print the plan
+ */
+__attribute__((unused)) static void ei_memory_plan_init(void)
+{
+    using namespace ei::memory_plan;
+
+    alignas(16) static uint8_t buffer[total_size];
+    ei::memory::arena_init(buffer, total_size);
+
+    ei_printf("Memory plan: %u bytes (DSP phase %u, inference phase %u = features %u + tensor arena %u), "
+        "%u bytes less than separate buffers\n",
+        (unsigned)total_size, (unsigned)dsp_phase_size, (unsigned)inference_phase_size,
+        (unsigned)features_size, (unsigned)tensor_arena_size,
+        (unsigned)(dsp_phase_size + tensor_arena_size - total_size));
+}
+
+#else
+
+#define ei_tensor_arena_calloc ei_aligned_calloc
+#define ei_tensor_arena_free   ei_aligned_free
+
+#endif // EI_CLASSIFIER_MEMORY_PLAN
+
+#endif // _EI_CLASSIFIER_MEMORY_PLAN_H_
@@ -68,6 +68,9 @@
 #define EI_CLASSIFIER_IMAGE_SCALING_MIN1_1        3
 
 struct ei_impulse;
+#if EI_CLASSIFIER_PROFILE_OPS
+class EiOpProfiler;
+#endif
 
 typedef struct {
     uint16_t implementation_version;
@@ -123,6 +126,9 @@ typedef struct {
     TfLiteStatus (*model_reset)(void (*free)(void* ptr));
     TfLiteStatus (*model_input)(int, TfLiteTensor*);
     TfLiteStatus (*model_output)(int, TfLiteTensor*);
+#if EI_CLASSIFIER_PROFILE_OPS
+    TfLiteStatus (*model_set_profiler)(EiOpProfiler*);
+#endif
 } ei_config_tflite_eon_graph_t;
 
 typedef struct {
@@ -158,6 +164,17 @@ typedef struct {
     void* graph_config;
 } ei_learning_block_config_anomaly_gmm_t;
 
+typedef struct {
+    uint16_t implementation_version;
+    const float *weights;
+    size_t input_size;
+    float bias;
+    // windows scoring below it skip the blocks after the gate, keep it below 0.5: a rejected window
+    // reports the gate score as the keyword's
+    float threshold;
+    uint16_t keyword_label_ix;
+} ei_learning_block_config_gate_linear_t;
+
 typedef struct ei_impulse {
     /* project details */
     uint32_t project_id;
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _EI_CLASSIFIER_OP_PROFILER_H_
+#define _EI_CLASSIFIER_OP_PROFILER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "edge-impulse-sdk/tensorflow/lite/c/common.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_profiler_interface.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_time.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+#ifndef EI_OP_PROFILER_MAX_OPS
+#define EI_OP_PROFILER_MAX_OPS 32
+#endif
+
+/**
+ * Per-op profiler for the neural network, works for both the TFLite Micro interpreter and
+ * EON compiled models as both report one event per node through MicroProfilerInterface.
+ * Ticks come from tflite::GetCurrentTimeTicks (see micro_time.cpp, e.g. the DWT cycle
+ * counter on Cortex-M or clock_gettime on a host). Timing is accumulated over invocations
+ * until Reset() so the table shows averages.
+ *
+ * The runner calls BeginInvoke() before invoking the graph, so event n is always node n.
+ * MACs per node and the arena usage are filled in by the runner when it knows them.
+ */
+class EiOpProfiler : public tflite::MicroProfilerInterface {
+public:
+    EiOpProfiler() {
+        Reset();
+    }
+
+    /**
+     * Forget all timing and node info (e.g. after switching models)
+     */
+    void Reset() {
+        memset(ops_, 0, sizeof(ops_));
+        ops_count_ = 0;
+        next_op_ = 0;
+        invokes_ = 0;
+        arena_used_ = 0;
+        arena_size_ = 0;
+        arena_heap_ = 0;
+    }
+
+    void BeginInvoke() {
+        next_op_ = 0;
+        invokes_++;
+    }
+
+    uint32_t BeginEvent(const char *tag) override {
+        if (next_op_ >= EI_OP_PROFILER_MAX_OPS) {
+            return EI_OP_PROFILER_MAX_OPS;
+        }
+
+        uint32_t handle = next_op_++;
+        if (handle >= ops_count_) {
+            ops_count_ = handle + 1;
+        }
+        ops_[handle].tag = tag;
+        ops_[handle].start_ticks = tflite::GetCurrentTimeTicks();
+        return handle;
+    }
+
+    void EndEvent(uint32_t event_handle) override {
+        if (event_handle >= EI_OP_PROFILER_MAX_OPS) {
+            return;
+        }
+        ops_[event_handle].ticks += tflite::GetCurrentTimeTicks() - ops_[event_handle].start_ticks;
+    }
+
+    /**
+     * Set the number of multiply-accumulates of a node (0 for ops without MACs)
+     */
+    void SetNodeMacs(size_t node, uint64_t macs) {
+        if (node < EI_OP_PROFILER_MAX_OPS) {
+            ops_[node].macs = macs;
+        }
+    }
+
+    /**
+     * Report the tensor arena usage after the model was set up, the maximum is kept
+     * @param used Bytes used in the arena (tensors, persistent and scratch buffers)
+     * @param size Size of the arena
+     * @param heap Bytes that didn't fit in the arena and went to the heap instead
+     */
+    void SetArenaUsage(size_t used, size_t size, size_t heap) {
+        if (used > arena_used_) {
+            arena_used_ = used;
+        }
+        if (heap > arena_heap_) {
+            arena_heap_ = heap;
+        }
+        arena_size_ = size;
+    }
+
+    /**
+     * Count the MACs of a node from its weights and output tensors
+     * @param op Op name (as in the builtin operator enum, e.g. "CONV_2D")
+     * @param output Output tensor; the convolution output (intermediate tensor) for a
+     *               fused CONV_2D_MAX_POOL_2D node
+     */
+    static uint64_t CountMacs(const char *op, const TfLiteTensor *filter, const TfLiteTensor *output) {
+        if (!filter || !output || !filter->dims || !output->dims) {
+            return 0;
+        }
+
+        uint64_t output_elements = 1;
+        for (int ix = 0; ix < output->dims->size; ix++) {
+            output_elements *= output->dims->data[ix];
+        }
+
+        const TfLiteIntArray *f = filter->dims;
+        if ((strcmp(op, "CONV_2D") == 0 || strcmp(op, "CONV_2D_MAX_POOL_2D") == 0) && f->size == 4) {
+            // filter is [out_channels, h, w, in_channels]
+            return output_elements * f->data[1] * f->data[2] * f->data[3];
+        }
+        if (strcmp(op, "DEPTHWISE_CONV_2D") == 0 && f->size == 4) {
+            return output_elements * f->data[1] * f->data[2];
+        }
+        if (strcmp(op, "FULLY_CONNECTED") == 0 && f->size == 2) {
+            // filter is [units, input depth]
+            return output_elements * f->data[1];
+        }
+        return 0;
+    }
+
+    /**
+     * Print the per-op table, average per invocation
+     */
+    void Log() const {
+        if (invokes_ == 0) {
+            ei_printf("No inferences profiled\n");
+            return;
+        }
+
+        const uint32_t tps = tflite::ticks_per_second();
+        uint64_t total_ticks = 0;
+        uint64_t total_macs = 0;
+
+        ei_printf("Per-op profile, average of %d inferences:\n", (int)invokes_);
+        ei_printf("  #  op                      ticks        us        MACs  MACs/tick\n");
+        for (uint32_t ix = 0; ix < ops_count_; ix++) {
+            const op_t *op = &ops_[ix];
+            uint32_t ticks = (uint32_t)(op->ticks / invokes_);
+            total_ticks += ticks;
+            total_macs += op->macs;
+
+            ei_printf("%3d  %-20s %9lu %9lu %11lu  ", (int)ix, op->tag ? op->tag : "?",
+                (unsigned long)ticks, (unsigned long)TicksToUs(ticks, tps), (unsigned long)op->macs);
+            if (op->macs > 0 && ticks > 0) {
+                ei_printf_float((float)op->macs / ticks);
+            }
+            ei_printf("\n");
+        }
+        ei_printf("     %-20s %9lu %9lu %11lu\n", "total",
+            (unsigned long)total_ticks, (unsigned long)TicksToUs(total_ticks, tps), (unsigned long)total_macs);
+
+        if (arena_size_ > 0) {
+            ei_printf("Tensor arena high-water: %d of %d bytes (%d bytes on the heap)\n",
+                (int)arena_used_, (int)arena_size_, (int)arena_heap_);
+        }
+    }
+
+private:
+    typedef struct {
+        const char *tag;
+        uint32_t start_ticks;
+        uint64_t ticks;
+        uint64_t macs;
+    } op_t;
+
+    static uint64_t TicksToUs(uint64_t ticks, uint32_t tps) {
+        return tps > 0 ? (ticks * 1000000ULL) / tps : 0;
+    }
+
+    op_t ops_[EI_OP_PROFILER_MAX_OPS];
+    uint32_t ops_count_;
+    uint32_t next_op_;
+    uint32_t invokes_;
+    size_t arena_used_;
+    size_t arena_size_;
+    size_t arena_heap_;
+};
+
+// profiler the runners report to, see ei_classifier_set_op_profiler. Defined once in
+// ei_op_profiler.cpp so the compiled model and every runner see the same one
+extern EiOpProfiler *ei_op_profiler_active;
+
+#endif // _EI_CLASSIFIER_OP_PROFILER_H_
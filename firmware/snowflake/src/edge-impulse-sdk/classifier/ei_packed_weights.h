@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _EI_CLASSIFIER_PACKED_WEIGHTS_H_
+#define _EI_CLASSIFIER_PACKED_WEIGHTS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+
+/**
+ * Compiled (EON) models can carry the weights of a CONV_2D or FULLY_CONNECTED node in the layout
+ * the CMSIS-NN kernel wants, instead of having the kernel rework them on every inference
+ * (see EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS). The node points at one of these through
+ * TfLiteNode::custom_initial_data, which TFLite only uses for custom ops; the filter tensor
+ * itself holds the packed weights.
+ */
+typedef enum {
+    // [C_OUT, HK, WK, C_IN], as in the .tflite file
+    EI_FILTER_LAYOUT_OHWI = 0,
+    // [C_OUT, HK, WK, C_IN] reordered per group of 4 by arm_convolve_s8_reorder_filter(),
+    // for arm_convolve_s8_reordered()
+    EI_FILTER_LAYOUT_OHWI_REORDERED = 1,
+    // FULLY_CONNECTED only: [C_OUT, C_IN] cut into blocks of 1 x block_size weights, of which only
+    // the blocks that aren't all zero are stored, row by row (see block_bitmap). For a model pruned
+    // in blocks and retrained: the keyword model doesn't carry one, test/test_block_sparse.cpp
+    // checks the kernels
+    EI_FILTER_LAYOUT_BLOCK_SPARSE = 2,
+} ei_filter_layout_t;
+
+typedef struct {
+    ei_filter_layout_t filter_layout;
+    // FULLY_CONNECTED only: bias[i] - input_zero_point * sum(filter row i), so the kernel runs
+    // with an input offset of 0 and skips adding it to every input. nullptr to keep the bias tensor
+    const int32_t *folded_bias;
+    // EI_FILTER_LAYOUT_BLOCK_SPARSE only: (C_IN / block_size + 7) / 8 bytes per row, bit b (LSB
+    // first) set if block b of the row is stored, the bits past the last block are 0. block_size is
+    // a multiple of 4 that divides C_IN
+    const uint8_t *block_bitmap;
+    uint16_t block_size;
+} ei_packed_weights_t;
+
+/**
+ * The packed weights of a node, or nullptr if its weights are as in the .tflite file
+ */
+static inline const ei_packed_weights_t *ei_get_packed_weights(const void *custom_initial_data,
+                                                               int custom_initial_data_size) {
+    if (custom_initial_data == nullptr ||
+        custom_initial_data_size != (int)sizeof(ei_packed_weights_t)) {
+        return nullptr;
+    }
+    return static_cast<const ei_packed_weights_t *>(custom_initial_data);
+}
+
+#endif // _EI_CLASSIFIER_PACKED_WEIGHTS_H_
@@ -24,13 +24,30 @@
 #include "ei_classifier_types.h"
 #include "ei_signal_with_axes.h"
 #include "ei_performance_calibration.h"
+#include "ei_memory_plan.h"
 
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
 
+#if EI_CLASSIFIER_PROFILE_OPS
+#include "ei_op_profiler.h"
+#endif
+
+#if EI_CLASSIFIER_TRACE
+#define EI_TRACE_BEGIN(name) ei_trace_begin(name)
+#define EI_TRACE_END(name) ei_trace_end(name)
+#else
+#define EI_TRACE_BEGIN(name)
+#define EI_TRACE_END(name)
+#endif
+
 #if EI_CLASSIFIER_HAS_ANOMALY == 1
 #include "inferencing_engines/anomaly.h"
 #endif
 
+#if EI_CLASSIFIER_HAS_GATE == 1
+#include "inferencing_engines/gate.h"
+#endif
+
 #if defined(EI_CLASSIFIER_HAS_SAMPLER) && EI_CLASSIFIER_HAS_SAMPLER == 1
 #include "ei_sampler.h"
 #endif
@@ -63,10 +80,28 @@
 
 #include "model-parameters/model_variables.h"
 
+#if EIDSP_LOCK_SHARED_STATE
+#include <mutex>
+#endif
+
 #ifdef __cplusplus
 namespace {
 #endif // __cplusplus
 
+/**
+ * Everything continuous classification keeps between slices. Every context is independent,
+ * so multiple classifiers (or threads, see EIDSP_LOCK_SHARED_STATE) can each use their own. The
+ * functions that don't take a context use a default one.
+ */
+typedef struct ei_classifier_context {
+    // continuous DSP state (current frame, features ring head)
+    ei_dsp_cont_state_t dsp;
+    // ring buffer of the features for the last window, allocated on first use
+    ei::matrix_t *features;
+    uint64_t features_written;
+    RecognizeEvents *avg_scores;
+} ei_classifier_context_t;
+
 /* Function prototypes ----------------------------------------------------- */
 extern "C" EI_IMPULSE_ERROR run_inference(const ei_impulse_t *impulse, ei::matrix_t *fmatrix, ei_impulse_result_t *result, bool debug);
 extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(const ei_impulse_t *impulse, signal_t *signal, ei_impulse_result_t *result, bool debug);
@@ -74,11 +109,17 @@ static EI_IMPULSE_ERROR can_run_classifier_image_quantized(const ei_impulse_t *i
 
 /* Private variables ------------------------------------------------------- */
 
-static uint64_t classifier_continuous_features_written = 0;
-static RecognizeEvents *avg_scores = NULL;
+static ei_classifier_context_t ei_default_classifier_context = { };
 
 /* Private functions ------------------------------------------------------- */
 
+#if EIDSP_LOCK_SHARED_STATE
+static std::mutex &ei_run_inference_mutex() {
+    static std::mutex m;
+    return m;
+}
+#endif
+
 /* These functions (up to Public functions section) are not exposed to end-user,
 therefore changes are allowed. */
 
@@ -154,6 +195,16 @@ extern "C" EI_IMPULSE_ERROR run_inference(
     ei_impulse_result_t *result,
     bool debug = false)
 {
+#if EIDSP_LOCK_SHARED_STATE
+    // the learning blocks (e.g. the compiled model and its tensor arena) aren't per context
+    std::lock_guard<std::mutex> lock(ei_run_inference_mutex());
+#endif
+
+#if EI_CLASSIFIER_HAS_GATE == 1
+    // the result can be one of an earlier window
+    result->gate_rejected = false;
+#endif
+
     for (size_t ix = 0; ix < impulse->learning_blocks_size; ix++) {
         ei_learning_block_t block = impulse->learning_blocks[ix];
 
@@ -169,6 +220,19 @@ extern "C" EI_IMPULSE_ERROR run_inference(
             return res;
         }
 
+#if EI_CLASSIFIER_HAS_GATE == 1
+        // cascade: a gate block rejected this window, don't run the (expensive) blocks after it
+        if (result->gate_rejected) {
+#if EI_CLASSIFIER_LOAD_IMAGE_SCALING
+            scale_res = unscale_fmatrix(&block, fmatrix);
+            if (scale_res != EI_IMPULSE_OK) {
+                return scale_res;
+            }
+#endif
+            break;
+        }
+#endif
+
 #if EI_CLASSIFIER_LOAD_IMAGE_SCALING
         // undo scaling
         scale_res = unscale_fmatrix(&block, fmatrix);
@@ -211,6 +275,8 @@ extern "C" EI_IMPULSE_ERROR process_impulse(const ei_impulse_t *impulse,
 
     memset(result, 0, sizeof(ei_impulse_result_t));
 
+    ei::memory::arena_scope dsp_arena;
+
     ei::matrix_t features_matrix(1, impulse->nn_input_frame_size);
 
     uint64_t dsp_start_us = ei_read_timer_us();
@@ -271,37 +337,51 @@ extern "C" EI_IMPULSE_ERROR process_impulse(const ei_impulse_t *impulse,
 }
 
 /**
- * @brief      Process a complete impulse for continuous inference
+ * @brief      Run the DSP of a continuous impulse over a slice, into the features ring of ctx
  *
+ * @param      ctx      classifier context to keep the state between slices in
  * @param      impulse  struct with information about model and DSP
  * @param      signal   Sample data
- * @param      result   Output classifier results
+ * @param      result   Output classifier results (only the DSP timing is set)
  * @param[in]  debug    Debug output enable
  *
  * @return     The ei impulse error.
  */
-extern "C" EI_IMPULSE_ERROR process_impulse_continuous(const ei_impulse_t *impulse,
-                                            signal_t *signal,
-                                            ei_impulse_result_t *result,
-                                            bool debug,
-                                            bool enable_maf)
+static EI_IMPULSE_ERROR process_impulse_continuous_dsp(ei_classifier_context_t *ctx,
+                                                       const ei_impulse_t *impulse,
+                                                       signal_t *signal,
+                                                       ei_impulse_result_t *result,
+                                                       bool debug)
 {
-
-    static ei::matrix_t static_features_matrix(1, impulse->nn_input_frame_size);
-    if (!static_features_matrix.buffer) {
-        return EI_IMPULSE_ALLOC_FAILED;
+    ei::memory::arena_scope dsp_arena;
+
+    // ring buffer of the features for the last window, see ei_dsp_cont_state_t::features_head
+    // (kept between slices, so not from the DSP arena)
+    if (!ctx->features) {
+        ei::memory::arena_suspend();
+        ctx->features = new ei::matrix_t(1, impulse->nn_input_frame_size);
+        ei::memory::arena_resume();
+        if (!ctx->features->buffer) {
+            delete ctx->features;
+            ctx->features = nullptr;
+            return EI_IMPULSE_ALLOC_FAILED;
+        }
     }
+    if (ctx->features->cols != impulse->nn_input_frame_size) {
+        ei_printf("ERR: Classifier context was set up for another impulse, run run_classifier_init first\n");
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+    ei::matrix_t &static_features_matrix = *ctx->features;
 
-    memset(result, 0, sizeof(ei_impulse_result_t));
-
-    EI_IMPULSE_ERROR ei_impulse_error = EI_IMPULSE_OK;
+    // the features ring has a single head, so there can only be one DSP block writing to it
+    if (impulse->dsp_blocks_size != 1) {
+        ei_printf("ERR: Continuous classification only supports a single DSP block\n");
+        return EI_IMPULSE_DSP_ERROR;
+    }
 
     uint64_t dsp_start_us = ei_read_timer_us();
 
     size_t out_features_index = 0;
-    bool is_mfcc = false;
-    bool is_mfe = false;
-    bool is_spectrogram = false;
 
     for (size_t ix = 0; ix < impulse->dsp_blocks_size; ix++) {
         ei_model_dsp_t block = impulse->dsp_blocks[ix];
@@ -314,20 +394,17 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(const ei_impulse_t *impul
         ei::matrix_t fm(1, block.n_output_features,
                         static_features_matrix.buffer + out_features_index);
 
-        int (*extract_fn_slice)(ei::signal_t *signal, ei::matrix_t *output_matrix, void *config, const float frequency, matrix_size_t *out_matrix_size);
+        int (*extract_fn_slice)(ei::signal_t *signal, ei::matrix_t *output_matrix, void *config, const float frequency, matrix_size_t *out_matrix_size, ei_dsp_cont_state_t *state);
 
         /* Switch to the slice version of the mfcc feature extract function */
         if (block.extract_fn == extract_mfcc_features) {
             extract_fn_slice = &extract_mfcc_per_slice_features;
-            is_mfcc = true;
         }
         else if (block.extract_fn == extract_spectrogram_features) {
             extract_fn_slice = &extract_spectrogram_per_slice_features;
-            is_spectrogram = true;
         }
         else if (block.extract_fn == extract_mfe_features) {
             extract_fn_slice = &extract_mfe_per_slice_features;
-            is_mfe = true;
         }
         else {
             ei_printf("ERR: Unknown extract function, only MFCC, MFE and spectrogram supported\n");
@@ -341,10 +418,10 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(const ei_impulse_t *impul
             ei_printf("ERR: EIDSP_SIGNAL_C_FN_POINTER can only be used when all axes are selected for DSP blocks\n");
             return EI_IMPULSE_DSP_ERROR;
         }
-        int ret = extract_fn_slice(signal, &fm, block.config, impulse->frequency, &features_written);
+        int ret = extract_fn_slice(signal, &fm, block.config, impulse->frequency, &features_written, &ctx->dsp);
 #else
         SignalWithAxes swa(signal, block.axes, block.axes_size, impulse);
-        int ret = extract_fn_slice(swa.get_signal(), &fm, block.config, impulse->frequency, &features_written);
+        int ret = extract_fn_slice(swa.get_signal(), &fm, block.config, impulse->frequency, &features_written, &ctx->dsp);
 #endif
 
         if (ret != EIDSP_OK) {
@@ -356,7 +433,7 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(const ei_impulse_t *impul
             return EI_IMPULSE_CANCELED;
         }
 
-        classifier_continuous_features_written += (features_written.rows * features_written.cols);
+        ctx->features_written += (features_written.rows * features_written.cols);
 
         out_features_index += block.n_output_features;
     }
@@ -367,94 +444,359 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(const ei_impulse_t *impul
     if (debug) {
         ei_printf("\r\nFeatures (%d ms.): ", result->timing.dsp);
         for (size_t ix = 0; ix < static_features_matrix.cols; ix++) {
-            ei_printf_float(static_features_matrix.buffer[ix]);
+            ei_printf_float(static_features_matrix.buffer[(ctx->dsp.features_head + ix) % static_features_matrix.cols]);
             ei_printf(" ");
         }
         ei_printf("\n");
     }
 
-    if (classifier_continuous_features_written >= impulse->nn_input_frame_size) {
-        dsp_start_us = ei_read_timer_us();
-        ei::matrix_t classify_matrix(1, impulse->nn_input_frame_size);
+    return EI_IMPULSE_OK;
+}
 
-        /* Create a copy of the matrix for normalization */
-        for (size_t m_ix = 0; m_ix < impulse->nn_input_frame_size; m_ix++) {
-            classify_matrix.buffer[m_ix] = static_features_matrix.buffer[m_ix];
-        }
+/**
+ * @brief      Unroll the features ring of ctx (oldest first) into classify_matrix and normalize it,
+ *             only call this once a full window has been written
+ *
+ * @param      ctx              classifier context the DSP ran in
+ * @param      impulse          struct with information about model and DSP
+ * @param      classify_matrix  Output, nn_input_frame_size features
+ * @param      result           Output classifier results (the DSP timing is updated)
+ */
+static void process_impulse_continuous_window(ei_classifier_context_t *ctx,
+                                              const ei_impulse_t *impulse,
+                                              ei::matrix_t *classify_matrix,
+                                              ei_impulse_result_t *result)
+{
+    uint64_t dsp_start_us = ei_read_timer_us();
 
-        if (is_mfcc) {
-            calc_cepstral_mean_and_var_normalization_mfcc(&classify_matrix, impulse->dsp_blocks[0].config);
-        }
-        else if (is_spectrogram) {
-            calc_cepstral_mean_and_var_normalization_spectrogram(&classify_matrix, impulse->dsp_blocks[0].config);
-        }
-        else if (is_mfe) {
-            calc_cepstral_mean_and_var_normalization_mfe(&classify_matrix, impulse->dsp_blocks[0].config);
-        }
-        result->timing.dsp_us += ei_read_timer_us() - dsp_start_us;
-        result->timing.dsp = (int)(result->timing.dsp_us / 1000);
+    ei_dsp_cont_features_linearize(&ctx->dsp, ctx->features->buffer, impulse->nn_input_frame_size, classify_matrix->buffer);
 
-        if (debug) {
-            ei_printf("Running impulse...\n");
-        }
+    int (*extract_fn)(ei::signal_t *signal, ei::matrix_t *output_matrix, void *config, const float frequency) =
+        impulse->dsp_blocks[0].extract_fn;
+    if (extract_fn == extract_mfcc_features) {
+        calc_cepstral_mean_and_var_normalization_mfcc(classify_matrix, impulse->dsp_blocks[0].config);
+    }
+    else if (extract_fn == extract_spectrogram_features) {
+        calc_cepstral_mean_and_var_normalization_spectrogram(classify_matrix, impulse->dsp_blocks[0].config);
+    }
+    else if (extract_fn == extract_mfe_features) {
+        calc_cepstral_mean_and_var_normalization_mfe(classify_matrix, impulse->dsp_blocks[0].config);
+    }
 
-        ei_impulse_error = run_inference(impulse, &classify_matrix, result, debug);
+    result->timing.dsp_us += ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp = (int)(result->timing.dsp_us / 1000);
+}
 
+/**
+ * @brief      Run the performance calibration of ctx over the results of a window
+ */
+static void process_impulse_continuous_calibration(ei_classifier_context_t *ctx,
+                                                   const ei_impulse_t *impulse,
+                                                   ei_impulse_result_t *result,
+                                                   bool enable_maf)
+{
 #if EI_CLASSIFIER_CALIBRATION_ENABLED
-        if (impulse->sensor == EI_CLASSIFIER_SENSOR_MICROPHONE) {
-            if((void *)avg_scores != NULL && enable_maf == true) {
-                if (enable_maf && !impulse->calibration.is_configured) {
-                    // perfcal is not configured, print msg first time
-                    static bool has_printed_msg = false;
-
-                    if (!has_printed_msg) {
-                        ei_printf("WARN: run_classifier_continuous, enable_maf is true, but performance calibration is not configured.\n");
-                        ei_printf("       Previously we'd run a moving-average filter over your outputs in this case, but this is now disabled.\n");
-                        ei_printf("       Go to 'Performance calibration' in your Edge Impulse project to configure post-processing parameters.\n");
-                        ei_printf("       (You can enable this from 'Dashboard' if it's not visible in your project)\n");
-                        ei_printf("\n");
-
-                        has_printed_msg = true;
-                    }
+    if (impulse->sensor == EI_CLASSIFIER_SENSOR_MICROPHONE) {
+        if((void *)ctx->avg_scores != NULL && enable_maf == true) {
+            if (enable_maf && !impulse->calibration.is_configured) {
+                // perfcal is not configured, print msg first time
+                static bool has_printed_msg = false;
+
+                if (!has_printed_msg) {
+                    ei_printf("WARN: run_classifier_continuous, enable_maf is true, but performance calibration is not configured.\n");
+                    ei_printf("       Previously we'd run a moving-average filter over your outputs in this case, but this is now disabled.\n");
+                    ei_printf("       Go to 'Performance calibration' in your Edge Impulse project to configure post-processing parameters.\n");
+                    ei_printf("       (You can enable this from 'Dashboard' if it's not visible in your project)\n");
+                    ei_printf("\n");
+
+                    has_printed_msg = true;
                 }
-                else {
-                    // perfcal is configured
-                    static bool has_printed_msg = false;
+            }
+            else {
+                // perfcal is configured
+                static bool has_printed_msg = false;
 
-                    if (!has_printed_msg) {
-                        ei_printf("\nPerformance calibration is configured for your project. If no event is detected, all values are 0.\r\n\n");
-                        has_printed_msg = true;
-                    }
+                if (!has_printed_msg) {
+                    ei_printf("\nPerformance calibration is configured for your project. If no event is detected, all values are 0.\r\n\n");
+                    has_printed_msg = true;
+                }
 
-                    int label_detected = avg_scores->trigger(result->classification);
+                int label_detected = ctx->avg_scores->trigger(result->classification);
 
-                    if (avg_scores->should_boost()) {
-                        for (int i = 0; i < impulse->label_count; i++) {
-                            if (i == label_detected) {
-                                result->classification[i].value = 1.0f;
-                            }
-                            else {
-                                result->classification[i].value = 0.0f;
-                            }
+                if (ctx->avg_scores->should_boost()) {
+                    for (int i = 0; i < impulse->label_count; i++) {
+                        if (i == label_detected) {
+                            result->classification[i].value = 1.0f;
+                        }
+                        else {
+                            result->classification[i].value = 0.0f;
                         }
                     }
                 }
             }
         }
+    }
+#else
+    (void)ctx;
+    (void)impulse;
+    (void)result;
+    (void)enable_maf;
 #endif
+}
+
+/**
+ * @brief      Run the learning blocks of a continuous impulse over a window, and the
+ *             performance calibration of ctx over the results
+ *
+ * @param      ctx              classifier context that holds the calibration state
+ * @param      impulse          struct with information about model and DSP
+ * @param      classify_matrix  Normalized window (see process_impulse_continuous_window)
+ * @param      result           Output classifier results
+ * @param[in]  debug            Debug output enable
+ * @param[in]  enable_maf       Run the performance calibration
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR process_impulse_continuous_inference(ei_classifier_context_t *ctx,
+                                                             const ei_impulse_t *impulse,
+                                                             ei::matrix_t *classify_matrix,
+                                                             ei_impulse_result_t *result,
+                                                             bool debug,
+                                                             bool enable_maf)
+{
+    if (debug) {
+        ei_printf("Running impulse...\n");
     }
-    else {
-        if (!impulse->object_detection) {
-            for (int i = 0; i < impulse->label_count; i++) {
-                // set label correctly in the result struct if we have no results (otherwise is nullptr)
-                result->classification[i].label = impulse->categories[(uint32_t)i];
-            }
+
+    EI_IMPULSE_ERROR ei_impulse_error = run_inference(impulse, classify_matrix, result, debug);
+
+    process_impulse_continuous_calibration(ctx, impulse, result, enable_maf);
+
+    return ei_impulse_error;
+}
+
+#if EI_CLASSIFIER_CONTINUOUS_QUANTIZED_FEATURES && EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE)
+/**
+ * Check if a continuous impulse can normalize its features straight into the input tensor,
+ * see run_nn_inference_continuous_quantized
+ */
+static EI_IMPULSE_ERROR can_run_classifier_continuous_quantized(const ei_impulse_t *impulse) {
+    if (impulse->inferencing_engine != EI_CLASSIFIER_TFLITE) {
+        return EI_IMPULSE_UNSUPPORTED_INFERENCING_ENGINE;
+    }
+
+    // a single quantized NN, no anomaly or gate blocks that need the float features
+    if (impulse->has_anomaly == 1 || impulse->learning_blocks_size != 1 ||
+        impulse->learning_blocks[0].infer_fn != run_nn_inference) {
+        return EI_IMPULSE_UNSUPPORTED_INFERENCING_ENGINE;
+    }
+    ei_learning_block_config_tflite_graph_t *block_config =
+        (ei_learning_block_config_tflite_graph_t*)impulse->learning_blocks[0].config;
+    if (block_config->quantized != 1) {
+        return EI_IMPULSE_UNSUPPORTED_INFERENCING_ENGINE;
+    }
+
+    // over an MFCC window, the only normalization that's fused with the quantization
+    if (impulse->dsp_blocks_size != 1 || impulse->dsp_blocks[0].extract_fn != extract_mfcc_features) {
+        return EI_IMPULSE_DSP_ERROR;
+    }
+    ei_dsp_config_mfcc_t *config = (ei_dsp_config_mfcc_t *)impulse->dsp_blocks[0].config;
+    if (config->win_size % 2 == 0) {
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief      process_impulse_continuous_inference, with the features window normalized straight
+ *             into the input tensor instead of into a float window (see
+ *             can_run_classifier_continuous_quantized)
+ *
+ * @param      ctx          context to calibrate the results in
+ * @param      features_ctx context with the features window (ctx, or the one that ran the
+ *                          shared DSP, see run_classifier_continuous_multi)
+ */
+static EI_IMPULSE_ERROR process_impulse_continuous_quantized(ei_classifier_context_t *ctx,
+                                                             ei_classifier_context_t *features_ctx,
+                                                             const ei_impulse_t *impulse,
+                                                             ei_impulse_result_t *result,
+                                                             bool debug,
+                                                             bool enable_maf)
+{
+    if (debug) {
+        ei_printf("Running impulse...\n");
+    }
+
+    EI_IMPULSE_ERROR ei_impulse_error;
+    {
+#if EIDSP_LOCK_SHARED_STATE
+        std::lock_guard<std::mutex> lock(ei_run_inference_mutex());
+#endif
+        ei_impulse_error = run_nn_inference_continuous_quantized(impulse, &features_ctx->dsp, features_ctx->features,
+            result, impulse->learning_blocks[0].config, debug);
+    }
+
+    process_impulse_continuous_calibration(ctx, impulse, result, enable_maf);
+
+    return ei_impulse_error;
+}
+#endif
+
+/**
+ * @brief      Set the labels of a result for a slice where no inference ran (yet)
+ */
+static void process_impulse_continuous_no_window(const ei_impulse_t *impulse, ei_impulse_result_t *result)
+{
+    if (!impulse->object_detection) {
+        for (int i = 0; i < impulse->label_count; i++) {
+            // set label correctly in the result struct if we have no results (otherwise is nullptr)
+            result->classification[i].label = impulse->categories[(uint32_t)i];
+        }
+    }
+}
+
+/**
+ * @brief      Process a complete impulse for continuous inference
+ *
+ * @param      ctx      classifier context to keep the state between slices in
+ * @param      impulse  struct with information about model and DSP
+ * @param      signal   Sample data
+ * @param      result   Output classifier results
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+EI_IMPULSE_ERROR process_impulse_continuous(ei_classifier_context_t *ctx,
+                                            const ei_impulse_t *impulse,
+                                            signal_t *signal,
+                                            ei_impulse_result_t *result,
+                                            bool debug,
+                                            bool enable_maf)
+{
+    memset(result, 0, sizeof(ei_impulse_result_t));
+
+    EI_TRACE_BEGIN("ei_dsp");
+    EI_IMPULSE_ERROR ei_impulse_error = process_impulse_continuous_dsp(ctx, impulse, signal, result, debug);
+    EI_TRACE_END("ei_dsp");
+    if (ei_impulse_error != EI_IMPULSE_OK) {
+        return ei_impulse_error;
+    }
+
+    if (ctx->features_written >= impulse->nn_input_frame_size) {
+        // the inference phase, reuses the arena of the DSP run above
+        ei::memory::arena_scope nn_arena;
+
+#if EI_CLASSIFIER_CONTINUOUS_QUANTIZED_FEATURES && EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE)
+        if (can_run_classifier_continuous_quantized(impulse) == EI_IMPULSE_OK) {
+            EI_TRACE_BEGIN("ei_inference");
+            ei_impulse_error = process_impulse_continuous_quantized(ctx, ctx, impulse, result, debug, enable_maf);
+            EI_TRACE_END("ei_inference");
+            return ei_impulse_error;
         }
+#endif
+
+        ei::matrix_t classify_matrix(1, impulse->nn_input_frame_size);
+
+        EI_TRACE_BEGIN("ei_window");
+        process_impulse_continuous_window(ctx, impulse, &classify_matrix, result);
+        EI_TRACE_END("ei_window");
+
+        EI_TRACE_BEGIN("ei_inference");
+        ei_impulse_error = process_impulse_continuous_inference(ctx, impulse, &classify_matrix, result, debug, enable_maf);
+        EI_TRACE_END("ei_inference");
+    }
+    else {
+        process_impulse_continuous_no_window(impulse, result);
     }
 
     return ei_impulse_error;
+}
+
+/**
+ * @brief      Check whether two impulses have the same DSP front end (same single audio DSP
+ *             block, input axes and parameters), so they can be run on the same features
+ */
+static bool process_impulse_continuous_same_dsp(const ei_impulse_t *a, const ei_impulse_t *b)
+{
+    if (a->dsp_blocks_size != 1 || b->dsp_blocks_size != 1 ||
+        a->frequency != b->frequency ||
+        a->raw_samples_per_frame != b->raw_samples_per_frame ||
+        a->slice_size != b->slice_size ||
+        a->nn_input_frame_size != b->nn_input_frame_size) {
+        return false;
+    }
+
+    const ei_model_dsp_t *block_a = &a->dsp_blocks[0];
+    const ei_model_dsp_t *block_b = &b->dsp_blocks[0];
 
+    if (block_a->extract_fn != block_b->extract_fn ||
+        block_a->n_output_features != block_b->n_output_features ||
+        block_a->axes_size != block_b->axes_size) {
+        return false;
+    }
+    // same number of axes isn't enough, the block has to read the same ones of the signal
+    for (size_t ix = 0; ix < block_a->axes_size; ix++) {
+        if (block_a->axes[ix] != block_b->axes[ix]) {
+            return false;
+        }
+    }
+    if (block_a->config == block_b->config) {
+        return true;
+    }
 
+    // block ids may differ between projects, everything else has to match
+    if (block_a->extract_fn == extract_mfcc_features) {
+        const ei_dsp_config_mfcc_t *ca = (const ei_dsp_config_mfcc_t *)block_a->config;
+        const ei_dsp_config_mfcc_t *cb = (const ei_dsp_config_mfcc_t *)block_b->config;
+        return ca->implementation_version == cb->implementation_version &&
+            ca->num_cepstral == cb->num_cepstral &&
+            ca->frame_length == cb->frame_length &&
+            ca->frame_stride == cb->frame_stride &&
+            ca->num_filters == cb->num_filters &&
+            ca->fft_length == cb->fft_length &&
+            ca->win_size == cb->win_size &&
+            ca->low_frequency == cb->low_frequency &&
+            ca->high_frequency == cb->high_frequency &&
+            ca->pre_cof == cb->pre_cof &&
+            ca->pre_shift == cb->pre_shift;
+    }
+    else if (block_a->extract_fn == extract_mfe_features) {
+        const ei_dsp_config_mfe_t *ca = (const ei_dsp_config_mfe_t *)block_a->config;
+        const ei_dsp_config_mfe_t *cb = (const ei_dsp_config_mfe_t *)block_b->config;
+        return ca->implementation_version == cb->implementation_version &&
+            ca->frame_length == cb->frame_length &&
+            ca->frame_stride == cb->frame_stride &&
+            ca->num_filters == cb->num_filters &&
+            ca->fft_length == cb->fft_length &&
+            ca->low_frequency == cb->low_frequency &&
+            ca->high_frequency == cb->high_frequency &&
+            ca->win_size == cb->win_size &&
+            ca->noise_floor_db == cb->noise_floor_db;
+    }
+    else if (block_a->extract_fn == extract_spectrogram_features) {
+        const ei_dsp_config_spectrogram_t *ca = (const ei_dsp_config_spectrogram_t *)block_a->config;
+        const ei_dsp_config_spectrogram_t *cb = (const ei_dsp_config_spectrogram_t *)block_b->config;
+        return ca->implementation_version == cb->implementation_version &&
+            ca->frame_length == cb->frame_length &&
+            ca->frame_stride == cb->frame_stride &&
+            ca->fft_length == cb->fft_length &&
+            ca->noise_floor_db == cb->noise_floor_db;
+    }
+
+    return false;
+}
+
+/**
+ * @brief      Process a complete impulse for continuous inference, in the default context
+ */
+extern "C" EI_IMPULSE_ERROR process_impulse_continuous(const ei_impulse_t *impulse,
+                                            signal_t *signal,
+                                            ei_impulse_result_t *result,
+                                            bool debug,
+                                            bool enable_maf)
+{
+    return process_impulse_continuous(&ei_default_classifier_context, impulse, signal, result, debug, enable_maf);
 }
 
 /**
@@ -519,49 +861,120 @@ extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
 to preserve backwards compatibility. */
 
 /**
- * @brief      Init static vars
+ * @brief      Init a classifier context, for multi-model / multi-thread support
  */
-extern "C" void run_classifier_init()
+__attribute__((unused)) void run_classifier_init(ei_classifier_context_t *ctx, const ei_impulse_t *impulse)
 {
+    ctx->features_written = 0;
+    ei_dsp_clear_continuous_audio_state(&ctx->dsp);
 
-    classifier_continuous_features_written = 0;
-    ei_dsp_clear_continuous_audio_state();
+    if (ctx->features && ctx->features->cols != impulse->nn_input_frame_size) {
+        delete ctx->features;
+        ctx->features = nullptr;
+    }
 
 #if EI_CLASSIFIER_CALIBRATION_ENABLED
+    const ei_model_performance_calibration_t *calibration = &impulse->calibration;
 
-    const ei_impulse_t impulse = ei_default_impulse;
-    const ei_model_performance_calibration_t *calibration = &impulse.calibration;
+    if (ctx->avg_scores != NULL) {
+        delete ctx->avg_scores;
+        ctx->avg_scores = NULL;
+    }
 
     if(calibration != NULL) {
-        avg_scores = new RecognizeEvents(calibration,
-            impulse.label_count, impulse.slice_size, impulse.interval_ms);
+        ctx->avg_scores = new RecognizeEvents(calibration,
+            impulse->label_count, impulse->slice_size, impulse->interval_ms);
+    }
+#endif
+}
+
+/**
+ * @brief      Set up the DSP arena, or the memory plan that also holds the tensor arena
+ */
+static void run_classifier_init_arena()
+{
+#if EI_CLASSIFIER_MEMORY_PLAN
+    ei_memory_plan_init();
+#elif EIDSP_ARENA_SIZE > 0
+    if (!ei::memory::arena_init(EIDSP_ARENA_SIZE)) {
+        ei_printf("WARN: Failed to allocate the DSP arena (%d bytes), using the heap\n", EIDSP_ARENA_SIZE);
     }
 #endif
 }
 
+/**
+ * @brief      Init static vars
+ */
+extern "C" void run_classifier_init()
+{
+    run_classifier_init_arena();
+
+    const ei_impulse_t impulse = ei_default_impulse;
+    run_classifier_init(&ei_default_classifier_context, &impulse);
+}
+
 /**
  * @brief      Init static vars, for multi-model support
  */
 __attribute__((unused)) void run_classifier_init(const ei_impulse_t *impulse)
 {
-    classifier_continuous_features_written = 0;
-    ei_dsp_clear_continuous_audio_state();
+    run_classifier_init_arena();
 
-#if EI_CLASSIFIER_CALIBRATION_ENABLED
-    const ei_model_performance_calibration_t *calibration = &impulse->calibration;
+    run_classifier_init(&ei_default_classifier_context, impulse);
+}
 
-    if(calibration != NULL) {
-        avg_scores = new RecognizeEvents(calibration,
-            impulse->label_count, impulse->slice_size, impulse->interval_ms);
+#if EI_CLASSIFIER_PROFILE_OPS
+/**
+ * @brief      Collect per-op timing, MACs and tensor arena usage of the neural network
+ *             in `profiler` (print with profiler->Log()), pass nullptr to stop profiling
+ */
+__attribute__((unused)) void ei_classifier_set_op_profiler(EiOpProfiler *profiler)
+{
+    ei_op_profiler_active = profiler;
+}
+#endif // EI_CLASSIFIER_PROFILE_OPS
+
+/**
+ * @brief      Run `filter` over every slice passed to run_classifier_continuous before the
+ *             audio DSP, keeping its state between slices (nullptr to remove it). The
+ *             filter is owned by the caller and has to outlive the context.
+ */
+__attribute__((unused)) void run_classifier_set_stream_filter(ei_classifier_context_t *ctx, ei::spectral::stream_filter *filter)
+{
+    ctx->dsp.filter = filter;
+    if (filter) {
+        filter->reset();
     }
-#endif
 }
 
-extern "C" void run_classifier_deinit(void)
+/**
+ * @brief      Free everything held by a classifier context
+ */
+__attribute__((unused)) void run_classifier_deinit(ei_classifier_context_t *ctx)
 {
-    if((void *)avg_scores != NULL) {
-        delete avg_scores;
+    if((void *)ctx->avg_scores != NULL) {
+        delete ctx->avg_scores;
+        ctx->avg_scores = NULL;
     }
+
+    delete ctx->features;
+    ctx->features = nullptr;
+    ctx->features_written = 0;
+
+    ei_dsp_clear_continuous_audio_state(&ctx->dsp);
+}
+
+extern "C" void run_classifier_deinit(void)
+{
+    run_classifier_deinit(&ei_default_classifier_context);
+
+#if EI_CLASSIFIER_PERSISTENT_INTERPRETER > 0 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE)
+    inference_tflite_teardown();
+#endif
+
+#if EIDSP_ARENA_SIZE > 0
+    ei::memory::arena_deinit();
+#endif
 }
 
 /**
@@ -581,7 +994,7 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(
     bool enable_maf = true)
 {
     const ei_impulse_t impulse = ei_default_impulse;
-    return process_impulse_continuous(&impulse, signal, result, debug, enable_maf);
+    return process_impulse_continuous(&ei_default_classifier_context, &impulse, signal, result, debug, enable_maf);
 }
 
 /**
@@ -602,7 +1015,131 @@ __attribute__((unused)) EI_IMPULSE_ERROR run_classifier_continuous(
     bool debug = false,
     bool enable_maf = true)
 {
-    return process_impulse_continuous(impulse, signal, result, debug, enable_maf);
+    return process_impulse_continuous(&ei_default_classifier_context, impulse, signal, result, debug, enable_maf);
+}
+
+/**
+ * @brief      Fill the complete matrix with sample slices. From there, run impulse
+ *             on the matrix.
+ *
+ * @param      ctx     classifier context (set up with run_classifier_init)
+ * @param      impulse struct with information about model and DSP
+ * @param      signal  Sample data
+ * @param      result  Classification output
+ * @param[in]  debug   Debug output enable boot
+ *
+ * @return     The ei impulse error.
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_continuous(
+    ei_classifier_context_t *ctx,
+    const ei_impulse_t *impulse,
+    signal_t *signal,
+    ei_impulse_result_t *result,
+    bool debug = false,
+    bool enable_maf = true)
+{
+    return process_impulse_continuous(ctx, impulse, signal, result, debug, enable_maf);
+}
+
+/**
+ * @brief      Run several impulses that share a DSP front end (e.g. keyword models trained
+ *             with the same MFCC parameters) over a slice. The DSP only runs once, for
+ *             impulses[0], and the learning blocks of every impulse run on the same window,
+ *             so adding models doesn't add DSP time.
+ *
+ * @param      ctxs          impulse_count classifier contexts, ctxs[i] set up with
+ *                           run_classifier_init(&ctxs[i], impulses[i]). The DSP state and
+ *                           features live in ctxs[0], the others only keep their calibration
+ * @param      impulses      impulse_count impulses, all with the same DSP block and parameters
+ * @param      impulse_count Number of impulses
+ * @param      signal        Sample data
+ * @param      results       impulse_count classification outputs, results[i] for impulses[i]
+ * @param[in]  debug         Debug output enable boot
+ *
+ * @return     The ei impulse error.
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_continuous_multi(
+    ei_classifier_context_t *ctxs,
+    const ei_impulse_t **impulses,
+    size_t impulse_count,
+    signal_t *signal,
+    ei_impulse_result_t *results,
+    bool debug = false,
+    bool enable_maf = true)
+{
+    if (impulse_count == 0) {
+        return EI_IMPULSE_OK;
+    }
+
+    for (size_t ix = 1; ix < impulse_count; ix++) {
+        if (!process_impulse_continuous_same_dsp(impulses[0], impulses[ix])) {
+            ei_printf("ERR: Impulse %d does not have the same DSP block as impulse 0\n", (int)ix);
+            return EI_IMPULSE_DSP_ERROR;
+        }
+    }
+
+    memset(results, 0, impulse_count * sizeof(ei_impulse_result_t));
+
+    ei_classifier_context_t *dsp_ctx = &ctxs[0];
+    EI_TRACE_BEGIN("ei_dsp");
+    EI_IMPULSE_ERROR ei_impulse_error = process_impulse_continuous_dsp(dsp_ctx, impulses[0], signal, &results[0], debug);
+    EI_TRACE_END("ei_dsp");
+    if (ei_impulse_error != EI_IMPULSE_OK) {
+        return ei_impulse_error;
+    }
+
+    if (dsp_ctx->features_written < impulses[0]->nn_input_frame_size) {
+        for (size_t ix = 0; ix < impulse_count; ix++) {
+            results[ix].timing = results[0].timing;
+            process_impulse_continuous_no_window(impulses[ix], &results[ix]);
+        }
+        return EI_IMPULSE_OK;
+    }
+
+    ei::memory::arena_scope nn_arena;
+
+    // the float window is only needed by impulses that can't normalize the shared features
+    // straight into their own input tensor
+    bool float_window = true;
+#if EI_CLASSIFIER_CONTINUOUS_QUANTIZED_FEATURES && EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE)
+    float_window = false;
+    for (size_t ix = 0; ix < impulse_count; ix++) {
+        if (can_run_classifier_continuous_quantized(impulses[ix]) != EI_IMPULSE_OK) {
+            float_window = true;
+        }
+    }
+#endif
+
+    ei::matrix_t classify_matrix(1, float_window ? impulses[0]->nn_input_frame_size : 1);
+    if (float_window) {
+        EI_TRACE_BEGIN("ei_window");
+        process_impulse_continuous_window(dsp_ctx, impulses[0], &classify_matrix, &results[0]);
+        EI_TRACE_END("ei_window");
+    }
+    const ei_impulse_result_timing_t dsp_timing = results[0].timing;
+
+    for (size_t ix = 0; ix < impulse_count; ix++) {
+        results[ix].timing = dsp_timing;
+
+        EI_TRACE_BEGIN("ei_inference");
+#if EI_CLASSIFIER_CONTINUOUS_QUANTIZED_FEATURES && EI_CLASSIFIER_QUANTIZATION_ENABLED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE)
+        if (can_run_classifier_continuous_quantized(impulses[ix]) == EI_IMPULSE_OK) {
+            ei_impulse_error = process_impulse_continuous_quantized(&ctxs[ix], dsp_ctx, impulses[ix],
+                &results[ix], debug, enable_maf);
+        }
+        else
+#endif
+        {
+            ei_impulse_error = process_impulse_continuous_inference(&ctxs[ix], impulses[ix], &classify_matrix,
+                &results[ix], debug, enable_maf);
+        }
+        EI_TRACE_END("ei_inference");
+        if (ei_impulse_error != EI_IMPULSE_OK) {
+            return ei_impulse_error;
+        }
+    }
+
+    return EI_IMPULSE_OK;
 }
 
 /**
@@ -638,6 +1175,69 @@ __attribute__((unused)) EI_IMPULSE_ERROR run_classifier(
     return process_impulse(impulse, signal, result, debug);
 }
 
+/**
+ * Run the learning blocks over a batch of feature windows (already processed by the DSP
+ * blocks, e.g. for replaying recorded audio or catching up on a backlog of windows)
+ * @param impulse struct with information about model and DSP
+ * @param features Features matrix, one window (nn_input_frame_size features) per row
+ * @param results Array of features->rows objects to store the results in
+ * @param debug Whether to show debug messages (default: false)
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_batch(
+    const ei_impulse_t *impulse,
+    ei::matrix_t *features,
+    ei_impulse_result_t *results,
+    bool debug = false)
+{
+    if (features->cols != impulse->nn_input_frame_size) {
+        ei_printf("ERR: Features matrix has %d columns, expected %d\n",
+            (int)features->cols, (int)impulse->nn_input_frame_size);
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+
+    if (features->rows == 0) {
+        return EI_IMPULSE_OK;
+    }
+
+    memset(results, 0, features->rows * sizeof(ei_impulse_result_t));
+
+#if EI_CLASSIFIER_COMPILED == 1
+    // single compiled network: set the model up once for the whole batch
+    if (impulse->learning_blocks_size == 1 && impulse->learning_blocks[0].infer_fn == run_nn_inference) {
+#if EIDSP_LOCK_SHARED_STATE
+        std::lock_guard<std::mutex> lock(ei_run_inference_mutex());
+#endif
+        return run_nn_inference_batch(impulse, features, results, impulse->learning_blocks[0].config, debug);
+    }
+#endif
+
+    for (size_t row = 0; row < features->rows; row++) {
+        ei::matrix_t window(1, features->cols, features->buffer + (row * features->cols));
+
+        EI_IMPULSE_ERROR res = run_inference(impulse, &window, &results[row], debug);
+        if (res != EI_IMPULSE_OK) {
+            return res;
+        }
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Run the classifier over a batch of feature windows
+ * @param features Features matrix, one window (nn_input_frame_size features) per row
+ * @param results Array of features->rows objects to store the results in
+ * @param debug Whether to show debug messages (default: false)
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_batch(
+    ei::matrix_t *features,
+    ei_impulse_result_t *results,
+    bool debug = false)
+{
+    const ei_impulse_t impulse = ei_default_impulse;
+    return run_classifier_batch(&impulse, features, results, debug);
+}
+
 /* Deprecated functions ------------------------------------------------------- */
 
 /* These functions are being deprecated and possibly will be removed or moved in future.
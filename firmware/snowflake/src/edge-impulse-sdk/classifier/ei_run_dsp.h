@@ -42,10 +42,204 @@ using namespace ei;
 float ei_dsp_image_buffer[EI_DSP_IMAGE_BUFFER_STATIC_SIZE];
 #endif
 
-// this is the frame we work on... allocate it statically so we share between invocations
-static float *ei_dsp_cont_current_frame = nullptr;
-static size_t ei_dsp_cont_current_frame_size = 0;
-static int ei_dsp_cont_current_frame_ix = 0;
+/**
+ * State the continuous audio DSP keeps between slices, there's one per classifier
+ * context (see ei_classifier_context_t in ei_run_classifier.h)
+ */
+typedef struct ei_dsp_cont_state {
+    // this is the frame we work on, kept between invocations
+    // it's used as a ring buffer: the frame starts at current_frame_head and moves
+    // forward by the frame stride instead of shifting the samples down
+    float *current_frame;
+    size_t current_frame_size;
+    int current_frame_ix;
+    size_t current_frame_head;
+
+    // the continuous features matrix is a ring buffer as well (continuous inference runs a single
+    // audio DSP block): new rows are written at this offset, which is also where the oldest
+    // features start once the buffer has wrapped
+    size_t features_head;
+
+    // optional streaming filter (e.g. a high pass), runs once over every new slice before the
+    // DSP, so its delay line carries over between slices; the filtered slice goes in filter_buffer
+    spectral::stream_filter *filter;
+    float *filter_buffer;
+    size_t filter_buffer_size;
+} ei_dsp_cont_state_t;
+
+// state of the default classifier context
+static ei_dsp_cont_state_t ei_dsp_cont_default_state = { };
+
+/**
+ * Read from the (circular) continuous frame buffer, in frame order
+ */
+static int ei_dsp_cont_current_frame_get_data(ei_dsp_cont_state_t *state, size_t offset, size_t length, float *out_ptr) {
+    if (offset + length > state->current_frame_size) {
+        EIDSP_ERR(EIDSP_OUT_OF_BOUNDS);
+    }
+
+    size_t start = (state->current_frame_head + offset) % state->current_frame_size;
+    size_t first = state->current_frame_size - start;
+    if (first > length) {
+        first = length;
+    }
+
+    memcpy(out_ptr, state->current_frame + start, first * sizeof(float));
+    memcpy(out_ptr + first, state->current_frame, (length - first) * sizeof(float));
+
+    return EIDSP_OK;
+}
+
+#if EIDSP_SIGNAL_C_FN_POINTER
+// plain function pointers can't carry any state, so signals are bound through these
+// instead and only one DSP run can be in flight at a time
+static ei_dsp_cont_state_t *ei_dsp_bound_cont_state = nullptr;
+static int ei_dsp_bound_cont_frame_get_data(size_t offset, size_t length, float *out_ptr) {
+    return ei_dsp_cont_current_frame_get_data(ei_dsp_bound_cont_state, offset, length, out_ptr);
+}
+#endif
+
+/**
+ * Make `signal` read from the continuous frame of `state`
+ */
+static void ei_dsp_cont_frame_signal(signal_t *signal, ei_dsp_cont_state_t *state) {
+    signal->total_length = state->current_frame_size;
+#if EIDSP_SIGNAL_C_FN_POINTER
+    ei_dsp_bound_cont_state = state;
+    signal->get_data = &ei_dsp_bound_cont_frame_get_data;
+#else
+    signal->get_data = [state](size_t offset, size_t length, float *out_ptr) {
+        return ei_dsp_cont_current_frame_get_data(state, offset, length, out_ptr);
+    };
+#endif
+}
+
+#if EIDSP_SIGNAL_C_FN_POINTER
+static ei_dsp_cont_state_t *ei_dsp_bound_filter_state = nullptr;
+static int ei_dsp_bound_filter_get_data(size_t offset, size_t length, float *out_ptr) {
+    return numpy::signal_get_data(ei_dsp_bound_filter_state->filter_buffer, offset, length, out_ptr);
+}
+#endif
+
+/**
+ * Run the streaming filter of `state` over a new slice and make `filtered` read the result,
+ * returns the signal the DSP should use (`signal` itself if there's no filter)
+ */
+static signal_t *ei_dsp_cont_filter_slice(ei_dsp_cont_state_t *state, signal_t *signal, signal_t *filtered, int *ret) {
+    *ret = EIDSP_OK;
+    if (!state->filter) {
+        return signal;
+    }
+
+    if (state->filter_buffer && state->filter_buffer_size != signal->total_length) {
+        ei_free(state->filter_buffer);
+        state->filter_buffer = nullptr;
+    }
+    if (!state->filter_buffer) {
+        state->filter_buffer = (float*)ei_calloc(signal->total_length * sizeof(float), 1);
+        if (!state->filter_buffer) {
+            *ret = EIDSP_OUT_OF_MEM;
+            return nullptr;
+        }
+        state->filter_buffer_size = signal->total_length;
+    }
+
+    *ret = signal->get_data(0, signal->total_length, state->filter_buffer);
+    if (*ret == EIDSP_OK) {
+        *ret = state->filter->run(state->filter_buffer, state->filter_buffer, signal->total_length);
+    }
+    if (*ret != EIDSP_OK) {
+        return nullptr;
+    }
+
+    filtered->total_length = signal->total_length;
+#if EIDSP_SIGNAL_C_FN_POINTER
+    ei_dsp_bound_filter_state = state;
+    filtered->get_data = &ei_dsp_bound_filter_get_data;
+#else
+    float *buffer = state->filter_buffer;
+    filtered->get_data = [buffer](size_t offset, size_t length, float *out_ptr) {
+        return numpy::signal_get_data(buffer, offset, length, out_ptr);
+    };
+#endif
+    return filtered;
+}
+
+/**
+ * Complete the continuous frame: read `length` values from the start of the signal
+ * into the frame, directly after the `current_frame_ix` values already in there
+ */
+static int ei_dsp_cont_current_frame_fill(ei_dsp_cont_state_t *state, signal_t *signal, size_t length) {
+    size_t start = (state->current_frame_head + state->current_frame_ix) % state->current_frame_size;
+    size_t first = state->current_frame_size - start;
+    if (first > length) {
+        first = length;
+    }
+
+    int x = signal->get_data(0, first, state->current_frame + start);
+    if (x != EIDSP_OK) {
+        return x;
+    }
+    if (length > first) {
+        x = signal->get_data(first, length - first, state->current_frame);
+    }
+    return x;
+}
+
+/**
+ * Where a slice of `slice_size` continuous features should be written. If it fits before the
+ * end of the features ring this points straight into the ring, otherwise it's nullptr and the
+ * slice needs its own buffer; either way call ei_dsp_cont_features_commit afterwards.
+ */
+static float *ei_dsp_cont_features_slice_buffer(ei_dsp_cont_state_t *state, matrix_t *ring, size_t slice_size) {
+    if (state->features_head + slice_size <= ring->rows * ring->cols) {
+        return ring->buffer + state->features_head;
+    }
+    return nullptr;
+}
+
+/**
+ * Store a slice obtained through ei_dsp_cont_features_slice_buffer in the ring and advance the head
+ */
+static void ei_dsp_cont_features_commit(ei_dsp_cont_state_t *state, matrix_t *ring, matrix_t *slice) {
+    const size_t ring_size = ring->rows * ring->cols;
+    const size_t slice_size = slice->rows * slice->cols;
+
+    if (slice->buffer != ring->buffer + state->features_head) {
+        // wraps around the end of the ring, copy in two segments
+        const size_t first = ring_size - state->features_head;
+        memcpy(ring->buffer + state->features_head, slice->buffer, first * sizeof(float));
+        memcpy(ring->buffer, slice->buffer + first, (slice_size - first) * sizeof(float));
+    }
+
+    state->features_head = (state->features_head + slice_size) % ring_size;
+}
+
+/**
+ * Copy the continuous features ring into `out` in chronological order (oldest first),
+ * this is the only place where the window is materialised
+ */
+__attribute__((unused)) static void ei_dsp_cont_features_linearize(ei_dsp_cont_state_t *state, const float *ring, size_t ring_size, float *out) {
+    const size_t head = state->features_head % ring_size;
+    memcpy(out, ring + head, (ring_size - head) * sizeof(float));
+    memcpy(out + (ring_size - head), ring, head * sizeof(float));
+}
+
+/**
+ * Normalize the MFCC features window like calc_cepstral_mean_and_var_normalization_mfcc and
+ * quantize it into `output_matrix` (the input tensor), reading the features ring in place instead
+ * of linearizing it first
+ */
+__attribute__((unused)) static int ei_dsp_cont_features_quantize_mfcc(ei_dsp_cont_state_t *state, const matrix_t *ring,
+    void *config_ptr, float scale, float zero_point, matrix_i8_t *output_matrix)
+{
+    ei_dsp_config_mfcc_t *config = (ei_dsp_config_mfcc_t *)config_ptr;
+
+    const size_t ring_size = ring->rows * ring->cols;
+
+    return speechpy::processing::cmvnw_quantize(ring->buffer, state->features_head % ring_size,
+        ring_size / config->num_cepstral, config->num_cepstral, config->win_size, scale, zero_point, output_matrix);
+}
 
 __attribute__((unused)) int extract_spectral_analysis_features(
     signal_t *signal,
@@ -236,9 +430,72 @@ __attribute__((unused)) int extract_flatten_features(signal_t *signal, matrix_t
     return EIDSP_OK;
 }
 
-static class speechpy::processing::preemphasis *preemphasis;
-static int preemphasized_audio_signal_get_data(size_t offset, size_t length, float *out_ptr) {
-    return preemphasis->get_data(offset, length, out_ptr);
+#if EIDSP_SIGNAL_C_FN_POINTER
+static class speechpy::processing::preemphasis *ei_dsp_bound_preemphasis = nullptr;
+static int ei_dsp_bound_preemphasis_get_data(size_t offset, size_t length, float *out_ptr) {
+    return ei_dsp_bound_preemphasis->get_data(offset, length, out_ptr);
+}
+#endif
+
+/**
+ * Make `signal` read the preemphasized audio from `pre`
+ */
+static void ei_dsp_preemphasized_signal(signal_t *signal, class speechpy::processing::preemphasis *pre) {
+#if EIDSP_SIGNAL_C_FN_POINTER
+    ei_dsp_bound_preemphasis = pre;
+    signal->get_data = &ei_dsp_bound_preemphasis_get_data;
+#else
+    signal->get_data = [pre](size_t offset, size_t length, float *out_ptr) {
+        return pre->get_data(offset, length, out_ptr);
+    };
+#endif
+}
+
+#if EI_DSP_PARAMS_GENERATED && defined(EI_DSP_PARAMS_MFCC_NUM_CEPSTRAL)
+// MFCC specialised for the block in model_metadata.h, see speechpy::mfcc_static
+typedef speechpy::mfcc_static<
+    EI_CLASSIFIER_FREQUENCY,
+    speechpy::mfcc_static_frame_samples(EI_CLASSIFIER_FREQUENCY, EI_DSP_PARAMS_MFCC_FRAME_LENGTH),
+    speechpy::mfcc_static_frame_samples(EI_CLASSIFIER_FREQUENCY, EI_DSP_PARAMS_MFCC_FRAME_STRIDE),
+    EI_DSP_PARAMS_MFCC_NUM_CEPSTRAL, EI_DSP_PARAMS_MFCC_NUM_FILTERS, EI_DSP_PARAMS_MFCC_FFT_LENGTH,
+    EI_DSP_PARAMS_MFCC_LOW_FREQUENCY, EI_DSP_PARAMS_MFCC_HIGH_FREQUENCY,
+    EI_DSP_PARAMS_MFCC_IMPLEMENTATION_VERSION> ei_dsp_mfcc_static_t;
+#endif
+
+/**
+ * Run the MFCC (with DC elimination) for a config, uses the specialised version when the
+ * config is the one the model parameters were generated for
+ */
+static int ei_dsp_mfcc(matrix_t *out_features, signal_t *signal, uint32_t frequency,
+    const ei_dsp_config_mfcc_t *config, int implementation_version)
+{
+#if EI_DSP_PARAMS_GENERATED && defined(EI_DSP_PARAMS_MFCC_NUM_CEPSTRAL)
+    if (frequency == EI_CLASSIFIER_FREQUENCY &&
+        implementation_version == EI_DSP_PARAMS_MFCC_IMPLEMENTATION_VERSION &&
+        config->num_cepstral == EI_DSP_PARAMS_MFCC_NUM_CEPSTRAL &&
+        // in samples, as the frames are cut, not the seconds as floats
+        speechpy::mfcc_static_frame_samples(frequency, config->frame_length) ==
+            speechpy::mfcc_static_frame_samples(EI_CLASSIFIER_FREQUENCY, EI_DSP_PARAMS_MFCC_FRAME_LENGTH) &&
+        speechpy::mfcc_static_frame_samples(frequency, config->frame_stride) ==
+            speechpy::mfcc_static_frame_samples(EI_CLASSIFIER_FREQUENCY, EI_DSP_PARAMS_MFCC_FRAME_STRIDE) &&
+        config->num_filters == EI_DSP_PARAMS_MFCC_NUM_FILTERS &&
+        config->fft_length == EI_DSP_PARAMS_MFCC_FFT_LENGTH &&
+        config->low_frequency == EI_DSP_PARAMS_MFCC_LOW_FREQUENCY &&
+        config->high_frequency == EI_DSP_PARAMS_MFCC_HIGH_FREQUENCY) {
+        return ei_dsp_mfcc_static_t::mfcc(out_features, signal);
+    }
+
+    // e.g. a re-exported model whose MFCC no longer matches the EI_DSP_PARAMS_MFCC_* in model_metadata.h
+    static bool has_printed_msg = false;
+    if (!has_printed_msg) {
+        ei_printf("WARN: MFCC config doesn't match EI_DSP_PARAMS_MFCC_*, running the generic MFCC\n");
+        has_printed_msg = true;
+    }
+#endif
+
+    return speechpy::feature::mfcc(out_features, signal,
+        frequency, config->frame_length, config->frame_stride, config->num_cepstral, config->num_filters, config->fft_length,
+        config->low_frequency, config->high_frequency, true, implementation_version);
 }
 
 __attribute__((unused)) int extract_mfcc_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency) {
@@ -260,11 +517,10 @@ __attribute__((unused)) int extract_mfcc_features(signal_t *signal, matrix_t *ou
 
     // preemphasis class to preprocess the audio...
     class speechpy::processing::preemphasis pre(signal, config.pre_shift, config.pre_cof, false);
-    preemphasis = &pre;
 
     signal_t preemphasized_audio_signal;
     preemphasized_audio_signal.total_length = signal->total_length;
-    preemphasized_audio_signal.get_data = &preemphasized_audio_signal_get_data;
+    ei_dsp_preemphasized_signal(&preemphasized_audio_signal, &pre);
 
     // calculate the size of the MFCC matrix
     matrix_size_t out_matrix_size =
@@ -281,9 +537,8 @@ __attribute__((unused)) int extract_mfcc_features(signal_t *signal, matrix_t *ou
     output_matrix->cols = out_matrix_size.cols;
 
     // and run the MFCC extraction
-    int ret = speechpy::feature::mfcc(output_matrix, &preemphasized_audio_signal,
-        frequency, config.frame_length, config.frame_stride, config.num_cepstral, config.num_filters, config.fft_length,
-        config.low_frequency, config.high_frequency, true, config.implementation_version);
+    int ret = ei_dsp_mfcc(output_matrix, &preemphasized_audio_signal, frequency, &config,
+        config.implementation_version);
     if (ret != EIDSP_OK) {
         ei_printf("ERR: MFCC failed (%d)\n", ret);
         EIDSP_ERR(ret);
@@ -303,7 +558,7 @@ __attribute__((unused)) int extract_mfcc_features(signal_t *signal, matrix_t *ou
 }
 
 
-static int extract_mfcc_run_slice(signal_t *signal, matrix_t *output_matrix, ei_dsp_config_mfcc_t *config, const float sampling_frequency, matrix_size_t *matrix_size_out, int implementation_version) {
+static int extract_mfcc_run_slice(ei_dsp_cont_state_t *state, signal_t *signal, matrix_t *output_matrix, ei_dsp_config_mfcc_t *config, const float sampling_frequency, matrix_size_t *matrix_size_out, int implementation_version) {
     uint32_t frequency = (uint32_t)sampling_frequency;
 
     int x;
@@ -314,29 +569,28 @@ static int extract_mfcc_run_slice(signal_t *signal, matrix_t *output_matrix, ei_
             signal->total_length, frequency, config->frame_length, config->frame_stride, config->num_cepstral,
             implementation_version);
 
-    // we roll the output matrix back so we have room at the end...
-    x = numpy::roll(output_matrix->buffer, output_matrix->rows * output_matrix->cols,
-        -(out_matrix_size.rows * out_matrix_size.cols));
-    if (x != EIDSP_OK) {
-        EIDSP_ERR(x);
+    // the output matrix is a ring buffer, so instead of rolling it back we write
+    // the new slice at the head (in place, unless it wraps around the end)
+    const size_t out_matrix_slice_size = out_matrix_size.rows * out_matrix_size.cols;
+    if (out_matrix_slice_size > output_matrix->rows * output_matrix->cols) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
     }
 
-    // slice in the output matrix to write to
-    // the offset in the classification matrix here is always at the end
-    size_t output_matrix_offset = (output_matrix->rows * output_matrix->cols) -
-        (out_matrix_size.rows * out_matrix_size.cols);
-
-    matrix_t output_matrix_slice(out_matrix_size.rows, out_matrix_size.cols, output_matrix->buffer + output_matrix_offset);
+    matrix_t output_matrix_slice(out_matrix_size.rows, out_matrix_size.cols,
+        ei_dsp_cont_features_slice_buffer(state, output_matrix, out_matrix_slice_size));
+    if (out_matrix_slice_size > 0 && !output_matrix_slice.buffer) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
 
     // and run the MFCC extraction
-    x = speechpy::feature::mfcc(&output_matrix_slice, signal,
-        frequency, config->frame_length, config->frame_stride, config->num_cepstral, config->num_filters, config->fft_length,
-        config->low_frequency, config->high_frequency, true, implementation_version);
+    x = ei_dsp_mfcc(&output_matrix_slice, signal, frequency, config, implementation_version);
     if (x != EIDSP_OK) {
         ei_printf("ERR: MFCC failed (%d)\n", x);
         EIDSP_ERR(x);
     }
 
+    ei_dsp_cont_features_commit(state, output_matrix, &output_matrix_slice);
+
     matrix_size_out->rows += out_matrix_size.rows;
     if (out_matrix_size.cols > 0) {
         matrix_size_out->cols = out_matrix_size.cols;
@@ -345,7 +599,7 @@ static int extract_mfcc_run_slice(signal_t *signal, matrix_t *output_matrix, ei_
     return EIDSP_OK;
 }
 
-__attribute__((unused)) int extract_mfcc_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency, matrix_size_t *matrix_size_out) {
+__attribute__((unused)) int extract_mfcc_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency, matrix_size_t *matrix_size_out, ei_dsp_cont_state_t *state = &ei_dsp_cont_default_state) {
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
     ei_printf("ERR: Continuous audio is not supported when EI_C_LINKAGE is defined\n");
     EIDSP_ERR(EIDSP_NOT_SUPPORTED);
@@ -365,15 +619,22 @@ __attribute__((unused)) int extract_mfcc_per_slice_features(signal_t *signal, ma
         EIDSP_ERR(EIDSP_PARAMETER_INVALID);
     }
 
+    // streaming filter (if any) over the new samples only
+    signal_t filtered_signal;
+    int filter_ret;
+    signal = ei_dsp_cont_filter_slice(state, signal, &filtered_signal, &filter_ret);
+    if (filter_ret != EIDSP_OK) {
+        EIDSP_ERR(filter_ret);
+    }
+
     const uint32_t frequency = static_cast<uint32_t>(sampling_frequency);
 
     // preemphasis class to preprocess the audio...
     class speechpy::processing::preemphasis pre(signal, config.pre_shift, config.pre_cof, false);
-    preemphasis = &pre;
 
     signal_t preemphasized_audio_signal;
     preemphasized_audio_signal.total_length = signal->total_length;
-    preemphasized_audio_signal.get_data = &preemphasized_audio_signal_get_data;
+    ei_dsp_preemphasized_signal(&preemphasized_audio_signal, &pre);
 
     // Go from the time (e.g. 0.25 seconds to number of frames based on freq)
     const size_t frame_length_values = frequency * config.frame_length;
@@ -392,9 +653,9 @@ __attribute__((unused)) int extract_mfcc_per_slice_features(signal_t *signal, ma
     int x;
 
     // have current frame, but wrong size? then free
-    if (ei_dsp_cont_current_frame && ei_dsp_cont_current_frame_size != frame_length_values) {
-        ei_free(ei_dsp_cont_current_frame);
-        ei_dsp_cont_current_frame = nullptr;
+    if (state->current_frame && state->current_frame_size != frame_length_values) {
+        ei_free(state->current_frame);
+        state->current_frame = nullptr;
     }
 
     int implementation_version = config.implementation_version;
@@ -402,19 +663,20 @@ __attribute__((unused)) int extract_mfcc_per_slice_features(signal_t *signal, ma
     // this is the offset in the signal from which we'll work
     size_t offset_in_signal = 0;
 
-    if (!ei_dsp_cont_current_frame) {
-        ei_dsp_cont_current_frame = (float*)ei_calloc(frame_length_values * sizeof(float), 1);
-        if (!ei_dsp_cont_current_frame) {
+    if (!state->current_frame) {
+        state->current_frame = (float*)ei_calloc(frame_length_values * sizeof(float), 1);
+        if (!state->current_frame) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
-        ei_dsp_cont_current_frame_size = frame_length_values;
-        ei_dsp_cont_current_frame_ix = 0;
+        state->current_frame_size = frame_length_values;
+        state->current_frame_ix = 0;
+        state->current_frame_head = 0;
     }
 
 
-    if ((frame_length_values) > preemphasized_audio_signal.total_length  + ei_dsp_cont_current_frame_ix) {
+    if ((frame_length_values) > preemphasized_audio_signal.total_length  + state->current_frame_ix) {
         ei_printf("ERR: frame_length (%d) cannot be larger than signal's total length (%d) for continuous classification\n",
-            (int)frame_length_values, (int)preemphasized_audio_signal.total_length  + ei_dsp_cont_current_frame_ix);
+            (int)frame_length_values, (int)preemphasized_audio_signal.total_length  + state->current_frame_ix);
         EIDSP_ERR(EIDSP_PARAMETER_INVALID);
     }
 
@@ -426,44 +688,41 @@ __attribute__((unused)) int extract_mfcc_per_slice_features(signal_t *signal, ma
         implementation_version = 2;
     }
 
-    if (ei_dsp_cont_current_frame_ix > (int)ei_dsp_cont_current_frame_size) {
-        ei_printf("ERR: ei_dsp_cont_current_frame_ix is larger than frame size (ix=%d size=%d)\n",
-            ei_dsp_cont_current_frame_ix, (int)ei_dsp_cont_current_frame_size);
+    if (state->current_frame_ix > (int)state->current_frame_size) {
+        ei_printf("ERR: current_frame_ix is larger than frame size (ix=%d size=%d)\n",
+            state->current_frame_ix, (int)state->current_frame_size);
         EIDSP_ERR(EIDSP_PARAMETER_INVALID);
     }
 
     // if we still have some code from previous run
-    while (ei_dsp_cont_current_frame_ix > 0) {
-        // then from the current frame we need to read `frame_length_values - ei_dsp_cont_current_frame_ix`
+    while (state->current_frame_ix > 0) {
+        // then from the current frame we need to read `frame_length_values - state->current_frame_ix`
         // starting at offset 0
-        x = preemphasized_audio_signal.get_data(0, frame_length_values - ei_dsp_cont_current_frame_ix, ei_dsp_cont_current_frame + ei_dsp_cont_current_frame_ix);
+        x = ei_dsp_cont_current_frame_fill(state, &preemphasized_audio_signal, frame_length_values - state->current_frame_ix);
         if (x != EIDSP_OK) {
             EIDSP_ERR(x);
         }
 
-        // now ei_dsp_cont_current_frame is complete
+        // now state->current_frame is complete
         signal_t frame_signal;
-        x = numpy::signal_from_buffer(ei_dsp_cont_current_frame, frame_length_values, &frame_signal);
-        if (x != EIDSP_OK) {
-            EIDSP_ERR(x);
-        }
+        ei_dsp_cont_frame_signal(&frame_signal, state);
 
-        x = extract_mfcc_run_slice(&frame_signal, output_matrix, &config, sampling_frequency, matrix_size_out, implementation_version);
+        x = extract_mfcc_run_slice(state, &frame_signal, output_matrix, &config, sampling_frequency, matrix_size_out, implementation_version);
         if (x != EIDSP_OK) {
             EIDSP_ERR(x);
         }
 
-        // if there's overlap between frames we roll through
+        // if there's overlap between frames we move the start of the frame forward
         if (frame_stride_values > 0) {
-            numpy::roll(ei_dsp_cont_current_frame, frame_length_values, -frame_stride_values);
+            state->current_frame_head = (state->current_frame_head + frame_stride_values) % frame_length_values;
         }
 
-        ei_dsp_cont_current_frame_ix -= frame_stride_values;
+        state->current_frame_ix -= frame_stride_values;
     }
 
-    if (ei_dsp_cont_current_frame_ix < 0) {
-        offset_in_signal = -ei_dsp_cont_current_frame_ix;
-        ei_dsp_cont_current_frame_ix = 0;
+    if (state->current_frame_ix < 0) {
+        offset_in_signal = -state->current_frame_ix;
+        state->current_frame_ix = 0;
     }
 
     if (offset_in_signal >= signal->total_length) {
@@ -478,7 +737,7 @@ __attribute__((unused)) int extract_mfcc_per_slice_features(signal_t *signal, ma
     size_t range_signal_orig_length = range_signal->total_length;
 
     // then we'll just go through normal processing of the signal:
-    x = extract_mfcc_run_slice(range_signal, output_matrix, &config, sampling_frequency, matrix_size_out, implementation_version);
+    x = extract_mfcc_run_slice(state, range_signal, output_matrix, &config, sampling_frequency, matrix_size_out, implementation_version);
     if (x != EIDSP_OK) {
         EIDSP_ERR(x);
     }
@@ -496,19 +755,18 @@ __attribute__((unused)) int extract_mfcc_per_slice_features(signal_t *signal, ma
     bytes_left_end_of_frame += frame_overlap_values;
 
     if (bytes_left_end_of_frame > 0) {
-        // then read that into the ei_dsp_cont_current_frame buffer
+        // then read that into the state->current_frame buffer
         x = preemphasized_audio_signal.get_data(
             (preemphasized_audio_signal.total_length - bytes_left_end_of_frame),
             bytes_left_end_of_frame,
-            ei_dsp_cont_current_frame);
+            state->current_frame);
+        state->current_frame_head = 0;
         if (x != EIDSP_OK) {
             EIDSP_ERR(x);
         }
     }
 
-    ei_dsp_cont_current_frame_ix = bytes_left_end_of_frame;
-
-    preemphasis = nullptr;
+    state->current_frame_ix = bytes_left_end_of_frame;
 
     return EIDSP_OK;
 #endif
@@ -571,33 +829,27 @@ __attribute__((unused)) int extract_spectrogram_features(signal_t *signal, matri
 }
 
 
-static int extract_spectrogram_run_slice(signal_t *signal, matrix_t *output_matrix, ei_dsp_config_spectrogram_t *config, const float sampling_frequency, matrix_size_t *matrix_size_out) {
+static int extract_spectrogram_run_slice(ei_dsp_cont_state_t *state, signal_t *signal, matrix_t *output_matrix, ei_dsp_config_spectrogram_t *config, const float sampling_frequency, matrix_size_t *matrix_size_out) {
     uint32_t frequency = (uint32_t)sampling_frequency;
 
-    int x;
-
     // calculate the size of the spectrogram matrix
     matrix_size_t out_matrix_size =
         speechpy::feature::calculate_mfe_buffer_size(
             signal->total_length, frequency, config->frame_length, config->frame_stride, config->fft_length / 2 + 1,
             config->implementation_version);
 
-    // we roll the output matrix back so we have room at the end...
-    x = numpy::roll(output_matrix->buffer, output_matrix->rows * output_matrix->cols,
-        -(out_matrix_size.rows * out_matrix_size.cols));
-    if (x != EIDSP_OK) {
-        if (preemphasis) {
-            delete preemphasis;
-        }
-        EIDSP_ERR(x);
+    // the output matrix is a ring buffer, so instead of rolling it back we write
+    // the new slice at the head (in place, unless it wraps around the end)
+    const size_t out_matrix_slice_size = out_matrix_size.rows * out_matrix_size.cols;
+    if (out_matrix_slice_size > output_matrix->rows * output_matrix->cols) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
     }
 
-    // slice in the output matrix to write to
-    // the offset in the classification matrix here is always at the end
-    size_t output_matrix_offset = (output_matrix->rows * output_matrix->cols) -
-        (out_matrix_size.rows * out_matrix_size.cols);
-
-    matrix_t output_matrix_slice(out_matrix_size.rows, out_matrix_size.cols, output_matrix->buffer + output_matrix_offset);
+    matrix_t output_matrix_slice(out_matrix_size.rows, out_matrix_size.cols,
+        ei_dsp_cont_features_slice_buffer(state, output_matrix, out_matrix_slice_size));
+    if (out_matrix_slice_size > 0 && !output_matrix_slice.buffer) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
 
     // and run the spectrogram extraction
     int ret = speechpy::feature::spectrogram(&output_matrix_slice, signal,
@@ -608,6 +860,8 @@ static int extract_spectrogram_run_slice(signal_t *signal, matrix_t *output_matr
         EIDSP_ERR(ret);
     }
 
+    ei_dsp_cont_features_commit(state, output_matrix, &output_matrix_slice);
+
     matrix_size_out->rows += out_matrix_size.rows;
     if (out_matrix_size.cols > 0) {
         matrix_size_out->cols = out_matrix_size.cols;
@@ -616,7 +870,7 @@ static int extract_spectrogram_run_slice(signal_t *signal, matrix_t *output_matr
     return EIDSP_OK;
 }
 
-__attribute__((unused)) int extract_spectrogram_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency, matrix_size_t *matrix_size_out) {
+__attribute__((unused)) int extract_spectrogram_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency, matrix_size_t *matrix_size_out, ei_dsp_cont_state_t *state = &ei_dsp_cont_default_state) {
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
     ei_printf("ERR: Continuous audio is not supported when EI_C_LINKAGE is defined\n");
     EIDSP_ERR(EIDSP_NOT_SUPPORTED);
@@ -634,6 +888,14 @@ __attribute__((unused)) int extract_spectrogram_per_slice_features(signal_t *sig
         EIDSP_ERR(EIDSP_PARAMETER_INVALID);
     }
 
+    // streaming filter (if any) over the new samples only
+    signal_t filtered_signal;
+    int filter_ret;
+    signal = ei_dsp_cont_filter_slice(state, signal, &filtered_signal, &filter_ret);
+    if (filter_ret != EIDSP_OK) {
+        EIDSP_ERR(filter_ret);
+    }
+
     const uint32_t frequency = static_cast<uint32_t>(sampling_frequency);
 
     /* Fake an extra frame_length for stack frames calculations. There, 1 frame_length is always
@@ -671,18 +933,19 @@ __attribute__((unused)) int extract_spectrogram_per_slice_features(signal_t *sig
     int x;
 
     // have current frame, but wrong size? then free
-    if (ei_dsp_cont_current_frame && ei_dsp_cont_current_frame_size != frame_length_values) {
-        ei_free(ei_dsp_cont_current_frame);
-        ei_dsp_cont_current_frame = nullptr;
+    if (state->current_frame && state->current_frame_size != frame_length_values) {
+        ei_free(state->current_frame);
+        state->current_frame = nullptr;
     }
 
-    if (!ei_dsp_cont_current_frame) {
-        ei_dsp_cont_current_frame = (float*)ei_calloc(frame_length_values * sizeof(float), 1);
-        if (!ei_dsp_cont_current_frame) {
+    if (!state->current_frame) {
+        state->current_frame = (float*)ei_calloc(frame_length_values * sizeof(float), 1);
+        if (!state->current_frame) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
-        ei_dsp_cont_current_frame_size = frame_length_values;
-        ei_dsp_cont_current_frame_ix = 0;
+        state->current_frame_size = frame_length_values;
+        state->current_frame_ix = 0;
+        state->current_frame_head = 0;
     }
 
     matrix_size_out->rows = 0;
@@ -691,43 +954,40 @@ __attribute__((unused)) int extract_spectrogram_per_slice_features(signal_t *sig
     // this is the offset in the signal from which we'll work
     size_t offset_in_signal = 0;
 
-    if (ei_dsp_cont_current_frame_ix > (int)ei_dsp_cont_current_frame_size) {
-        ei_printf("ERR: ei_dsp_cont_current_frame_ix is larger than frame size\n");
+    if (state->current_frame_ix > (int)state->current_frame_size) {
+        ei_printf("ERR: current_frame_ix is larger than frame size\n");
         EIDSP_ERR(EIDSP_PARAMETER_INVALID);
     }
 
     // if we still have some code from previous run
-    while (ei_dsp_cont_current_frame_ix > 0) {
-        // then from the current frame we need to read `frame_length_values - ei_dsp_cont_current_frame_ix`
+    while (state->current_frame_ix > 0) {
+        // then from the current frame we need to read `frame_length_values - state->current_frame_ix`
         // starting at offset 0
-        x = signal->get_data(0, frame_length_values - ei_dsp_cont_current_frame_ix, ei_dsp_cont_current_frame + ei_dsp_cont_current_frame_ix);
+        x = ei_dsp_cont_current_frame_fill(state, signal, frame_length_values - state->current_frame_ix);
         if (x != EIDSP_OK) {
             EIDSP_ERR(x);
         }
 
-        // now ei_dsp_cont_current_frame is complete
+        // now state->current_frame is complete
         signal_t frame_signal;
-        x = numpy::signal_from_buffer(ei_dsp_cont_current_frame, frame_length_values, &frame_signal);
-        if (x != EIDSP_OK) {
-            EIDSP_ERR(x);
-        }
+        ei_dsp_cont_frame_signal(&frame_signal, state);
 
-        x = extract_spectrogram_run_slice(&frame_signal, output_matrix, &config, sampling_frequency, matrix_size_out);
+        x = extract_spectrogram_run_slice(state, &frame_signal, output_matrix, &config, sampling_frequency, matrix_size_out);
         if (x != EIDSP_OK) {
             EIDSP_ERR(x);
         }
 
-        // if there's overlap between frames we roll through
+        // if there's overlap between frames we move the start of the frame forward
         if (frame_stride_values > 0) {
-            numpy::roll(ei_dsp_cont_current_frame, frame_length_values, -frame_stride_values);
+            state->current_frame_head = (state->current_frame_head + frame_stride_values) % frame_length_values;
         }
 
-        ei_dsp_cont_current_frame_ix -= frame_stride_values;
+        state->current_frame_ix -= frame_stride_values;
     }
 
-    if (ei_dsp_cont_current_frame_ix < 0) {
-        offset_in_signal = -ei_dsp_cont_current_frame_ix;
-        ei_dsp_cont_current_frame_ix = 0;
+    if (state->current_frame_ix < 0) {
+        offset_in_signal = -state->current_frame_ix;
+        state->current_frame_ix = 0;
     }
 
     if (offset_in_signal >= signal->total_length) {
@@ -742,7 +1002,7 @@ __attribute__((unused)) int extract_spectrogram_per_slice_features(signal_t *sig
     size_t range_signal_orig_length = range_signal->total_length;
 
     // then we'll just go through normal processing of the signal:
-    x = extract_spectrogram_run_slice(range_signal, output_matrix, &config, sampling_frequency, matrix_size_out);
+    x = extract_spectrogram_run_slice(state, range_signal, output_matrix, &config, sampling_frequency, matrix_size_out);
     if (x != EIDSP_OK) {
         EIDSP_ERR(x);
     }
@@ -760,17 +1020,18 @@ __attribute__((unused)) int extract_spectrogram_per_slice_features(signal_t *sig
     bytes_left_end_of_frame += frame_overlap_values;
 
     if (bytes_left_end_of_frame > 0) {
-        // then read that into the ei_dsp_cont_current_frame buffer
+        // then read that into the state->current_frame buffer
         x = signal->get_data(
             (signal->total_length - bytes_left_end_of_frame),
             bytes_left_end_of_frame,
-            ei_dsp_cont_current_frame);
+            state->current_frame);
+        state->current_frame_head = 0;
         if (x != EIDSP_OK) {
             EIDSP_ERR(x);
         }
     }
 
-    ei_dsp_cont_current_frame_ix = bytes_left_end_of_frame;
+    state->current_frame_ix = bytes_left_end_of_frame;
 
     if (config.implementation_version < 2) {
         if (first_run == true) {
@@ -800,6 +1061,7 @@ __attribute__((unused)) int extract_mfe_features(signal_t *signal, matrix_t *out
 
     const uint32_t frequency = static_cast<uint32_t>(sampling_frequency);
 
+    class speechpy::processing::preemphasis *preemphasis = nullptr;
     signal_t preemphasized_audio_signal;
 
     // before version 3 we did not have preemphasis
@@ -813,9 +1075,9 @@ __attribute__((unused)) int extract_mfe_features(signal_t *signal, matrix_t *out
         // preemphasis class to preprocess the audio...
         class speechpy::processing::preemphasis *pre = new class speechpy::processing::preemphasis(signal, 1, 0.98f, true);
         preemphasis = pre;
+        ei_dsp_preemphasized_signal(&preemphasized_audio_signal, pre);
 
         preemphasized_audio_signal.total_length = signal->total_length;
-        preemphasized_audio_signal.get_data = &preemphasized_audio_signal_get_data;
     }
 
     // calculate the size of the MFE matrix
@@ -842,7 +1104,7 @@ __attribute__((unused)) int extract_mfe_features(signal_t *signal, matrix_t *out
     // So for v2 and v1, we'll just use the old code
     // (the new mfe does away with the intermediate filterbank matrix)
     if (config.implementation_version > 2) {
-        ret = speechpy::feature::mfe(output_matrix, nullptr, &preemphasized_audio_signal,
+        ret = speechpy::feature::mfe_batched(output_matrix, nullptr, &preemphasized_audio_signal,
             frequency, config.frame_length, config.frame_stride, config.num_filters, config.fft_length,
             config.low_frequency, config.high_frequency, config.implementation_version);
     } else {
@@ -882,7 +1144,7 @@ __attribute__((unused)) int extract_mfe_features(signal_t *signal, matrix_t *out
     return EIDSP_OK;
 }
 
-static int extract_mfe_run_slice(signal_t *signal, matrix_t *output_matrix, ei_dsp_config_mfe_t *config, const float sampling_frequency, matrix_size_t *matrix_size_out) {
+static int extract_mfe_run_slice(ei_dsp_cont_state_t *state, signal_t *signal, matrix_t *output_matrix, ei_dsp_config_mfe_t *config, const float sampling_frequency, matrix_size_t *matrix_size_out) {
     uint32_t frequency = (uint32_t)sampling_frequency;
 
     int x;
@@ -893,19 +1155,18 @@ static int extract_mfe_run_slice(signal_t *signal, matrix_t *output_matrix, ei_d
             signal->total_length, frequency, config->frame_length, config->frame_stride, config->num_filters,
             config->implementation_version);
 
-    // we roll the output matrix back so we have room at the end...
-    x = numpy::roll(output_matrix->buffer, output_matrix->rows * output_matrix->cols,
-        -(out_matrix_size.rows * out_matrix_size.cols));
-    if (x != EIDSP_OK) {
-        EIDSP_ERR(x);
+    // the output matrix is a ring buffer, so instead of rolling it back we write
+    // the new slice at the head (in place, unless it wraps around the end)
+    const size_t out_matrix_slice_size = out_matrix_size.rows * out_matrix_size.cols;
+    if (out_matrix_slice_size > output_matrix->rows * output_matrix->cols) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
     }
 
-    // slice in the output matrix to write to
-    // the offset in the classification matrix here is always at the end
-    size_t output_matrix_offset = (output_matrix->rows * output_matrix->cols) -
-        (out_matrix_size.rows * out_matrix_size.cols);
-
-    matrix_t output_matrix_slice(out_matrix_size.rows, out_matrix_size.cols, output_matrix->buffer + output_matrix_offset);
+    matrix_t output_matrix_slice(out_matrix_size.rows, out_matrix_size.cols,
+        ei_dsp_cont_features_slice_buffer(state, output_matrix, out_matrix_slice_size));
+    if (out_matrix_slice_size > 0 && !output_matrix_slice.buffer) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
 
     // and run the MFE extraction
     // This probably seems incorrect, but the mfe func can actually handle all versions
@@ -913,7 +1174,7 @@ static int extract_mfe_run_slice(signal_t *signal, matrix_t *output_matrix, ei_d
     // So for v2 and v1, we'll just use the old code
     // (the new mfe does away with the intermediate filterbank matrix)
     if (config->implementation_version > 2) {
-         x = speechpy::feature::mfe(&output_matrix_slice, nullptr, signal,
+         x = speechpy::feature::mfe_batched(&output_matrix_slice, nullptr, signal,
             frequency, config->frame_length, config->frame_stride, config->num_filters, config->fft_length,
             config->low_frequency, config->high_frequency, config->implementation_version);
     } else {
@@ -926,6 +1187,8 @@ static int extract_mfe_run_slice(signal_t *signal, matrix_t *output_matrix, ei_d
         EIDSP_ERR(x);
     }
 
+    ei_dsp_cont_features_commit(state, output_matrix, &output_matrix_slice);
+
     matrix_size_out->rows += out_matrix_size.rows;
     if (out_matrix_size.cols > 0) {
         matrix_size_out->cols = out_matrix_size.cols;
@@ -934,7 +1197,7 @@ static int extract_mfe_run_slice(signal_t *signal, matrix_t *output_matrix, ei_d
     return EIDSP_OK;
 }
 
-__attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency, matrix_size_t *matrix_size_out) {
+__attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float sampling_frequency, matrix_size_t *matrix_size_out, ei_dsp_cont_state_t *state = &ei_dsp_cont_default_state) {
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
     ei_printf("ERR: Continuous audio is not supported when EI_C_LINKAGE is defined\n");
     EIDSP_ERR(EIDSP_NOT_SUPPORTED);
@@ -959,6 +1222,14 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
         EIDSP_ERR(EIDSP_PARAMETER_INVALID);
     }
 
+    // streaming filter (if any) over the new samples only
+    signal_t filtered_signal;
+    int filter_ret;
+    signal = ei_dsp_cont_filter_slice(state, signal, &filtered_signal, &filter_ret);
+    if (filter_ret != EIDSP_OK) {
+        EIDSP_ERR(filter_ret);
+    }
+
     const uint32_t frequency = static_cast<uint32_t>(sampling_frequency);
 
     // Fake an extra frame_length for stack frames calculations. There, 1 frame_length is always
@@ -973,6 +1244,7 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
     }
 
     // ok all setup, let's construct the signal (with preemphasis for impl version >3)
+    class speechpy::processing::preemphasis *preemphasis = nullptr;
     signal_t preemphasized_audio_signal;
 
    // before version 3 we did not have preemphasis
@@ -985,8 +1257,8 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
         // preemphasis class to preprocess the audio...
         class speechpy::processing::preemphasis *pre = new class speechpy::processing::preemphasis(signal, 1, 0.98f, true);
         preemphasis = pre;
+        ei_dsp_preemphasized_signal(&preemphasized_audio_signal, pre);
         preemphasized_audio_signal.total_length = signal->total_length;
-        preemphasized_audio_signal.get_data = &preemphasized_audio_signal_get_data;
     }
 
     // Go from the time (e.g. 0.25 seconds to number of frames based on freq)
@@ -1019,21 +1291,22 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
     int x;
 
     // have current frame, but wrong size? then free
-    if (ei_dsp_cont_current_frame && ei_dsp_cont_current_frame_size != frame_length_values) {
-        ei_free(ei_dsp_cont_current_frame);
-        ei_dsp_cont_current_frame = nullptr;
+    if (state->current_frame && state->current_frame_size != frame_length_values) {
+        ei_free(state->current_frame);
+        state->current_frame = nullptr;
     }
 
-    if (!ei_dsp_cont_current_frame) {
-        ei_dsp_cont_current_frame = (float*)ei_calloc(frame_length_values * sizeof(float), 1);
-        if (!ei_dsp_cont_current_frame) {
+    if (!state->current_frame) {
+        state->current_frame = (float*)ei_calloc(frame_length_values * sizeof(float), 1);
+        if (!state->current_frame) {
             if (preemphasis) {
                 delete preemphasis;
             }
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
-        ei_dsp_cont_current_frame_size = frame_length_values;
-        ei_dsp_cont_current_frame_ix = 0;
+        state->current_frame_size = frame_length_values;
+        state->current_frame_ix = 0;
+        state->current_frame_head = 0;
     }
 
     matrix_size_out->rows = 0;
@@ -1042,8 +1315,8 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
     // this is the offset in the signal from which we'll work
     size_t offset_in_signal = 0;
 
-    if (ei_dsp_cont_current_frame_ix > (int)ei_dsp_cont_current_frame_size) {
-        ei_printf("ERR: ei_dsp_cont_current_frame_ix is larger than frame size\n");
+    if (state->current_frame_ix > (int)state->current_frame_size) {
+        ei_printf("ERR: current_frame_ix is larger than frame size\n");
         if (preemphasis) {
             delete preemphasis;
         }
@@ -1051,10 +1324,10 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
     }
 
     // if we still have some code from previous run
-    while (ei_dsp_cont_current_frame_ix > 0) {
-        // then from the current frame we need to read `frame_length_values - ei_dsp_cont_current_frame_ix`
+    while (state->current_frame_ix > 0) {
+        // then from the current frame we need to read `frame_length_values - state->current_frame_ix`
         // starting at offset 0
-        x = preemphasized_audio_signal.get_data(0, frame_length_values - ei_dsp_cont_current_frame_ix, ei_dsp_cont_current_frame + ei_dsp_cont_current_frame_ix);
+        x = ei_dsp_cont_current_frame_fill(state, &preemphasized_audio_signal, frame_length_values - state->current_frame_ix);
         if (x != EIDSP_OK) {
             if (preemphasis) {
                 delete preemphasis;
@@ -1062,17 +1335,11 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
             EIDSP_ERR(x);
         }
 
-        // now ei_dsp_cont_current_frame is complete
+        // now state->current_frame is complete
         signal_t frame_signal;
-        x = numpy::signal_from_buffer(ei_dsp_cont_current_frame, frame_length_values, &frame_signal);
-        if (x != EIDSP_OK) {
-            if (preemphasis) {
-                delete preemphasis;
-            }
-            EIDSP_ERR(x);
-        }
+        ei_dsp_cont_frame_signal(&frame_signal, state);
 
-        x = extract_mfe_run_slice(&frame_signal, output_matrix, &config, sampling_frequency, matrix_size_out);
+        x = extract_mfe_run_slice(state, &frame_signal, output_matrix, &config, sampling_frequency, matrix_size_out);
         if (x != EIDSP_OK) {
             if (preemphasis) {
                 delete preemphasis;
@@ -1080,17 +1347,17 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
             EIDSP_ERR(x);
         }
 
-        // if there's overlap between frames we roll through
+        // if there's overlap between frames we move the start of the frame forward
         if (frame_stride_values > 0) {
-            numpy::roll(ei_dsp_cont_current_frame, frame_length_values, -frame_stride_values);
+            state->current_frame_head = (state->current_frame_head + frame_stride_values) % frame_length_values;
         }
 
-        ei_dsp_cont_current_frame_ix -= frame_stride_values;
+        state->current_frame_ix -= frame_stride_values;
     }
 
-    if (ei_dsp_cont_current_frame_ix < 0) {
-        offset_in_signal = -ei_dsp_cont_current_frame_ix;
-        ei_dsp_cont_current_frame_ix = 0;
+    if (state->current_frame_ix < 0) {
+        offset_in_signal = -state->current_frame_ix;
+        state->current_frame_ix = 0;
     }
 
     if (offset_in_signal >= signal->total_length) {
@@ -1108,7 +1375,7 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
     size_t range_signal_orig_length = range_signal->total_length;
 
     // then we'll just go through normal processing of the signal:
-    x = extract_mfe_run_slice(range_signal, output_matrix, &config, sampling_frequency, matrix_size_out);
+    x = extract_mfe_run_slice(state, range_signal, output_matrix, &config, sampling_frequency, matrix_size_out);
     if (x != EIDSP_OK) {
         if (preemphasis) {
             delete preemphasis;
@@ -1129,11 +1396,12 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
     bytes_left_end_of_frame += frame_overlap_values;
 
     if (bytes_left_end_of_frame > 0) {
-        // then read that into the ei_dsp_cont_current_frame buffer
+        // then read that into the state->current_frame buffer
         x = preemphasized_audio_signal.get_data(
             (preemphasized_audio_signal.total_length - bytes_left_end_of_frame),
             bytes_left_end_of_frame,
-            ei_dsp_cont_current_frame);
+            state->current_frame);
+        state->current_frame_head = 0;
         if (x != EIDSP_OK) {
             if (preemphasis) {
                 delete preemphasis;
@@ -1142,7 +1410,7 @@ __attribute__((unused)) int extract_mfe_per_slice_features(signal_t *signal, mat
         }
     }
 
-    ei_dsp_cont_current_frame_ix = bytes_left_end_of_frame;
+    state->current_frame_ix = bytes_left_end_of_frame;
 
 
     if (config.implementation_version == 1) {
@@ -1401,18 +1669,34 @@ __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, m
 /**
  * Clear all state regarding continuous audio. Invoke this function after continuous audio loop ends.
  */
-__attribute__((unused)) int ei_dsp_clear_continuous_audio_state() {
-    if (ei_dsp_cont_current_frame) {
-        ei_free(ei_dsp_cont_current_frame);
+__attribute__((unused)) int ei_dsp_clear_continuous_audio_state(ei_dsp_cont_state_t *state) {
+    if (state->current_frame) {
+        ei_free(state->current_frame);
     }
 
-    ei_dsp_cont_current_frame = nullptr;
-    ei_dsp_cont_current_frame_size = 0;
-    ei_dsp_cont_current_frame_ix = 0;
+    state->current_frame = nullptr;
+    state->current_frame_size = 0;
+    state->current_frame_ix = 0;
+    state->current_frame_head = 0;
+    state->features_head = 0;
+
+    // the filter stays attached, but starts from a clean delay line
+    if (state->filter_buffer) {
+        ei_free(state->filter_buffer);
+    }
+    state->filter_buffer = nullptr;
+    state->filter_buffer_size = 0;
+    if (state->filter) {
+        state->filter->reset();
+    }
 
     return EIDSP_OK;
 }
 
+__attribute__((unused)) int ei_dsp_clear_continuous_audio_state() {
+    return ei_dsp_clear_continuous_audio_state(&ei_dsp_cont_default_state);
+}
+
 /**
  * @brief      Calculates the cepstral mean and variable normalization.
  *
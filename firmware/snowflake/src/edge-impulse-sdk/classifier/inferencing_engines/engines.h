@@ -34,6 +34,13 @@ EI_IMPULSE_ERROR run_gmm_anomaly(
     void *config_ptr,
     bool debug);
 
+EI_IMPULSE_ERROR run_linear_gate(
+    const ei_impulse_t *impulse,
+    ei::matrix_t *fmatrix,
+    ei_impulse_result_t *result,
+    void *config_ptr,
+    bool debug);
+
 EI_IMPULSE_ERROR run_nn_inference(
     const ei_impulse_t *impulse,
     ei::matrix_t *fmatrix,
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _EDGE_IMPULSE_INFERENCING_GATE_H_
+#define _EDGE_IMPULSE_INFERENCING_GATE_H_
+
+#if (EI_CLASSIFIER_HAS_GATE == 1)
+
+#include <math.h>
+#include <stdint.h>
+
+#include "edge-impulse-sdk/classifier/ei_classifier_types.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/classifier/inferencing_engines/engines.h"
+#if EIDSP_USE_CMSIS_DSP
+#include "edge-impulse-sdk/CMSIS/DSP/Include/arm_math.h"
+#endif
+
+/**
+ * Linear gate in front of the neural network (first stage of a cascade).
+ * Scores the same features the network gets with a logistic regression,
+ * and if the score for the keyword stays below the gate threshold the window
+ * is rejected: the result is filled from the gate score and
+ * result->gate_rejected is set, so run_inference skips the remaining blocks.
+ */
+EI_IMPULSE_ERROR run_linear_gate(
+    const ei_impulse_t *impulse,
+    ei::matrix_t *fmatrix,
+    ei_impulse_result_t *result,
+    void *config_ptr,
+    bool debug = false)
+{
+    ei_learning_block_config_gate_linear_t *block_config = (ei_learning_block_config_gate_linear_t*)config_ptr;
+
+    uint64_t gate_start_us = ei_read_timer_us();
+
+    if (fmatrix->rows * fmatrix->cols < block_config->input_size) {
+        ei_printf("ERR: Gate expects %d features, got %d\n",
+            (int)block_config->input_size, (int)(fmatrix->rows * fmatrix->cols));
+        return EI_IMPULSE_INVALID_SIZE;
+    }
+
+    float logit;
+#if EIDSP_USE_CMSIS_DSP
+    arm_dot_prod_f32(fmatrix->buffer, block_config->weights, block_config->input_size, &logit);
+#else
+    logit = 0.0f;
+    for (size_t ix = 0; ix < block_config->input_size; ix++) {
+        logit += fmatrix->buffer[ix] * block_config->weights[ix];
+    }
+#endif
+    float score = 1.0f / (1.0f + expf(-(logit + block_config->bias)));
+
+    result->gate_rejected = score < block_config->threshold;
+
+    if (result->gate_rejected) {
+        // the network won't run, so report the gate's own estimate instead
+        const float other = impulse->label_count > 1 ?
+            (1.0f - score) / (impulse->label_count - 1) : 0.0f;
+        for (uint32_t ix = 0; ix < impulse->label_count; ix++) {
+            result->classification[ix].label = impulse->categories[ix];
+            result->classification[ix].value = ix == block_config->keyword_label_ix ? score : other;
+        }
+    }
+
+    result->timing.gate_us = ei_read_timer_us() - gate_start_us;
+    result->timing.gate = (int)(result->timing.gate_us / 1000);
+
+    if (debug) {
+        ei_printf("Gate score (time: %d ms.): ", result->timing.gate);
+        ei_printf_float(score);
+        ei_printf(result->gate_rejected ? " (rejected)\n" : " (passed)\n");
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+#endif // #if (EI_CLASSIFIER_HAS_GATE == 1)
+#endif // _EDGE_IMPULSE_INFERENCING_GATE_H_
@@ -23,10 +23,64 @@
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+#include "edge-impulse-sdk/classifier/ei_memory_plan.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
 #include "edge-impulse-sdk/classifier/ei_fill_result_struct.h"
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
 #include "edge-impulse-sdk/classifier/inferencing_engines/tflite_helper.h"
 #include "edge-impulse-sdk/classifier/ei_run_dsp.h"
+#if EI_CLASSIFIER_PROFILE_OPS
+#include "edge-impulse-sdk/classifier/ei_op_profiler.h"
+#endif
+
+#if EI_CLASSIFIER_PERSISTENT_INTERPRETER > 0
+/**
+ * A compiled model that's kept initialized between inferences (the graph config can be a
+ * temporary, so the model is identified by its functions)
+ */
+typedef struct {
+    TfLiteStatus (*model_init)(void*(*alloc_fnc)(size_t, size_t));
+    TfLiteStatus (*model_reset)(void (*free)(void* ptr));
+} ei_eon_persistent_t;
+
+static ei_eon_persistent_t *inference_tflite_persistent() {
+    static ei_eon_persistent_t slots[EI_CLASSIFIER_PERSISTENT_INTERPRETER] = { };
+    return slots;
+}
+
+static void inference_tflite_persistent_free(ei_eon_persistent_t *slot) {
+    if (slot->model_reset) {
+        slot->model_reset(ei_tensor_arena_free);
+    }
+    slot->model_init = nullptr;
+    slot->model_reset = nullptr;
+}
+#endif // EI_CLASSIFIER_PERSISTENT_INTERPRETER > 0
+
+/**
+ * Reset the models kept with EI_CLASSIFIER_PERSISTENT_INTERPRETER (see run_classifier_deinit)
+ */
+__attribute__((unused)) static void inference_tflite_teardown() {
+#if EI_CLASSIFIER_PERSISTENT_INTERPRETER > 0
+    ei_eon_persistent_t *slots = inference_tflite_persistent();
+    for (size_t ix = 0; ix < EI_CLASSIFIER_PERSISTENT_INTERPRETER; ix++) {
+        inference_tflite_persistent_free(&slots[ix]);
+    }
+#endif
+}
+
+/**
+ * Done with a model from inference_tflite_setup, reset (frees the arena) unless it's kept
+ * for the next inference
+ */
+static TfLiteStatus inference_tflite_release(ei_config_tflite_eon_graph_t *graph_config) {
+#if EI_CLASSIFIER_PERSISTENT_INTERPRETER > 0
+    (void)graph_config;
+    return kTfLiteOk;
+#else
+    return graph_config->model_reset(ei_tensor_arena_free);
+#endif
+}
 
 /**
  * Setup the TFLite runtime
@@ -51,10 +105,44 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
 
     *ctx_start_us = ei_read_timer_us();
 
-    TfLiteStatus init_status = graph_config->model_init(ei_aligned_calloc);
-    if (init_status != kTfLiteOk) {
-        ei_printf("Failed to initialize the model (error code %d)\n", init_status);
-        return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+#if EI_CLASSIFIER_PROFILE_OPS
+    // before init, MACs and arena usage are reported from there
+    if (graph_config->model_set_profiler) {
+        graph_config->model_set_profiler(ei_op_profiler_active);
+    }
+#endif
+
+    bool initialized = false;
+
+#if EI_CLASSIFIER_PERSISTENT_INTERPRETER > 0
+    // already initialized? then the arena is allocated and the kernels are prepared
+    ei_eon_persistent_t *slots = inference_tflite_persistent();
+    ei_eon_persistent_t *slot = &slots[EI_CLASSIFIER_PERSISTENT_INTERPRETER - 1];
+    for (size_t ix = 0; ix < EI_CLASSIFIER_PERSISTENT_INTERPRETER; ix++) {
+        if (slots[ix].model_init == graph_config->model_init) {
+            initialized = true;
+            break;
+        }
+        if (!slots[ix].model_init && slot->model_init) {
+            slot = &slots[ix];
+        }
+    }
+    if (!initialized) {
+        // take a free slot, or make room in the last one
+        inference_tflite_persistent_free(slot);
+    }
+#endif
+
+    if (!initialized) {
+        TfLiteStatus init_status = graph_config->model_init(ei_tensor_arena_calloc);
+        if (init_status != kTfLiteOk) {
+            ei_printf("Failed to initialize the model (error code %d)\n", init_status);
+            return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+        }
+#if EI_CLASSIFIER_PERSISTENT_INTERPRETER > 0
+        slot->model_init = graph_config->model_init;
+        slot->model_reset = graph_config->model_reset;
+#endif
     }
 
     TfLiteStatus status;
@@ -122,7 +210,7 @@ static EI_IMPULSE_ERROR inference_tflite_run(
     EI_IMPULSE_ERROR fill_res = fill_result_struct_from_output_tensor_tflite(
         impulse, output, labels_tensor, scores_tensor, result, debug);
 
-    config->model_reset(ei_aligned_free);
+    inference_tflite_release(config);
 
     if (fill_res != EI_IMPULSE_OK) {
         return fill_res;
@@ -185,7 +273,7 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
         return output_res;
     }
 
-    if (graph_config->model_reset(ei_aligned_free) != kTfLiteOk) {
+    if (inference_tflite_release(graph_config) != kTfLiteOk) {
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
@@ -232,6 +320,8 @@ EI_IMPULSE_ERROR run_nn_inference(
         return init_res;
     }
 
+    const uint64_t setup_us = ei_read_timer_us() - ctx_start_us;
+
     uint8_t* tensor_arena = static_cast<uint8_t*>(p_tensor_arena.get());
 
     auto input_res = fill_input_tensor_from_matrix(fmatrix, &input);
@@ -249,6 +339,7 @@ EI_IMPULSE_ERROR run_nn_inference(
         tensor_arena, result, debug);
 
     result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+    result->timing.classification_setup_us = setup_us;
 
     if (run_res != EI_IMPULSE_OK) {
         return run_res;
@@ -257,6 +348,94 @@ EI_IMPULSE_ERROR run_nn_inference(
     return EI_IMPULSE_OK;
 }
 
+/**
+ * @brief      Do neural network inferencing over a batch of feature windows.
+ *             The model is initialized once and invoked for every window, instead
+ *             of being set up and torn down per window like run_nn_inference.
+ *
+ * @param      fmatrix  Processed features, one window per row
+ * @param      results  Output classifier results, fmatrix->rows entries
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+EI_IMPULSE_ERROR run_nn_inference_batch(
+    const ei_impulse_t *impulse,
+    ei::matrix_t *fmatrix,
+    ei_impulse_result_t *results,
+    void *config_ptr,
+    bool debug = false)
+{
+    ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)config_ptr;
+    ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
+
+    TfLiteTensor input;
+    TfLiteTensor output;
+    TfLiteTensor output_scores;
+    TfLiteTensor output_labels;
+
+    uint64_t ctx_start_us = ei_read_timer_us();
+    ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
+
+    EI_IMPULSE_ERROR init_res = inference_tflite_setup(
+        block_config,
+        &ctx_start_us,
+        &input,
+        &output,
+        &output_labels,
+        &output_scores,
+        p_tensor_arena);
+
+    if (init_res != EI_IMPULSE_OK) {
+        return init_res;
+    }
+
+    // the setup cost is shared by all windows in the batch
+    const uint64_t setup_us = (ei_read_timer_us() - ctx_start_us) / fmatrix->rows;
+
+    EI_IMPULSE_ERROR res = EI_IMPULSE_OK;
+
+    for (size_t row = 0; row < fmatrix->rows; row++) {
+        ei_impulse_result_t *result = &results[row];
+        uint64_t window_start_us = ei_read_timer_us();
+
+        ei::matrix_t window(1, fmatrix->cols, fmatrix->buffer + (row * fmatrix->cols));
+
+        res = fill_input_tensor_from_matrix(&window, &input);
+        if (res != EI_IMPULSE_OK) {
+            break;
+        }
+
+        if (graph_config->model_invoke() != kTfLiteOk) {
+            res = EI_IMPULSE_TFLITE_ERROR;
+            break;
+        }
+
+        result->timing.classification_us = (ei_read_timer_us() - window_start_us) + setup_us;
+        result->timing.classification_setup_us = setup_us;
+        result->timing.classification = (int)(result->timing.classification_us / 1000);
+
+        if (debug) {
+            ei_printf("Predictions for window %d (time: %d ms.):\n", (int)row, result->timing.classification);
+        }
+
+        res = fill_result_struct_from_output_tensor_tflite(
+            impulse, &output, &output_labels, &output_scores, result, debug);
+        if (res != EI_IMPULSE_OK) {
+            break;
+        }
+
+        if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+            res = EI_IMPULSE_CANCELED;
+            break;
+        }
+    }
+
+    inference_tflite_release(graph_config);
+
+    return res;
+}
+
 #if EI_CLASSIFIER_QUANTIZATION_ENABLED == 1
 /**
  * Special function to run the classifier on images, only works on TFLite models (either interpreter or EON or for tensaiflow)
@@ -295,6 +474,8 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return init_res;
     }
 
+    result->timing.classification_setup_us = ei_read_timer_us() - ctx_start_us;
+
     if (input.type != TfLiteType::kTfLiteInt8 && input.type != TfLiteType::kTfLiteUInt8) {
         return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
     }
@@ -345,10 +526,105 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return run_res;
     }
 
-    result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+    result->timing.classification_us = ei_read_timer_us() - ctx_start_us + result->timing.classification_setup_us;
+
+    return EI_IMPULSE_OK;
+}
+
+#if EI_CLASSIFIER_CONTINUOUS_QUANTIZED_FEATURES
+/**
+ * Run the classifier on a continuous MFCC features window, normalizing and quantizing the features
+ * straight into the input tensor instead of going through a float window and
+ * fill_input_tensor_from_matrix. Only works if 'can_run_classifier_continuous_quantized' returns
+ * EI_IMPULSE_OK. The normalization is added to the DSP timing of result.
+ */
+EI_IMPULSE_ERROR run_nn_inference_continuous_quantized(
+    const ei_impulse_t *impulse,
+    ei_dsp_cont_state_t *dsp_state,
+    matrix_t *features,
+    ei_impulse_result_t *result,
+    void *config_ptr,
+    bool debug = false) {
+
+    ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)config_ptr;
+    ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
+
+    uint64_t ctx_start_us;
+    TfLiteTensor input;
+    TfLiteTensor output;
+    TfLiteTensor output_scores;
+    TfLiteTensor output_labels;
+
+    ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
+
+    EI_IMPULSE_ERROR init_res = inference_tflite_setup(
+        block_config,
+        &ctx_start_us,
+        &input, &output,
+        &output_labels,
+        &output_scores,
+        p_tensor_arena);
+
+    if (init_res != EI_IMPULSE_OK) {
+        return init_res;
+    }
+
+    const uint64_t setup_us = ei_read_timer_us() - ctx_start_us;
+
+    if (input.type != TfLiteType::kTfLiteInt8 || input.bytes != impulse->nn_input_frame_size) {
+        ei_printf("ERR: Cannot quantize the features into input type (%d)\n", input.type);
+        inference_tflite_release(graph_config);
+        return EI_IMPULSE_INPUT_TENSOR_WAS_NULL;
+    }
+
+    uint64_t dsp_start_us = ei_read_timer_us();
+
+    // features matrix maps around the input tensor to not allocate any memory
+    ei::matrix_i8_t features_matrix(1, impulse->nn_input_frame_size, input.data.int8);
+
+    int ret = ei_dsp_cont_features_quantize_mfcc(dsp_state, features, impulse->dsp_blocks[0].config,
+        input.params.scale, input.params.zero_point, &features_matrix);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: Failed to normalize features (%d)\n", ret);
+        inference_tflite_release(graph_config);
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    result->timing.dsp_us += ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp = (int)(result->timing.dsp_us / 1000);
+
+    if (debug) {
+        ei_printf("Features (%d ms.): ", result->timing.dsp);
+        for (size_t ix = 0; ix < features_matrix.cols; ix++) {
+            ei_printf_float((features_matrix.buffer[ix] - input.params.zero_point) * input.params.scale);
+            ei_printf(" ");
+        }
+        ei_printf("\n");
+    }
+
+    ctx_start_us = ei_read_timer_us();
+
+    EI_IMPULSE_ERROR run_res = inference_tflite_run(
+        impulse,
+        graph_config,
+        ctx_start_us,
+        &output,
+        &output_labels,
+        &output_scores,
+        static_cast<uint8_t*>(p_tensor_arena.get()),
+        result,
+        debug);
+
+    result->timing.classification_us = ei_read_timer_us() - ctx_start_us + setup_us;
+    result->timing.classification_setup_us = setup_us;
+
+    if (run_res != EI_IMPULSE_OK) {
+        return run_res;
+    }
 
     return EI_IMPULSE_OK;
 }
+#endif // EI_CLASSIFIER_CONTINUOUS_QUANTIZED_FEATURES
 #endif // EI_CLASSIFIER_QUANTIZATION_ENABLED == 1
 
 __attribute__((unused)) int extract_tflite_eon_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
@@ -25,12 +25,18 @@
 #include <cmath>
 #include "edge-impulse-sdk/tensorflow/lite/micro/all_ops_resolver.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_interpreter.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/optimal_memory_planner.h"
 #include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated.h"
 #include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated_full.h"
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+#include "edge-impulse-sdk/classifier/ei_memory_plan.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
 #include "edge-impulse-sdk/classifier/ei_fill_result_struct.h"
 #include "edge-impulse-sdk/classifier/ei_model_types.h"
 #include "edge-impulse-sdk/classifier/inferencing_engines/tflite_helper.h"
+#if EI_CLASSIFIER_PROFILE_OPS
+#include "edge-impulse-sdk/classifier/ei_op_profiler.h"
+#endif
 
 #if defined(EI_CLASSIFIER_HAS_TFLITE_OPS_RESOLVER) && EI_CLASSIFIER_HAS_TFLITE_OPS_RESOLVER == 1
 #include "tflite-model/tflite-resolver.h"
@@ -46,6 +52,77 @@
 #endif
 #endif
 
+#if EI_CLASSIFIER_PERSISTENT_INTERPRETER > 0
+#ifdef EI_CLASSIFIER_ALLOCATION_STATIC
+#error "EI_CLASSIFIER_PERSISTENT_INTERPRETER needs a tensor arena per model, it can't be used with EI_CLASSIFIER_ALLOCATION_STATIC"
+#endif
+
+/**
+ * An interpreter that's kept between inferences, with the arena it planned its tensors in
+ */
+typedef struct {
+    const unsigned char *model;
+    tflite::MicroInterpreter *interpreter;
+    uint8_t *tensor_arena;
+} ei_tflite_persistent_t;
+
+static ei_tflite_persistent_t *inference_tflite_persistent() {
+    static ei_tflite_persistent_t slots[EI_CLASSIFIER_PERSISTENT_INTERPRETER] = { };
+    return slots;
+}
+
+static void inference_tflite_persistent_free(ei_tflite_persistent_t *slot) {
+    delete slot->interpreter;
+    ei_aligned_free(slot->tensor_arena);
+    slot->model = nullptr;
+    slot->interpreter = nullptr;
+    slot->tensor_arena = nullptr;
+}
+#endif // EI_CLASSIFIER_PERSISTENT_INTERPRETER > 0
+
+/**
+ * Free the interpreters kept with EI_CLASSIFIER_PERSISTENT_INTERPRETER (see run_classifier_deinit)
+ */
+__attribute__((unused)) static void inference_tflite_teardown() {
+#if EI_CLASSIFIER_PERSISTENT_INTERPRETER > 0
+    ei_tflite_persistent_t *slots = inference_tflite_persistent();
+    for (size_t ix = 0; ix < EI_CLASSIFIER_PERSISTENT_INTERPRETER; ix++) {
+        inference_tflite_persistent_free(&slots[ix]);
+    }
+#endif
+}
+
+/**
+ * Done with an interpreter from inference_tflite_setup, deleted unless it's kept for the next inference
+ */
+static void inference_tflite_release(tflite::MicroInterpreter *interpreter) {
+#if EI_CLASSIFIER_PERSISTENT_INTERPRETER > 0
+    (void)interpreter;
+#else
+    delete interpreter;
+#endif
+}
+
+/**
+ * Obtain pointers to the model's input and output tensors
+ */
+static void inference_tflite_get_tensors(
+    ei_learning_block_config_tflite_graph_t *block_config,
+    tflite::MicroInterpreter *interpreter,
+    TfLiteTensor** input,
+    TfLiteTensor** output,
+    TfLiteTensor** output_labels,
+    TfLiteTensor** output_scores) {
+
+    *input = interpreter->input(0);
+    *output = interpreter->output(block_config->output_data_tensor);
+
+    if (block_config->object_detection_last_layer == EI_CLASSIFIER_LAST_LAYER_SSD) {
+        *output_scores = interpreter->output(block_config->output_score_tensor);
+        *output_labels = interpreter->output(block_config->output_labels_tensor);
+    }
+}
+
 /**
  * Setup the TFLite runtime
  *
@@ -71,18 +148,37 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
 
     ei_config_tflite_graph_t *graph_config = (ei_config_tflite_graph_t*)block_config->graph_config;
 
+#if EI_CLASSIFIER_PERSISTENT_INTERPRETER > 0
+    // already set up for this model? then the arena is planned and the kernels are prepared
+    ei_tflite_persistent_t *slots = inference_tflite_persistent();
+    ei_tflite_persistent_t *slot = &slots[EI_CLASSIFIER_PERSISTENT_INTERPRETER - 1];
+    for (size_t ix = 0; ix < EI_CLASSIFIER_PERSISTENT_INTERPRETER; ix++) {
+        if (slots[ix].model == graph_config->model) {
+            *micro_interpreter = slots[ix].interpreter;
+            p_tensor_arena = ei_unique_ptr_t(slots[ix].tensor_arena, [](void*){});
+            inference_tflite_get_tensors(block_config, slots[ix].interpreter, input, output, output_labels, output_scores);
+            return EI_IMPULSE_OK;
+        }
+        if (!slots[ix].model && slot->model) {
+            slot = &slots[ix];
+        }
+    }
+    // take a free slot, or make room in the last one
+    inference_tflite_persistent_free(slot);
+#endif
+
 #ifdef EI_CLASSIFIER_ALLOCATION_STATIC
     // Assign a no-op lambda to the "free" function in case of static arena
     static uint8_t tensor_arena[EI_CLASSIFIER_TFLITE_ARENA_SIZE] ALIGN(16);
     p_tensor_arena = ei_unique_ptr_t(tensor_arena, [](void*){});
 #else
     // Create an area of memory to use for input, output, and intermediate arrays.
-    uint8_t *tensor_arena = (uint8_t*)ei_aligned_calloc(16, graph_config->arena_size);
+    uint8_t *tensor_arena = (uint8_t*)ei_tensor_arena_calloc(16, graph_config->arena_size);
     if (tensor_arena == NULL) {
         ei_printf("Failed to allocate TFLite arena (%zu bytes)\n", graph_config->arena_size);
         return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
     }
-    p_tensor_arena = ei_unique_ptr_t(tensor_arena, ei_aligned_free);
+    p_tensor_arena = ei_unique_ptr_t(tensor_arena, ei_tensor_arena_free);
 #endif
 
     static bool tflite_first_run = true;
@@ -121,8 +217,25 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
 #endif
 
     // Build an interpreter to run the model with.
+#if EI_CLASSIFIER_TFLITE_OPTIMAL_MEMORY_PLANNER == 1
+    // the planner is only used while AllocateTensors() lays out the arena, so one serves all interpreters
+    static tflite::OptimalMemoryPlanner memory_planner;
+    tflite::MicroAllocator *allocator = tflite::MicroAllocator::Create(
+        tensor_arena, graph_config->arena_size, &memory_planner);
+#if EI_CLASSIFIER_PROFILE_OPS
+    tflite::MicroInterpreter *interpreter = new tflite::MicroInterpreter(
+        model, resolver, allocator, nullptr, ei_op_profiler_active);
+#else
+    tflite::MicroInterpreter *interpreter = new tflite::MicroInterpreter(
+        model, resolver, allocator);
+#endif
+#elif EI_CLASSIFIER_PROFILE_OPS
+    tflite::MicroInterpreter *interpreter = new tflite::MicroInterpreter(
+        model, resolver, tensor_arena, graph_config->arena_size, nullptr, ei_op_profiler_active);
+#else
     tflite::MicroInterpreter *interpreter = new tflite::MicroInterpreter(
         model, resolver, tensor_arena, graph_config->arena_size);
+#endif
 
     *micro_interpreter = interpreter;
 
@@ -130,22 +243,31 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
     TfLiteStatus allocate_status = interpreter->AllocateTensors(true);
     if (allocate_status != kTfLiteOk) {
         ei_printf("AllocateTensors() failed");
+        delete interpreter;
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
-    // Obtain pointers to the model's input and output tensors.
-    *input = interpreter->input(0);
-    *output = interpreter->output(block_config->output_data_tensor);
-
-    if (block_config->object_detection_last_layer == EI_CLASSIFIER_LAST_LAYER_SSD) {
-        *output_scores = interpreter->output(block_config->output_score_tensor);
-        *output_labels = interpreter->output(block_config->output_labels_tensor);
+#if EI_CLASSIFIER_PROFILE_OPS
+    // the interpreter doesn't expose its nodes, so no MACs here
+    if (ei_op_profiler_active) {
+        ei_op_profiler_active->SetArenaUsage(interpreter->arena_used_bytes(), graph_config->arena_size, 0);
     }
+#endif
+
+    inference_tflite_get_tensors(block_config, interpreter, input, output, output_labels, output_scores);
 
     if (tflite_first_run) {
         tflite_first_run = false;
     }
 
+#if EI_CLASSIFIER_PERSISTENT_INTERPRETER > 0
+    // keep the interpreter and take the arena over from the caller
+    slot->model = graph_config->model;
+    slot->interpreter = interpreter;
+    slot->tensor_arena = static_cast<uint8_t*>(p_tensor_arena.release());
+    p_tensor_arena = ei_unique_ptr_t(slot->tensor_arena, [](void*){});
+#endif
+
     return EI_IMPULSE_OK;
 }
 
@@ -173,10 +295,16 @@ static EI_IMPULSE_ERROR inference_tflite_run(
     ei_impulse_result_t *result,
     bool debug) {
 
+#if EI_CLASSIFIER_PROFILE_OPS
+    if (ei_op_profiler_active) {
+        ei_op_profiler_active->BeginInvoke();
+    }
+#endif
+
     // Run inference, and report any error
     TfLiteStatus invoke_status = interpreter->Invoke();
     if (invoke_status != kTfLiteOk) {
-        delete interpreter;
+        inference_tflite_release(interpreter);
         ei_printf("Invoke failed (%d)\n", invoke_status);
         return EI_IMPULSE_TFLITE_ERROR;
     }
@@ -194,7 +322,7 @@ static EI_IMPULSE_ERROR inference_tflite_run(
     EI_IMPULSE_ERROR fill_res = fill_result_struct_from_output_tensor_tflite(
         impulse, output, labels_tensor, scores_tensor, result, debug);
 
-    delete interpreter;
+    inference_tflite_release(interpreter);
 
     if (fill_res != EI_IMPULSE_OK) {
         return fill_res;
@@ -259,7 +387,7 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
         return output_res;
     }
 
-    delete interpreter;
+    inference_tflite_release(interpreter);
 
     return EI_IMPULSE_OK;
 }
@@ -303,6 +431,8 @@ EI_IMPULSE_ERROR run_nn_inference(
         return init_res;
     }
 
+    const uint64_t setup_us = ei_read_timer_us() - ctx_start_us;
+
     uint8_t* tensor_arena = static_cast<uint8_t*>(p_tensor_arena.get());
 
     auto input_res = fill_input_tensor_from_matrix(fmatrix, input);
@@ -320,6 +450,7 @@ EI_IMPULSE_ERROR run_nn_inference(
         interpreter, tensor_arena, result, debug);
 
     result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+    result->timing.classification_setup_us = setup_us;
 
     if (run_res != EI_IMPULSE_OK) {
         return run_res;
@@ -366,6 +497,8 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return init_res;
     }
 
+    result->timing.classification_setup_us = ei_read_timer_us() - ctx_start_us;
+
     if (input->type != TfLiteType::kTfLiteInt8 && input->type != TfLiteType::kTfLiteUInt8) {
         return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
     }
@@ -415,10 +548,104 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return run_res;
     }
 
-    result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+    result->timing.classification_us = ei_read_timer_us() - ctx_start_us + result->timing.classification_setup_us;
+
+    return EI_IMPULSE_OK;
+}
+
+#if EI_CLASSIFIER_CONTINUOUS_QUANTIZED_FEATURES
+/**
+ * Run the classifier on a continuous MFCC features window, normalizing and quantizing the features
+ * straight into the input tensor instead of going through a float window and
+ * fill_input_tensor_from_matrix. Only works if 'can_run_classifier_continuous_quantized' returns
+ * EI_IMPULSE_OK. The normalization is added to the DSP timing of result.
+ */
+EI_IMPULSE_ERROR run_nn_inference_continuous_quantized(
+    const ei_impulse_t *impulse,
+    ei_dsp_cont_state_t *dsp_state,
+    matrix_t *features,
+    ei_impulse_result_t *result,
+    void *config_ptr,
+    bool debug = false)
+{
+    ei_learning_block_config_tflite_graph_t *block_config = (ei_learning_block_config_tflite_graph_t*)config_ptr;
+
+    uint64_t ctx_start_us;
+    TfLiteTensor* input;
+    TfLiteTensor* output;
+    TfLiteTensor* output_scores;
+    TfLiteTensor* output_labels;
+    ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
+
+    tflite::MicroInterpreter* interpreter;
+    EI_IMPULSE_ERROR init_res = inference_tflite_setup(
+        block_config,
+        &ctx_start_us,
+        &input, &output,
+        &output_labels,
+        &output_scores,
+        &interpreter,
+        p_tensor_arena);
+
+    if (init_res != EI_IMPULSE_OK) {
+        return init_res;
+    }
+
+    const uint64_t setup_us = ei_read_timer_us() - ctx_start_us;
+
+    if (input->type != TfLiteType::kTfLiteInt8 || input->bytes != impulse->nn_input_frame_size) {
+        ei_printf("ERR: Cannot quantize the features into input type (%d)\n", input->type);
+        inference_tflite_release(interpreter);
+        return EI_IMPULSE_INPUT_TENSOR_WAS_NULL;
+    }
+
+    uint64_t dsp_start_us = ei_read_timer_us();
+
+    // features matrix maps around the input tensor to not allocate any memory
+    ei::matrix_i8_t features_matrix(1, impulse->nn_input_frame_size, input->data.int8);
+
+    int ret = ei_dsp_cont_features_quantize_mfcc(dsp_state, features, impulse->dsp_blocks[0].config,
+        input->params.scale, input->params.zero_point, &features_matrix);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: Failed to normalize features (%d)\n", ret);
+        inference_tflite_release(interpreter);
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    result->timing.dsp_us += ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp = (int)(result->timing.dsp_us / 1000);
+
+    if (debug) {
+        ei_printf("Features (%d ms.): ", result->timing.dsp);
+        for (size_t ix = 0; ix < features_matrix.cols; ix++) {
+            ei_printf_float((features_matrix.buffer[ix] - input->params.zero_point) * input->params.scale);
+            ei_printf(" ");
+        }
+        ei_printf("\n");
+    }
+
+    ctx_start_us = ei_read_timer_us();
+
+    EI_IMPULSE_ERROR run_res = inference_tflite_run(impulse,
+        block_config,
+        ctx_start_us,
+        output,
+        output_labels,
+        output_scores,
+        interpreter,
+        static_cast<uint8_t*>(p_tensor_arena.get()),
+        result, debug);
+
+    result->timing.classification_us = ei_read_timer_us() - ctx_start_us + setup_us;
+    result->timing.classification_setup_us = setup_us;
+
+    if (run_res != EI_IMPULSE_OK) {
+        return run_res;
+    }
 
     return EI_IMPULSE_OK;
 }
+#endif // EI_CLASSIFIER_CONTINUOUS_QUANTIZED_FEATURES
 #endif // EI_CLASSIFIER_QUANTIZATION_ENABLED == 1
 
 __attribute__((unused)) int extract_tflite_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
@@ -85,9 +85,50 @@
 #define EIDSP_PRINT_ALLOCATIONS      1
 #endif
 
+// number of FFT plans (per length and backend) that are kept around between calls
+#ifndef EIDSP_FFT_PLAN_CACHE_SIZE
+#define EIDSP_FFT_PLAN_CACHE_SIZE    4
+#endif // EIDSP_FFT_PLAN_CACHE_SIZE
+
+// number of frames speechpy::feature::mfe_batched pushes through each stage at once
+#ifndef EIDSP_MFE_BLOCK_FRAMES
+#define EIDSP_MFE_BLOCK_FRAMES       4
+#endif // EIDSP_MFE_BLOCK_FRAMES
+
+// size (in bytes) of the arena the DSP allocates from instead of the heap, set up by
+// run_classifier_init, 0 disables it. Use ei::memory::arena_stats().peak to size it
+#ifndef EIDSP_ARENA_SIZE
+#define EIDSP_ARENA_SIZE             0
+#endif // EIDSP_ARENA_SIZE
+
+// run the spectral analysis (FFT) block in fixed point: Q31 Butterworth biquads and a Q15 FFT
+// with block scaling, instead of float. Not bit exact: features are close to the float path, see
+// test/test_spectral_fixed_point.cpp for how close
+#ifndef EIDSP_SPECTRAL_FIXED_POINT
+#define EIDSP_SPECTRAL_FIXED_POINT   0
+#endif // EIDSP_SPECTRAL_FIXED_POINT
+
+// block size (in samples) the streaming filters (spectral/stream_filter.hpp) work in, their
+// delay lines and conversion buffers scale with this
+#ifndef EIDSP_STREAM_FILTER_BLOCK
+#define EIDSP_STREAM_FILTER_BLOCK    64
+#endif // EIDSP_STREAM_FILTER_BLOCK
+
 #ifndef EIDSP_SIGNAL_C_FN_POINTER
 #define EIDSP_SIGNAL_C_FN_POINTER    0
 #endif // EIDSP_SIGNAL_C_FN_POINTER
 
+// lock the state that classifier contexts share (FFT plan and DCT caches, the DSP arena, the
+// learning blocks), so separate contexts can be used from separate threads. This serializes
+// rather than parallelizes: DSP runs only overlap without a DSP arena, and inference always
+// runs one at a time, as the compiled model keeps one micro context and tensor arena
+#ifndef EIDSP_LOCK_SHARED_STATE
+#define EIDSP_LOCK_SHARED_STATE      0
+#endif // EIDSP_LOCK_SHARED_STATE
+
+#if EIDSP_LOCK_SHARED_STATE && EIDSP_SIGNAL_C_FN_POINTER
+#error "EIDSP_LOCK_SHARED_STATE cannot be combined with EIDSP_SIGNAL_C_FN_POINTER, signals can't carry their context"
+#endif
+
 // clang-format on
 #endif // _EIDSP_CPP_CONFIG_H_
@@ -20,10 +20,16 @@
 
 // clang-format off
 #include <stdio.h>
+#include <string.h>
 #include <memory>
 #include "../porting/ei_classifier_porting.h"
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 #include "config.hpp"
+#if EIDSP_LOCK_SHARED_STATE
+#include <atomic>
+#include <mutex>
+#include <thread>
+#endif // EIDSP_LOCK_SHARED_STATE
 
 extern size_t ei_memory_in_use;
 extern size_t ei_memory_peak_use;
@@ -108,9 +114,9 @@ namespace ei {
     #define ei_dsp_register_matrix_alloc(...) ei_dsp_register_matrix_alloc_internal(__func__, __FILE__, __LINE__, __VA_ARGS__)
     #define ei_dsp_register_free(...) ei_dsp_register_free_internal(__func__, __FILE__, __LINE__, __VA_ARGS__)
     #define ei_dsp_register_matrix_free(...) ei_dsp_register_matrix_free_internal(__func__, __FILE__, __LINE__, __VA_ARGS__)
-    #define ei_dsp_malloc(...) memory::ei_wrapped_malloc(__func__, __FILE__, __LINE__, __VA_ARGS__)
-    #define ei_dsp_calloc(...) memory::ei_wrapped_calloc(__func__, __FILE__, __LINE__, __VA_ARGS__)
-    #define ei_dsp_free(...) memory::ei_wrapped_free(__func__, __FILE__, __LINE__, __VA_ARGS__)
+    #define ei_dsp_malloc(...) ei::memory::ei_wrapped_malloc(__func__, __FILE__, __LINE__, __VA_ARGS__)
+    #define ei_dsp_calloc(...) ei::memory::ei_wrapped_calloc(__func__, __FILE__, __LINE__, __VA_ARGS__)
+    #define ei_dsp_free(...) ei::memory::ei_wrapped_free(__func__, __FILE__, __LINE__, __VA_ARGS__)
     #define EI_DSP_MATRIX(name, ...) matrix_t name(__VA_ARGS__, NULL, __func__, __FILE__, __LINE__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_MATRIX_B(name, ...) matrix_t name(__VA_ARGS__, __func__, __FILE__, __LINE__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_QUANTIZED_MATRIX(name, ...) quantized_matrix_t name(__VA_ARGS__, NULL, __func__, __FILE__, __LINE__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
@@ -120,26 +126,266 @@ namespace ei {
     #define ei_dsp_register_matrix_alloc(...) (void)0
     #define ei_dsp_register_free(...) (void)0
     #define ei_dsp_register_matrix_free(...) (void)0
-    #define ei_dsp_malloc ei_malloc
-    #define ei_dsp_calloc ei_calloc
-    #define ei_dsp_free(ptr, size) ei_free(ptr)
+    #define ei_dsp_malloc ei::memory::arena_malloc
+    #define ei_dsp_calloc ei::memory::arena_calloc
+    #define ei_dsp_free(ptr, size) ei::memory::arena_free(ptr)
     #define EI_DSP_MATRIX(name, ...) matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_MATRIX_B(name, ...) matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_QUANTIZED_MATRIX(name, ...) quantized_matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_QUANTIZED_MATRIX_B(name, ...) quantized_matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
 #endif
 
-#if EIDSP_TRACK_ALLOCATIONS
 class memory {
 
 
 public:
+    /**
+     * DSP arena statistics, see arena_stats()
+     */
+    typedef struct {
+        size_t size;        // size of the arena, 0 if there's no arena
+        size_t used;        // bytes in use right now
+        size_t peak;        // high-water mark since arena_init
+        size_t fallbacks;   // allocations that didn't fit and went to the heap
+    } arena_stats_t;
+
+    /**
+     * Allocate the DSP arena. Between arena_begin() and arena_end() (see arena_scope) matrices
+     * and ei_dsp_malloc / ei_dsp_calloc are then bump allocated from it instead of from the heap,
+     * and the outermost arena_begin() hands everything back at once. Freeing the latest allocation
+     * pops it, any other free is a no-op until the next begin. Requests that don't fit go to the heap.
+     * There is one arena: with EIDSP_LOCK_SHARED_STATE one thread at a time allocates from it
+     * (the others wait in arena_begin() and use the heap outside of a scope), otherwise the DSP
+     * has to run on one thread at a time. Don't init / deinit while a scope is open.
+     * @param size Size of the arena in bytes (see arena_stats().peak)
+     * @returns false if the arena could not be allocated
+     */
+    static bool arena_init(size_t size) {
+        arena_t *arena = get_arena();
+        if (arena->buffer && arena->size == size) {
+            arena_reset();
+            return true;
+        }
+
+        arena_deinit();
+        arena->buffer = (uint8_t*)ei_malloc(size);
+        if (!arena->buffer) {
+            return false;
+        }
+        arena->owned = true;
+        arena->size = size;
+        arena->peak = 0;
+        arena->fallbacks = 0;
+        arena_reset();
+        return true;
+    }
+
+    /**
+     * Use a buffer the caller owns (e.g. a static one) as the DSP arena, see arena_init(size)
+     * @param buffer Buffer, 16 byte aligned, that stays valid until arena_deinit()
+     * @param size Size of the buffer in bytes
+     */
+    static void arena_init(void *buffer, size_t size) {
+        arena_t *arena = get_arena();
+        arena_deinit();
+        arena->buffer = (uint8_t*)buffer;
+        arena->owned = false;
+        arena->size = size;
+        arena_reset();
+    }
+
+    /**
+     * Free the DSP arena, allocations go to the heap again
+     */
+    static void arena_deinit() {
+        arena_t *arena = get_arena();
+        if (arena->buffer && arena->owned) {
+            ei_free(arena->buffer);
+        }
+        memset(arena, 0, sizeof(arena_t));
+    }
+
+    /**
+     * Release everything that was allocated from the arena. Anything still pointing
+     * into the arena is invalid afterwards.
+     */
+    static void arena_reset() {
+        arena_t *arena = get_arena();
+        arena->top = 0;
+        arena->last = NO_ALLOCATION;
+    }
+
+    /**
+     * Start a DSP run: reset the arena and allocate from it until arena_end(). Begin / end pairs
+     * nest, only the outermost ones reset the arena and stop allocating from it.
+     */
+    static void arena_begin() {
+        arena_t *arena = get_arena();
+#if EIDSP_LOCK_SHARED_STATE
+        arena_mutex().lock();
+        arena_owner().store(std::this_thread::get_id());
+#endif
+        if (arena->depth == 0) {
+            arena_reset();
+        }
+        arena->depth++;
+        arena->active = true;
+    }
+
+    static void arena_end() {
+        arena_t *arena = get_arena();
+        if (arena->depth > 1) {
+            arena->depth--;
+#if EIDSP_LOCK_SHARED_STATE
+            arena_mutex().unlock();
+#endif
+            return;
+        }
+        arena->depth = 0;
+        arena->active = false;
+#if EIDSP_LOCK_SHARED_STATE
+        arena_owner().store(std::thread::id());
+        arena_mutex().unlock();
+#endif
+#if EIDSP_TRACK_ALLOCATIONS
+        if (arena->buffer) {
+            ei_dsp_printf("arena peak=%lu of %lu bytes, %lu heap fallbacks\n",
+                (unsigned long)arena->peak, (unsigned long)arena->size, (unsigned long)arena->fallbacks);
+        }
+#endif
+    }
+
+    /**
+     * Allocates from the arena (if there is one) for the lifetime of the object. A scope inside
+     * another one releases only what was allocated since it started, the outer scope's
+     * allocations stay valid.
+     */
+    class arena_scope {
+    public:
+        arena_scope() {
+            arena_begin();
+            arena_t *arena = get_arena();
+            top_ = arena->top;
+            last_ = arena->last;
+        }
+        ~arena_scope() {
+            arena_t *arena = get_arena();
+            arena->top = top_;
+            arena->last = last_;
+            arena_end();
+        }
+
+    private:
+        size_t top_;
+        size_t last_;
+    };
+
+    /**
+     * Send allocations to the heap until arena_resume(), for memory that has to survive
+     * the DSP run (caches, continuous state). Calls can be nested.
+     */
+    static void arena_suspend() {
+        if (!arena_is_owner()) {
+            return;
+        }
+        get_arena()->suspended++;
+    }
+
+    static void arena_resume() {
+        arena_t *arena = get_arena();
+        if (!arena_is_owner()) {
+            return;
+        }
+        if (arena->suspended > 0) {
+            arena->suspended--;
+        }
+    }
+
+    static arena_stats_t arena_stats() {
+        const arena_t *arena = get_arena();
+        arena_stats_t stats = { arena->size, arena->top, arena->peak, arena->fallbacks };
+        return stats;
+    }
+
+    static void *arena_malloc(size_t size) {
+        arena_t *arena = get_arena();
+        if (!arena_in_use(arena)) {
+            return ei_malloc(size);
+        }
+
+        void *ptr = arena_push(size, ARENA_ALIGN);
+        if (!ptr) {
+            arena->fallbacks++;
+            return ei_malloc(size);
+        }
+        return ptr;
+    }
+
+    /**
+     * Zeroed, aligned block from the arena, for memory outside of the DSP that lives until the
+     * end of the run (e.g. the tensor arena, see ei_memory_plan.h). Free with arena_free().
+     * @returns nullptr if the arena isn't active or the block doesn't fit (no heap fallback)
+     */
+    static void *arena_aligned_calloc(size_t alignment, size_t size) {
+        arena_t *arena = get_arena();
+        if (!arena_in_use(arena)) {
+            return nullptr;
+        }
+
+        void *ptr = arena_push(size, alignment);
+        if (!ptr) {
+            arena->fallbacks++;
+            return nullptr;
+        }
+        memset(ptr, 0, size);
+        return ptr;
+    }
+
+    /**
+     * Whether ptr points into the arena
+     */
+    static bool arena_owns(const void *ptr) {
+        const arena_t *arena = get_arena();
+        const uint8_t *p = (const uint8_t*)ptr;
+        return arena->buffer && p >= arena->buffer && p < arena->buffer + arena->size;
+    }
+
+    static void *arena_calloc(size_t num, size_t size) {
+        arena_t *arena = get_arena();
+        if (!arena_in_use(arena)) {
+            return ei_calloc(num, size);
+        }
+
+        void *ptr = arena_malloc(num * size);
+        if (ptr) {
+            memset(ptr, 0, num * size);
+        }
+        return ptr;
+    }
+
+    static void arena_free(void *ptr) {
+        arena_t *arena = get_arena();
+        uint8_t *p = (uint8_t*)ptr;
+        if (!arena_owns(p)) {
+            ei_free(ptr);
+            return;
+        }
+
+        // only the latest block can be popped, the rest is reclaimed by arena_reset()
+        arena_header_t *header = ((arena_header_t*)p) - 1;
+        if ((size_t)((uint8_t*)header - arena->buffer) == arena->last) {
+            arena->top = arena->last;
+            arena->last = header->prev_last;
+        }
+    }
+
+#if EIDSP_TRACK_ALLOCATIONS
     /**
      * Allocate a new block of memory
      * @param size The size of the memory block, in bytes.
      */
     static void *ei_wrapped_malloc(const char *fn, const char *file, int line, size_t size) {
-        void *ptr = ei_malloc(size);
+        void *ptr = arena_malloc(size);
         if (ptr) {
             ei_dsp_register_alloc_internal(fn, file, line, size, ptr);
         }
@@ -153,7 +399,7 @@ public:
      * @param size Size of each element
      */
     static void *ei_wrapped_calloc(const char *fn, const char *file, int line, size_t num, size_t size) {
-        void *ptr = ei_calloc(num, size);
+        void *ptr = arena_calloc(num, size);
         if (ptr) {
             ei_dsp_register_alloc_internal(fn, file, line, num * size, ptr);
         }
@@ -166,12 +412,99 @@ public:
      * @param size Size of the block of memory previously allocated.
      */
     static void ei_wrapped_free(const char *fn, const char *file, int line, void *ptr, size_t size) {
-        ei_free(ptr);
+        arena_free(ptr);
         ei_dsp_register_free_internal(fn, file, line, size, ptr);
     }
-};
 #endif // #if EIDSP_TRACK_ALLOCATIONS
 
+private:
+    static const size_t ARENA_ALIGN = 8;
+    static const size_t NO_ALLOCATION = (size_t)-1;
+
+    typedef struct {
+        size_t prev_last;
+        size_t padding; // keep the data aligned on 64-bit hosts too
+    } arena_header_t;
+
+    typedef struct {
+        uint8_t *buffer;
+        bool owned;         // allocated by arena_init(size), not a caller's buffer
+        size_t size;
+        size_t top;
+        size_t last;
+        size_t peak;
+        size_t fallbacks;
+        bool active;
+        int depth;          // nested arena_begin() calls
+        int suspended;
+    } arena_t;
+
+    static arena_t *get_arena() {
+        static arena_t arena = { };
+        return &arena;
+    }
+
+#if EIDSP_LOCK_SHARED_STATE
+    // held from the outermost arena_begin() to its arena_end(), by the owner
+    static std::recursive_mutex &arena_mutex() {
+        static std::recursive_mutex m;
+        return m;
+    }
+
+    static std::atomic<std::thread::id> &arena_owner() {
+        static std::atomic<std::thread::id> owner;
+        return owner;
+    }
+#endif
+
+    /**
+     * Whether the calling thread is in an arena scope (always, without EIDSP_LOCK_SHARED_STATE)
+     */
+    static bool arena_is_owner() {
+#if EIDSP_LOCK_SHARED_STATE
+        return arena_owner().load() == std::this_thread::get_id();
+#else
+        return true;
+#endif
+    }
+
+    /**
+     * Whether allocations of the calling thread come from the arena right now
+     */
+    static bool arena_in_use(const arena_t *arena) {
+        return arena->buffer && arena->active && arena->suspended == 0 && arena_is_owner();
+    }
+
+    /**
+     * Bump allocate a block whose data starts at a multiple of `alignment` (the padding in
+     * front of the header is reclaimed when the block before it is popped)
+     * @returns nullptr if it doesn't fit
+     */
+    static void *arena_push(size_t size, size_t alignment) {
+        arena_t *arena = get_arena();
+
+        // every block starts with a header so the latest one can be popped again
+        size_t start = arena->top;
+        size_t data = (size_t)(arena->buffer + start + sizeof(arena_header_t));
+        if (alignment > ARENA_ALIGN && data % alignment != 0) {
+            start += alignment - (data % alignment);
+        }
+        size_t bytes = sizeof(arena_header_t) + ((size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1));
+        if (start > arena->size || bytes > arena->size - start) {
+            return nullptr;
+        }
+
+        arena_header_t *header = (arena_header_t*)(arena->buffer + start);
+        header->prev_last = arena->last;
+        arena->last = start;
+        arena->top = start + bytes;
+        if (arena->top > arena->peak) {
+            arena->peak = arena->top;
+        }
+        return header + 1;
+    }
+};
+
 } // namespace ei
 
 // clang-format on
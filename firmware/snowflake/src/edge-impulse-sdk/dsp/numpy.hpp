@@ -55,6 +55,9 @@
 #else
 #include <functional>
 #endif // __MBED__
+#if EIDSP_LOCK_SHARED_STATE
+#include <mutex>
+#endif // EIDSP_LOCK_SHARED_STATE
 
 #define EI_MAX_UINT16 65535
 
@@ -72,6 +75,40 @@ static constexpr float quantized_values_one_zero[] = { (0.0f / 1.0f), (1.0f / 10
 class numpy {
 public:
 
+    /**
+     * The process-wide caches numpy keeps between calls
+     */
+    typedef enum {
+        CACHE_FFT_PLANS = 0,
+        CACHE_DCT2_BASIS,
+        CACHE_COUNT
+    } cache_t;
+
+    /**
+     * Holds the lock on one of the caches for as long as it's in scope, so results obtained
+     * from the cache stay valid while they're used. A no-op unless EIDSP_LOCK_SHARED_STATE is set.
+     */
+    class cache_lock {
+    public:
+#if EIDSP_LOCK_SHARED_STATE
+        cache_lock(cache_t cache) : guard_(mutexes()[cache]) { }
+#else
+        cache_lock(cache_t cache) { (void)cache; }
+#endif
+        cache_lock(const cache_lock&) = delete;
+        cache_lock &operator=(const cache_lock&) = delete;
+
+#if EIDSP_LOCK_SHARED_STATE
+    private:
+        static std::mutex *mutexes() {
+            static std::mutex m[CACHE_COUNT];
+            return m;
+        }
+
+        std::lock_guard<std::mutex> guard_;
+#endif
+    };
+
     static float sqrt(float x) {
 #if EIDSP_USE_CMSIS_DSP
         float temp;
@@ -538,6 +575,81 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Discrete Cosine Transform type 2 over every row of a matrix, but only calculate
+     * the first output->cols coefficients (e.g. the cepstra we keep for MFCC).
+     * Instead of a full (FFT based) DCT per row this multiplies the whole input with a
+     * precomputed (truncated) DCT basis in one go, so no allocations per call.
+     * @param input Input matrix (rows x N)
+     * @param output Output matrix (rows x K), K <= N
+     * @returns EIDSP_OK if OK
+     */
+    static int dct2_truncated(matrix_t *input, matrix_t *output, DCT_NORMALIZATION_MODE normalization = DCT_NORMALIZATION_NONE) {
+        if (input->rows != output->rows || output->cols > input->cols) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (input->rows == 0 || output->cols == 0) {
+            return EIDSP_OK;
+        }
+
+        cache_lock lock(CACHE_DCT2_BASIS);
+        matrix_t *basis = dct2_basis(input->cols, output->cols, normalization);
+        if (!basis) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        return dot(input, basis, output);
+    }
+
+    /**
+     * Get the N x K DCT-II basis (column k holds coefficient k), this is calculated once
+     * and kept around until it's requested for a different size / normalization.
+     * @returns Basis, or nullptr if out of memory
+     */
+    static matrix_t *dct2_basis(size_t N, size_t K, DCT_NORMALIZATION_MODE normalization) {
+        static matrix_t *basis = nullptr;
+        static DCT_NORMALIZATION_MODE basis_normalization = DCT_NORMALIZATION_NONE;
+
+        if (basis && basis->rows == N && basis->cols == K && basis_normalization == normalization) {
+            return basis;
+        }
+
+        delete basis;
+        // kept across DSP runs, so not from the DSP arena
+        memory::arena_suspend();
+        basis = new matrix_t(N, K);
+        memory::arena_resume();
+        if (!basis->buffer) {
+            delete basis;
+            basis = nullptr;
+            return nullptr;
+        }
+        basis_normalization = normalization;
+
+        dct2_basis_fill(basis->buffer, N, K, normalization);
+
+        return basis;
+    }
+
+    /**
+     * Calculate the N x K DCT-II basis (column k holds coefficient k) into `basis`
+     */
+    static void dct2_basis_fill(float *basis, size_t N, size_t K, DCT_NORMALIZATION_MODE normalization) {
+        // same scaling as dct2(): unnormalized is 2 * sum, ortho scales row 0 by sqrt(1/N), others by sqrt(2/N)
+        const double pi = 3.14159265358979323846;
+        for (size_t k = 0; k < K; k++) {
+            double scale = 2.0;
+            if (normalization == DCT_NORMALIZATION_ORTHO) {
+                scale = k == 0 ? sqrt(1.0 / N) : sqrt(2.0 / N);
+            }
+            for (size_t n = 0; n < N; n++) {
+                basis[n * K + k] = static_cast<float>(
+                    scale * cos((pi * k * (2 * n + 1)) / (2.0 * N)));
+            }
+        }
+    }
+
     /**
      * Quantize a float value between zero and one
      * @param value Float value
@@ -1238,9 +1350,10 @@ public:
         }
         else {
             // hardware acceleration only works for the powers above...
-            arm_rfft_fast_instance_f32 rfft_instance;
-            int status = cmsis_rfft_init_f32(&rfft_instance, n_fft);
-            if (status != ARM_MATH_SUCCESS) {
+            cache_lock lock(CACHE_FFT_PLANS);
+            fft_plan_t *plan;
+            int status = fft_plan_get(n_fft, FFT_PLAN_BACKEND_CMSIS, &plan);
+            if (status != EIDSP_OK) {
                 return status;
             }
 
@@ -1249,7 +1362,7 @@ public:
                 EIDSP_ERR(EIDSP_OUT_OF_MEM);
             }
 
-            arm_rfft_fast_f32(&rfft_instance, fft_input.buffer, fft_output.buffer, 0);
+            arm_rfft_fast_f32(&plan->cmsis, fft_input.buffer, fft_output.buffer, 0);
 
             output[0] = fft_output.buffer[0];
             output[n_fft_out_features - 1] = fft_output.buffer[1];
@@ -1323,31 +1436,21 @@ public:
         }
         else {
             // hardware acceleration only works for the powers above...
-            arm_rfft_fast_instance_f32 rfft_instance;
-            int status = cmsis_rfft_init_f32(&rfft_instance, n_fft);
-            if (status != ARM_MATH_SUCCESS) {
+            cache_lock lock(CACHE_FFT_PLANS);
+            fft_plan_t *plan;
+            int status = fft_plan_get(n_fft, FFT_PLAN_BACKEND_CMSIS, &plan);
+            if (status != EIDSP_OK) {
                 return status;
             }
 
-            EI_DSP_MATRIX(fft_output, 1, n_fft);
-            if (!fft_output.buffer) {
-                EIDSP_ERR(EIDSP_OUT_OF_MEM);
-            }
-
-            arm_rfft_fast_f32(&rfft_instance, fft_input.buffer, fft_output.buffer, 0);
+            // CMSIS packs bin k at [2k, 2k + 1] (with the Nyquist real in the DC imag slot),
+            // which already is the fft_complex_t layout, so write straight into the output
+            float *fft_output = (float*)output;
+            arm_rfft_fast_f32(&plan->cmsis, fft_input.buffer, fft_output, 0);
 
-            output[0].r = fft_output.buffer[0];
-            output[0].i = 0.0f;
-            output[n_fft_out_features - 1].r = fft_output.buffer[1];
+            output[n_fft_out_features - 1].r = fft_output[1];
             output[n_fft_out_features - 1].i = 0.0f;
-
-            size_t fft_output_buffer_ix = 2;
-            for (size_t ix = 1; ix < n_fft_out_features - 1; ix += 1) {
-                output[ix].r = fft_output.buffer[fft_output_buffer_ix];
-                output[ix].i = fft_output.buffer[fft_output_buffer_ix + 1];
-
-                fft_output_buffer_ix += 2;
-            }
+            output[0].i = 0.0f;
         }
 #else
         int ret = software_rfft(fft_input.buffer, output, n_fft, n_fft_out_features);
@@ -1359,6 +1462,83 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Real FFT in Q15, same output as CMSIS-DSP `arm_rfft_q15` (which is used when available):
+     * every butterfly stage scales down by 2, so the output is the transform divided by n_fft
+     * (upscale by log2(n_fft) bits to get the actual transform).
+     * @param input n_fft samples, zero padded. Used as scratch, so it's modified
+     * @param output 2 * n_fft values (scratch), bin k is at [2k, 2k + 1] for k in 0..n_fft / 2
+     * @param n_fft Length of the FFT, a power of 2
+     * @returns 0 if OK
+     */
+    static int rfft_q15(EIDSP_i16 *input, EIDSP_i16 *output, size_t n_fft) {
+        if (n_fft < 2 || (n_fft & (n_fft - 1)) != 0) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+#if EIDSP_USE_CMSIS_DSP
+        if (n_fft >= 32 && n_fft <= 8192) {
+            arm_rfft_instance_q15 rfft_instance;
+            if (arm_rfft_init_q15(&rfft_instance, n_fft, 0, 1) != ARM_MATH_SUCCESS) {
+                EIDSP_ERR(EIDSP_FFT_TABLE_NOT_LOADED);
+            }
+            arm_rfft_q15(&rfft_instance, input, output);
+            return EIDSP_OK;
+        }
+#endif
+
+        // radix-2 decimation in time over the real input (imaginary part zero),
+        // with the twiddles in the input buffer once the input has been copied out
+        for (size_t ix = 0, rev = 0; ix < n_fft; ix++) {
+            output[2 * rev] = input[ix];
+            output[2 * rev + 1] = 0;
+            // increment the bit reversed index
+            size_t bit = n_fft >> 1;
+            while (rev & bit) {
+                rev ^= bit;
+                bit >>= 1;
+            }
+            rev |= bit;
+        }
+
+        // exp(-2 pi i k / n) by rotating, in double so it rounds the same as calculating every one
+        const double pi = 3.14159265358979323846;
+        const double step_r = cos(2.0 * pi / static_cast<double>(n_fft));
+        const double step_i = -sin(2.0 * pi / static_cast<double>(n_fft));
+        double w_r = 1.0;
+        double w_i = 0.0;
+        EIDSP_i16 *twiddles = input;
+        for (size_t k = 0; k < n_fft / 2; k++) {
+            twiddles[2 * k] = static_cast<EIDSP_i16>(floor(w_r * 32767.0 + 0.5));
+            twiddles[2 * k + 1] = static_cast<EIDSP_i16>(floor(w_i * 32767.0 + 0.5));
+            const double next_r = w_r * step_r - w_i * step_i;
+            w_i = w_r * step_i + w_i * step_r;
+            w_r = next_r;
+        }
+
+        for (size_t half = 1; half < n_fft; half *= 2) {
+            const size_t twiddle_step = n_fft / (2 * half);
+            for (size_t start = 0; start < n_fft; start += 2 * half) {
+                for (size_t k = 0; k < half; k++) {
+                    EIDSP_i16 *a = output + 2 * (start + k);
+                    EIDSP_i16 *b = output + 2 * (start + k + half);
+                    const int32_t wr = twiddles[2 * k * twiddle_step];
+                    const int32_t wi = twiddles[2 * k * twiddle_step + 1];
+                    const int32_t tr = (wr * b[0] - wi * b[1]) >> 15;
+                    const int32_t ti = (wr * b[1] + wi * b[0]) >> 15;
+                    const int32_t ar = a[0];
+                    const int32_t ai = a[1];
+                    a[0] = static_cast<EIDSP_i16>((ar + tr) >> 1);
+                    a[1] = static_cast<EIDSP_i16>((ai + ti) >> 1);
+                    b[0] = static_cast<EIDSP_i16>((ar - tr) >> 1);
+                    b[1] = static_cast<EIDSP_i16>((ai - ti) >> 1);
+                }
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
 
     /**
      * Return evenly spaced numbers over a specified interval.
@@ -1475,6 +1655,28 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Create a signal structure from an int16 buffer (e.g. PCM audio), get_data converts
+     * to float. The audio DSP blocks read such a signal directly (see signal_t::raw_i16).
+     * @param data Buffer, make sure to keep this pointer alive
+     * @param data_size Size of the buffer
+     * @param signal Output signal
+     * @returns EIDSP_OK if ok
+     */
+    static int signal_from_int16_buffer(const EIDSP_i16 *data, size_t data_size, signal_t *signal)
+    {
+        signal->total_length = data_size;
+        signal->raw_i16 = data;
+#ifdef __MBED__
+        signal->get_data = mbed::callback(&numpy::signal_get_data_int16_to_float, data);
+#else
+        signal->get_data = [data](size_t offset, size_t length, float *out_ptr) {
+            return numpy::signal_get_data_int16_to_float(data, offset, length, out_ptr);
+        };
+#endif
+        return EIDSP_OK;
+    }
+
 #endif
 
 #if defined ( __GNUC__ )
@@ -1686,26 +1888,23 @@ public:
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        size_t kiss_fftr_mem_length;
-
-        // create fftr context
-        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
-        if (!cfg) {
+        // get the (cached) fftr context
+        cache_lock lock(CACHE_FFT_PLANS);
+        fft_plan_t *plan;
+        int ret = fft_plan_get(n_fft, FFT_PLAN_BACKEND_KISSFFT, &plan);
+        if (ret != EIDSP_OK) {
             ei_dsp_free(fft_output, n_fft_out_features * sizeof(kiss_fft_cpx));
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            EIDSP_ERR(ret);
         }
 
-        ei_dsp_register_alloc(kiss_fftr_mem_length, cfg);
-
         // execute the rfft operation
-        kiss_fftr(cfg, fft_input, fft_output);
+        kiss_fftr(plan->kiss, fft_input, fft_output);
 
         // and write back to the output
         for (size_t ix = 0; ix < n_fft_out_features; ix++) {
             output[ix] = sqrt(pow(fft_output[ix].r, 2) + pow(fft_output[ix].i, 2));
         }
 
-        ei_dsp_free(cfg, kiss_fftr_mem_length);
         ei_dsp_free(fft_output, n_fft_out_features * sizeof(kiss_fft_cpx));
 
         return EIDSP_OK;
@@ -1713,24 +1912,149 @@ public:
 
     static int software_rfft(float *fft_input, fft_complex_t *output, size_t n_fft, size_t n_fft_out_features)
     {
-        // create fftr context
-        size_t kiss_fftr_mem_length;
+        // get the (cached) fftr context
+        cache_lock lock(CACHE_FFT_PLANS);
+        fft_plan_t *plan;
+        int ret = fft_plan_get(n_fft, FFT_PLAN_BACKEND_KISSFFT, &plan);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
 
-        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
-        if (!cfg) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        // execute the rfft operation
+        kiss_fftr(plan->kiss, fft_input, (kiss_fft_cpx*)output);
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * A real-input FFT plan: the kissfft config (incl. twiddles) or the CMSIS-DSP instance
+     */
+    typedef struct {
+        size_t n_fft; // 0 if the slot is unused
+        FFT_PLAN_BACKEND backend;
+        size_t bytes;
+        kiss_fftr_cfg kiss;
+#if EIDSP_USE_CMSIS_DSP
+        arm_rfft_fast_instance_f32 cmsis;
+#endif
+    } fft_plan_t;
+
+    /**
+     * Get the FFT plan for a length / backend. Plans are created on first use and then kept
+     * (process-wide) in a small cache, so e.g. MFCC does not rebuild the twiddles for every
+     * frame. When the cache is full the oldest plan is replaced.
+     * Plans hold scratch state, so hold a cache_lock on CACHE_FFT_PLANS from here until the
+     * transform is done.
+     * @param n_fft FFT length
+     * @param backend Implementation to create the plan for
+     * @param plan Out pointer to the plan, only valid until the next call
+     * @returns EIDSP_OK if OK
+     */
+    static int fft_plan_get(size_t n_fft, FFT_PLAN_BACKEND backend, fft_plan_t **plan) {
+        fft_plan_t *plans = fft_plan_cache();
+        fft_plan_cache_stats_t *stats = fft_plan_cache_counters();
+
+        for (size_t ix = 0; ix < EIDSP_FFT_PLAN_CACHE_SIZE; ix++) {
+            if (plans[ix].n_fft == n_fft && plans[ix].backend == backend) {
+                stats->hits++;
+                *plan = &plans[ix];
+                return EIDSP_OK;
+            }
         }
 
-        ei_dsp_register_alloc(kiss_fftr_mem_length, cfg);
+        stats->misses++;
 
-        // execute the rfft operation
-        kiss_fftr(cfg, fft_input, (kiss_fft_cpx*)output);
+        // find a free slot, or evict the oldest one
+        static size_t next_evict = 0;
+        fft_plan_t *slot = nullptr;
+        for (size_t ix = 0; ix < EIDSP_FFT_PLAN_CACHE_SIZE; ix++) {
+            if (plans[ix].n_fft == 0) {
+                slot = &plans[ix];
+                break;
+            }
+        }
+        if (!slot) {
+            slot = &plans[next_evict];
+            next_evict = (next_evict + 1) % EIDSP_FFT_PLAN_CACHE_SIZE;
+            fft_plan_free(slot);
+        }
+
+        if (backend == FFT_PLAN_BACKEND_KISSFFT) {
+            size_t kiss_fftr_mem_length;
+            slot->kiss = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
+            if (!slot->kiss) {
+                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+            }
+            slot->bytes = kiss_fftr_mem_length;
+        }
+        else {
+#if EIDSP_USE_CMSIS_DSP
+            int status = cmsis_rfft_init_f32(&slot->cmsis, n_fft);
+            if (status != ARM_MATH_SUCCESS) {
+                return status;
+            }
+            // the twiddle tables are const, so the plan is just the instance
+            slot->bytes = sizeof(arm_rfft_fast_instance_f32);
+#else
+            EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+#endif
+        }
 
-        ei_dsp_free(cfg, kiss_fftr_mem_length);
+        slot->n_fft = n_fft;
+        slot->backend = backend;
+        stats->plans++;
+        stats->bytes += slot->bytes;
 
+        *plan = slot;
         return EIDSP_OK;
     }
 
+    /**
+     * Free all cached FFT plans (e.g. when done with DSP and memory is needed elsewhere).
+     * Hit and miss counters are kept.
+     */
+    static void fft_plan_cache_clear() {
+        cache_lock lock(CACHE_FFT_PLANS);
+        fft_plan_t *plans = fft_plan_cache();
+        for (size_t ix = 0; ix < EIDSP_FFT_PLAN_CACHE_SIZE; ix++) {
+            fft_plan_free(&plans[ix]);
+        }
+    }
+
+    /**
+     * Get the FFT plan cache counters
+     */
+    static fft_plan_cache_stats_t fft_plan_cache_stats() {
+        cache_lock lock(CACHE_FFT_PLANS);
+        return *fft_plan_cache_counters();
+    }
+
+    static fft_plan_t *fft_plan_cache() {
+        static fft_plan_t plans[EIDSP_FFT_PLAN_CACHE_SIZE] = { };
+        return plans;
+    }
+
+    static fft_plan_cache_stats_t *fft_plan_cache_counters() {
+        static fft_plan_cache_stats_t stats = { };
+        return &stats;
+    }
+
+    static void fft_plan_free(fft_plan_t *plan) {
+        if (plan->n_fft == 0) {
+            return;
+        }
+
+        if (plan->kiss) {
+            kiss_fftr_free(plan->kiss);
+        }
+
+        fft_plan_cache_stats_t *stats = fft_plan_cache_counters();
+        stats->plans--;
+        stats->bytes -= plan->bytes;
+
+        memset(plan, 0, sizeof(fft_plan_t));
+    }
+
     static int signal_get_data(const float *in_buffer, size_t offset, size_t length, float *out_ptr)
     {
         memcpy(out_ptr, in_buffer + offset, length * sizeof(float));
@@ -1743,6 +2067,11 @@ public:
         return 0;
     }
 
+    static int signal_get_data_int16_to_float(const EIDSP_i16 *in_buffer, size_t offset, size_t length, float *out_ptr)
+    {
+        return int16_to_float(in_buffer + offset, out_ptr, length);
+    }
+
 #if EIDSP_USE_CMSIS_DSP
     /**
      * @brief      The CMSIS std variance function with the same behaviour as the NumPy
@@ -34,9 +34,9 @@
 #include "../porting/ei_classifier_porting.h"
 
 
-#if EIDSP_TRACK_ALLOCATIONS
+#ifdef __cplusplus
 #include "memory.hpp"
-#endif
+#endif // __cplusplus
 
 #ifdef __cplusplus
 namespace ei {
@@ -93,7 +93,7 @@ typedef struct ei_matrix {
             buffer_managed_by_me = false;
         }
         else {
-            buffer = (float*)ei_calloc(n_rows * n_cols * sizeof(float), 1);
+            buffer = (float*)ei::memory::arena_calloc(n_rows * n_cols * sizeof(float), 1);
             buffer_managed_by_me = true;
         }
         rows = n_rows;
@@ -118,7 +118,7 @@ typedef struct ei_matrix {
 
     ~ei_matrix() {
         if (buffer && buffer_managed_by_me) {
-            ei_free(buffer);
+            ei::memory::arena_free(buffer);
 
 #if EIDSP_TRACK_ALLOCATIONS
             if (_fn) {
@@ -192,7 +192,7 @@ typedef struct ei_matrix_i8 {
             buffer_managed_by_me = false;
         }
         else {
-            buffer = (int8_t*)ei_calloc(n_rows * n_cols * sizeof(int8_t), 1);
+            buffer = (int8_t*)ei::memory::arena_calloc(n_rows * n_cols * sizeof(int8_t), 1);
             buffer_managed_by_me = true;
         }
         rows = n_rows;
@@ -217,7 +217,7 @@ typedef struct ei_matrix_i8 {
 
     ~ei_matrix_i8() {
         if (buffer && buffer_managed_by_me) {
-            ei_free(buffer);
+            ei::memory::arena_free(buffer);
 
 #if EIDSP_TRACK_ALLOCATIONS
             if (_fn) {
@@ -288,7 +288,7 @@ typedef struct ei_matrix_i32 {
             buffer_managed_by_me = false;
         }
         else {
-            buffer = (int32_t*)ei_calloc(n_rows * n_cols * sizeof(int32_t), 1);
+            buffer = (int32_t*)ei::memory::arena_calloc(n_rows * n_cols * sizeof(int32_t), 1);
             buffer_managed_by_me = true;
         }
         rows = n_rows;
@@ -313,7 +313,7 @@ typedef struct ei_matrix_i32 {
 
     ~ei_matrix_i32() {
         if (buffer && buffer_managed_by_me) {
-            ei_free(buffer);
+            ei::memory::arena_free(buffer);
 
 #if EIDSP_TRACK_ALLOCATIONS
             if (_fn) {
@@ -395,7 +395,7 @@ typedef struct ei_quantized_matrix {
             buffer_managed_by_me = false;
         }
         else {
-            buffer = (uint8_t*)ei_calloc(n_rows * n_cols * sizeof(uint8_t), 1);
+            buffer = (uint8_t*)ei::memory::arena_calloc(n_rows * n_cols * sizeof(uint8_t), 1);
             buffer_managed_by_me = true;
         }
         rows = n_rows;
@@ -420,7 +420,7 @@ typedef struct ei_quantized_matrix {
 
     ~ei_quantized_matrix() {
         if (buffer && buffer_managed_by_me) {
-            ei_free(buffer);
+            ei::memory::arena_free(buffer);
 
 #if EIDSP_TRACK_ALLOCATIONS
             if (_fn) {
@@ -491,7 +491,7 @@ typedef struct ei_matrix_u8 {
             buffer_managed_by_me = false;
         }
         else {
-            buffer = (uint8_t*)ei_calloc(n_rows * n_cols * sizeof(uint8_t), 1);
+            buffer = (uint8_t*)ei::memory::arena_calloc(n_rows * n_cols * sizeof(uint8_t), 1);
             buffer_managed_by_me = true;
         }
         rows = n_rows;
@@ -516,7 +516,7 @@ typedef struct ei_matrix_u8 {
 
     ~ei_matrix_u8() {
         if (buffer && buffer_managed_by_me) {
-            ei_free(buffer);
+            ei::memory::arena_free(buffer);
 
 #if EIDSP_TRACK_ALLOCATIONS
             if (_fn) {
@@ -558,6 +558,24 @@ typedef enum {
     DCT_NORMALIZATION_ORTHO
 } DCT_NORMALIZATION_MODE;
 
+/**
+ * Implementation an FFT plan was created for
+ */
+typedef enum {
+    FFT_PLAN_BACKEND_KISSFFT,
+    FFT_PLAN_BACKEND_CMSIS
+} FFT_PLAN_BACKEND;
+
+/**
+ * FFT plan cache counters, see numpy::fft_plan_cache_stats()
+ */
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t plans; // plans currently in the cache
+    size_t bytes;   // memory held by the cached plans
+} fft_plan_cache_stats_t;
+
 /**
  * Sensor signal structure
  */
@@ -580,6 +598,13 @@ typedef struct ei_signal_t {
 #endif // EIDSP_SIGNAL_C_FN_POINTER == 1
 
     size_t total_length;
+
+    /**
+     * Optional, the int16 PCM buffer get_data reads from (see numpy::signal_from_int16_buffer).
+     * If set, the audio DSP blocks convert and preemphasize straight from it in one pass
+     * instead of going through get_data.
+     */
+    const EIDSP_i16 *raw_i16 = nullptr;
 } signal_t;
 
 #ifdef __cplusplus
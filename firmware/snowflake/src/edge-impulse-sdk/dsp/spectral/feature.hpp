@@ -473,6 +473,241 @@ public:
         return num_features;
     }
 
+    /**
+     * @brief Fixed point version of `extract_spec_features`, same arguments and features.
+     * Per axis the signal is converted to Q31 (with headroom for the filter), filtered by
+     * Q31 biquads and renormalized. Skew and kurtosis are calculated on the Q15 samples, and
+     * the Welch max hold uses a Q15 FFT on block scaled segments. Only the features
+     * themselves are converted back to float.
+     * The FFT length needs to be a power of 2.
+     *
+     * @return the number of features calculated
+     */
+    static size_t extract_spec_features_q(
+        matrix_t *input_matrix,
+        matrix_t *output_matrix,
+        ei_dsp_config_spectral_analysis_t *config,
+        const float sampling_freq,
+        const bool remove_mean = true,
+        const bool transpose_and_scale_input = true)
+    {
+        // filter_order is at most 8, but the Q31 filter handles up to 16
+        constexpr size_t max_filter_stages = 8;
+        // Butterworth stages overshoot, and the biquad accumulator doesn't saturate
+        constexpr int filter_headroom_bits = 4;
+
+        const size_t fft_length = config->fft_length;
+        if (fft_length < 2 || (fft_length & (fft_length - 1)) != 0) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        // scaling is folded into the conversion to Q31
+        float scale = 1.0f;
+        if (transpose_and_scale_input) {
+            // transpose the matrix so we have one row per axis
+            numpy::transpose_in_place(input_matrix);
+            scale = config->scale_axes;
+        }
+
+        bool do_filter = false;
+        bool is_high_pass = false;
+        EIDSP_i32 filter_coeffs[max_filter_stages * 5];
+        size_t filter_stages = 0;
+
+        if (strcmp(config->filter_type, "low") == 0 || strcmp(config->filter_type, "high") == 0) {
+            do_filter = true;
+            is_high_pass = strcmp(config->filter_type, "high") == 0;
+            if (config->filter_order) {
+                EI_TRY(filters::butterworth_biquad_q31(
+                    config->filter_order,
+                    sampling_freq,
+                    config->filter_cutoff,
+                    is_high_pass,
+                    filter_coeffs,
+                    max_filter_stages,
+                    &filter_stages));
+            }
+        }
+
+        // Figure bins we remove based on filter cutoff
+        size_t start_bin, stop_bin;
+        if (do_filter) {
+            get_start_stop_bin(
+                sampling_freq,
+                fft_length,
+                config->filter_cutoff,
+                &start_bin,
+                &stop_bin,
+                is_high_pass);
+        }
+        else {
+            start_bin = 1;
+            stop_bin = fft_length / 2 + 1;
+        }
+        size_t num_bins = stop_bin - start_bin;
+
+        const size_t data_size = input_matrix->cols;
+        const size_t fft_out_size = fft_length / 2 + 1;
+
+        // FFT input (n) and output (2n) in Q15, then the max hold
+        matrix_i32_t scratch(1, (3 * fft_length) / 2 + fft_out_size);
+        if (!scratch.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        EIDSP_i16 *fft_in = reinterpret_cast<EIDSP_i16*>(scratch.buffer);
+        EIDSP_i16 *fft_out = fft_in + fft_length;
+        float *max_hold = reinterpret_cast<float*>(scratch.buffer + (3 * fft_length) / 2);
+
+        float *feature_out = output_matrix->buffer;
+        const float *feature_out_ori = feature_out;
+        for (size_t row = 0; row < input_matrix->rows; row++) {
+            float *data_window = input_matrix->get_row_ptr(row);
+            // converted in place, a Q31 value takes as much room as a float
+            EIDSP_i32 *q = reinterpret_cast<EIDSP_i32*>(data_window);
+
+            // to Q31, lsb is the value of one Q31 step
+            float max_abs = 0.0f;
+            for (size_t i = 0; i < data_size; i++) {
+                max_abs = std::max(max_abs, fabsf(data_window[i] * scale));
+            }
+            float lsb = max_abs > 0.0f ? ldexpf(max_abs, -(31 - filter_headroom_bits)) : 1.0f;
+            const float to_q31 = scale / lsb;
+            for (size_t i = 0; i < data_size; i++) {
+                q[i] = static_cast<EIDSP_i32>(lrintf(data_window[i] * to_q31));
+            }
+
+            if (filter_stages > 0) {
+                EIDSP_i32 filter_state[max_filter_stages * 4] = { 0 };
+                filters::biquad_cascade_df1_q31(filter_coeffs, filter_state, filter_stages,
+                    q, q, data_size);
+            }
+
+            // remove the mean and renormalize, so the largest sample uses the full Q31 range
+            int64_t mean = 0;
+            if (remove_mean && data_size > 0) {
+                for (size_t i = 0; i < data_size; i++) {
+                    mean += q[i];
+                }
+                mean /= static_cast<int64_t>(data_size);
+            }
+            int64_t max_q = 0;
+            for (size_t i = 0; i < data_size; i++) {
+                int64_t v = q[i] - mean;
+                max_q = std::max(max_q, v < 0 ? -v : v);
+            }
+            int shift = 0;
+            while (max_q >= (static_cast<int64_t>(1) << 31)) {
+                max_q >>= 1;
+                shift--;
+            }
+            while (max_q > 0 && max_q < (static_cast<int64_t>(1) << 30)) {
+                max_q <<= 1;
+                shift++;
+            }
+            for (size_t i = 0; i < data_size; i++) {
+                int64_t v = q[i] - mean;
+                q[i] = static_cast<EIDSP_i32>(shift >= 0 ? v * (static_cast<int64_t>(1) << shift) : v >> -shift);
+            }
+            lsb = ldexpf(lsb, -shift);
+
+            // RMS, skew and kurtosis (mean is 0, see extract_spec_features) on the Q15 samples
+            int64_t sum_sq = 0;
+            int64_t sum_cube = 0;
+            int64_t sum_quad = 0;
+            for (size_t i = 0; i < data_size; i++) {
+                int32_t x = q[i] >> 16;
+                int32_t x2 = x * x;
+                sum_sq += x2;
+                sum_cube += static_cast<int64_t>(x2) * x;
+                sum_quad += (static_cast<int64_t>(x2) * x2) >> 15;
+            }
+            float rms = sqrtf(static_cast<float>(sum_sq) / data_size);
+            *feature_out++ = rms * ldexpf(lsb, 16);
+            if (sum_sq == 0) {
+                *feature_out++ = 0.0f;
+                *feature_out++ = -3.0f;
+            }
+            else {
+                float rms3 = rms * rms * rms;
+                // skew is Q45 / Q45, kurtosis Q45 / Q60
+                *feature_out++ = (static_cast<float>(sum_cube) / data_size) / rms3;
+                *feature_out++ = (ldexpf(static_cast<float>(sum_quad), 15) / data_size) / (rms3 * rms) - 3;
+            }
+
+            // Welch max hold, every segment scaled to the Q15 range on its own
+            memset(max_hold, 0, fft_out_size * sizeof(float));
+            const size_t hop = config->do_fft_overlap ? fft_length / 2 : fft_length;
+            for (size_t seg = 0; seg < data_size; seg += hop) {
+                const size_t n_points = seg + fft_length <= data_size ? fft_length : data_size - seg;
+
+                int32_t seg_max = 0;
+                for (size_t i = 0; i < n_points; i++) {
+                    seg_max = std::max(seg_max, q[seg + i] < 0 ? -q[seg + i] : q[seg + i]);
+                }
+                int seg_shift = 0;
+                while (seg_shift < 16 && (seg_max >> seg_shift) >= 32768) {
+                    seg_shift++;
+                }
+                for (size_t i = 0; i < n_points; i++) {
+                    fft_in[i] = static_cast<EIDSP_i16>(q[seg + i] >> seg_shift);
+                }
+                memset(fft_in + n_points, 0, (fft_length - n_points) * sizeof(EIDSP_i16));
+
+                EI_TRY(numpy::rfft_q15(fft_in, fft_out, fft_length));
+
+                // the FFT output is X / n, so power |X|^2 / n is |out|^2 * n
+                const float seg_lsb = ldexpf(lsb, seg_shift);
+                const float power_scale = seg_lsb * seg_lsb * static_cast<float>(fft_length);
+                for (size_t i = 0; i < fft_out_size; i++) {
+                    int64_t re = fft_out[2 * i];
+                    int64_t im = fft_out[2 * i + 1];
+                    max_hold[i] = std::max(max_hold[i], static_cast<float>(re * re + im * im) * power_scale);
+                }
+            }
+
+            if (config->implementation_version == 4) {
+                matrix_t x(1, fft_out_size, max_hold);
+                matrix_t out(1, 1);
+
+                *feature_out++ = (numpy::skew(&x, &out) == EIDSP_OK) ? (out.get_row_ptr(0)[0]) : 0.0f;
+                *feature_out++ = (numpy::kurtosis(&x, &out) == EIDSP_OK) ? (out.get_row_ptr(0)[0]) : 0.0f;
+            }
+            for (size_t i = start_bin; i < stop_bin; i++) {
+                feature_out[i - start_bin] = max_hold[i];
+            }
+            if (config->do_log) {
+                numpy::zero_handling(feature_out, num_bins);
+                ei_matrix temp(num_bins, 1, feature_out);
+                numpy::log10(&temp);
+            }
+            feature_out += num_bins;
+        }
+        size_t num_features = feature_out - feature_out_ori;
+        return num_features;
+    }
+
+    /**
+     * `extract_spec_features`, or `extract_spec_features_q` when EIDSP_SPECTRAL_FIXED_POINT
+     * is set (and the FFT length is a power of 2)
+     */
+    static size_t spec_features(
+        matrix_t *input_matrix,
+        matrix_t *output_matrix,
+        ei_dsp_config_spectral_analysis_t *config,
+        const float sampling_freq,
+        const bool remove_mean = true,
+        const bool transpose_and_scale_input = true)
+    {
+#if EIDSP_SPECTRAL_FIXED_POINT
+        if (config->fft_length >= 2 && (config->fft_length & (config->fft_length - 1)) == 0) {
+            return extract_spec_features_q(input_matrix, output_matrix, config, sampling_freq,
+                remove_mean, transpose_and_scale_input);
+        }
+#endif
+        return extract_spec_features(input_matrix, output_matrix, config, sampling_freq,
+            remove_mean, transpose_and_scale_input);
+    }
+
     static int extract_spectral_analysis_features_v2(
         matrix_t *input_matrix,
         matrix_t *output_matrix,
@@ -480,7 +715,7 @@ public:
         const float sampling_freq)
     {
         size_t n_features =
-            extract_spec_features(input_matrix, output_matrix, config, sampling_freq);
+            spec_features(input_matrix, output_matrix, config, sampling_freq);
         return n_features == output_matrix->cols ? EIDSP_OK : EIDSP_MATRIX_SIZE_MISMATCH;
     }
 
@@ -588,7 +823,7 @@ public:
         }
         else if (config->extra_low_freq == false && config->input_decimation_ratio == 1) {
             size_t n_features =
-                extract_spec_features(input_matrix, output_matrix, config, sampling_freq);
+                spec_features(input_matrix, output_matrix, config, sampling_freq);
             return n_features == output_matrix->cols ? EIDSP_OK : EIDSP_MATRIX_SIZE_MISMATCH;
         }
         else {
@@ -645,7 +880,7 @@ public:
             matrix_t lf_signal(input_matrix->rows, decimated_size);
             _decimate(input_matrix, &lf_signal, decimation);
 
-            size_t n_features = extract_spec_features(
+            size_t n_features = spec_features(
                 input_matrix,
                 output_matrix,
                 config,
@@ -658,7 +893,7 @@ public:
                 matrix_t lf_features(1, output_matrix->rows * output_matrix->cols - n_features,
                     output_matrix->buffer + n_features);
 
-                n_features += extract_spec_features(
+                n_features += spec_features(
                     &lf_signal,
                     &lf_features,
                     config,
@@ -140,6 +140,130 @@ namespace filters {
         ei_free(w2);
     }
 
+    // biquad coefficients can be up to 2, so they're stored as Q31 halved (CMSIS postShift)
+    static const uint8_t biquad_q31_post_shift = 1;
+
+    /**
+     * The Butterworth filter of `butterworth_lowpass` / `butterworth_highpass` as a cascade of
+     * biquads, in the CMSIS-DSP DF1 Q31 coefficient layout {b0, b1, b2, a1, a2} per stage,
+     * scaled down by `biquad_q31_post_shift`.
+     * @param filter_order Even filter order (between 2..8)
+     * @param sampling_freq Sample frequency of the signal
+     * @param cutoff_freq Cut-off frequency of the signal
+     * @param is_high_pass High pass (or low pass)
+     * @param coeffs Out, 5 coefficients per stage
+     * @param max_stages Number of stages that fit in coeffs
+     * @param stages Out, number of stages (filter_order / 2)
+     * @returns 0 if OK
+     */
+    static int butterworth_biquad_q31(
+        int filter_order,
+        float sampling_freq,
+        float cutoff_freq,
+        bool is_high_pass,
+        EIDSP_i32 *coeffs,
+        size_t max_stages,
+        size_t *stages)
+    {
+        int n_steps = filter_order / 2;
+        if (n_steps < 0 || static_cast<size_t>(n_steps) > max_stages) {
+            EIDSP_ERR(EIDSP_UNSUPPORTED_FILTER_CONFIG);
+        }
+
+        const float scale = static_cast<float>(1u << (31 - biquad_q31_post_shift));
+        auto to_q31 = [scale](float c) -> EIDSP_i32 {
+            float v = roundf(c * scale);
+            if (v >= 2147483647.0f) {
+                return INT32_MAX;
+            }
+            if (v <= -2147483648.0f) {
+                return INT32_MIN;
+            }
+            return static_cast<EIDSP_i32>(v);
+        };
+
+        // same parameters as the float filters
+        float a = tan(M_PI * cutoff_freq / sampling_freq);
+        float a2 = pow(a, 2);
+        for (int ix = 0; ix < n_steps; ix++) {
+            float r = sin(M_PI * ((2.0 * ix) + 1.0) / (2.0 * filter_order));
+            float s = a2 + (2.0 * a * r) + 1.0;
+            float A = is_high_pass ? 1.0f / s : a2 / s;
+            float d1 = 2.0 * (1 - a2) / s;
+            float d2 = -(a2 - (2.0 * a * r) + 1.0) / s;
+
+            // w0 = d1 * w1 + d2 * w2 + x, y = A * (w0 +- 2 * w1 + w2) as a DF1 biquad
+            EIDSP_i32 *c = coeffs + (ix * 5);
+            c[0] = to_q31(A);
+            c[1] = to_q31(is_high_pass ? -2.0f * A : 2.0f * A);
+            c[2] = to_q31(A);
+            c[3] = to_q31(d1);
+            c[4] = to_q31(d2);
+        }
+
+        *stages = n_steps;
+        return EIDSP_OK;
+    }
+
+    /**
+     * Run a cascade of DF1 biquads in Q31 (in place is fine), `arm_biquad_cascade_df1_q31` when
+     * CMSIS-DSP is available, otherwise the same calculation in plain C.
+     * The 64 bit accumulator doesn't saturate, leave a few bits of headroom in the input.
+     * @param coeffs Coefficients, see `butterworth_biquad_q31`
+     * @param state 4 values per stage, zero before the first call
+     * @param stages Number of stages
+     * @param src Source array
+     * @param dest Destination array
+     * @param size Size of both source and destination arrays
+     */
+    static void biquad_cascade_df1_q31(
+        const EIDSP_i32 *coeffs,
+        EIDSP_i32 *state,
+        size_t stages,
+        const EIDSP_i32 *src,
+        EIDSP_i32 *dest,
+        size_t size)
+    {
+        if (stages == 0) {
+            if (src != dest) {
+                memcpy(dest, src, size * sizeof(EIDSP_i32));
+            }
+            return;
+        }
+
+#if EIDSP_USE_CMSIS_DSP
+        arm_biquad_casd_df1_inst_q31 instance;
+        arm_biquad_cascade_df1_init_q31(&instance, stages, const_cast<EIDSP_i32*>(coeffs), state,
+            biquad_q31_post_shift);
+        arm_biquad_cascade_df1_q31(&instance, src, dest, size);
+#else
+        const int shift = 31 - biquad_q31_post_shift;
+        for (size_t stage = 0; stage < stages; stage++) {
+            const EIDSP_i32 *c = coeffs + (stage * 5);
+            EIDSP_i32 *st = state + (stage * 4);
+            EIDSP_i32 x1 = st[0], x2 = st[1], y1 = st[2], y2 = st[3];
+            const EIDSP_i32 *in = stage == 0 ? src : dest;
+
+            for (size_t sx = 0; sx < size; sx++) {
+                EIDSP_i32 x = in[sx];
+                int64_t acc = (int64_t)c[0] * x + (int64_t)c[1] * x1 + (int64_t)c[2] * x2 +
+                    (int64_t)c[3] * y1 + (int64_t)c[4] * y2;
+                EIDSP_i32 y = static_cast<EIDSP_i32>(acc >> shift);
+                x2 = x1;
+                x1 = x;
+                y2 = y1;
+                y1 = y;
+                dest[sx] = y;
+            }
+
+            st[0] = x1;
+            st[1] = x2;
+            st[2] = y1;
+            st[3] = y2;
+        }
+#endif
+    }
+
 } // namespace filters
 } // namespace spectral
 } // namespace ei
@@ -21,5 +21,6 @@
 #include "../config.hpp"
 #include "processing.hpp"
 #include "feature.hpp"
+#include "stream_filter.hpp"
 
 #endif // _EIDSP_SPECTRAL_SPECTRAL_H_
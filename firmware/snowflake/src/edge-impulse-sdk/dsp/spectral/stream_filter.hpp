@@ -0,0 +1,482 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _EIDSP_SPECTRAL_STREAM_FILTER_H_
+#define _EIDSP_SPECTRAL_STREAM_FILTER_H_
+
+#include <math.h>
+#include <type_traits>
+#include "../config.hpp"
+#include "../numpy.hpp"
+#include "../returntypes.hpp"
+#include "filters.hpp"
+
+namespace ei {
+namespace spectral {
+
+/**
+ * A filter over a continuous signal. The delay line is kept between calls, so the stream
+ * can be fed in blocks of any size and gives the same output as filtering it in one go;
+ * every sample goes through the filter exactly once.
+ * Samples are floats in the range of the signal (e.g. int16 PCM values for audio).
+ */
+class stream_filter {
+public:
+    virtual ~stream_filter() { }
+
+    /**
+     * Filter the next `size` samples of the stream (src and dest can be the same)
+     * @returns EIDSP_OK if OK
+     */
+    virtual int run(const float *src, float *dest, size_t size) = 0;
+
+    /**
+     * Clear the delay line, e.g. when there's a gap in the stream
+     */
+    virtual void reset() = 0;
+};
+
+namespace stream_filter_internal {
+    /**
+     * Float samples (full_scale = 1.0) to Q15 / Q31, saturating
+     */
+    static inline void to_q(const float *src, EIDSP_i16 *dest, size_t size, float scale) {
+        for (size_t ix = 0; ix < size; ix++) {
+            float v = roundf(src[ix] * scale * 32768.0f);
+            dest[ix] = v >= 32767.0f ? INT16_MAX : (v <= -32768.0f ? INT16_MIN : static_cast<EIDSP_i16>(v));
+        }
+    }
+
+    static inline void to_q(const float *src, EIDSP_i32 *dest, size_t size, float scale) {
+        for (size_t ix = 0; ix < size; ix++) {
+            float v = roundf(src[ix] * scale * 2147483648.0f);
+            dest[ix] = v >= 2147483647.0f ? INT32_MAX : (v <= -2147483648.0f ? INT32_MIN : static_cast<EIDSP_i32>(v));
+        }
+    }
+
+    static inline void from_q(const EIDSP_i16 *src, float *dest, size_t size, float full_scale) {
+        const float scale = full_scale / 32768.0f;
+        for (size_t ix = 0; ix < size; ix++) {
+            dest[ix] = static_cast<float>(src[ix]) * scale;
+        }
+    }
+
+    static inline void from_q(const EIDSP_i32 *src, float *dest, size_t size, float full_scale) {
+        const float scale = full_scale / 2147483648.0f;
+        for (size_t ix = 0; ix < size; ix++) {
+            dest[ix] = static_cast<float>(src[ix]) * scale;
+        }
+    }
+
+    static inline EIDSP_i16 tap_to_q(float tap, EIDSP_i16) {
+        EIDSP_i16 q;
+        to_q(&tap, &q, 1, 1.0f);
+        return q;
+    }
+
+    static inline EIDSP_i32 tap_to_q(float tap, EIDSP_i32) {
+        EIDSP_i32 q;
+        to_q(&tap, &q, 1, 1.0f);
+        return q;
+    }
+
+    static inline float tap_to_q(float tap, float) {
+        return tap;
+    }
+
+    /**
+     * One block of FIR output, the last (num_taps - 1) inputs sit in front of the block in
+     * `state`. Taps are time reversed (CMSIS order).
+     */
+    static inline void fir_block(const float *taps, size_t num_taps, const float *state, float *dest, size_t size) {
+        for (size_t ix = 0; ix < size; ix++) {
+            const float *x = state + ix;
+            float acc = 0.0f;
+            for (size_t t = 0; t < num_taps; t++) {
+                acc += taps[t] * x[t];
+            }
+            dest[ix] = acc;
+        }
+    }
+
+    static inline void fir_block(const EIDSP_i16 *taps, size_t num_taps, const EIDSP_i16 *state, EIDSP_i16 *dest, size_t size) {
+        // 34.30 accumulator, like arm_fir_q15
+        for (size_t ix = 0; ix < size; ix++) {
+            const EIDSP_i16 *x = state + ix;
+            int64_t acc = 0;
+            for (size_t t = 0; t < num_taps; t++) {
+                acc += static_cast<int32_t>(taps[t]) * x[t];
+            }
+            acc >>= 15;
+            dest[ix] = acc > INT16_MAX ? INT16_MAX : (acc < INT16_MIN ? INT16_MIN : static_cast<EIDSP_i16>(acc));
+        }
+    }
+
+    static inline void fir_block(const EIDSP_i32 *taps, size_t num_taps, const EIDSP_i32 *state, EIDSP_i32 *dest, size_t size) {
+        // 2.62 accumulator, like arm_fir_q31
+        for (size_t ix = 0; ix < size; ix++) {
+            const EIDSP_i32 *x = state + ix;
+            int64_t acc = 0;
+            for (size_t t = 0; t < num_taps; t++) {
+                acc += static_cast<int64_t>(taps[t]) * x[t];
+            }
+            dest[ix] = static_cast<EIDSP_i32>(acc >> 31);
+        }
+    }
+} // namespace stream_filter_internal
+
+/**
+ * Streaming FIR filter in float, Q15 or Q31 (`arm_fir_f32` / `_q15` / `_q31` with CMSIS-DSP).
+ * Input is copied into a delay line of (num_taps - 1 + EIDSP_STREAM_FILTER_BLOCK) samples
+ * and filtered in blocks of up to EIDSP_STREAM_FILTER_BLOCK.
+ *
+ * @tparam T float, EIDSP_i16 (Q15) or EIDSP_i32 (Q31)
+ */
+template<typename T>
+class stream_fir : public stream_filter {
+public:
+    /**
+     * @param taps Filter taps (b[0] first), for Q15 / Q31 they're converted and need to be in [-1, 1)
+     * @param num_taps Number of taps
+     * @param full_scale For Q15 / Q31, the float sample value that maps to 1.0 in `run(const float*...)`
+     */
+    stream_fir(const float *taps, size_t num_taps, float full_scale = 32768.0f)
+        : _full_scale(full_scale)
+    {
+        // arm_fir_init_q15 needs an even number of taps, at least 4; trailing zero taps don't change the output
+        _num_taps = num_taps == 0 ? 1 : num_taps;
+        if (std::is_same<T, EIDSP_i16>::value) {
+            _num_taps = _num_taps < 4 ? 4 : _num_taps + (_num_taps & 1);
+        }
+
+        _taps = (T*)ei_calloc(_num_taps, sizeof(T));
+        _state = (T*)ei_calloc(_num_taps - 1 + EIDSP_STREAM_FILTER_BLOCK, sizeof(T));
+        if (!_taps || !_state) {
+            return;
+        }
+
+        // CMSIS keeps the taps time reversed
+        for (size_t ix = 0; ix < num_taps; ix++) {
+            _taps[_num_taps - 1 - ix] = stream_filter_internal::tap_to_q(taps[ix], T());
+        }
+
+#if EIDSP_USE_CMSIS_DSP
+        init_instance();
+#endif
+    }
+
+    ~stream_fir() {
+        ei_free(_taps);
+        ei_free(_state);
+    }
+
+    // owns its taps and delay line, copies would free them twice
+    stream_fir(const stream_fir&) = delete;
+    stream_fir &operator=(const stream_fir&) = delete;
+
+    /**
+     * Whether the filter could be allocated
+     */
+    bool is_valid() const {
+        return _taps && _state;
+    }
+
+    /**
+     * Filter the next `size` samples in the native format (src and dest can be the same)
+     */
+    int run_native(const T *src, T *dest, size_t size) {
+        if (!is_valid()) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        while (size > 0) {
+            const size_t block = size < EIDSP_STREAM_FILTER_BLOCK ? size : EIDSP_STREAM_FILTER_BLOCK;
+#if EIDSP_USE_CMSIS_DSP
+            cmsis_fir(src, dest, block);
+#else
+            T *history = _state + (_num_taps - 1);
+            memcpy(history, src, block * sizeof(T));
+            stream_filter_internal::fir_block(_taps, _num_taps, _state, dest, block);
+            memmove(_state, _state + block, (_num_taps - 1) * sizeof(T));
+#endif
+            src += block;
+            dest += block;
+            size -= block;
+        }
+        return EIDSP_OK;
+    }
+
+    int run(const float *src, float *dest, size_t size) override {
+        if (std::is_same<T, float>::value) {
+            return run_native((const T*)src, (T*)dest, size);
+        }
+
+        T buffer[EIDSP_STREAM_FILTER_BLOCK];
+        while (size > 0) {
+            const size_t block = size < EIDSP_STREAM_FILTER_BLOCK ? size : EIDSP_STREAM_FILTER_BLOCK;
+            convert_in(src, buffer, block);
+            int ret = run_native(buffer, buffer, block);
+            if (ret != EIDSP_OK) {
+                return ret;
+            }
+            convert_out(buffer, dest, block);
+            src += block;
+            dest += block;
+            size -= block;
+        }
+        return EIDSP_OK;
+    }
+
+    void reset() override {
+        if (_state) {
+            memset(_state, 0, (_num_taps - 1 + EIDSP_STREAM_FILTER_BLOCK) * sizeof(T));
+        }
+    }
+
+private:
+    void convert_in(const float *src, float *dest, size_t size) {
+        memcpy(dest, src, size * sizeof(float));
+    }
+    template<typename Q>
+    void convert_in(const float *src, Q *dest, size_t size) {
+        stream_filter_internal::to_q(src, dest, size, 1.0f / _full_scale);
+    }
+    void convert_out(const float *src, float *dest, size_t size) {
+        memcpy(dest, src, size * sizeof(float));
+    }
+    template<typename Q>
+    void convert_out(const Q *src, float *dest, size_t size) {
+        stream_filter_internal::from_q(src, dest, size, _full_scale);
+    }
+
+#if EIDSP_USE_CMSIS_DSP
+    void init_instance() {
+        cmsis_init(&_instance);
+    }
+    void cmsis_init(arm_fir_instance_f32 *instance) {
+        arm_fir_init_f32(instance, _num_taps, (float32_t*)_taps, (float32_t*)_state, EIDSP_STREAM_FILTER_BLOCK);
+    }
+    void cmsis_init(arm_fir_instance_q15 *instance) {
+        arm_fir_init_q15(instance, _num_taps, (q15_t*)_taps, (q15_t*)_state, EIDSP_STREAM_FILTER_BLOCK);
+    }
+    void cmsis_init(arm_fir_instance_q31 *instance) {
+        arm_fir_init_q31(instance, _num_taps, (q31_t*)_taps, (q31_t*)_state, EIDSP_STREAM_FILTER_BLOCK);
+    }
+    void cmsis_fir(const float *src, float *dest, size_t size) {
+        arm_fir_f32(&_instance, src, dest, size);
+    }
+    void cmsis_fir(const EIDSP_i16 *src, EIDSP_i16 *dest, size_t size) {
+        arm_fir_q15(&_instance, src, dest, size);
+    }
+    void cmsis_fir(const EIDSP_i32 *src, EIDSP_i32 *dest, size_t size) {
+        arm_fir_q31(&_instance, src, dest, size);
+    }
+
+    typedef typename std::conditional<std::is_same<T, float>::value, arm_fir_instance_f32,
+        typename std::conditional<std::is_same<T, EIDSP_i16>::value, arm_fir_instance_q15,
+            arm_fir_instance_q31>::type>::type instance_t;
+
+    instance_t _instance;
+#endif
+
+    float _full_scale;
+    size_t _num_taps;
+    T *_taps = nullptr;
+    T *_state = nullptr;
+};
+
+/**
+ * Streaming cascade of biquads in float, in scipy's second order sections layout
+ * {b0, b1, b2, a0, a1, a2} per section (see signal::sosfilt), run as transposed direct
+ * form II (`arm_biquad_cascade_df2T_f32` with CMSIS-DSP).
+ */
+class stream_biquad_f32 : public stream_filter {
+public:
+    /**
+     * @param sos Second order sections, 6 coefficients per section
+     * @param num_sections Number of sections
+     */
+    stream_biquad_f32(const float *sos, size_t num_sections)
+        : _num_sections(num_sections)
+    {
+        _coeffs = (float*)ei_calloc(num_sections * 5, sizeof(float));
+        _state = (float*)ei_calloc(num_sections * 2, sizeof(float));
+        if (!_coeffs || !_state) {
+            return;
+        }
+
+        // normalized by a0, with the feedback coefficients negated (CMSIS layout)
+        for (size_t ix = 0; ix < num_sections; ix++) {
+            const float *s = sos + (ix * 6);
+            float *c = _coeffs + (ix * 5);
+            c[0] = s[0] / s[3];
+            c[1] = s[1] / s[3];
+            c[2] = s[2] / s[3];
+            c[3] = -s[4] / s[3];
+            c[4] = -s[5] / s[3];
+        }
+
+#if EIDSP_USE_CMSIS_DSP
+        arm_biquad_cascade_df2T_init_f32(&_instance, num_sections, _coeffs, _state);
+#endif
+    }
+
+    ~stream_biquad_f32() {
+        ei_free(_coeffs);
+        ei_free(_state);
+    }
+
+    stream_biquad_f32(const stream_biquad_f32&) = delete;
+    stream_biquad_f32 &operator=(const stream_biquad_f32&) = delete;
+
+    bool is_valid() const {
+        return _coeffs && _state;
+    }
+
+    int run(const float *src, float *dest, size_t size) override {
+        if (!is_valid()) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        if (_num_sections == 0) {
+            if (src != dest) {
+                memcpy(dest, src, size * sizeof(float));
+            }
+            return EIDSP_OK;
+        }
+
+#if EIDSP_USE_CMSIS_DSP
+        arm_biquad_cascade_df2T_f32(&_instance, src, dest, size);
+#else
+        for (size_t stage = 0; stage < _num_sections; stage++) {
+            const float *c = _coeffs + (stage * 5);
+            float *st = _state + (stage * 2);
+            float d1 = st[0], d2 = st[1];
+            const float *in = stage == 0 ? src : dest;
+
+            for (size_t sx = 0; sx < size; sx++) {
+                float x = in[sx];
+                float y = c[0] * x + d1;
+                d1 = c[1] * x + c[3] * y + d2;
+                d2 = c[2] * x + c[4] * y;
+                dest[sx] = y;
+            }
+
+            st[0] = d1;
+            st[1] = d2;
+        }
+#endif
+        return EIDSP_OK;
+    }
+
+    void reset() override {
+        if (_state) {
+            memset(_state, 0, _num_sections * 2 * sizeof(float));
+        }
+    }
+
+private:
+    size_t _num_sections;
+    float *_coeffs = nullptr;
+    float *_state = nullptr;
+#if EIDSP_USE_CMSIS_DSP
+    arm_biquad_cascade_df2T_instance_f32 _instance;
+#endif
+};
+
+/**
+ * Streaming cascade of DF1 biquads in Q31 (see filters::biquad_cascade_df1_q31), e.g. the
+ * Butterworth filter from filters::butterworth_biquad_q31.
+ */
+class stream_biquad_q31 : public stream_filter {
+public:
+    /**
+     * @param coeffs 5 coefficients per stage, see filters::butterworth_biquad_q31 (copied)
+     * @param stages Number of stages
+     * @param full_scale The float sample value that maps to 1.0 in `run(const float*...)`
+     * @param headroom_bits The float input is scaled down by this many bits, as the filter
+     *                      doesn't saturate internally
+     */
+    stream_biquad_q31(const EIDSP_i32 *coeffs, size_t stages, float full_scale = 32768.0f, uint8_t headroom_bits = 4)
+        : _stages(stages), _full_scale(full_scale), _headroom_bits(headroom_bits)
+    {
+        _coeffs = (EIDSP_i32*)ei_calloc(stages * 5 + 1, sizeof(EIDSP_i32));
+        _state = (EIDSP_i32*)ei_calloc(stages * 4 + 1, sizeof(EIDSP_i32));
+        if (_coeffs) {
+            memcpy(_coeffs, coeffs, stages * 5 * sizeof(EIDSP_i32));
+        }
+    }
+
+    ~stream_biquad_q31() {
+        ei_free(_coeffs);
+        ei_free(_state);
+    }
+
+    stream_biquad_q31(const stream_biquad_q31&) = delete;
+    stream_biquad_q31 &operator=(const stream_biquad_q31&) = delete;
+
+    bool is_valid() const {
+        return _coeffs && _state;
+    }
+
+    /**
+     * Filter the next `size` Q31 samples (src and dest can be the same)
+     */
+    int run_native(const EIDSP_i32 *src, EIDSP_i32 *dest, size_t size) {
+        if (!is_valid()) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        filters::biquad_cascade_df1_q31(_coeffs, _state, _stages, src, dest, size);
+        return EIDSP_OK;
+    }
+
+    int run(const float *src, float *dest, size_t size) override {
+        const float headroom = static_cast<float>(1u << _headroom_bits);
+        EIDSP_i32 buffer[EIDSP_STREAM_FILTER_BLOCK];
+
+        while (size > 0) {
+            const size_t block = size < EIDSP_STREAM_FILTER_BLOCK ? size : EIDSP_STREAM_FILTER_BLOCK;
+            stream_filter_internal::to_q(src, buffer, block, 1.0f / (_full_scale * headroom));
+            int ret = run_native(buffer, buffer, block);
+            if (ret != EIDSP_OK) {
+                return ret;
+            }
+            stream_filter_internal::from_q(buffer, dest, block, _full_scale * headroom);
+            src += block;
+            dest += block;
+            size -= block;
+        }
+        return EIDSP_OK;
+    }
+
+    void reset() override {
+        if (_state) {
+            memset(_state, 0, _stages * 4 * sizeof(EIDSP_i32));
+        }
+    }
+
+private:
+    size_t _stages;
+    float _full_scale;
+    uint8_t _headroom_bits;
+    EIDSP_i32 *_coeffs = nullptr;
+    EIDSP_i32 *_state = nullptr;
+};
+
+} // namespace spectral
+} // namespace ei
+
+#endif // _EIDSP_SPECTRAL_STREAM_FILTER_H_
@@ -538,6 +538,286 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Compute Mel-filterbank energy features from an audio signal, same output as `mfe`.
+     * Frames are pushed through the pipeline in blocks of EIDSP_MFE_BLOCK_FRAMES (fetch,
+     * rfft, then power spectrum + mel weighting fused in one pass over the bins), and all
+     * buffers live in one scratch arena of `calculate_mfe_batched_scratch_size` floats,
+     * so there are no allocations per frame.
+     * See `mfe` for the parameters.
+     * @EIDSP_OK if OK
+     */
+    static int mfe_batched(matrix_t *out_features, matrix_t *out_energies,
+        signal_t *signal,
+        uint32_t sampling_frequency,
+        float frame_length, float frame_stride, uint16_t num_filters,
+        uint16_t fft_length, uint32_t low_frequency, uint32_t high_frequency,
+        uint16_t version
+        )
+    {
+        int ret = 0;
+
+        if (high_frequency == 0) {
+            high_frequency = sampling_frequency / 2;
+        }
+
+        if (version<4) {
+            if (low_frequency == 0) {
+                low_frequency = 300;
+            }
+        }
+
+        stack_frames_info_t stack_frame_info = { 0 };
+        stack_frame_info.signal = signal;
+
+        ret = processing::stack_frames(
+            &stack_frame_info,
+            sampling_frequency,
+            frame_length,
+            frame_stride,
+            false,
+            version
+        );
+        if (ret != 0) {
+            EIDSP_ERR(ret);
+        }
+
+        const size_t frame_count = stack_frame_info.frame_ixs.size();
+
+        if (frame_count != out_features->rows) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (num_filters != out_features->cols) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (out_energies) {
+            if (frame_count != out_energies->rows || out_energies->cols != 1) {
+                EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+            }
+        }
+
+        memset(out_features->buffer, 0, out_features->rows * out_features->cols * sizeof(float));
+
+        if (frame_count == 0) {
+            return EIDSP_OK;
+        }
+
+        const size_t power_spectrum_frame_size = (fft_length / 2 + 1);
+        const size_t frame_slot_size = mfe_batched_frame_slot_size(stack_frame_info.frame_length, fft_length);
+        const size_t block_frames = frame_count < EIDSP_MFE_BLOCK_FRAMES ? frame_count : EIDSP_MFE_BLOCK_FRAMES;
+
+        // one arena for everything, carved up below
+        EI_DSP_MATRIX(scratch, 1, calculate_mfe_batched_scratch_size(
+            signal->total_length, sampling_frequency, frame_length, frame_stride,
+            num_filters, fft_length, version));
+        if (!scratch.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        float *frames = scratch.buffer;
+        fft_complex_t *spectra = (fft_complex_t*)(frames + block_frames * frame_slot_size);
+        float *mels = (float*)(spectra + block_frames * power_spectrum_frame_size);
+        float *weights = mels + (num_filters + 2);
+        uint16_t *weight_filters = (uint16_t*)(weights + mfe_batched_max_weights(num_filters, fft_length));
+        uint16_t *bin_offsets = weight_filters + mfe_batched_max_weights(num_filters, fft_length);
+
+        ret = mfe_batched_filterbank(mels, sampling_frequency, num_filters, fft_length,
+            low_frequency, high_frequency, version, weights, weight_filters, bin_offsets);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        const float power_scale = 1.0f / static_cast<float>(fft_length);
+
+        for (size_t block_ix = 0; block_ix < frame_count; block_ix += block_frames) {
+            const size_t frames_in_block = frame_count - block_ix < block_frames ?
+                frame_count - block_ix : block_frames;
+
+            // stage 1: fetch the frames, zero padded to the FFT length
+            for (size_t f = 0; f < frames_in_block; f++) {
+                float *frame = frames + f * frame_slot_size;
+                size_t signal_offset = stack_frame_info.frame_ixs.at(block_ix + f);
+                size_t signal_length = stack_frame_info.frame_length;
+                // don't read outside of the audio buffer
+                if (signal_offset + signal_length > stack_frame_info.signal->total_length) {
+                    signal_length = stack_frame_info.signal->total_length > signal_offset ?
+                        stack_frame_info.signal->total_length - signal_offset : 0;
+                }
+
+                ret = stack_frame_info.signal->get_data(signal_offset, signal_length, frame);
+                if (ret != 0) {
+                    EIDSP_ERR(ret);
+                }
+                if (signal_length < fft_length) {
+                    memset(frame + signal_length, 0, (fft_length - signal_length) * sizeof(float));
+                }
+            }
+
+            // stage 2: FFT every frame
+            for (size_t f = 0; f < frames_in_block; f++) {
+                ret = numpy::rfft(frames + f * frame_slot_size, fft_length,
+                    spectra + f * power_spectrum_frame_size, power_spectrum_frame_size, fft_length);
+                if (ret != EIDSP_OK) {
+                    EIDSP_ERR(ret);
+                }
+            }
+
+            // stage 3: power spectrum, energy and mel weighting in one go
+            for (size_t f = 0; f < frames_in_block; f++) {
+                const fft_complex_t *spectrum = spectra + f * power_spectrum_frame_size;
+                float *row_ptr = out_features->get_row_ptr(block_ix + f);
+                float energy = 0.0f;
+
+                for (size_t bin = 0; bin < power_spectrum_frame_size; bin++) {
+                    float power = power_scale *
+                        (spectrum[bin].r * spectrum[bin].r + spectrum[bin].i * spectrum[bin].i);
+                    energy += power;
+
+                    for (size_t w = bin_offsets[bin]; w < bin_offsets[bin + 1]; w++) {
+                        row_ptr[weight_filters[w]] += weights[w] * power;
+                    }
+                }
+
+                if (out_energies) {
+                    out_energies->buffer[block_ix + f] = energy == 0 ? 1e-10 : energy;
+                }
+            }
+        }
+
+        numpy::zero_handling(out_features);
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Calculate the scratch arena size for `mfe_batched`
+     * @returns Size in floats
+     */
+    static size_t calculate_mfe_batched_scratch_size(
+        size_t signal_length,
+        uint32_t sampling_frequency,
+        float frame_length, float frame_stride, uint16_t num_filters,
+        uint16_t fft_length, uint16_t version)
+    {
+        matrix_size_t mfe_size = calculate_mfe_buffer_size(
+            signal_length, sampling_frequency, frame_length, frame_stride, num_filters, version);
+
+        size_t block_frames = mfe_size.rows < EIDSP_MFE_BLOCK_FRAMES ? mfe_size.rows : EIDSP_MFE_BLOCK_FRAMES;
+        // upper bound, v1 rounds instead
+        size_t frame_length_samples = (size_t)processing::ceil_unless_very_close_to_floor(
+            static_cast<float>(sampling_frequency) * frame_length);
+        size_t power_spectrum_frame_size = fft_length / 2 + 1;
+        size_t max_weights = mfe_batched_max_weights(num_filters, fft_length);
+
+        return block_frames * mfe_batched_frame_slot_size(frame_length_samples, fft_length) + // frames
+            block_frames * power_spectrum_frame_size * 2 +                                    // spectra
+            (num_filters + 2) +                                                               // mels / bins
+            max_weights +                                                                     // weights
+            (max_weights + power_spectrum_frame_size + 1 + 1) / 2;                            // uint16 indices
+    }
+
+    /**
+     * Build the mel filterbank for `mfe_batched` as a per bin list of (filter, weight), so the
+     * power spectrum and the mel weighting can be done in a single pass over the bins.
+     * Same weights as `mfe`. low_frequency and high_frequency must already be defaulted.
+     * @param mels Scratch, num_filters + 2 floats
+     * @param weights Out, mfe_batched_max_weights() weights
+     * @param weight_filters Out, filter index for every weight
+     * @param bin_offsets Out, fft_length / 2 + 2 offsets, the weights of bin b are at
+     *     [bin_offsets[b], bin_offsets[b + 1])
+     * @returns EIDSP_OK if OK
+     */
+    static int mfe_batched_filterbank(float *mels, uint32_t sampling_frequency,
+        uint16_t num_filters, uint16_t fft_length, uint32_t low_frequency, uint32_t high_frequency,
+        uint16_t version, float *weights, uint16_t *weight_filters, uint16_t *bin_offsets)
+    {
+        const size_t power_spectrum_frame_size = (fft_length / 2 + 1);
+        const int MELS_SIZE = num_filters + 2;
+        uint16_t *bins = reinterpret_cast<uint16_t*>(mels); // alias the mels array so we can reuse the space
+
+        numpy::linspace(
+            functions::frequency_to_mel(static_cast<float>(low_frequency)),
+            functions::frequency_to_mel(static_cast<float>(high_frequency)),
+            num_filters + 2,
+            mels);
+
+        uint16_t max_bin = version >= 4 ? fft_length : power_spectrum_frame_size; // preserve a bug in v<4
+        for (uint16_t ix = 0; ix < MELS_SIZE-1; ix++) {
+            mels[ix] = functions::mel_to_frequency(mels[ix]);
+            if (mels[ix] < low_frequency) {
+                mels[ix] = low_frequency;
+            }
+            if (mels[ix] > high_frequency) {
+                mels[ix] = high_frequency;
+            }
+            bins[ix] = get_fft_bin_from_hertz(max_bin, mels[ix], sampling_frequency);
+        }
+
+        // same Speechpy last bucket adjustment as in mfe
+        mels[MELS_SIZE-1] = functions::mel_to_frequency(mels[MELS_SIZE-1]);
+        if (mels[MELS_SIZE-1] > high_frequency) {
+            mels[MELS_SIZE-1] = high_frequency;
+        }
+        mels[MELS_SIZE-1] -= 0.001;
+        bins[MELS_SIZE-1] = get_fft_bin_from_hertz(max_bin, mels[MELS_SIZE-1], sampling_frequency);
+
+        // middle is 1.0, left and right are zero and skipped
+        memset(bin_offsets, 0, (power_spectrum_frame_size + 1) * sizeof(uint16_t));
+        for (size_t i = 0; i < num_filters; i++) {
+            size_t left = bins[i];
+            size_t middle = bins[i+1];
+            size_t right = bins[i+2];
+            if (right >= power_spectrum_frame_size) {
+                EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+            }
+            for (size_t bin = left + 1; bin < right; bin++) {
+                bin_offsets[bin + 1]++;
+            }
+            if (middle <= left || middle >= right) {
+                bin_offsets[middle + 1]++;
+            }
+        }
+        for (size_t bin = 0; bin < power_spectrum_frame_size; bin++) {
+            bin_offsets[bin + 1] += bin_offsets[bin];
+        }
+        for (size_t i = 0; i < num_filters; i++) {
+            size_t left = bins[i];
+            size_t middle = bins[i+1];
+            size_t right = bins[i+2];
+            for (size_t bin = left + 1; bin < right; bin++) {
+                if (bin == middle) {
+                    continue;
+                }
+                size_t w = bin_offsets[bin]++;
+                weight_filters[w] = i;
+                weights[w] = bin < middle ?
+                    ((static_cast<float>(bin) - left) / (middle - left)) :
+                    ((right - static_cast<float>(bin)) / (right - middle));
+            }
+            size_t w = bin_offsets[middle]++;
+            weight_filters[w] = i;
+            weights[w] = 1.0f;
+        }
+        // the fill above moved every offset to the start of the next bin, shift back
+        for (size_t bin = power_spectrum_frame_size; bin > 0; bin--) {
+            bin_offsets[bin] = bin_offsets[bin - 1];
+        }
+        bin_offsets[0] = 0;
+
+        return EIDSP_OK;
+    }
+
+    static size_t mfe_batched_frame_slot_size(size_t frame_length, uint16_t fft_length) {
+        return frame_length > fft_length ? frame_length : fft_length;
+    }
+
+    static size_t mfe_batched_max_weights(uint16_t num_filters, uint16_t fft_length) {
+        // every bin can be on the slope of at most two neighbouring filters, plus a middle per filter
+        return 2 * (fft_length / 2 + 1) + num_filters;
+    }
+
     /**
      * Compute spectrogram from a sensor signal.
      * @param out_features Use `calculate_mfe_buffer_size` to allocate the right matrix.
@@ -734,7 +1014,7 @@ public:
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        ret = mfe(&features_matrix, &energy_matrix, signal,
+        ret = mfe_batched(&features_matrix, &energy_matrix, signal,
             sampling_frequency, frame_length, frame_stride, num_filters, fft_length,
             low_frequency, high_frequency, version);
         if (ret != EIDSP_OK) {
@@ -748,23 +1028,16 @@ public:
             EIDSP_ERR(ret);
         }
 
-        // now do DST type 2
-        ret = numpy::dct2(&features_matrix, DCT_NORMALIZATION_ORTHO);
+        // now do DCT type 2, straight into the output and only for the cepstra we keep
+        ret = numpy::dct2_truncated(&features_matrix, out_features, DCT_NORMALIZATION_ORTHO);
         if (ret != EIDSP_OK) {
             EIDSP_ERR(ret);
         }
 
         // replace first cepstral coefficient with log of frame energy for DC elimination
         if (dc_elimination) {
-            for (size_t row = 0; row < features_matrix.rows; row++) {
-                features_matrix.buffer[row * features_matrix.cols] = numpy::log(energy_matrix.buffer[row]);
-            }
-        }
-
-        // copy to the output...
-        for (size_t row = 0; row < features_matrix.rows; row++) {
-            for(int i = 0; i < num_cepstral; i++) {
-                *(out_features->buffer + (num_cepstral * row) + i) = *(features_matrix.buffer + (features_matrix.cols * row) + i);
+            for (size_t row = 0; row < out_features->rows; row++) {
+                out_features->buffer[row * out_features->cols] = numpy::log(energy_matrix.buffer[row]);
             }
         }
 
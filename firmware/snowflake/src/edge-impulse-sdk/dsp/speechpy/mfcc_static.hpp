@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an "AS
+ * IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language
+ * governing permissions and limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _EIDSP_SPEECHPY_MFCC_STATIC_H_
+#define _EIDSP_SPEECHPY_MFCC_STATIC_H_
+
+#include <stdint.h>
+#include "../config.hpp"
+#include "../numpy.hpp"
+#include "../returntypes.hpp"
+#include "feature.hpp"
+
+namespace ei {
+namespace speechpy {
+
+/**
+ * Frame length / stride in samples, as processing::stack_frames calculates it (version > 1,
+ * so ceil unless very close to floor), usable as a template argument
+ */
+constexpr size_t mfcc_static_frame_samples(uint32_t sampling_frequency, float seconds) {
+    return static_cast<float>(sampling_frequency) * seconds ==
+            static_cast<float>(static_cast<size_t>(static_cast<float>(sampling_frequency) * seconds)) ||
+        static_cast<float>(sampling_frequency) * seconds -
+            static_cast<float>(static_cast<size_t>(static_cast<float>(sampling_frequency) * seconds)) < 0.001f ?
+        static_cast<size_t>(static_cast<float>(sampling_frequency) * seconds) :
+        static_cast<size_t>(static_cast<float>(sampling_frequency) * seconds) + 1;
+}
+
+/**
+ * MFCC for parameters that are known at compile time (e.g. from the generated
+ * EI_DSP_PARAMS_MFCC_* in model_metadata.h), same output as
+ * `feature::mfcc(..., dc_elimination = true, Version)`.
+ * Frame counts and buffer sizes are constants, the scratch buffer is a fixed size, and the
+ * mel filterbank and DCT basis are calculated once instead of on every call.
+ *
+ * @tparam SamplingFrequency Sampling frequency in Hz
+ * @tparam FrameLength Frame length in samples (see mfcc_static_frame_samples())
+ * @tparam FrameStride Frame stride in samples (see mfcc_static_frame_samples())
+ */
+template<uint32_t SamplingFrequency, size_t FrameLength, size_t FrameStride,
+         uint16_t NumCepstral, uint16_t NumFilters, uint16_t FftLength,
+         uint32_t LowFrequency, uint32_t HighFrequency, uint16_t Version>
+class mfcc_static {
+public:
+    static_assert(Version >= 2, "mfcc_static needs implementation version 2 or newer");
+    static_assert(FrameStride > 0 && FrameStride <= FrameLength, "invalid frame stride");
+    static_assert(NumCepstral <= NumFilters, "more cepstra than filters");
+
+    static constexpr size_t power_spectrum_frame_size = FftLength / 2 + 1;
+    static constexpr size_t frame_slot_size = FrameLength > FftLength ? FrameLength : FftLength;
+    static constexpr size_t block_frames = EIDSP_MFE_BLOCK_FRAMES;
+    static constexpr size_t max_weights = 2 * power_spectrum_frame_size + NumFilters;
+    static constexpr uint32_t high_frequency = HighFrequency == 0 ? SamplingFrequency / 2 : HighFrequency;
+    static constexpr uint32_t low_frequency = (Version < 4 && LowFrequency == 0) ? 300 : LowFrequency;
+
+    // frames, spectra, mel energies and frame energies for one block of frames
+    static constexpr size_t scratch_size =
+        block_frames * frame_slot_size +
+        block_frames * power_spectrum_frame_size * 2 +
+        block_frames * NumFilters +
+        block_frames;
+
+    /**
+     * Number of frames (rows of the output) for a signal
+     */
+    static constexpr size_t frame_count(size_t signal_length) {
+        return signal_length < FrameLength - FrameStride ?
+            0 : (signal_length - (FrameLength - FrameStride)) / FrameStride;
+    }
+
+    /**
+     * Compute the MFCC of a signal
+     * @param out_features frame_count(signal->total_length) x NumCepstral matrix
+     * @param signal Audio signal
+     * @returns EIDSP_OK if OK
+     */
+    static int mfcc(matrix_t *out_features, signal_t *signal) {
+        const tables_t *t = tables();
+        if (!t->ok) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        const size_t frames_total = frame_count(signal->total_length);
+        if (out_features->rows != frames_total || out_features->cols != NumCepstral) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+        if (frames_total == 0) {
+            return EIDSP_OK;
+        }
+
+        EI_DSP_MATRIX(scratch, 1, scratch_size);
+        if (!scratch.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        float *frames = scratch.buffer;
+        fft_complex_t *spectra = (fft_complex_t*)(frames + block_frames * frame_slot_size);
+        float *mels = (float*)(spectra + block_frames * power_spectrum_frame_size);
+        float *energies = mels + block_frames * NumFilters;
+
+        matrix_t basis(NumFilters, NumCepstral, const_cast<float*>(t->basis));
+        const float power_scale = 1.0f / static_cast<float>(FftLength);
+        int ret;
+
+        for (size_t block_ix = 0; block_ix < frames_total; block_ix += block_frames) {
+            const size_t frames_in_block = frames_total - block_ix < block_frames ?
+                frames_total - block_ix : block_frames;
+
+            // fetch the frames, zero padded to the FFT length, and FFT them
+            for (size_t f = 0; f < frames_in_block; f++) {
+                float *frame = frames + f * frame_slot_size;
+                ret = signal->get_data((block_ix + f) * FrameStride, FrameLength, frame);
+                if (ret != 0) {
+                    EIDSP_ERR(ret);
+                }
+                if (FrameLength < FftLength) {
+                    memset(frame + FrameLength, 0, (FftLength - FrameLength) * sizeof(float));
+                }
+
+                ret = numpy::rfft(frame, FftLength, spectra + f * power_spectrum_frame_size,
+                    power_spectrum_frame_size, FftLength);
+                if (ret != EIDSP_OK) {
+                    EIDSP_ERR(ret);
+                }
+            }
+
+            // power spectrum, energy and mel weighting in one go, then log
+            for (size_t f = 0; f < frames_in_block; f++) {
+                const fft_complex_t *spectrum = spectra + f * power_spectrum_frame_size;
+                float *mel = mels + f * NumFilters;
+                float energy = 0.0f;
+
+                memset(mel, 0, NumFilters * sizeof(float));
+                for (size_t bin = 0; bin < power_spectrum_frame_size; bin++) {
+                    float power = power_scale *
+                        (spectrum[bin].r * spectrum[bin].r + spectrum[bin].i * spectrum[bin].i);
+                    energy += power;
+
+                    for (size_t w = t->bin_offsets[bin]; w < t->bin_offsets[bin + 1]; w++) {
+                        mel[t->weight_filters[w]] += t->weights[w] * power;
+                    }
+                }
+
+                numpy::zero_handling(mel, NumFilters);
+                for (size_t ix = 0; ix < NumFilters; ix++) {
+                    mel[ix] = numpy::log(mel[ix]);
+                }
+
+                energies[f] = energy == 0 ? 1e-10 : energy;
+            }
+
+            // DCT-II (ortho), only the cepstra we keep, straight into the output
+            matrix_t mel_block(frames_in_block, NumFilters, mels);
+            matrix_t out_block(frames_in_block, NumCepstral, out_features->get_row_ptr(block_ix));
+            ret = numpy::dot(&mel_block, &basis, &out_block);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+
+            // replace first cepstral coefficient with log of frame energy for DC elimination
+            for (size_t f = 0; f < frames_in_block; f++) {
+                out_block.buffer[f * NumCepstral] = numpy::log(energies[f]);
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
+private:
+    /**
+     * The mel filterbank (see feature::mfe_batched_filterbank) and the DCT basis
+     */
+    typedef struct tables {
+        tables() {
+            float mels[NumFilters + 2];
+            ok = feature::mfe_batched_filterbank(mels, SamplingFrequency, NumFilters, FftLength,
+                low_frequency, high_frequency, Version, weights, weight_filters, bin_offsets) == EIDSP_OK;
+            numpy::dct2_basis_fill(basis, NumFilters, NumCepstral, DCT_NORMALIZATION_ORTHO);
+        }
+
+        bool ok;
+        float weights[max_weights];
+        uint16_t weight_filters[max_weights];
+        uint16_t bin_offsets[power_spectrum_frame_size + 1];
+        float basis[NumFilters * NumCepstral];
+    } tables_t;
+
+    /**
+     * The tables, calculated on first use
+     */
+    static const tables_t *tables() {
+        static const tables_t t;
+        return &t;
+    }
+};
+
+} // namespace speechpy
+} // namespace ei
+
+#endif // _EIDSP_SPEECHPY_MFCC_STATIC_H_
@@ -40,11 +40,17 @@ namespace processing {
     class preemphasis {
 public:
         preemphasis(ei_signal_t *signal, int shift, float cof, bool rescale)
-            : _signal(signal), _shift(shift), _cof(cof), _rescale(rescale)
+            : _signal(signal), _shift(shift), _cof(cof), _prev_buffer(nullptr),
+              _end_of_signal_buffer(nullptr), _next_offset_should_be(0), _rescale(rescale)
         {
+            // int16 PCM is read directly, so there's no history to keep
+            _direct = signal->raw_i16 && shift > 0 && static_cast<size_t>(shift) <= signal->total_length;
+            if (_direct) {
+                return;
+            }
+
             _prev_buffer = (float*)ei_dsp_calloc(shift * sizeof(float), 1);
             _end_of_signal_buffer = (float*)ei_dsp_calloc(shift * sizeof(float), 1);
-            _next_offset_should_be = 0;
 
             if (shift < 0) {
                 _shift = signal->total_length + shift;
@@ -63,6 +69,9 @@ public:
          * @param length Length of the audio signal
          */
         int get_data(size_t offset, size_t length, float *out_buffer) {
+            if (_direct) {
+                return get_data_i16(offset, length, out_buffer);
+            }
             if (!_prev_buffer || !_end_of_signal_buffer) {
                 EIDSP_ERR(EIDSP_OUT_OF_MEM);
             }
@@ -118,6 +127,43 @@ public:
             return EIDSP_OK;
         }
 
+        /**
+         * get_data for int16 PCM signals: convert, preemphasize and rescale in a single pass
+         * over the PCM buffer, without going through the signal's get_data
+         */
+        int get_data_i16(size_t offset, size_t length, float *out_buffer) {
+            if (offset + length > _signal->total_length) {
+                EIDSP_ERR(EIDSP_OUT_OF_BOUNDS);
+            }
+
+            const EIDSP_i16 *now = _signal->raw_i16 + offset;
+            const size_t shift = static_cast<size_t>(_shift);
+            const float scale = _rescale ? 1.0f / 32768.0f : 1.0f;
+
+            // under shift? preemphasize with the end of the signal
+            size_t ix = 0;
+            const EIDSP_i16 *end = _signal->raw_i16 + _signal->total_length - shift;
+            for (; ix < length && offset + ix < shift; ix++) {
+                out_buffer[ix] = (static_cast<float>(now[ix]) - (_cof * static_cast<float>(end[offset + ix]))) * scale;
+            }
+
+            const EIDSP_i16 *prev = now - shift;
+            if (_rescale) {
+                for (; ix < length; ix++) {
+                    out_buffer[ix] = (static_cast<float>(now[ix]) - (_cof * static_cast<float>(prev[ix]))) * scale;
+                }
+            }
+            else {
+                for (; ix < length; ix++) {
+                    out_buffer[ix] = static_cast<float>(now[ix]) - (_cof * static_cast<float>(prev[ix]));
+                }
+            }
+
+            _next_offset_should_be += length;
+
+            return EIDSP_OK;
+        }
+
         ~preemphasis() {
             if (_prev_buffer) {
                 ei_dsp_free(_prev_buffer, _shift * sizeof(float));
@@ -127,6 +173,15 @@ public:
             }
         }
 
+        // the DSP creates one of these per run, so keep it off the heap as well
+        static void *operator new(size_t size) noexcept {
+            return ei_dsp_malloc(size);
+        }
+
+        static void operator delete(void *ptr, size_t size) {
+            ei_dsp_free(ptr, size);
+        }
+
 private:
         ei_signal_t *_signal;
         int _shift;
@@ -135,6 +190,7 @@ private:
         float *_end_of_signal_buffer;
         size_t _next_offset_should_be;
         bool _rescale;
+        bool _direct;
     };
 }
 
@@ -472,6 +528,169 @@ namespace processing {
         return EIDSP_OK;
     }
 
+    /**
+     * cmvnw with variance normalization (and without scaling), fused with the int8 quantization
+     * of the network input. The features are read in place and the normalized features are
+     * written quantized, so the normalized window never exists as floats.
+     * The mean and std of the windows are kept as running sums along the (symmetric padded)
+     * rows, instead of being summed over the whole window for every row, and the padding is
+     * an index table instead of a copy of the features.
+     * @param features Features, rows x cols (one observation per row), starting at `start` and
+     *   wrapping around the end of the buffer (a ring buffer of rows * cols, start 0 if not)
+     * @param start Offset of the first row in `features`, a multiple of cols
+     * @param rows Number of rows
+     * @param cols Number of columns
+     * @param win_size The size of sliding window for local normalization
+     * @param scale Quantization scale of the output
+     * @param zero_point Quantization zero point of the output
+     * @param output Output, rows * cols quantized features
+     * @returns 0 if OK
+     */
+    static int cmvnw_quantize(const float *features, size_t start, size_t rows, size_t cols,
+        uint16_t win_size, float scale, float zero_point, matrix_i8_t *output)
+    {
+        const size_t size = rows * cols;
+        if (output->rows * output->cols != size) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+        if (rows == 0 || start % cols != 0) {
+            EIDSP_ERR(EIDSP_PARAMETER_INVALID);
+        }
+
+        auto row = [features, start, size, cols](size_t ix) -> const float* {
+            return features + ((start + ix * cols) % size);
+        };
+        auto quantize = [scale, zero_point](float value) -> int8_t {
+            int32_t q = static_cast<int32_t>(round(value / scale)) + static_cast<int32_t>(zero_point);
+            return static_cast<int8_t>(q < -128 ? -128 : (q > 127 ? 127 : q));
+        };
+
+        if (win_size == 0) {
+            for (size_t ix = 0; ix < rows; ix++) {
+                const float *in = row(ix);
+                for (size_t col = 0; col < cols; col++) {
+                    output->buffer[ix * cols + col] = quantize(in[col]);
+                }
+            }
+            return EIDSP_OK;
+        }
+
+        // with an even window the last window of cmvnw runs past the padding
+        if (win_size % 2 == 0) {
+            EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+        }
+
+        const size_t pad_size = (win_size - 1) / 2;
+        const size_t pad_rows = rows + (pad_size * 2);
+
+        // padded row -> row, walks back and forth like numpy::pad_1d_symmetric
+        uint16_t *pad_index = (uint16_t*)ei_dsp_malloc(pad_rows * sizeof(uint16_t));
+        // mean subtracted features, then the window sums of them and their squares
+        float *centered = (float*)ei_dsp_malloc(size * sizeof(float));
+        float *sum = (float*)ei_dsp_calloc(cols * 2, sizeof(float));
+        if (!pad_index || !centered || !sum) {
+            ei_dsp_free(sum, cols * 2 * sizeof(float));
+            ei_dsp_free(centered, size * sizeof(float));
+            ei_dsp_free(pad_index, pad_rows * sizeof(uint16_t));
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+        float *sum_sq = sum + cols;
+
+        size_t index = 0;
+        bool up = true;
+        for (size_t ix = pad_size; ix-- > 0; ) {
+            pad_index[ix] = index;
+            if (index == 0 && !up) {
+                up = true;
+            }
+            else if (index == rows - 1 && up) {
+                up = false;
+            }
+            else if (up) {
+                index++;
+            }
+            else {
+                index--;
+            }
+        }
+        for (size_t ix = 0; ix < rows; ix++) {
+            pad_index[pad_size + ix] = ix;
+        }
+        index = rows - 1;
+        up = false;
+        for (size_t ix = 0; ix < pad_size; ix++) {
+            pad_index[pad_size + rows + ix] = index;
+            if (index == 0 && !up) {
+                up = true;
+            }
+            else if (index == rows - 1 && up) {
+                up = false;
+            }
+            else if (up) {
+                index++;
+            }
+            else {
+                index--;
+            }
+        }
+
+        const float inv_win_size = 1.0f / win_size;
+
+        // mean normalization
+        for (size_t ix = 0; ix < win_size; ix++) {
+            const float *in = row(pad_index[ix]);
+            for (size_t col = 0; col < cols; col++) {
+                sum[col] += in[col];
+            }
+        }
+        for (size_t ix = 0; ix < rows; ix++) {
+            const float *in = row(ix);
+            for (size_t col = 0; col < cols; col++) {
+                centered[ix * cols + col] = in[col] - sum[col] * inv_win_size;
+            }
+            if (ix + 1 < rows) {
+                const float *leaving = row(pad_index[ix]);
+                const float *entering = row(pad_index[ix + win_size]);
+                for (size_t col = 0; col < cols; col++) {
+                    sum[col] += entering[col] - leaving[col];
+                }
+            }
+        }
+
+        // variance normalization, over the windows of the mean normalized features
+        memset(sum, 0, cols * 2 * sizeof(float));
+        for (size_t ix = 0; ix < win_size; ix++) {
+            const float *in = centered + pad_index[ix] * cols;
+            for (size_t col = 0; col < cols; col++) {
+                sum[col] += in[col];
+                sum_sq[col] += in[col] * in[col];
+            }
+        }
+        for (size_t ix = 0; ix < rows; ix++) {
+            const float *in = centered + ix * cols;
+            for (size_t col = 0; col < cols; col++) {
+                float mean = sum[col] * inv_win_size;
+                float var = sum_sq[col] * inv_win_size - mean * mean;
+                float std = var > 0.0f ? sqrtf(var) : 0.0f;
+                output->buffer[ix * cols + col] = quantize(in[col] / (std + 1e-10f));
+            }
+            if (ix + 1 < rows) {
+                const float *leaving = centered + pad_index[ix] * cols;
+                const float *entering = centered + pad_index[ix + win_size] * cols;
+                for (size_t col = 0; col < cols; col++) {
+                    sum[col] += entering[col] - leaving[col];
+                    sum_sq[col] += entering[col] * entering[col] - leaving[col] * leaving[col];
+                }
+            }
+        }
+
+        ei_dsp_free(sum, cols * 2 * sizeof(float));
+        ei_dsp_free(centered, size * sizeof(float));
+        ei_dsp_free(pad_index, pad_rows * sizeof(uint16_t));
+
+        return EIDSP_OK;
+    }
+
     /**
      * Perform normalization for MFE frames, this converts the signal to dB,
      * then add a hard filter, and quantize / dequantize the output
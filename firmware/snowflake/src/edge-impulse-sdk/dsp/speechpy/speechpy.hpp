@@ -20,6 +20,7 @@
 
 #include "../config.hpp"
 #include "feature.hpp"
+#include "mfcc_static.hpp"
 #include "functions.hpp"
 #include "processing.hpp"
 
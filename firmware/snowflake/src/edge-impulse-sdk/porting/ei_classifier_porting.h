@@ -120,6 +120,14 @@ void *ei_calloc(size_t nitems, size_t size);
  */
 void ei_free(void *ptr);
 
+/**
+ * Begin / end a stage of the classifier on the calling thread, only called with
+ * EI_CLASSIFIER_TRACE=1 (the application implements these then). name is a string literal,
+ * the same one for the begin and the end
+ */
+void ei_trace_begin(const char *name);
+void ei_trace_end(const char *name);
+
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
 }
 #endif // defined(__cplusplus) && EI_C_LINKAGE == 1
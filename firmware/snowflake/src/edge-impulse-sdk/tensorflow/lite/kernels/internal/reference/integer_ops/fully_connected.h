@@ -120,6 +120,68 @@ void FullyConnected(const FullyConnectedParams& params,
   }
 }
 
+// Patched by Edge Impulse: FullyConnected on a block sparse filter. The filter
+// is cut into blocks of 1 x block_size weights, of which only the blocks set in
+// block_bitmap are stored, row by row. block_bitmap holds
+// (accum_depth / block_size + 7) / 8 bytes per row, bit b (LSB first) set if
+// block b of the row is stored. The blocks that aren't stored are all zeros.
+inline void FullyConnectedBlockSparse(
+    const FullyConnectedParams& params, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const uint8_t* block_bitmap, int block_size,
+    const RuntimeShape& bias_shape, const int32_t* bias_data,
+    const RuntimeShape& output_shape, int8_t* output_data) {
+  const int32_t input_offset = params.input_offset;
+  const int32_t output_offset = params.output_offset;
+  const int32_t output_multiplier = params.output_multiplier;
+  const int output_shift = params.output_shift;
+  const int32_t output_activation_min = params.quantized_activation_min;
+  const int32_t output_activation_max = params.quantized_activation_max;
+  TFLITE_DCHECK_GE(filter_shape.DimensionsCount(), 2);
+  TFLITE_DCHECK_GE(output_shape.DimensionsCount(), 1);
+  TFLITE_DCHECK_EQ(params.weights_offset, 0);
+
+  TFLITE_DCHECK_LE(output_activation_min, output_activation_max);
+  const int filter_dim_count = filter_shape.DimensionsCount();
+  const int output_dim_count = output_shape.DimensionsCount();
+  const int batches = FlatSizeSkipDim(output_shape, output_dim_count - 1);
+  const int output_depth = output_shape.Dims(output_dim_count - 1);
+  TFLITE_DCHECK_LE(output_depth, filter_shape.Dims(filter_dim_count - 2));
+  const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
+  TFLITE_DCHECK_EQ(accum_depth % block_size, 0);
+  const int block_count = accum_depth / block_size;
+  const int bitmap_stride = (block_count + 7) / 8;
+  for (int b = 0; b < batches; ++b) {
+    const int8_t* filter_ptr = filter_data;
+    for (int out_c = 0; out_c < output_depth; ++out_c) {
+      const uint8_t* row_bitmap = block_bitmap + out_c * bitmap_stride;
+      int32_t acc = 0;
+      for (int block = 0; block < block_count; ++block) {
+        if ((row_bitmap[block / 8] & (1 << (block % 8))) == 0) {
+          continue;
+        }
+        const int8_t* input_ptr =
+            input_data + b * accum_depth + block * block_size;
+        for (int d = 0; d < block_size; ++d) {
+          int32_t input_val = input_ptr[d];
+          int32_t filter_val = *filter_ptr++;
+          acc += filter_val * (input_val + input_offset);
+        }
+      }
+      if (bias_data) {
+        acc += bias_data[out_c];
+      }
+      int32_t acc_scaled =
+          MultiplyByQuantizedMultiplier(acc, output_multiplier, output_shift);
+      acc_scaled += output_offset;
+      acc_scaled = std::max(acc_scaled, output_activation_min);
+      acc_scaled = std::min(acc_scaled, output_activation_max);
+      output_data[out_c + output_depth * b] =
+          static_cast<int8_t>(acc_scaled);
+    }
+  }
+}
+
 }  // namespace reference_integer_ops
 }  // namespace tflite
 
@@ -22,6 +22,7 @@ limitations under the License.
 
 #include "edge-impulse-sdk/CMSIS/NN/Include/arm_nn_types.h"
 #include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "edge-impulse-sdk/classifier/ei_packed_weights.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/common.h"
@@ -42,6 +43,20 @@ struct OpData {
 
   // Index to buffer for optimizations if applicable.
   int buffer_idx;
+
+  // The filter was reordered when the model was compiled, for
+  // arm_convolve_s8_reordered (see ei_packed_weights.h).
+  bool filter_reordered;
+
+  // The filter is int4, which arm_convolve_s4 unpacks in its inner loop
+  // (otherwise it's unpacked to a scratch buffer on every Eval).
+  bool filter_int4;
+
+  // CONV_2D_MAX_POOL_2D node: the output is the 1x2 max pool of a
+  // conv_output_height x conv_output_width convolution output.
+  bool max_pool_1x2;
+  int conv_output_height;
+  int conv_output_width;
 };
 
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
@@ -49,7 +64,8 @@ void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   return context->AllocatePersistentBuffer(context, sizeof(OpData));
 }
 
-TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+TfLiteStatus PrepareImpl(TfLiteContext* context, TfLiteNode* node,
+                         bool max_pool_1x2) {
   TFLITE_DCHECK(node->user_data != nullptr);
   TFLITE_DCHECK(node->builtin_data != nullptr);
 
@@ -70,8 +86,16 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       micro_context->AllocateTempOutputTensor(node, kConvOutputTensor);
   TF_LITE_ENSURE(context, output != nullptr);
 
+  // A fused node stores the pooled output only, the convolution output is
+  // described by its intermediate tensor
+  TfLiteTensor* conv_output = output;
+  if (max_pool_1x2) {
+    conv_output = micro_context->AllocateTempIntermediateTensor(node, 0);
+    TF_LITE_ENSURE(context, conv_output != nullptr);
+  }
+
   RuntimeShape input_shape = GetTensorShape(input);
-  RuntimeShape output_shape = GetTensorShape(output);
+  RuntimeShape output_shape = GetTensorShape(conv_output);
 
   // Initialize cmsis_nn input dimensions
   cmsis_nn_dims input_dims;
@@ -90,11 +114,58 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   // Initialize cmsis_nn output dimensions
   cmsis_nn_dims output_dims;
   output_dims.n = input_dims.n;
-  output_dims.h = output->dims->data[1];
-  output_dims.w = output->dims->data[2];
+  output_dims.h = conv_output->dims->data[1];
+  output_dims.w = conv_output->dims->data[2];
   output_dims.c = output_shape.Dims(3);
 
-  if (filter->type == kTfLiteInt4) {
+  data->max_pool_1x2 = max_pool_1x2;
+  data->conv_output_height = output_dims.h;
+  data->conv_output_width = output_dims.w;
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+  if (max_pool_1x2) {
+    const TfLitePoolParams& pool_params =
+        static_cast<const EiConvMaxPoolParams*>(node->builtin_data)->max_pool;
+    TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt8);
+    TF_LITE_ENSURE_EQ(context, pool_params.filter_height, 1);
+    TF_LITE_ENSURE_EQ(context, pool_params.stride_height, 1);
+    TF_LITE_ENSURE_EQ(context, pool_params.filter_width, 2);
+    TF_LITE_ENSURE_EQ(context, pool_params.stride_width, 2);
+    TF_LITE_ENSURE_EQ(context, pool_params.activation, kTfLiteActNone);
+    // the pooling windows are pairs of neighbouring output pixels
+    TF_LITE_ENSURE(context, output_dims.h == 1 || output_dims.w % 2 == 0);
+    TF_LITE_ENSURE_EQ(context, output->dims->data[1], output_dims.h);
+    TF_LITE_ENSURE_EQ(context, output->dims->data[2],
+                      ComputeOutSize(pool_params.padding, output_dims.w, 2, 2));
+    TF_LITE_ENSURE_EQ(context, output->dims->data[3], output_dims.c);
+    // max pooling keeps the quantization
+    TF_LITE_ENSURE_EQ(context, output->params.zero_point,
+                      conv_output->params.zero_point);
+    TF_LITE_ENSURE_EQ(context, output->params.scale, conv_output->params.scale);
+  }
+#endif  // EI_CLASSIFIER_TFLITE_FUSED_OPS
+
+  const ei_packed_weights_t* packed_weights = ei_get_packed_weights(
+      node->custom_initial_data, node->custom_initial_data_size);
+  data->filter_reordered =
+      packed_weights != nullptr &&
+      packed_weights->filter_layout == EI_FILTER_LAYOUT_OHWI_REORDERED;
+  if (data->filter_reordered) {
+#if EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+    TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt8);
+    TF_LITE_ENSURE_TYPES_EQ(context, filter->type, kTfLiteInt8);
+#else
+    MicroPrintf("Model was compiled with EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS");
+    return kTfLiteError;
+#endif
+  }
+
+#if !defined(ARM_MATH_MVEI)
+  data->filter_int4 =
+      filter->type == kTfLiteInt4 && input->type == kTfLiteInt8;
+#else
+  data->filter_int4 = false;
+#endif
+  if (filter->type == kTfLiteInt4 && !data->filter_int4) {
     int filter_size =
         RuntimeShape(filter->dims->size,
                      reinterpret_cast<const int32_t*>(filter->dims->data))
@@ -132,7 +203,14 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     conv_params.activation.min = data->reference_op_data.output_activation_min;
     conv_params.activation.max = data->reference_op_data.output_activation_max;
 
-    if (input->type == kTfLiteInt8) {
+    if (data->max_pool_1x2) {
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+      buf_size = arm_convolve_s8_max_pool_1x2_get_buffer_size(&input_dims,
+                                                               &filter_dims);
+#endif
+    } else if (data->filter_reordered || data->filter_int4) {
+      buf_size = arm_convolve_s8_get_buffer_size(&input_dims, &filter_dims);
+    } else if (input->type == kTfLiteInt8) {
       buf_size = arm_convolve_wrapper_s8_get_buffer_size(
           &conv_params, &input_dims, &filter_dims, &output_dims);
     } else if (input->type == kTfLiteInt16) {
@@ -150,6 +228,9 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     }
   }
 
+  if (max_pool_1x2) {
+    micro_context->DeallocateTempTfLiteTensor(conv_output);
+  }
   micro_context->DeallocateTempTfLiteTensor(output);
   micro_context->DeallocateTempTfLiteTensor(input);
   micro_context->DeallocateTempTfLiteTensor(filter);
@@ -157,6 +238,16 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   return kTfLiteOk;
 }
 
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  return PrepareImpl(context, node, false);
+}
+
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+TfLiteStatus PrepareMaxPool(TfLiteContext* context, TfLiteNode* node) {
+  return PrepareImpl(context, node, true);
+}
+#endif
+
 TfLiteStatus EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
                                      const TfLiteConvParams& params,
                                      const OpData& data,
@@ -164,6 +255,14 @@ TfLiteStatus EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
                                      const TfLiteEvalTensor* filter,
                                      const TfLiteEvalTensor* bias,
                                      TfLiteEvalTensor* output) {
+  // int4 filters the s4 kernels don't run on are unpacked first
+  TfLiteEvalTensor filter_int8 = *filter;
+  if (!data.filter_int4) {
+    filter_int8 = tflite::micro::MakeUnpackedInt4Tensor(
+        context, data.reference_op_data.filter_buffer_index, filter);
+    filter = &filter_int8;
+  }
+
   cmsis_nn_conv_params conv_params;
   conv_params.dilation.h = params.dilation_height_factor;
   conv_params.dilation.w = params.dilation_width_factor;
@@ -243,6 +342,81 @@ TfLiteStatus EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
     // arm_convolve_wrapper_s8_get_buffer_size
   }
 
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+  if (data.max_pool_1x2) {
+    // output_dims are the pooled dimensions
+    cmsis_nn_dims conv_output_dims = output_dims;
+    conv_output_dims.h = data.conv_output_height;
+    conv_output_dims.w = data.conv_output_width;
+    if (data.filter_int4) {
+      TFLITE_DCHECK_EQ(
+          arm_convolve_s4_max_pool_1x2(
+              &ctx, &conv_params, &quant_params, &input_dims,
+              tflite::micro::GetTensorData<int8_t>(input), &filter_dims,
+              tflite::micro::GetTensorData<int8_t>(filter), &bias_dims,
+              tflite::micro::GetOptionalTensorData<int32_t>(bias),
+              &conv_output_dims, &output_dims,
+              tflite::micro::GetTensorData<int8_t>(output)),
+          ARM_CMSIS_NN_SUCCESS);
+      return kTfLiteOk;
+    }
+#if EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+    if (data.filter_reordered) {
+      TFLITE_DCHECK_EQ(
+          arm_convolve_s8_reordered_max_pool_1x2(
+              &ctx, &conv_params, &quant_params, &input_dims,
+              tflite::micro::GetTensorData<int8_t>(input), &filter_dims,
+              tflite::micro::GetTensorData<int8_t>(filter), &bias_dims,
+              tflite::micro::GetOptionalTensorData<int32_t>(bias),
+              &conv_output_dims, &output_dims,
+              tflite::micro::GetTensorData<int8_t>(output)),
+          ARM_CMSIS_NN_SUCCESS);
+      return kTfLiteOk;
+    }
+#endif
+    TFLITE_DCHECK_EQ(
+        arm_convolve_s8_max_pool_1x2(
+            &ctx, &conv_params, &quant_params, &input_dims,
+            tflite::micro::GetTensorData<int8_t>(input), &filter_dims,
+            tflite::micro::GetTensorData<int8_t>(filter), &bias_dims,
+            tflite::micro::GetOptionalTensorData<int32_t>(bias),
+            &conv_output_dims, &output_dims,
+            tflite::micro::GetTensorData<int8_t>(output)),
+        ARM_CMSIS_NN_SUCCESS);
+    return kTfLiteOk;
+  }
+#endif  // EI_CLASSIFIER_TFLITE_FUSED_OPS
+
+#if !defined(ARM_MATH_MVEI)
+  if (data.filter_int4) {
+    TFLITE_DCHECK_EQ(
+        arm_convolve_s4(&ctx, &conv_params, &quant_params, &input_dims,
+                        tflite::micro::GetTensorData<int8_t>(input),
+                        &filter_dims,
+                        tflite::micro::GetTensorData<int8_t>(filter),
+                        &bias_dims,
+                        tflite::micro::GetOptionalTensorData<int32_t>(bias),
+                        &output_dims,
+                        tflite::micro::GetTensorData<int8_t>(output)),
+        ARM_CMSIS_NN_SUCCESS);
+    return kTfLiteOk;
+  }
+#endif
+
+#if EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+  if (data.filter_reordered) {
+    TFLITE_DCHECK_EQ(
+        arm_convolve_s8_reordered(
+            &ctx, &conv_params, &quant_params, &input_dims,
+            tflite::micro::GetTensorData<int8_t>(input), &filter_dims,
+            tflite::micro::GetTensorData<int8_t>(filter), &bias_dims,
+            tflite::micro::GetOptionalTensorData<int32_t>(bias), &output_dims,
+            tflite::micro::GetTensorData<int8_t>(output)),
+        ARM_CMSIS_NN_SUCCESS);
+    return kTfLiteOk;
+  }
+#endif
+
   // arm_convolve_wrapper_s8 dispatches the optimized kernel accordingly with
   // the parameters passed
   TFLITE_DCHECK_EQ(
@@ -370,11 +544,9 @@ TfLiteStatus EvalInt8(TfLiteContext* context, TfLiteNode* node) {
       *(reinterpret_cast<TfLiteConvParams*>(node->builtin_data));
   TFLITE_DCHECK(node->user_data != nullptr);
   const OpData& data = *(static_cast<const OpData*>(node->user_data));
-  TfLiteEvalTensor filter_int8 = tflite::micro::MakeUnpackedInt4Tensor(
-      context, data.reference_op_data.filter_buffer_index, filter);
 
-  return EvalQuantizedPerChannel(context, node, params, data, input,
-                                 &filter_int8, bias, output);
+  return EvalQuantizedPerChannel(context, node, params, data, input, filter,
+                                 bias, output);
 }
 
 TfLiteStatus EvalInt16x8(TfLiteContext* context, TfLiteNode* node) {
@@ -425,9 +597,6 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           (input->type == kTfLiteInt8 && filter->type == kTfLiteInt4),
       "Hybrid models are not supported on TFLite Micro.");
 
-  TfLiteEvalTensor filter_int8 = tflite::micro::MakeUnpackedInt4Tensor(
-      context, data.reference_op_data.filter_buffer_index, filter);
-
   switch (input->type) {  // Already know in/out types are same.
     case kTfLiteFloat32: {
 #if EI_TFLITE_DISABLE_CONV_2D_IN_F32
@@ -454,10 +623,11 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
                   input->type);
       return kTfLiteError;
 #endif
-      switch (filter_int8.type) {
-        case kTfLiteInt8: {
+      switch (filter->type) {
+        case kTfLiteInt8:
+        case kTfLiteInt4: {
           return EvalQuantizedPerChannel(context, node, params, data, input,
-                                         &filter_int8, bias, output);
+                                         filter, bias, output);
         }
 
         default: {
@@ -494,6 +664,12 @@ TfLiteRegistration Register_CONV_2D_INT16() {
   return tflite::micro::RegisterOp(Init, Prepare, EvalInt16x8);
 }
 
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+TfLiteRegistration Register_CONV_2D_MAX_POOL_2D() {
+  return tflite::micro::RegisterOp(Init, PrepareMaxPool, EvalInt8);
+}
+#endif
+
 }  // namespace tflite
 
 #elif EI_CLASSIFIER_TFLITE_ENABLE_ARC == 1
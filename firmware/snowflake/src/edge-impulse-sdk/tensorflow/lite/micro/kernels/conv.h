@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <cstdint>
 
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/types.h"
@@ -103,6 +104,22 @@ TfLiteRegistration Register_CONV_2D_INT8();
 // implementations.
 TfLiteRegistration Register_CONV_2D_INT16();
 
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+// Patched by Edge Impulse, CONV_2D followed by a MAX_POOL_2D that pools 2
+// neighbouring pixels of a row (compiled models, see
+// EI_CLASSIFIER_TFLITE_FUSED_OPS). The pooling is done before the convolution
+// output is stored; the node's first intermediate tensor has the dimensions of
+// the convolution output, its output tensor is the pooled output.
+typedef struct {
+  // first, so the node's builtin_data can be read as TfLiteConvParams
+  TfLiteConvParams conv;
+  // 1x2 filter and stride, on the convolution output
+  TfLitePoolParams max_pool;
+} EiConvMaxPoolParams;
+
+TfLiteRegistration Register_CONV_2D_MAX_POOL_2D();
+#endif  // EI_CLASSIFIER_TFLITE_FUSED_OPS
+
 #else
 inline TfLiteRegistration Register_CONV_2D_INT8() { return Register_CONV_2D(); }
 
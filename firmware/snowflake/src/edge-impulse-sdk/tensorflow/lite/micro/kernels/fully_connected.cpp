@@ -21,6 +21,7 @@ limitations under the License.
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/fully_connected.h"
 
 #include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "edge-impulse-sdk/classifier/ei_packed_weights.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/common.h"
@@ -50,6 +51,15 @@ struct OpData {
   int32_t batches;
   int32_t accum_depth;
   int32_t output_depth;
+
+  // Bias with the input zero point folded in when the model was compiled, the
+  // kernels then run with an input offset of 0 (see ei_packed_weights.h).
+  const int32_t* folded_bias;
+
+  // The filter is block sparse, with the blocks that are stored set in
+  // block_bitmap (see ei_packed_weights.h). nullptr for a dense filter.
+  const uint8_t* block_bitmap;
+  int32_t block_size;
 };
 
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
@@ -96,6 +106,38 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
   // Set buffer index to a reset value
   data->buffer_idx = -1;
+
+  const ei_packed_weights_t* packed_weights = ei_get_packed_weights(
+      node->custom_initial_data, node->custom_initial_data_size);
+  data->folded_bias =
+      packed_weights != nullptr ? packed_weights->folded_bias : nullptr;
+  if (data->folded_bias != nullptr) {
+#if EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+    TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt8);
+    TF_LITE_ENSURE(context, filter->type == kTfLiteInt8 ||
+                                filter->type == kTfLiteInt4);
+#else
+    MicroPrintf("Model was compiled with EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS");
+    return kTfLiteError;
+#endif
+  }
+
+  data->block_bitmap = nullptr;
+  data->block_size = 0;
+  if (packed_weights != nullptr &&
+      packed_weights->filter_layout == EI_FILTER_LAYOUT_BLOCK_SPARSE) {
+    TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt8);
+    TF_LITE_ENSURE_TYPES_EQ(context, filter->type, kTfLiteInt8);
+    TF_LITE_ENSURE(context, packed_weights->block_bitmap != nullptr &&
+                                packed_weights->block_size > 0 &&
+                                packed_weights->block_size % 4 == 0 &&
+                                data->accum_depth %
+                                        packed_weights->block_size ==
+                                    0);
+    data->block_bitmap = packed_weights->block_bitmap;
+    data->block_size = packed_weights->block_size;
+  }
+
   TF_LITE_ENSURE_STATUS(CalculateOpDataFullyConnected(
       context, params->activation, input->type, input, filter, bias, output,
       &(data->reference_op_data)));
@@ -125,7 +167,11 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 #if EI_TFLITE_DISABLE_CONV_2D_IN_I8
     buf_size = arm_fully_connected_s8_get_buffer_size(&filter_dims);
 #else
-    if (output_dim_count > 2 && data->accum_depth % 4 == 0) {
+    if (filter->type == kTfLiteInt4 || data->block_bitmap != nullptr) {
+      // arm_fully_connected_s4 / arm_fully_connected_block_sparse_s8 need no
+      // buffer
+      buf_size = 0;
+    } else if (output_dim_count > 2 && data->accum_depth % 4 == 0) {
       data->per_channel_output_multiplier =
           static_cast<int32_t*>(context->AllocatePersistentBuffer(
               context, data->output_depth * sizeof(int32_t)));
@@ -146,13 +192,9 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 #endif
   }
 
+  // int4 filters aren't unpacked, arm_fully_connected_s4 runs on them
   if (filter->type == kTfLiteInt4) {
-    int filter_size =
-        RuntimeShape(filter->dims->size,
-                     reinterpret_cast<const int32_t*>(filter->dims->data))
-            .FlatSize();
-    context->RequestScratchBufferInArena(
-        context, filter_size, &data->reference_op_data.filter_buffer_index);
+    TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt8);
   }
 
   if (buf_size > 0) {
@@ -230,10 +272,54 @@ TfLiteStatus EvalQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
 
   const int32_t* bias_data =
       tflite::micro::GetOptionalTensorData<int32_t>(bias);
+  int32_t input_offset = -data.reference_op_data.input_zero_point;
+  if (data.folded_bias != nullptr) {
+    bias_data = data.folded_bias;
+    input_offset = 0;
+  }
+
+  if (filter->type == kTfLiteInt4) {
+    cmsis_nn_fc_params fc_params;
+    fc_params.input_offset = input_offset;
+    fc_params.output_offset = data.reference_op_data.output_zero_point;
+    fc_params.filter_offset = 0;
+    fc_params.activation.min = data.reference_op_data.output_activation_min;
+    fc_params.activation.max = data.reference_op_data.output_activation_max;
+
+    TF_LITE_ENSURE_EQ(
+        context,
+        arm_fully_connected_s4(
+            &ctx, &fc_params, &quant_params, &input_dims,
+            tflite::micro::GetTensorData<int8_t>(input), &filter_dims,
+            tflite::micro::GetTensorData<int8_t>(filter), &bias_dims, bias_data,
+            &output_dims, tflite::micro::GetTensorData<int8_t>(output)),
+        ARM_CMSIS_NN_SUCCESS);
+    return kTfLiteOk;
+  }
+
+  if (data.block_bitmap != nullptr) {
+    cmsis_nn_fc_params fc_params;
+    fc_params.input_offset = input_offset;
+    fc_params.output_offset = data.reference_op_data.output_zero_point;
+    fc_params.filter_offset = 0;
+    fc_params.activation.min = data.reference_op_data.output_activation_min;
+    fc_params.activation.max = data.reference_op_data.output_activation_max;
+
+    TF_LITE_ENSURE_EQ(
+        context,
+        arm_fully_connected_block_sparse_s8(
+            &ctx, &fc_params, &quant_params, &input_dims,
+            tflite::micro::GetTensorData<int8_t>(input), &filter_dims,
+            tflite::micro::GetTensorData<int8_t>(filter), data.block_bitmap,
+            data.block_size, &bias_dims, bias_data, &output_dims,
+            tflite::micro::GetTensorData<int8_t>(output)),
+        ARM_CMSIS_NN_SUCCESS);
+    return kTfLiteOk;
+  }
 
 #if EI_TFLITE_DISABLE_CONV_2D_IN_I8
     cmsis_nn_fc_params fc_params;
-    fc_params.input_offset = -data.reference_op_data.input_zero_point;
+    fc_params.input_offset = input_offset;
     fc_params.output_offset = data.reference_op_data.output_zero_point;
     fc_params.filter_offset = 0;
     fc_params.activation.min = data.reference_op_data.output_activation_min;
@@ -253,7 +339,7 @@ TfLiteStatus EvalQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
     cmsis_nn_conv_params conv_params;
     conv_params.dilation.h = 1;
     conv_params.dilation.w = 1;
-    conv_params.input_offset = -data.reference_op_data.input_zero_point;
+    conv_params.input_offset = input_offset;
     conv_params.output_offset = data.reference_op_data.output_zero_point;
     conv_params.stride.h = 1;
     conv_params.stride.w = 1;
@@ -283,7 +369,7 @@ TfLiteStatus EvalQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
         ARM_CMSIS_NN_SUCCESS);
   } else {
     cmsis_nn_fc_params fc_params;
-    fc_params.input_offset = -data.reference_op_data.input_zero_point;
+    fc_params.input_offset = input_offset;
     fc_params.output_offset = data.reference_op_data.output_zero_point;
     fc_params.filter_offset = 0;
     fc_params.activation.min = data.reference_op_data.output_activation_min;
@@ -358,9 +444,6 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->user_data != nullptr);
   const OpData& data = *(static_cast<const OpData*>(node->user_data));
 
-  TfLiteEvalTensor filter_int8 = tflite::micro::MakeUnpackedInt4Tensor(
-      context, data.reference_op_data.filter_buffer_index, filter);
-
   // Checks in Prepare ensure input, output and filter types are all the same.
   switch (input->type) {
     case kTfLiteFloat32: {
@@ -383,15 +466,16 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       break;
     }
     case kTfLiteInt8: {
-      switch (filter_int8.type) {
+      switch (filter->type) {
         case kTfLiteInt8:
+        case kTfLiteInt4:
 #if EI_TFLITE_DISABLE_FULLY_CONNECTED_IN_I8
         MicroPrintf("Filter data type %s currently not supported.",
                               TfLiteTypeGetName(filter->type));
         return kTfLiteError;
 #endif
-          return EvalQuantizedInt8(context, node, data, input, &filter_int8,
-                                   bias, output);
+          return EvalQuantizedInt8(context, node, data, input, filter, bias,
+                                   output);
         default:
           MicroPrintf("Filter Type %s (%d) not supported.",
                       TfLiteTypeGetName(filter->type), filter->type);
@@ -443,11 +527,7 @@ TfLiteStatus EvalInt8(TfLiteContext* context, TfLiteNode* node) {
     return kTfLiteError;
   }
 
-  TfLiteEvalTensor filter_int8 = tflite::micro::MakeUnpackedInt4Tensor(
-      context, data.reference_op_data.filter_buffer_index, filter);
-
-  return EvalQuantizedInt8(context, node, data, input, &filter_int8, bias,
-                           output);
+  return EvalQuantizedInt8(context, node, data, input, filter, bias, output);
 }
 
 TfLiteStatus EvalInt16(TfLiteContext* context, TfLiteNode* node) {
@@ -1616,6 +1696,7 @@ limitations under the License.
 
 #include "edge-impulse-sdk/tensorflow/lite/micro/kernels/fully_connected.h"
 
+#include "edge-impulse-sdk/classifier/ei_packed_weights.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/kernels/internal/portable_tensor_utils.h"
@@ -1656,6 +1737,21 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE(context, output != nullptr);
   TF_LITE_ENSURE_TYPES_EQ(context, input->type, output->type);
 
+  // The only packed weights the reference kernel runs on are block sparse ones
+  const ei_packed_weights_t* packed_weights = ei_get_packed_weights(
+      node->custom_initial_data, node->custom_initial_data_size);
+  if (packed_weights != nullptr) {
+    TF_LITE_ENSURE(context, packed_weights->filter_layout ==
+                                    EI_FILTER_LAYOUT_BLOCK_SPARSE &&
+                                packed_weights->folded_bias == nullptr);
+    TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt8);
+    TF_LITE_ENSURE_TYPES_EQ(context, filter->type, kTfLiteInt8);
+    const int accum_depth = filter->dims->data[filter->dims->size - 1];
+    TF_LITE_ENSURE(context, packed_weights->block_bitmap != nullptr &&
+                                packed_weights->block_size > 0 &&
+                                accum_depth % packed_weights->block_size == 0);
+  }
+
   if (filter->type == kTfLiteInt4) {
     int filter_size =
         RuntimeShape(filter->dims->size,
@@ -1744,6 +1840,22 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           break;
         }
         case kTfLiteInt8: {
+          const ei_packed_weights_t* packed_weights = ei_get_packed_weights(
+              node->custom_initial_data, node->custom_initial_data_size);
+          if (packed_weights != nullptr) {
+            tflite::reference_integer_ops::FullyConnectedBlockSparse(
+                FullyConnectedParamsQuantized(data),
+                tflite::micro::GetTensorShape(input),
+                tflite::micro::GetTensorData<int8_t>(input),
+                tflite::micro::GetTensorShape(filter),
+                tflite::micro::GetTensorData<int8_t>(filter),
+                packed_weights->block_bitmap, packed_weights->block_size,
+                tflite::micro::GetTensorShape(bias),
+                tflite::micro::GetOptionalTensorData<int32_t>(bias),
+                tflite::micro::GetTensorShape(output),
+                tflite::micro::GetTensorData<int8_t>(output));
+            break;
+          }
           tflite::reference_integer_ops::FullyConnected(
               FullyConnectedParamsQuantized(data),
               tflite::micro::GetTensorShape(input),
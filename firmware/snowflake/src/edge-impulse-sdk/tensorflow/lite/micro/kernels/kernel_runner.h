@@ -57,6 +57,14 @@ class KernelRunner {
   // to stub out MicroGraph methods and track invocations on each subgraph.
   MockMicroGraph* GetMockGraph() { return &mock_micro_graph_; }
 
+  // Patched by Edge Impulse, what compiled models point a builtin node at
+  // through custom_initial_data (packed weights, see ei_packed_weights.h).
+  // Call before InitAndPrepare.
+  void SetCustomInitialData(const void* data, int size) {
+    node_.custom_initial_data = data;
+    node_.custom_initial_data_size = size;
+  }
+
   // Returns true if all temp buffer in tests are deallocated.
   // TODO(b/209453859): move this function to private after deallocation checks
   // are enabled for all kernel tests.
@@ -0,0 +1,420 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/optimal_memory_planner.h"
+
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+
+OptimalMemoryPlanner::OptimalMemoryPlanner(int max_search_steps)
+    : max_search_steps_(max_search_steps) {}
+
+TfLiteStatus OptimalMemoryPlanner::Init(unsigned char* scratch_buffer,
+                                        int scratch_buffer_size) {
+  // Reset internal states
+  buffer_count_ = 0;
+  need_to_calculate_offsets_ = true;
+
+  // Allocate the arrays we need within the scratch buffer arena.
+  max_buffer_count_ = scratch_buffer_size / per_buffer_size();
+
+  unsigned char* next_free = scratch_buffer;
+  requirements_ = reinterpret_cast<BufferRequirements*>(next_free);
+  next_free += sizeof(BufferRequirements) * max_buffer_count_;
+
+  buffer_offsets_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  current_offsets_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  buffer_ids_sorted_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  placed_by_offset_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  search_buffer_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  search_cursor_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  search_peak_ = reinterpret_cast<int*>(next_free);
+  return kTfLiteOk;
+}
+
+OptimalMemoryPlanner::~OptimalMemoryPlanner() {
+  // We don't own the scratch buffer, so don't deallocate anything.
+}
+
+TfLiteStatus OptimalMemoryPlanner::AddBuffer(int size, int first_time_used,
+                                             int last_time_used) {
+  if (buffer_count_ >= max_buffer_count_) {
+    MicroPrintf("Too many buffers (max is %d)", max_buffer_count_);
+    return kTfLiteError;
+  }
+  BufferRequirements* current = &requirements_[buffer_count_];
+  current->size = size;
+  current->first_time_used = first_time_used;
+  current->last_time_used = last_time_used;
+  current->offline_offset = kOnlinePlannedBuffer;
+  ++buffer_count_;
+  need_to_calculate_offsets_ = true;
+  return kTfLiteOk;
+}
+
+TfLiteStatus OptimalMemoryPlanner::AddBuffer(int size, int first_time_used,
+                                             int last_time_used,
+                                             int offline_offset) {
+  BufferRequirements* current = &requirements_[buffer_count_];
+  if (AddBuffer(size, first_time_used, last_time_used) != kTfLiteOk) {
+    return kTfLiteError;
+  }
+  current->offline_offset = offline_offset;
+  return kTfLiteOk;
+}
+
+bool OptimalMemoryPlanner::DoBuffersOverlapInTime(int a_id, int b_id) const {
+  const BufferRequirements* a_requirements = &requirements_[a_id];
+  const BufferRequirements* b_requirements = &requirements_[b_id];
+  if (a_requirements->first_time_used > b_requirements->last_time_used) {
+    return false;
+  }
+  if (b_requirements->first_time_used > a_requirements->last_time_used) {
+    return false;
+  }
+  return true;
+}
+
+int OptimalMemoryPlanner::LowestFreeOffset(int buffer_id,
+                                           int lowest_offset) const {
+  const int wanted_size = requirements_[buffer_id].size;
+  int candidate_offset = lowest_offset;
+  // Same walk as the GreedyMemoryPlanner: the placed buffers are in order of
+  // offset, so the first gap between the ones active at the same time that's
+  // big enough is the lowest.
+  for (int i = 0; i < placed_count_; ++i) {
+    const int placed_id = placed_by_offset_[i];
+    if (!DoBuffersOverlapInTime(placed_id, buffer_id)) {
+      continue;
+    }
+    const int placed_offset = current_offsets_[placed_id];
+    if (placed_offset - candidate_offset >= wanted_size) {
+      break;
+    }
+    const int placed_end = placed_offset + requirements_[placed_id].size;
+    if (placed_end > candidate_offset) {
+      candidate_offset = placed_end;
+    }
+  }
+  return candidate_offset;
+}
+
+void OptimalMemoryPlanner::PlaceBuffer(int buffer_id, int offset) {
+  current_offsets_[buffer_id] = offset;
+  int i = placed_count_;
+  while (i > 0 && current_offsets_[placed_by_offset_[i - 1]] > offset) {
+    placed_by_offset_[i] = placed_by_offset_[i - 1];
+    --i;
+  }
+  placed_by_offset_[i] = buffer_id;
+  ++placed_count_;
+}
+
+void OptimalMemoryPlanner::RemoveBuffer(int buffer_id) {
+  int i = 0;
+  while (placed_by_offset_[i] != buffer_id) {
+    ++i;
+  }
+  --placed_count_;
+  for (; i < placed_count_; ++i) {
+    placed_by_offset_[i] = placed_by_offset_[i + 1];
+  }
+  current_offsets_[buffer_id] = -1;
+}
+
+int OptimalMemoryPlanner::PlanLowerBound(int offset, int peak) const {
+  int bound = peak > live_size_bound_ ? peak : live_size_bound_;
+  // The buffers still to be placed go at offset or above, and placing more
+  // buffers only takes gaps away, so each of them ends at least where it would
+  // end if it were placed now.
+  for (int i = 0; i < online_count_; ++i) {
+    const int buffer_id = buffer_ids_sorted_[i];
+    if (current_offsets_[buffer_id] != -1) {
+      continue;
+    }
+    const int end =
+        LowestFreeOffset(buffer_id, offset) + requirements_[buffer_id].size;
+    if (end > bound) {
+      bound = end;
+    }
+  }
+  return bound;
+}
+
+void OptimalMemoryPlanner::Search() {
+  // Depth-first over the order in which the online planned buffers are
+  // placed, each one at its lowest free offset. A plan is only visited in
+  // order of (offset, buffer id), so each layout is reached once. Iterative,
+  // as the depth can be as large as the number of buffers.
+  int depth = 0;
+  search_cursor_[0] = 0;
+  while (depth >= 0) {
+    if (search_steps_ >= max_search_steps_) {
+      // Out of budget, keep the best plan found so far.
+      return;
+    }
+    const int prior_id = depth > 0 ? search_buffer_[depth - 1] : -1;
+    const int prior_offset = depth > 0 ? current_offsets_[prior_id] : 0;
+    const int prior_peak = depth > 0 ? search_peak_[depth - 1] : offline_peak_;
+
+    int buffer_id = -1;
+    int offset = 0;
+    if (prior_peak < best_size_) {
+      while (search_cursor_[depth] < online_count_) {
+        const int candidate_id = buffer_ids_sorted_[search_cursor_[depth]];
+        ++search_cursor_[depth];
+        if (current_offsets_[candidate_id] != -1) {
+          continue;
+        }
+        const int candidate_offset = LowestFreeOffset(candidate_id, 0);
+        if ((candidate_offset < prior_offset) ||
+            ((candidate_offset == prior_offset) && (candidate_id < prior_id))) {
+          continue;
+        }
+        if (candidate_offset + requirements_[candidate_id].size >=
+            best_size_) {
+          continue;
+        }
+        buffer_id = candidate_id;
+        offset = candidate_offset;
+        break;
+      }
+    }
+    if (buffer_id == -1) {
+      // Nothing left to try at this depth, go back up.
+      --depth;
+      if (depth >= 0) {
+        RemoveBuffer(search_buffer_[depth]);
+      }
+      continue;
+    }
+
+    PlaceBuffer(buffer_id, offset);
+    ++search_steps_;
+    const int end = offset + requirements_[buffer_id].size;
+    search_buffer_[depth] = buffer_id;
+    search_peak_[depth] = end > prior_peak ? end : prior_peak;
+
+    if (depth + 1 == online_count_) {
+      // A complete plan, smaller than the best one so far.
+      best_size_ = search_peak_[depth];
+      for (int i = 0; i < online_count_; ++i) {
+        const int id = buffer_ids_sorted_[i];
+        buffer_offsets_[id] = current_offsets_[id];
+      }
+      RemoveBuffer(buffer_id);
+      if (best_size_ == live_size_bound_) {
+        break;
+      }
+      continue;
+    }
+    if (PlanLowerBound(offset, search_peak_[depth]) >= best_size_) {
+      RemoveBuffer(buffer_id);
+      continue;
+    }
+    ++depth;
+    search_cursor_[depth] = 0;
+  }
+  is_plan_optimal_ = true;
+}
+
+void OptimalMemoryPlanner::CalculateOffsetsIfNeeded() {
+  if (!need_to_calculate_offsets_ || (buffer_count_ == 0)) {
+    return;
+  }
+  need_to_calculate_offsets_ = false;
+
+  // Offline planned buffers go where they were planned, and buffers of zero
+  // size at offset zero; neither is part of the search.
+  placed_count_ = 0;
+  online_count_ = 0;
+  offline_peak_ = 0;
+  for (int i = 0; i < buffer_count_; ++i) {
+    const BufferRequirements* requirements = &requirements_[i];
+    current_offsets_[i] = -1;
+    if (requirements->offline_offset != kOnlinePlannedBuffer) {
+      buffer_offsets_[i] = requirements->offline_offset;
+      const int end = requirements->offline_offset + requirements->size;
+      if (end > offline_peak_) {
+        offline_peak_ = end;
+      }
+      if (requirements->size > 0) {
+        PlaceBuffer(i, requirements->offline_offset);
+      }
+    } else if (requirements->size == 0) {
+      buffer_offsets_[i] = 0;
+    } else {
+      // Descending order of size, the last added first among buffers of the
+      // same size. This is the order the GreedyMemoryPlanner places them in.
+      int j = online_count_;
+      while (j > 0 &&
+             requirements_[buffer_ids_sorted_[j - 1]].size <=
+                 requirements->size) {
+        buffer_ids_sorted_[j] = buffer_ids_sorted_[j - 1];
+        --j;
+      }
+      buffer_ids_sorted_[j] = i;
+      ++online_count_;
+    }
+  }
+
+  // The memory in use is highest when some buffer is first used.
+  live_size_bound_ = offline_peak_;
+  for (int i = 0; i < buffer_count_; ++i) {
+    const int time = requirements_[i].first_time_used;
+    int live_size = 0;
+    for (int j = 0; j < buffer_count_; ++j) {
+      if ((requirements_[j].first_time_used <= time) &&
+          (requirements_[j].last_time_used >= time)) {
+        live_size += requirements_[j].size;
+      }
+    }
+    if (live_size > live_size_bound_) {
+      live_size_bound_ = live_size;
+    }
+  }
+
+  // The greedy plan is the one to beat.
+  greedy_size_ = offline_peak_;
+  for (int i = 0; i < online_count_; ++i) {
+    const int buffer_id = buffer_ids_sorted_[i];
+    const int offset = LowestFreeOffset(buffer_id, 0);
+    buffer_offsets_[buffer_id] = offset;
+    PlaceBuffer(buffer_id, offset);
+    const int end = offset + requirements_[buffer_id].size;
+    if (end > greedy_size_) {
+      greedy_size_ = end;
+    }
+  }
+  best_size_ = greedy_size_;
+  search_steps_ = 0;
+  is_plan_optimal_ = (best_size_ == live_size_bound_) || (online_count_ == 0);
+  if (is_plan_optimal_ || (online_count_ > kMaxSearchBuffers)) {
+    return;
+  }
+
+  // Start the search from the offline planned buffers alone.
+  for (int i = 0; i < online_count_; ++i) {
+    current_offsets_[buffer_ids_sorted_[i]] = -1;
+  }
+  placed_count_ = 0;
+  for (int i = 0; i < buffer_count_; ++i) {
+    const BufferRequirements* requirements = &requirements_[i];
+    if ((requirements->offline_offset != kOnlinePlannedBuffer) &&
+        (requirements->size > 0)) {
+      PlaceBuffer(i, requirements->offline_offset);
+    }
+  }
+  Search();
+}
+
+size_t OptimalMemoryPlanner::GetMaximumMemorySize() {
+  CalculateOffsetsIfNeeded();
+  if (buffer_count_ == 0) {
+    return 0;
+  }
+  return best_size_;
+}
+
+size_t OptimalMemoryPlanner::GetGreedyMemorySize() {
+  CalculateOffsetsIfNeeded();
+  if (buffer_count_ == 0) {
+    return 0;
+  }
+  return greedy_size_;
+}
+
+bool OptimalMemoryPlanner::IsPlanOptimal() {
+  CalculateOffsetsIfNeeded();
+  return (buffer_count_ == 0) || is_plan_optimal_;
+}
+
+int OptimalMemoryPlanner::GetSearchSteps() {
+  CalculateOffsetsIfNeeded();
+  return buffer_count_ == 0 ? 0 : search_steps_;
+}
+
+void OptimalMemoryPlanner::PrintMemoryPlan() {
+  CalculateOffsetsIfNeeded();
+
+  for (int i = 0; i < buffer_count_; ++i) {
+    MicroPrintf("%d: size=%d, offset=%d, first_used=%d last_used=%d%s", i,
+                requirements_[i].size, buffer_offsets_[i],
+                requirements_[i].first_time_used,
+                requirements_[i].last_time_used,
+                requirements_[i].offline_offset == kOnlinePlannedBuffer
+                    ? ""
+                    : " (offline)");
+  }
+  MicroPrintf("arena: %d bytes (greedy: %d bytes, saved %d), %s after %d steps",
+              static_cast<int>(GetMaximumMemorySize()),
+              static_cast<int>(GetGreedyMemorySize()),
+              static_cast<int>(GetGreedyMemorySize() - GetMaximumMemorySize()),
+              IsPlanOptimal() ? "optimal" : "best found", GetSearchSteps());
+}
+
+int OptimalMemoryPlanner::GetBufferCount() { return buffer_count_; }
+
+TfLiteStatus OptimalMemoryPlanner::GetOffsetForBuffer(int buffer_index,
+                                                      int* offset) {
+  CalculateOffsetsIfNeeded();
+  if ((buffer_index < 0) || (buffer_index >= buffer_count_)) {
+    MicroPrintf("buffer index %d is outside range 0 to %d", buffer_index,
+                buffer_count_);
+    return kTfLiteError;
+  }
+  *offset = buffer_offsets_[buffer_index];
+  return kTfLiteOk;
+}
+
+bool OptimalMemoryPlanner::DoAnyBuffersOverlap() {
+  CalculateOffsetsIfNeeded();
+  bool were_overlaps_found = false;
+  for (int i = 0; i < buffer_count_; ++i) {
+    const int a_start_offset = buffer_offsets_[i];
+    const int a_end_offset = a_start_offset + requirements_[i].size;
+    for (int j = 0; j < buffer_count_; ++j) {
+      if ((i == j) || !DoBuffersOverlapInTime(i, j)) {
+        continue;
+      }
+      const int b_start_offset = buffer_offsets_[j];
+      const int b_end_offset = b_start_offset + requirements_[j].size;
+      if ((a_start_offset >= b_end_offset) ||
+          (b_start_offset >= a_end_offset)) {
+        // No overlap in memory.
+        continue;
+      }
+      were_overlaps_found = true;
+      MicroPrintf("Overlap: %d (%d->%d) vs %d (%d->%d)", i, a_start_offset,
+                  a_end_offset, j, b_start_offset, b_end_offset);
+    }
+  }
+  return were_overlaps_found;
+}
+
+}  // namespace tflite
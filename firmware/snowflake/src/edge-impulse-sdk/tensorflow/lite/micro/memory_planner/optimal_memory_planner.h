@@ -0,0 +1,194 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_OPTIMAL_MEMORY_PLANNER_H_
+#define TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_OPTIMAL_MEMORY_PLANNER_H_
+
+#include "edge-impulse-sdk/tensorflow/lite/micro/compatibility.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/micro_memory_planner.h"
+
+namespace tflite {
+
+// A memory planner that searches for the smallest arena with a branch and
+// bound over buffer placements, for graphs small enough that this is cheap.
+//
+// The algorithm works like this:
+//  - Offline planned buffers are placed at their given offsets, as in the
+//    GreedyMemoryPlanner.
+//  - The online planned buffers are placed the way the GreedyMemoryPlanner
+//    places them (descending size, first gap that fits). This plan is the
+//    starting point, and its size is kept as GetGreedyMemorySize().
+//  - If that plan isn't already as small as the most memory that's in use at
+//    any one time (a lower bound for any plan), the planner searches over the
+//    order in which buffers are placed, each one at the lowest offset that's
+//    free during its lifetime. Taking the buffers of any plan in order of
+//    offset and placing them like this gives a plan that's at most as large,
+//    so searching over these orders finds the smallest arena. Only orders of
+//    non-decreasing offset are visited, and a branch is dropped once a buffer
+//    still to be placed can't end below the best plan found so far.
+//  - The search stops after max_search_steps buffer placements, keeping the
+//    best plan found; IsPlanOptimal() tells whether it ran to completion. The
+//    budget is counted in placements rather than time so that a model always
+//    gets the same plan.
+//  - Graphs with more than kMaxSearchBuffers online planned buffers keep the
+//    greedy plan.
+//
+// The plan is never larger than the GreedyMemoryPlanner one.
+class OptimalMemoryPlanner : public MicroMemoryPlanner {
+ public:
+  // Most online planned buffers the search is run for. Past this the greedy
+  // plan is kept as is: the search rarely gets far enough within the budget
+  // to improve on it, and each buffer takes about 44 bytes of scratch.
+  static constexpr int kMaxSearchBuffers = 64;
+  // Default budget, in buffer placements. Each placement walks the buffers
+  // placed so far, so a search that runs out of budget on a 64 buffer graph
+  // takes about 14 ms on an x86 host (test/test_optimal_memory_planner.cpp),
+  // an order of magnitude more on a Cortex-M. Graphs of up to about 8
+  // buffers are searched to completion well within it.
+  static constexpr int kDefaultMaxSearchSteps = 4096;
+
+  explicit OptimalMemoryPlanner(int max_search_steps = kDefaultMaxSearchSteps);
+  ~OptimalMemoryPlanner() override;
+
+  // You need to pass in an area of memory to be used for planning, see
+  // GreedyMemoryPlanner::Init(). Each buffer requires about 44 bytes of
+  // scratch.
+  TfLiteStatus Init(unsigned char* scratch_buffer,
+                    int scratch_buffer_size) override;
+
+  // Record details of a buffer we want to place.
+  TfLiteStatus AddBuffer(int size, int first_time_used,
+                         int last_time_used) override;
+
+  // Record details of an offline planned buffer offset we want to place.
+  // offline_offset is the buffer offset from the start of the arena.
+  TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used,
+                         int offline_offset) override;
+
+  // Returns the high-water mark of used memory. This is the minimum size of a
+  // memory arena you'd need to allocate to hold these buffers.
+  size_t GetMaximumMemorySize() override;
+
+  // How many buffers have been recorded.
+  int GetBufferCount() override;
+
+  // Where a given buffer should be placed in the memory arena.
+  TfLiteStatus GetOffsetForBuffer(int buffer_index, int* offset) override;
+
+  // Prints the buffer layout plan, and how it compares to the greedy one.
+  void PrintMemoryPlan() override;
+
+  // The arena the GreedyMemoryPlanner would need for the same buffers.
+  size_t GetGreedyMemorySize();
+
+  // Whether the search ran to completion, so no smaller arena exists.
+  bool IsPlanOptimal();
+
+  // How many buffer placements the search took.
+  int GetSearchSteps();
+
+  // Debug method to check whether any buffer allocations are overlapping. This
+  // is an O(N^2) complexity operation, so only use for testing.
+  bool DoAnyBuffersOverlap();
+
+  // Number of bytes required in order to plan a buffer.
+  static size_t per_buffer_size() {
+    const int per_buffer_size =
+        sizeof(BufferRequirements) +  // requirements_
+        sizeof(int) +                 // buffer_offsets_
+        sizeof(int) +                 // current_offsets_
+        sizeof(int) +                 // buffer_ids_sorted_
+        sizeof(int) +                 // placed_by_offset_
+        sizeof(int) +                 // search_buffer_
+        sizeof(int) +                 // search_cursor_
+        sizeof(int);                  // search_peak_
+    return per_buffer_size;
+  }
+
+ private:
+  // Whether two buffers are active at the same time.
+  bool DoBuffersOverlapInTime(int a_id, int b_id) const;
+
+  // The lowest offset, from lowest_offset up, at which a buffer fits next to
+  // the ones placed so far.
+  int LowestFreeOffset(int buffer_id, int lowest_offset) const;
+
+  // Add a buffer to the current plan, or take it out again.
+  void PlaceBuffer(int buffer_id, int offset);
+  void RemoveBuffer(int buffer_id);
+
+  // The smallest arena any plan that extends the current one can need, given
+  // the offset of the last buffer placed and the arena size so far.
+  int PlanLowerBound(int offset, int peak) const;
+
+  // Searches for a plan smaller than the one in buffer_offsets_.
+  void Search();
+
+  // If there isn't an up to date plan, calculate a new one.
+  void CalculateOffsetsIfNeeded();
+
+  // Records the client-provided information about each buffer.
+  struct BufferRequirements {
+    int size;
+    int offline_offset;
+    int first_time_used;
+    int last_time_used;
+  };
+
+  // How many buffer placements the search may take.
+  int max_search_steps_;
+
+  // How many buffers we can plan for, based on the scratch memory size.
+  int max_buffer_count_;
+
+  // The number of buffers added so far.
+  int buffer_count_;
+
+  BufferRequirements* requirements_;
+  // The best plan found so far, the location of each buffer in the arena.
+  int* buffer_offsets_;
+  // The plan being built by the search, -1 for buffers not placed yet.
+  int* current_offsets_;
+  // The online planned buffers of non-zero size, in descending order of size.
+  int* buffer_ids_sorted_;
+  int online_count_;
+  // The buffers in the current plan, in order of offset.
+  int* placed_by_offset_;
+  int placed_count_;
+  // For each search depth: the buffer placed, the next entry of
+  // buffer_ids_sorted_ to try and the arena size so far.
+  int* search_buffer_;
+  int* search_cursor_;
+  int* search_peak_;
+
+  // Where the offline planned buffers end.
+  int offline_peak_;
+  // The most memory in use at any one time, no plan can be smaller.
+  int live_size_bound_;
+  int greedy_size_;
+  int best_size_;
+  int search_steps_;
+  bool is_plan_optimal_;
+
+  // Whether buffers have been added since the last plan was calculated.
+  bool need_to_calculate_offsets_;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_OPTIMAL_MEMORY_PLANNER_H_
@@ -26,13 +26,48 @@ limitations under the License.
 
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_time.h"
 
-#if defined(TF_LITE_USE_CTIME)
+#if defined(TF_LITE_USE_CTIME) || defined(TF_LITE_USE_CLOCK_GETTIME)
 #include <ctime>
 #endif
 
 namespace tflite {
 
-#if !defined(TF_LITE_USE_CTIME)
+#if defined(TF_LITE_USE_DWT_CYCCNT)
+
+// Cortex-M DWT cycle counter, TF_LITE_DWT_CLOCK_HZ should be set to the core
+// clock. The counter is enabled on first use.
+#ifndef TF_LITE_DWT_CLOCK_HZ
+#define TF_LITE_DWT_CLOCK_HZ 200000000
+#endif
+
+uint32_t ticks_per_second() { return TF_LITE_DWT_CLOCK_HZ; }
+
+uint32_t GetCurrentTimeTicks() {
+  volatile uint32_t* const demcr = reinterpret_cast<volatile uint32_t*>(0xE000EDFC);
+  volatile uint32_t* const dwt_ctrl = reinterpret_cast<volatile uint32_t*>(0xE0001000);
+  volatile uint32_t* const dwt_cyccnt = reinterpret_cast<volatile uint32_t*>(0xE0001004);
+
+  if ((*dwt_ctrl & 1) == 0) {
+    *demcr |= (1UL << 24);  // TRCENA
+    *dwt_cyccnt = 0;
+    *dwt_ctrl |= 1;  // CYCCNTENA
+  }
+  return *dwt_cyccnt;
+}
+
+#elif defined(TF_LITE_USE_CLOCK_GETTIME)
+
+// Monotonic clock in microseconds, clock() only counts CPU time and is too
+// coarse on most hosts to time single ops.
+uint32_t ticks_per_second() { return 1000000; }
+
+uint32_t GetCurrentTimeTicks() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint32_t>(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+#elif !defined(TF_LITE_USE_CTIME)
 
 // Reference implementation of the ticks_per_second() function that's required
 // for a platform to support Tensorflow Lite for Microcontrollers profiling.
@@ -67,6 +67,9 @@
 #define EI_CLASSIFIER_INTERVAL_MS                0.0625
 #define EI_CLASSIFIER_LABEL_COUNT                2
 #define EI_CLASSIFIER_HAS_ANOMALY                0
+#ifndef EI_CLASSIFIER_HAS_GATE
+#define EI_CLASSIFIER_HAS_GATE                   0
+#endif // EI_CLASSIFIER_HAS_GATE
 #define EI_CLASSIFIER_FREQUENCY                  16000
 #define EI_CLASSIFIER_HAS_MODEL_VARIABLES        1
 
@@ -76,6 +79,9 @@
 #define EI_CLASSIFIER_OBJECT_DETECTION_LAST_LAYER EI_CLASSIFIER_LAST_LAYER_UNKNOWN
 
 
+// the largest kTensorArenaSize of the variants of tflite_learn_5_compiled.cpp, int4 filters unpacked
+// to int8 (EI_CLASSIFIER_TFLITE_INT4_WEIGHTS off CMSIS-NN); 2128 for the generated graph
+#define EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE     2928
 #define EI_CLASSIFIER_TFLITE_INPUT_DATATYPE         EI_CLASSIFIER_DATATYPE_INT8
 #define EI_CLASSIFIER_TFLITE_OUTPUT_DATATYPE        EI_CLASSIFIER_DATATYPE_INT8
 
@@ -93,6 +99,18 @@
 #define EI_CLASSIFIER_HAS_FFT_INFO               0
 
 #define EI_DSP_PARAMS_GENERATED 1
+// the MFCC block of model_variables.h (ei_dsp_config_3), test/test_mfcc_static.cpp checks they agree
+#define EI_DSP_PARAMS_MFCC_IMPLEMENTATION_VERSION  4
+#define EI_DSP_PARAMS_MFCC_NUM_CEPSTRAL             13
+#define EI_DSP_PARAMS_MFCC_FRAME_LENGTH             0.025f
+#define EI_DSP_PARAMS_MFCC_FRAME_STRIDE             0.02f
+#define EI_DSP_PARAMS_MFCC_NUM_FILTERS              32
+#define EI_DSP_PARAMS_MFCC_FFT_LENGTH               512
+#define EI_DSP_PARAMS_MFCC_WIN_SIZE                 151
+#define EI_DSP_PARAMS_MFCC_LOW_FREQUENCY            80
+#define EI_DSP_PARAMS_MFCC_HIGH_FREQUENCY           0
+#define EI_DSP_PARAMS_MFCC_PRE_COF                  0.98f
+#define EI_DSP_PARAMS_MFCC_PRE_SHIFT                1
 
 
 #define EI_CLASSIFIER_SENSOR                     EI_CLASSIFIER_SENSOR_MICROPHONE
@@ -66,6 +66,9 @@ const ei_config_tflite_eon_graph_t ei_config_tflite_graph_5 = {
     .model_reset = &tflite_learn_5_reset,
     .model_input = &tflite_learn_5_input,
     .model_output = &tflite_learn_5_output,
+#if EI_CLASSIFIER_PROFILE_OPS
+    .model_set_profiler = &tflite_learn_5_set_profiler,
+#endif
 };
 
 const ei_learning_block_config_tflite_graph_t ei_learning_block_config_5 = {
@@ -81,8 +84,27 @@ const ei_learning_block_config_tflite_graph_t ei_learning_block_config_5 = {
     .graph_config = (void*)&ei_config_tflite_graph_5
 };
 
+#if EI_CLASSIFIER_HAS_GATE == 1
+// linear gate over the MFCC features, exported next to the model as
+// `const ei_learning_block_config_gate_linear_t ei_learning_block_config_gate`
+// (test/test_gate_cascade.cpp has a synthetic one)
+#if !__has_include("model-parameters/gate_parameters.h")
+#error "EI_CLASSIFIER_HAS_GATE needs the gate parameters exported to model-parameters/gate_parameters.h"
+#endif
+#include "model-parameters/gate_parameters.h"
+
+const size_t ei_learning_blocks_size = 2;
+#else
 const size_t ei_learning_blocks_size = 1;
+#endif // EI_CLASSIFIER_HAS_GATE
 const ei_learning_block_t ei_learning_blocks[ei_learning_blocks_size] = {
+#if EI_CLASSIFIER_HAS_GATE == 1
+    {
+        &run_linear_gate,
+        (void*)&ei_learning_block_config_gate,
+        EI_CLASSIFIER_IMAGE_SCALING_NONE,
+    },
+#endif // EI_CLASSIFIER_HAS_GATE
     {
         &run_nn_inference,
         (void*)&ei_learning_block_config_5,
@@ -26,6 +26,10 @@
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/classifier/ei_packed_weights.h"
+#if EI_CLASSIFIER_PROFILE_OPS
+#include "edge-impulse-sdk/classifier/ei_op_profiler.h"
+#endif
 
 #if EI_CLASSIFIER_PRINT_STATE
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
@@ -65,11 +69,49 @@ using namespace tflite::ops::micro;
 
 namespace {
 
+// int4 filters that conv.cpp and fully_connected.cpp unpack to int8, in scratch buffers (384 + 416
+// bytes) on top of the tensors: everywhere but the CMSIS-NN kernels without MVE, which take them packed
+#define EI_INT4_WEIGHTS_UNPACKED (EI_CLASSIFIER_TFLITE_INT4_WEIGHTS && \
+    (EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN != 1 || defined(__ARM_FEATURE_MVE)))
+
+// one size per variant of the graph (see ei_classifier_config.h), the largest is
+// EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE in model_metadata.h
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+// int8 and int4 filters alike: the fused ops only build on the CMSIS-NN kernels without MVE, which
+// take int4 filters packed
+#if EI_INT4_WEIGHTS_UNPACKED
+#error "EI_CLASSIFIER_TFLITE_FUSED_OPS with int4 filters unpacked has no arena size"
+#endif
+#if defined(EI_CLASSIFIER_ALLOCATION_STATIC_HIMAX) || defined(EI_CLASSIFIER_ALLOCATION_STATIC_HIMAX_GNU)
+constexpr int kTensorArenaSize = 2736;
+#else
+constexpr int kTensorArenaSize = 1712;
+#endif
+#elif EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES && EI_INT4_WEIGHTS_UNPACKED
+#if defined(EI_CLASSIFIER_ALLOCATION_STATIC_HIMAX) || defined(EI_CLASSIFIER_ALLOCATION_STATIC_HIMAX_GNU)
+constexpr int kTensorArenaSize = 3776;
+#else
+constexpr int kTensorArenaSize = 2752;
+#endif
+#elif EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
+#if defined(EI_CLASSIFIER_ALLOCATION_STATIC_HIMAX) || defined(EI_CLASSIFIER_ALLOCATION_STATIC_HIMAX_GNU)
+constexpr int kTensorArenaSize = 2976;
+#else
+constexpr int kTensorArenaSize = 1952;
+#endif
+#elif EI_INT4_WEIGHTS_UNPACKED
+#if defined(EI_CLASSIFIER_ALLOCATION_STATIC_HIMAX) || defined(EI_CLASSIFIER_ALLOCATION_STATIC_HIMAX_GNU)
+constexpr int kTensorArenaSize = 3952;
+#else
+constexpr int kTensorArenaSize = 2928;
+#endif
+#else
 #if defined(EI_CLASSIFIER_ALLOCATION_STATIC_HIMAX) || defined(EI_CLASSIFIER_ALLOCATION_STATIC_HIMAX_GNU)
 constexpr int kTensorArenaSize = 3152;
 #else
 constexpr int kTensorArenaSize = 2128;
 #endif
+#endif // EI_CLASSIFIER_TFLITE_FUSED_OPS
 
 #if defined(EI_CLASSIFIER_ALLOCATION_STATIC)
 uint8_t tensor_arena[kTensorArenaSize] ALIGN(16);
@@ -90,9 +132,43 @@ static uint8_t* current_location;
 template <int SZ, class T> struct TfArray {
   int sz; T elem[SZ];
 };
+// Not all of this file is from the EON compiler. The graph with EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
+// (the RESHAPE nodes are not run, their output tensor shares the memory of their input) and with
+// EI_CLASSIFIER_TFLITE_FUSED_OPS (each CONV_2D + MAX_POOL_2D pair runs as one node) was written by
+// hand: when the model is generated again they're lost and have to be written again by hand, the
+// node, tensor and arena size tables under these flags (test/test_fused_model.cpp checks them
+// against the generated graph). The weight tables under EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS and
+// EI_CLASSIFIER_TFLITE_INT4_WEIGHTS are written by tools/eon_weight_tables.py from the generated
+// ones. Without these flags the graph is as generated
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+enum used_operators_e {
+  OP_CONV_2D_MAX_POOL_2D, OP_FULLY_CONNECTED, OP_SOFTMAX,  OP_LAST
+};
+constexpr size_t kNodeCount = 4;
+#elif EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
+enum used_operators_e {
+  OP_CONV_2D, OP_MAX_POOL_2D, OP_FULLY_CONNECTED, OP_SOFTMAX,  OP_LAST
+};
+constexpr size_t kNodeCount = 6;
+#else
 enum used_operators_e {
   OP_RESHAPE, OP_CONV_2D, OP_MAX_POOL_2D, OP_FULLY_CONNECTED, OP_SOFTMAX,  OP_LAST
 };
+constexpr size_t kNodeCount = 11;
+#endif // EI_CLASSIFIER_TFLITE_FUSED_OPS
+#if EI_CLASSIFIER_PROFILE_OPS
+const char *used_operator_names[OP_LAST] = {
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+  "CONV_2D_MAX_POOL_2D", "FULLY_CONNECTED", "SOFTMAX",
+#elif EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
+  "CONV_2D", "MAX_POOL_2D", "FULLY_CONNECTED", "SOFTMAX",
+#else
+  "RESHAPE", "CONV_2D", "MAX_POOL_2D", "FULLY_CONNECTED", "SOFTMAX",
+#endif // EI_CLASSIFIER_TFLITE_FUSED_OPS
+};
+static EiOpProfiler *op_profiler = nullptr;
+static size_t overflow_buffers_bytes = 0;
+#endif
 struct TensorInfo_t { // subset of TfLiteTensor used for initialization from constant memory
   TfLiteAllocationType allocation_type;
   TfLiteType type;
@@ -106,6 +182,7 @@ struct NodeInfo_t { // subset of TfLiteNode used for initialization from constan
   struct TfLiteIntArray* outputs;
   void* builtin_data;
   used_operators_e used_op_index;
+  struct TfLiteIntArray* intermediates;
 };
 
 typedef struct {
@@ -119,12 +196,12 @@ typedef struct {
 } TfLiteEvalTensorWithIndex;
 
 TfLiteContext ctx{};
-static const int MAX_TFL_TENSOR_COUNT = 4;
+static const int MAX_TFL_TENSOR_COUNT = 5;
 static TfLiteTensorWithIndex tflTensors[MAX_TFL_TENSOR_COUNT];
 static const int MAX_TFL_EVAL_COUNT = 4;
 static TfLiteEvalTensorWithIndex tflEvalTensors[MAX_TFL_EVAL_COUNT];
 TfLiteRegistration registrations[OP_LAST];
-TfLiteNode tflNodes[11];
+TfLiteNode tflNodes[kNodeCount];
 
 const TfArray<2, int> tensor_dimension0 = { 2, { 1,637 } };
 const TfArray<1, float> quant0_scale = { 1, { 0.052317272871732712, } };
@@ -140,8 +217,32 @@ const ALIGN(16) int32_t tensor_data4[4] = { 1, 25, 1, 16, };
 const TfArray<1, int> tensor_dimension4 = { 1, { 4 } };
 const ALIGN(8) int32_t tensor_data5[2] = { -1, 208, };
 const TfArray<1, int> tensor_dimension5 = { 1, { 2 } };
+#if EI_CLASSIFIER_TFLITE_INT4_WEIGHTS
+// int4, two per byte (element 2k is the low nibble of byte k), requantized to [-7, 7]
+const ALIGN(8) int32_t tensor_data6[2] = { -1, 1, };
+const TfArray<1, int> tensor_dimension6 = { 1, { 2 } };
+#if EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+// tensor_data6 - input zero point (-128) * sum of each tensor_data7 row
+const ALIGN(8) int32_t folded_bias6[2] = { -17793, 15745, };
+#endif // EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+const TfArray<1, float> quant6_scale = { 1, { 0.003916886635124683, } };
+const TfArray<1, int> quant6_zero = { 1, { 0 } };
+const TfLiteAffineQuantization quant6 = { (TfLiteFloatArray*)&quant6_scale, (TfLiteIntArray*)&quant6_zero, 0 };
+const ALIGN(16) int8_t tensor_data7[2*208/2] = { 
+  -48, -32, 0, 13, -18, -1, 12, 15, -48, -48, -1, 46, -19, 0, 30, 46, -2, -32, -16, 29, 13, 13, -20, 31, 15, -32, -32, 14, -18, 31, -35, 31, -2, 16, -31, 29, -32, 30, -34, 32, 13, -18, -111, 16, -48, 29, -32, 17, 15, 30, -48, 16, 0, 30, 1, 32, 63, 14, 0, -1, -16, 31, 1, 17, 47, 14, 13, 2, 0, 15, 19, 47, 31, -3, 14, -16, -32, -34, 34, 14, 15, -31, -1, 1, -2, 14, 17, 31, 1, -15, 15, 0, -17, -34, 33, 14, -17, -33, -14, -15, -2, -81, 18, 28, 
+  33, 49, -15, 2, 49, -1, 35, 1, 33, 17, 18, -14, 3, -15, 19, 2, 34, 17, -16, 20, 35, 2, 67, -32, -14, 1, 32, -12, 2, 3, 34, -17, 18, -16, 63, -14, 32, -31, 48, -47, 2, 33, 111, -15, 63, -13, 31, -3, 19, -28, 49, 0, 16, -15, -2, -33, -31, 18, 2, -31, -1, 1, -16, -31, -32, 1, 35, 15, 31, 17, -1, -32, -32, 50, 35, 46, 16, 35, -18, -15, -16, 47, 1, 32, 33, 16, -1, -14, 1, 33, 1, 15, -16, 33, -1, -32, 33, 18, 0, 31, 17, 81, -33, -12, 
+};
+const TfArray<2, int> tensor_dimension7 = { 2, { 2,208 } };
+const TfArray<1, float> quant7_scale = { 1, { 0.13102489709854126, } };
+const TfArray<1, int> quant7_zero = { 1, { 0 } };
+const TfLiteAffineQuantization quant7 = { (TfLiteFloatArray*)&quant7_scale, (TfLiteIntArray*)&quant7_zero, 0 };
+#else
 const ALIGN(8) int32_t tensor_data6[2] = { -25, 25, };
 const TfArray<1, int> tensor_dimension6 = { 1, { 2 } };
+#if EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+// tensor_data6 - input zero point (-128) * sum of each tensor_data7 row
+const ALIGN(8) int32_t folded_bias6[2] = { -315161, 278809, };
+#endif // EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
 const TfArray<1, float> quant6_scale = { 1, { 0.00021589139942079782, } };
 const TfArray<1, int> quant6_zero = { 1, { 0 } };
 const TfLiteAffineQuantization quant6 = { (TfLiteFloatArray*)&quant6_scale, (TfLiteIntArray*)&quant6_zero, 0 };
@@ -153,11 +254,64 @@ const TfArray<2, int> tensor_dimension7 = { 2, { 2,208 } };
 const TfArray<1, float> quant7_scale = { 1, { 0.0072218449786305428, } };
 const TfArray<1, int> quant7_zero = { 1, { 0 } };
 const TfLiteAffineQuantization quant7 = { (TfLiteFloatArray*)&quant7_scale, (TfLiteIntArray*)&quant7_zero, 0 };
+#endif // EI_CLASSIFIER_TFLITE_INT4_WEIGHTS
+#if EI_CLASSIFIER_TFLITE_INT4_WEIGHTS
+// int4, two per byte (element 2k is the low nibble of byte k), requantized to [-7, 7] per channel.
+// Not reordered with EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS, arm_convolve_s4 takes them as they are
+const ALIGN(16) int32_t tensor_data8[16] = { -63, -104, -37, -54, 18, 46, -43, -55, -98, -119, -69, -54, -10, 1, -94, -17, };
+const TfArray<1, int> tensor_dimension8 = { 1, { 16 } };
+const TfArray<16, float> quant8_scale = { 16, { 0.0034054825082421303, 0.004080112557858229, 0.0043639554642140865, 0.005031908862292767, 0.0036170289386063814, 0.005135021638125181, 0.0031543385703116655, 0.0034851410891860723, 0.003756994381546974, 0.003058400470763445, 0.0035321267787367105, 0.004371399525552988, 0.0043502082116901875, 0.005211809650063515, 0.002932942472398281, 0.005499167833477259, } };
+const TfArray<16, int> quant8_zero = { 16, { 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 } };
+const TfLiteAffineQuantization quant8 = { (TfLiteFloatArray*)&quant8_scale, (TfLiteIntArray*)&quant8_zero, 0 };
+const ALIGN(16) int8_t tensor_data9[16*1*3*8/2] = { 
+  /* [0][0][][] */ -32,116,-1,99, 14,-76,-33,-74, -38,3,-3,-33, 
+  /* [1][0][][] */ 58,65,-112,14, 43,47,-20,32, 5,-29,-23,15, 
+  /* [2][0][][] */ -33,34,-98,-16, -17,-14,-33,34, 14,-25,0,-27, 
+  /* [3][0][][] */ -50,2,19,46, -69,62,-31,31, -101,-80,14,2, 
+  /* [4][0][][] */ -102,-112,-1,62, -83,-1,29,-17, -64,-80,92,51, 
+  /* [5][0][][] */ 27,3,-99,77, 12,30,-70,0, -4,19,-51,-18, 
+  /* [6][0][][] */ -42,96,0,48, -64,-97,-3,86, -33,-6,-1,-52, 
+  /* [7][0][][] */ 125,-50,16,-1, -17,-67,-45,-1, 48,-68,19,-38, 
+  /* [8][0][][] */ -82,-11,14,65, -79,61,79,90, -80,1,79,-112, 
+  /* [9][0][][] */ -4,101,-82,103, -38,-60,-4,76, -22,78,-18,64, 
+  /* [10][0][][] */ 10,126,-18,-26, -34,29,-51,62, -22,18,-19,34, 
+  /* [11][0][][] */ 48,-2,34,-17, 46,16,-10,-1, 29,-18,-23,-35, 
+  /* [12][0][][] */ 12,64,-34,-3, 6,-4,44,-35, 15,-83,9,-2, 
+  /* [13][0][][] */ 1,12,-36,-31, 35,12,-85,13, 14,-30,-101,27, 
+  /* [14][0][][] */ -63,-16,113,-96, -50,82,66,-98, -53,-34,-62,17, 
+  /* [15][0][][] */ 34,-19,-14,-2, 77,-2,-65,-1, -65,-34,57,-1, 
+};
+const TfArray<4, int> tensor_dimension9 = { 4, { 16,1,3,8 } };
+const TfArray<16, float> quant9_scale = { 16, { 0.07680501788854599, 0.092020183801651, 0.09842178225517273, 0.11348637193441391, 0.08157609403133392, 0.11581190675497055, 0.07114087790250778, 0.07860158383846283, 0.0847327783703804, 0.06897715479135513, 0.07966126501560211, 0.09858968108892441, 0.09811173379421234, 0.11754374206066132, 0.06614765524864197, 0.12402462214231491, } };
+const TfArray<16, int> quant9_zero = { 16, { 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 } };
+const TfLiteAffineQuantization quant9 = { (TfLiteFloatArray*)&quant9_scale, (TfLiteIntArray*)&quant9_zero, 0 };
+#else
 const ALIGN(16) int32_t tensor_data8[16] = { -1135, -1890, -669, -981, 326, 833, -788, -993, -1775, -2166, -1258, -984, -183, 11, -1705, -312, };
 const TfArray<1, int> tensor_dimension8 = { 1, { 16 } };
 const TfArray<16, float> quant8_scale = { 16, { 0.0001877037575468421, 0.0002248881064588204, 0.0002405329723842442, 0.00027734931791201234, 0.00019936379976570606, 0.00028303268481977284, 0.00017386117542628199, 0.0001920943905133754, 0.00020707842486444861, 0.00016857325681485236, 0.00019468415121082217, 0.00024094329273793846, 0.00023977525415830314, 0.00028726510936394334, 0.00016165824490599334, 0.00030310373404063284, } };
 const TfArray<16, int> quant8_zero = { 16, { 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 } };
 const TfLiteAffineQuantization quant8 = { (TfLiteFloatArray*)&quant8_scale, (TfLiteIntArray*)&quant8_zero, 0 };
+#if EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+// reordered per group of 4 for arm_convolve_s8_reordered (see arm_convolve_s8_reorder_filter)
+const ALIGN(16) int8_t tensor_data9[16*1*3*8] = { 
+  /* [0] */ 3,66,-42,127,-18,61,-12,112,-30,66,-8,-91,-22,108,-58,-98,-106,52,-47,-1,-46,-19,-14,-61, 
+  /* [1] */ -103,27,50,76,4,-32,-122,-8,-95,-10,32,34,-68,-6,-30,40,97,48,-6,-28,-127,-21,-28,9, 
+  /* [2] */ -10,44,-54,44,-39,-7,-127,-24,-26,36,-31,-14,-12,45,-47,43,-43,121,0,-37,-6,97,-7,-30, 
+  /* [3] */ -38,35,-70,0,53,-45,23,42,-83,-30,-89,51,15,-16,-36,15,-90,7,-127,-89,-28,41,1,-7, 
+  /* [4] */ -113,-2,-127,-120,-10,-32,-10,50,-56,-10,-107,-12,-63,-15,17,-36,-8,8,-71,-91,-64,53,98,53, 
+  /* [5] */ -87,57,21,0,-60,-49,-127,81,-66,-34,8,17,-101,-8,-93,5,-70,62,-10,24,-61,-35,-77,-38, 
+  /* [6] */ 100,1,-55,100,0,-5,-6,53,0,-11,-65,-127,-48,100,-13,95,-17,-106,-48,-16,-25,-71,-15,-71, 
+  /* [7] */ -56,-33,127,-74,4,-11,27,-16,-21,-49,-45,-83,48,-16,-55,-27,-5,-80,55,-92,51,-107,20,-50, 
+  /* [8] */ -44,92,-109,-14,-35,25,8,71,18,-62,-98,46,-21,-106,69,90,-4,18,-96,5,-26,5,81,-127, 
+  /* [9] */ -69,84,-18,109,-33,127,-107,117,-102,69,-60,-66,-67,-69,-16,71,-110,-42,-35,73,-29,2,-39,74, 
+  /* [10] */ -104,-35,-6,127,-44,112,-42,-40,-39,-58,-55,14,-53,-30,-68,54,-108,31,-31,16,-58,36,-34,45, 
+  /* [11] */ 9,-36,50,-21,29,-23,36,-31,-31,4,34,10,110,-12,-27,-12,-46,-38,20,-39,-127,-60,-45,-49, 
+  /* [12] */ -68,4,-2,80,-44,-51,-53,-20,107,-75,4,-21,-66,-54,32,-48,-18,-62,-3,-100,-127,-41,2,-12, 
+  /* [13] */ 20,-71,-8,6,-72,19,-58,-35,57,-71,41,-8,-99,-59,-117,-9,-43,35,9,-31,-92,-84,-127,21, 
+  /* [14] */ 17,-7,-75,-17,26,-1,119,-109,-43,41,-70,95,44,-37,68,-127,-82,-35,-75,-53,34,12,-69,21, 
+  /* [15] */ 33,-52,39,-39,32,-34,-17,-27,-47,-37,67,-27,-21,-21,-92,-22,-23,-45,-84,-51,-127,-20,48,-13, 
+};
+#else
 const ALIGN(16) int8_t tensor_data9[16*1*3*8] = { 
   /* [0][0][][] */ 3,-42,66,127,-18,-12,61,112, -30,-8,66,-91,-22,-58,108,-98, -106,-47,52,-1,-46,-14,-19,-61, 
   /* [1][0][][] */ -103,50,27,76,4,-122,-32,-8, -95,32,-10,34,-68,-30,-6,40, 97,-6,48,-28,-127,-28,-21,9, 
@@ -176,15 +330,30 @@ const ALIGN(16) int8_t tensor_data9[16*1*3*8] = {
   /* [14][0][][] */ 17,-75,-7,-17,26,119,-1,-109, -43,-70,41,95,44,68,-37,-127, -82,-75,-35,-53,34,-69,12,21, 
   /* [15][0][][] */ 33,39,-52,-39,32,-17,-34,-27, -47,67,-37,-27,-21,-92,-21,-22, -23,-84,-45,-51,-127,48,-20,-13, 
 };
+#endif // EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
 const TfArray<4, int> tensor_dimension9 = { 4, { 16,1,3,8 } };
 const TfArray<16, float> quant9_scale = { 16, { 0.0042333472520112991, 0.0050719785504043102, 0.0054248226806521416, 0.0062551544979214668, 0.0044963201507925987, 0.0063833333551883698, 0.0039211506955325603, 0.0043323705904185772, 0.004670310765504837, 0.0038018904160708189, 0.0043907784856855869, 0.0054340767674148083, 0.0054077333770692348, 0.0064787887968122959, 0.0036459336988627911, 0.0068360026925802231, } };
 const TfArray<16, int> quant9_zero = { 16, { 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0 } };
 const TfLiteAffineQuantization quant9 = { (TfLiteFloatArray*)&quant9_scale, (TfLiteIntArray*)&quant9_zero, 0 };
+#endif // EI_CLASSIFIER_TFLITE_INT4_WEIGHTS
 const ALIGN(16) int32_t tensor_data10[8] = { -4271, -3136, -2979, -1778, -3036, -2788, -3593, -2901, };
 const TfArray<1, int> tensor_dimension10 = { 1, { 8 } };
 const TfArray<8, float> quant10_scale = { 8, { 0.00023965230502653867, 0.00025762937730178237, 0.00030109586077742279, 0.00033988966606557369, 0.00037117974716238678, 0.00033436354715377092, 0.00026870676083490252, 0.00029163091676309705, } };
 const TfArray<8, int> quant10_zero = { 8, { 0,0,0,0,0,0,0,0 } };
 const TfLiteAffineQuantization quant10 = { (TfLiteFloatArray*)&quant10_scale, (TfLiteIntArray*)&quant10_zero, 0 };
+#if EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+// reordered per group of 4 for arm_convolve_s8_reordered (see arm_convolve_s8_reorder_filter)
+const ALIGN(16) int8_t tensor_data11[8*1*3*13] = { 
+  /* [0] */ 127,85,32,4,-106,61,-57,-10,46,-4,-35,4,84,22,81,-12,-5,-95,-43,-60,68,-13,2,-9,62,98,-6,23,58,-92,79,-40,-23,-5,57,-13,-3,-78,23, 
+  /* [1] */ 68,2,-80,70,-35,-49,23,6,-32,73,15,-88,10,-50,-12,44,-1,52,-44,-21,-6,-17,-34,17,-37,-61,14,-127,47,-60,90,42,26,-23,-61,6,-36,-20,-8, 
+  /* [2] */ -36,-68,-17,-74,-30,-35,-69,-14,45,33,-24,9,-9,-89,-21,-20,-39,60,-21,84,103,1,33,-35,-11,-16,-12,-127,-91,-50,-20,-57,-54,31,-7,10,-58,-55,2, 
+  /* [3] */ -65,-26,-82,-127,-2,21,50,-42,-57,-14,-71,41,27,49,-30,59,-23,52,-42,25,-9,45,24,7,15,8,-10,32,98,27,9,28,15,29,-48,12,2,6,46, 
+  /* [4] */ 127,-13,-2,-28,-4,1,6,7,19,-6,36,21,20,-23,107,15,-25,34,29,-33,-1,10,-24,48,4,41,10,-37,28,16,11,54,-49,-5,-67,5,10,2,30, 
+  /* [5] */ 67,-51,-47,24,0,-10,41,56,-1,11,12,-12,-30,-21,127,-21,12,-25,-16,11,45,31,-16,19,33,116,-2,60,-38,-18,64,27,35,15,-10,32,-28,8,52, 
+  /* [6] */ 15,-15,83,47,11,-15,37,-75,-65,-23,-36,92,-32,-5,-20,-86,44,19,34,12,2,21,-6,-4,-19,99,21,-127,8,-10,80,-108,-61,-40,-52,48,11,30,4, 
+  /* [7] */ 57,0,-18,77,127,33,48,2,-13,-13,-72,-3,67,65,2,0,16,11,55,-8,0,40,8,17,43,51,-12,102,127,71,27,18,24,32,51,-11,52,-18,-20, 
+};
+#else
 const ALIGN(16) int8_t tensor_data11[8*1*3*13] = { 
   /* [0][0][][] */ 127,32,85,4,-106,-57,61,-10,46,-35,-4,4,84, 81,22,-12,-5,-43,-95,-60,68,2,-13,-9,62,-6, 98,23,58,79,-92,-40,-23,57,-5,-13,-3,-78,23, 
   /* [1][0][][] */ 68,-80,2,70,-35,23,-49,6,-32,15,73,-88,10, -12,-50,44,-1,-44,52,-21,-6,-34,-17,17,-37,14, -61,-127,47,90,-60,42,26,-61,-23,6,-36,-20,-8, 
@@ -195,6 +364,7 @@ const ALIGN(16) int8_t tensor_data11[8*1*3*13] = {
   /* [6][0][][] */ 15,83,-15,47,11,37,-15,-75,-65,-36,-23,92,-32, -20,-5,-86,44,34,19,12,2,-6,21,-4,-19,21, 99,-127,8,80,-10,-108,-61,-52,-40,48,11,30,4, 
   /* [7][0][][] */ 57,-18,0,77,127,48,33,2,-13,-72,-13,-3,67, 2,65,0,16,55,11,-8,0,8,40,17,43,-12, 51,102,127,27,71,18,24,51,32,-11,52,-18,-20, 
 };
+#endif // EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
 const TfArray<4, int> tensor_dimension11 = { 4, { 8,1,3,13 } };
 const TfArray<8, float> quant11_scale = { 8, { 0.0045807491987943649, 0.0049243657849729061, 0.005755190271884203, 0.0064967009238898754, 0.0070947837084531784, 0.006391073577105999, 0.0051361005753278732, 0.0055742757394909859, } };
 const TfArray<8, int> quant11_zero = { 8, { 0,0,0,0,0,0,0,0 } };
@@ -227,7 +397,11 @@ const TfArray<4, int> tensor_dimension18 = { 4, { 1,25,1,16 } };
 const TfArray<1, float> quant18_scale = { 1, { 0.029894215986132622, } };
 const TfArray<1, int> quant18_zero = { 1, { -128 } };
 const TfLiteAffineQuantization quant18 = { (TfLiteFloatArray*)&quant18_scale, (TfLiteIntArray*)&quant18_zero, 0 };
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+const TfArray<4, int> tensor_dimension19 = { 4, { 1,1,13,16 } };
+#else
 const TfArray<4, int> tensor_dimension19 = { 4, { 1,13,1,16 } };
+#endif // EI_CLASSIFIER_TFLITE_FUSED_OPS
 const TfArray<1, float> quant19_scale = { 1, { 0.029894215986132622, } };
 const TfArray<1, int> quant19_zero = { 1, { -128 } };
 const TfLiteAffineQuantization quant19 = { (TfLiteFloatArray*)&quant19_scale, (TfLiteIntArray*)&quant19_zero, 0 };
@@ -243,6 +417,41 @@ const TfArray<2, int> tensor_dimension22 = { 2, { 1,2 } };
 const TfArray<1, float> quant22_scale = { 1, { 0.00390625, } };
 const TfArray<1, int> quant22_zero = { 1, { -128 } };
 const TfLiteAffineQuantization quant22 = { (TfLiteFloatArray*)&quant22_scale, (TfLiteIntArray*)&quant22_zero, 0 };
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+const EiConvMaxPoolParams opdata0 = { { kTfLitePaddingSame, 1,1, kTfLiteActRelu, 1,1 }, { kTfLitePaddingSame, 2,1, 2,1, kTfLiteActNone, { { 0,0, 0, 0 } } } };
+const TfArray<3, int> inputs0 = { 3, { 12,11,10 } };
+const TfArray<1, int> outputs0 = { 1, { 16 } };
+const TfArray<1, int> intermediates0 = { 1, { 13 } };
+const EiConvMaxPoolParams opdata1 = { { kTfLitePaddingSame, 1,1, kTfLiteActRelu, 1,1 }, { kTfLitePaddingSame, 2,1, 2,1, kTfLiteActNone, { { 0,0, 0, 0 } } } };
+const TfArray<3, int> inputs1 = { 3, { 16,9,8 } };
+const TfArray<1, int> outputs1 = { 1, { 19 } };
+const TfArray<1, int> intermediates1 = { 1, { 17 } };
+const TfLiteFullyConnectedParams opdata2 = { kTfLiteActNone, kTfLiteFullyConnectedWeightsFormatDefault, false, false };
+const TfArray<3, int> inputs2 = { 3, { 20,7,6 } };
+const TfArray<1, int> outputs2 = { 1, { 21 } };
+const TfLiteSoftmaxParams opdata3 = { 1 };
+const TfArray<1, int> inputs3 = { 1, { 21 } };
+const TfArray<1, int> outputs3 = { 1, { 22 } };
+#elif EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
+const TfLiteConvParams opdata0 = { kTfLitePaddingSame, 1,1, kTfLiteActRelu, 1,1 };
+const TfArray<3, int> inputs0 = { 3, { 12,11,10 } };
+const TfArray<1, int> outputs0 = { 1, { 13 } };
+const TfLitePoolParams opdata1 = { kTfLitePaddingSame, 1,2, 1,2, kTfLiteActNone, { { 0,0, 0, 0 } } };
+const TfArray<1, int> inputs1 = { 1, { 14 } };
+const TfArray<1, int> outputs1 = { 1, { 15 } };
+const TfLiteConvParams opdata2 = { kTfLitePaddingSame, 1,1, kTfLiteActRelu, 1,1 };
+const TfArray<3, int> inputs2 = { 3, { 16,9,8 } };
+const TfArray<1, int> outputs2 = { 1, { 17 } };
+const TfLitePoolParams opdata3 = { kTfLitePaddingSame, 1,2, 1,2, kTfLiteActNone, { { 0,0, 0, 0 } } };
+const TfArray<1, int> inputs3 = { 1, { 18 } };
+const TfArray<1, int> outputs3 = { 1, { 19 } };
+const TfLiteFullyConnectedParams opdata4 = { kTfLiteActNone, kTfLiteFullyConnectedWeightsFormatDefault, false, false };
+const TfArray<3, int> inputs4 = { 3, { 20,7,6 } };
+const TfArray<1, int> outputs4 = { 1, { 21 } };
+const TfLiteSoftmaxParams opdata5 = { 1 };
+const TfArray<1, int> inputs5 = { 1, { 21 } };
+const TfArray<1, int> outputs5 = { 1, { 22 } };
+#else
 const TfLiteReshapeParams opdata0 = { { 0, 0, 0, 0, 0, 0, 0, 0, }, 0 };
 const TfArray<2, int> inputs0 = { 2, { 0,1 } };
 const TfArray<1, int> outputs0 = { 1, { 12 } };
@@ -276,19 +485,53 @@ const TfArray<1, int> outputs9 = { 1, { 21 } };
 const TfLiteSoftmaxParams opdata10 = { 1 };
 const TfArray<1, int> inputs10 = { 1, { 21 } };
 const TfArray<1, int> outputs10 = { 1, { 22 } };
+#endif // EI_CLASSIFIER_TFLITE_FUSED_OPS
 const TensorInfo_t tensorData[] = {
+#if EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
+  { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 0, (TfLiteIntArray*)&tensor_dimension0, 637, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant0))}, },
+#else
   { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 640, (TfLiteIntArray*)&tensor_dimension0, 637, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant0))}, },
+#endif // EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
   { kTfLiteMmapRo, kTfLiteInt32, (void*)tensor_data1, (TfLiteIntArray*)&tensor_dimension1, 16, {kTfLiteNoQuantization, nullptr}, },
   { kTfLiteMmapRo, kTfLiteInt32, (void*)tensor_data2, (TfLiteIntArray*)&tensor_dimension2, 16, {kTfLiteNoQuantization, nullptr}, },
   { kTfLiteMmapRo, kTfLiteInt32, (void*)tensor_data3, (TfLiteIntArray*)&tensor_dimension3, 16, {kTfLiteNoQuantization, nullptr}, },
   { kTfLiteMmapRo, kTfLiteInt32, (void*)tensor_data4, (TfLiteIntArray*)&tensor_dimension4, 16, {kTfLiteNoQuantization, nullptr}, },
   { kTfLiteMmapRo, kTfLiteInt32, (void*)tensor_data5, (TfLiteIntArray*)&tensor_dimension5, 8, {kTfLiteNoQuantization, nullptr}, },
   { kTfLiteMmapRo, kTfLiteInt32, (void*)tensor_data6, (TfLiteIntArray*)&tensor_dimension6, 8, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant6))}, },
+#if EI_CLASSIFIER_TFLITE_INT4_WEIGHTS
+  { kTfLiteMmapRo, kTfLiteInt4, (void*)tensor_data7, (TfLiteIntArray*)&tensor_dimension7, 208, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant7))}, },
+#else
   { kTfLiteMmapRo, kTfLiteInt8, (void*)tensor_data7, (TfLiteIntArray*)&tensor_dimension7, 416, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant7))}, },
+#endif // EI_CLASSIFIER_TFLITE_INT4_WEIGHTS
   { kTfLiteMmapRo, kTfLiteInt32, (void*)tensor_data8, (TfLiteIntArray*)&tensor_dimension8, 64, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant8))}, },
+#if EI_CLASSIFIER_TFLITE_INT4_WEIGHTS
+  { kTfLiteMmapRo, kTfLiteInt4, (void*)tensor_data9, (TfLiteIntArray*)&tensor_dimension9, 192, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant9))}, },
+#else
   { kTfLiteMmapRo, kTfLiteInt8, (void*)tensor_data9, (TfLiteIntArray*)&tensor_dimension9, 384, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant9))}, },
+#endif // EI_CLASSIFIER_TFLITE_INT4_WEIGHTS
   { kTfLiteMmapRo, kTfLiteInt32, (void*)tensor_data10, (TfLiteIntArray*)&tensor_dimension10, 32, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant10))}, },
   { kTfLiteMmapRo, kTfLiteInt8, (void*)tensor_data11, (TfLiteIntArray*)&tensor_dimension11, 312, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant11))}, },
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+  { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 0, (TfLiteIntArray*)&tensor_dimension12, 637, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant12))}, },
+  { kTfLiteMemNone, kTfLiteInt8, nullptr, (TfLiteIntArray*)&tensor_dimension13, 392, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant13))}, },
+  { kTfLiteMemNone, kTfLiteInt8, nullptr, (TfLiteIntArray*)&tensor_dimension14, 392, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant14))}, },
+  { kTfLiteMemNone, kTfLiteInt8, nullptr, (TfLiteIntArray*)&tensor_dimension15, 200, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant15))}, },
+  { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 640, (TfLiteIntArray*)&tensor_dimension16, 200, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant16))}, },
+  { kTfLiteMemNone, kTfLiteInt8, nullptr, (TfLiteIntArray*)&tensor_dimension17, 400, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant17))}, },
+  { kTfLiteMemNone, kTfLiteInt8, nullptr, (TfLiteIntArray*)&tensor_dimension18, 400, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant18))}, },
+  { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 0, (TfLiteIntArray*)&tensor_dimension19, 208, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant19))}, },
+  { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 0, (TfLiteIntArray*)&tensor_dimension20, 208, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant20))}, },
+#elif EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
+  { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 0, (TfLiteIntArray*)&tensor_dimension12, 637, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant12))}, },
+  { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 640, (TfLiteIntArray*)&tensor_dimension13, 392, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant13))}, },
+  { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 640, (TfLiteIntArray*)&tensor_dimension14, 392, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant14))}, },
+  { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 0, (TfLiteIntArray*)&tensor_dimension15, 200, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant15))}, },
+  { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 0, (TfLiteIntArray*)&tensor_dimension16, 200, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant16))}, },
+  { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 640, (TfLiteIntArray*)&tensor_dimension17, 400, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant17))}, },
+  { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 640, (TfLiteIntArray*)&tensor_dimension18, 400, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant18))}, },
+  { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 0, (TfLiteIntArray*)&tensor_dimension19, 208, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant19))}, },
+  { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 0, (TfLiteIntArray*)&tensor_dimension20, 208, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant20))}, },
+#else
   { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 0, (TfLiteIntArray*)&tensor_dimension12, 637, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant12))}, },
   { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 640, (TfLiteIntArray*)&tensor_dimension13, 392, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant13))}, },
   { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 0, (TfLiteIntArray*)&tensor_dimension14, 392, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant14))}, },
@@ -298,21 +541,56 @@ const TensorInfo_t tensorData[] = {
   { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 0, (TfLiteIntArray*)&tensor_dimension18, 400, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant18))}, },
   { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 400, (TfLiteIntArray*)&tensor_dimension19, 208, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant19))}, },
   { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 0, (TfLiteIntArray*)&tensor_dimension20, 208, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant20))}, },
+#endif // EI_CLASSIFIER_TFLITE_FUSED_OPS
   { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 208, (TfLiteIntArray*)&tensor_dimension21, 2, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant21))}, },
   { kTfLiteArenaRw, kTfLiteInt8, tensor_arena + 0, (TfLiteIntArray*)&tensor_dimension22, 2, {kTfLiteAffineQuantization, const_cast<void*>(static_cast<const void*>(&quant22))}, },
 };const NodeInfo_t nodeData[] = {
-  { (TfLiteIntArray*)&inputs0, (TfLiteIntArray*)&outputs0, const_cast<void*>(static_cast<const void*>(&opdata0)), OP_RESHAPE, },
-  { (TfLiteIntArray*)&inputs1, (TfLiteIntArray*)&outputs1, const_cast<void*>(static_cast<const void*>(&opdata1)), OP_CONV_2D, },
-  { (TfLiteIntArray*)&inputs2, (TfLiteIntArray*)&outputs2, const_cast<void*>(static_cast<const void*>(&opdata2)), OP_RESHAPE, },
-  { (TfLiteIntArray*)&inputs3, (TfLiteIntArray*)&outputs3, const_cast<void*>(static_cast<const void*>(&opdata3)), OP_MAX_POOL_2D, },
-  { (TfLiteIntArray*)&inputs4, (TfLiteIntArray*)&outputs4, const_cast<void*>(static_cast<const void*>(&opdata4)), OP_RESHAPE, },
-  { (TfLiteIntArray*)&inputs5, (TfLiteIntArray*)&outputs5, const_cast<void*>(static_cast<const void*>(&opdata5)), OP_CONV_2D, },
-  { (TfLiteIntArray*)&inputs6, (TfLiteIntArray*)&outputs6, const_cast<void*>(static_cast<const void*>(&opdata6)), OP_RESHAPE, },
-  { (TfLiteIntArray*)&inputs7, (TfLiteIntArray*)&outputs7, const_cast<void*>(static_cast<const void*>(&opdata7)), OP_MAX_POOL_2D, },
-  { (TfLiteIntArray*)&inputs8, (TfLiteIntArray*)&outputs8, const_cast<void*>(static_cast<const void*>(&opdata8)), OP_RESHAPE, },
-  { (TfLiteIntArray*)&inputs9, (TfLiteIntArray*)&outputs9, const_cast<void*>(static_cast<const void*>(&opdata9)), OP_FULLY_CONNECTED, },
-  { (TfLiteIntArray*)&inputs10, (TfLiteIntArray*)&outputs10, const_cast<void*>(static_cast<const void*>(&opdata10)), OP_SOFTMAX, },
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+  { (TfLiteIntArray*)&inputs0, (TfLiteIntArray*)&outputs0, const_cast<void*>(static_cast<const void*>(&opdata0)), OP_CONV_2D_MAX_POOL_2D, (TfLiteIntArray*)&intermediates0, },
+  { (TfLiteIntArray*)&inputs1, (TfLiteIntArray*)&outputs1, const_cast<void*>(static_cast<const void*>(&opdata1)), OP_CONV_2D_MAX_POOL_2D, (TfLiteIntArray*)&intermediates1, },
+  { (TfLiteIntArray*)&inputs2, (TfLiteIntArray*)&outputs2, const_cast<void*>(static_cast<const void*>(&opdata2)), OP_FULLY_CONNECTED, nullptr, },
+  { (TfLiteIntArray*)&inputs3, (TfLiteIntArray*)&outputs3, const_cast<void*>(static_cast<const void*>(&opdata3)), OP_SOFTMAX, nullptr, },
+#elif EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
+  { (TfLiteIntArray*)&inputs0, (TfLiteIntArray*)&outputs0, const_cast<void*>(static_cast<const void*>(&opdata0)), OP_CONV_2D, nullptr, },
+  { (TfLiteIntArray*)&inputs1, (TfLiteIntArray*)&outputs1, const_cast<void*>(static_cast<const void*>(&opdata1)), OP_MAX_POOL_2D, nullptr, },
+  { (TfLiteIntArray*)&inputs2, (TfLiteIntArray*)&outputs2, const_cast<void*>(static_cast<const void*>(&opdata2)), OP_CONV_2D, nullptr, },
+  { (TfLiteIntArray*)&inputs3, (TfLiteIntArray*)&outputs3, const_cast<void*>(static_cast<const void*>(&opdata3)), OP_MAX_POOL_2D, nullptr, },
+  { (TfLiteIntArray*)&inputs4, (TfLiteIntArray*)&outputs4, const_cast<void*>(static_cast<const void*>(&opdata4)), OP_FULLY_CONNECTED, nullptr, },
+  { (TfLiteIntArray*)&inputs5, (TfLiteIntArray*)&outputs5, const_cast<void*>(static_cast<const void*>(&opdata5)), OP_SOFTMAX, nullptr, },
+#else
+  { (TfLiteIntArray*)&inputs0, (TfLiteIntArray*)&outputs0, const_cast<void*>(static_cast<const void*>(&opdata0)), OP_RESHAPE, nullptr, },
+  { (TfLiteIntArray*)&inputs1, (TfLiteIntArray*)&outputs1, const_cast<void*>(static_cast<const void*>(&opdata1)), OP_CONV_2D, nullptr, },
+  { (TfLiteIntArray*)&inputs2, (TfLiteIntArray*)&outputs2, const_cast<void*>(static_cast<const void*>(&opdata2)), OP_RESHAPE, nullptr, },
+  { (TfLiteIntArray*)&inputs3, (TfLiteIntArray*)&outputs3, const_cast<void*>(static_cast<const void*>(&opdata3)), OP_MAX_POOL_2D, nullptr, },
+  { (TfLiteIntArray*)&inputs4, (TfLiteIntArray*)&outputs4, const_cast<void*>(static_cast<const void*>(&opdata4)), OP_RESHAPE, nullptr, },
+  { (TfLiteIntArray*)&inputs5, (TfLiteIntArray*)&outputs5, const_cast<void*>(static_cast<const void*>(&opdata5)), OP_CONV_2D, nullptr, },
+  { (TfLiteIntArray*)&inputs6, (TfLiteIntArray*)&outputs6, const_cast<void*>(static_cast<const void*>(&opdata6)), OP_RESHAPE, nullptr, },
+  { (TfLiteIntArray*)&inputs7, (TfLiteIntArray*)&outputs7, const_cast<void*>(static_cast<const void*>(&opdata7)), OP_MAX_POOL_2D, nullptr, },
+  { (TfLiteIntArray*)&inputs8, (TfLiteIntArray*)&outputs8, const_cast<void*>(static_cast<const void*>(&opdata8)), OP_RESHAPE, nullptr, },
+  { (TfLiteIntArray*)&inputs9, (TfLiteIntArray*)&outputs9, const_cast<void*>(static_cast<const void*>(&opdata9)), OP_FULLY_CONNECTED, nullptr, },
+  { (TfLiteIntArray*)&inputs10, (TfLiteIntArray*)&outputs10, const_cast<void*>(static_cast<const void*>(&opdata10)), OP_SOFTMAX, nullptr, },
+#endif // EI_CLASSIFIER_TFLITE_FUSED_OPS
+};
+#if EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+// how the weights of the conv (tensor_data11, tensor_data9) and fully connected (tensor_data7) nodes
+// are stored, see ei_packed_weights.h
+const ei_packed_weights_t conv0_weights = { EI_FILTER_LAYOUT_OHWI_REORDERED, nullptr };
+#if EI_CLASSIFIER_TFLITE_INT4_WEIGHTS
+const ei_packed_weights_t conv1_weights = { EI_FILTER_LAYOUT_OHWI, nullptr };
+#else
+const ei_packed_weights_t conv1_weights = { EI_FILTER_LAYOUT_OHWI_REORDERED, nullptr };
+#endif // EI_CLASSIFIER_TFLITE_INT4_WEIGHTS
+const ei_packed_weights_t fully_connected_weights = { EI_FILTER_LAYOUT_OHWI, folded_bias6 };
+const ei_packed_weights_t* const nodePackedWeights[kNodeCount] = {
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+  &conv0_weights, &conv1_weights, &fully_connected_weights, nullptr,
+#elif EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
+  &conv0_weights, nullptr, &conv1_weights, nullptr, &fully_connected_weights, nullptr,
+#else
+  nullptr, &conv0_weights, nullptr, nullptr, nullptr, &conv1_weights, nullptr, nullptr, nullptr, &fully_connected_weights, nullptr,
+#endif // EI_CLASSIFIER_TFLITE_FUSED_OPS
 };
+#endif // EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
 
 static void init_tflite_tensor(size_t i, TfLiteTensor *tensor) {
   tensor->type = tensorData[i].type;
@@ -390,6 +668,9 @@ static void * AllocatePersistentBufferImpl(struct TfLiteContext* ctx,
       return NULL;
     }
     overflow_buffers[overflow_buffers_ix++] = ptr;
+#if EI_CLASSIFIER_PROFILE_OPS
+    overflow_buffers_bytes += bytes;
+#endif
     return ptr;
   }
 
@@ -527,6 +808,9 @@ class EonMicroContext : public MicroContext {
   }
 };
 
+// the kernels can reach this through ctx.impl_ during invoke as well, so it has to outlive init
+static EonMicroContext micro_context_;
+
 } // namespace
 
 TfLiteStatus tflite_learn_5_init( void*(*alloc_fnc)(size_t,size_t) ) {
@@ -542,7 +826,6 @@ TfLiteStatus tflite_learn_5_init( void*(*alloc_fnc)(size_t,size_t) ) {
   tensor_boundary = tensor_arena;
   current_location = tensor_arena + kTensorArenaSize;
 
-  EonMicroContext micro_context_;
   ctx.impl_ = static_cast<void*>(&micro_context_);
   ctx.AllocatePersistentBuffer = &AllocatePersistentBufferImpl;
   ctx.RequestScratchBufferInArena = &RequestScratchBufferInArenaImpl;
@@ -565,23 +848,36 @@ TfLiteStatus tflite_learn_5_init( void*(*alloc_fnc)(size_t,size_t) ) {
     ei_printf("ERR: tensor arena is too small, does not fit model - even without scratch buffers\n");
     return kTfLiteError;
   }
+#if EI_CLASSIFIER_TFLITE_FUSED_OPS
+  registrations[OP_CONV_2D_MAX_POOL_2D] = Register_CONV_2D_MAX_POOL_2D();
+#else
+#if !EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
   registrations[OP_RESHAPE] = Register_RESHAPE();
+#endif // !EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
   registrations[OP_CONV_2D] = Register_CONV_2D();
   registrations[OP_MAX_POOL_2D] = Register_MAX_POOL_2D();
+#endif // EI_CLASSIFIER_TFLITE_FUSED_OPS
   registrations[OP_FULLY_CONNECTED] = Register_FULLY_CONNECTED();
   registrations[OP_SOFTMAX] = Register_SOFTMAX();
 
-  for (size_t i = 0; i < 11; ++i) {
+  for (size_t i = 0; i < kNodeCount; ++i) {
     tflNodes[i].inputs = nodeData[i].inputs;
     tflNodes[i].outputs = nodeData[i].outputs;
     tflNodes[i].builtin_data = nodeData[i].builtin_data;
+    tflNodes[i].intermediates = nodeData[i].intermediates;
+#if EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+    // builtin ops don't use custom_initial_data, the conv / fully connected kernels find their packed weights there
+    tflNodes[i].custom_initial_data = nodePackedWeights[i];
+    tflNodes[i].custom_initial_data_size = nodePackedWeights[i] ? sizeof(ei_packed_weights_t) : 0;
+#else
 tflNodes[i].custom_initial_data = nullptr;
       tflNodes[i].custom_initial_data_size = 0;
+#endif // EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
 if (registrations[nodeData[i].used_op_index].init) {
       tflNodes[i].user_data = registrations[nodeData[i].used_op_index].init(&ctx, (const char*)tflNodes[i].builtin_data, 0);
     }
   }
-  for (size_t i = 0; i < 11; ++i) {
+  for (size_t i = 0; i < kNodeCount; ++i) {
     if (registrations[nodeData[i].used_op_index].prepare) {
       ResetTensors();
 
@@ -591,6 +887,24 @@ if (registrations[nodeData[i].used_op_index].init) {
       }
     }
   }
+#if EI_CLASSIFIER_PROFILE_OPS
+  if (op_profiler) {
+    for (size_t i = 0; i < kNodeCount; ++i) {
+      if (nodeData[i].inputs->size < 2) {
+        continue;
+      }
+      TfLiteTensor filter;
+      TfLiteTensor output;
+      init_tflite_tensor(nodeData[i].inputs->data[1], &filter);
+      // fused nodes count the MACs of the convolution output, not of the pooled output
+      init_tflite_tensor(nodeData[i].intermediates ? nodeData[i].intermediates->data[0] : nodeData[i].outputs->data[0], &output);
+      op_profiler->SetNodeMacs(i, EiOpProfiler::CountMacs(
+        used_operator_names[nodeData[i].used_op_index], &filter, &output));
+    }
+    size_t arena_used = (tensor_boundary - tensor_arena) + (tensor_arena + kTensorArenaSize - current_location);
+    op_profiler->SetArenaUsage(arena_used, kTensorArenaSize, overflow_buffers_bytes);
+  }
+#endif
   return kTfLiteOk;
 }
 
@@ -611,10 +925,26 @@ TfLiteStatus tflite_learn_5_output(int index, TfLiteTensor *tensor) {
 }
 
 TfLiteStatus tflite_learn_5_invoke() {
-  for (size_t i = 0; i < 11; ++i) {
+#if EI_CLASSIFIER_PROFILE_OPS
+  if (op_profiler) {
+    op_profiler->BeginInvoke();
+  }
+#endif
+  for (size_t i = 0; i < kNodeCount; ++i) {
     ResetTensors();
 
+#if EI_CLASSIFIER_PROFILE_OPS
+    uint32_t event_handle = 0;
+    if (op_profiler) {
+      event_handle = op_profiler->BeginEvent(used_operator_names[nodeData[i].used_op_index]);
+    }
+#endif
     TfLiteStatus status = registrations[nodeData[i].used_op_index].invoke(&ctx, &tflNodes[i]);
+#if EI_CLASSIFIER_PROFILE_OPS
+    if (op_profiler) {
+      op_profiler->EndEvent(event_handle);
+    }
+#endif
 
 #if EI_CLASSIFIER_PRINT_STATE
     ei_printf("layer %lu\n", i);
@@ -695,5 +1025,15 @@ TfLiteStatus tflite_learn_5_reset( void (*free_fnc)(void* ptr) ) {
     ei_free(overflow_buffers[ix]);
   }
   overflow_buffers_ix = 0;
+#if EI_CLASSIFIER_PROFILE_OPS
+  overflow_buffers_bytes = 0;
+#endif
   return kTfLiteOk;
 }
+
+#if EI_CLASSIFIER_PROFILE_OPS
+TfLiteStatus tflite_learn_5_set_profiler(EiOpProfiler *profiler) {
+  op_profiler = profiler;
+  return kTfLiteOk;
+}
+#endif
@@ -35,6 +35,11 @@ TfLiteStatus tflite_learn_5_output(int index, TfLiteTensor* tensor);
 TfLiteStatus tflite_learn_5_invoke();
 //Frees memory allocated
 TfLiteStatus tflite_learn_5_reset( void (*free)(void* ptr) );
+#if EI_CLASSIFIER_PROFILE_OPS
+class EiOpProfiler;
+// Reports per-node timing, MACs and arena usage to the profiler (nullptr to disable).
+TfLiteStatus tflite_learn_5_set_profiler(EiOpProfiler *profiler);
+#endif
 
 
 // Returns the number of input tensors.
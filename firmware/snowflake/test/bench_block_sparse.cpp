@@ -0,0 +1,110 @@
+/* arm_fully_connected_block_sparse_s8 (EI_FILTER_LAYOUT_BLOCK_SPARSE) against the dense
+ * arm_fully_connected_s8 on the same weights with the zeros stored, with 50, 75 and 90% of the blocks
+ * zero, per x86 instruction set. The dense kernel's time doesn't depend on how many weights are zero */
+
+// test-flags: -DEI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86=1
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+#include <functional>
+#include <vector>
+
+static const arm_nn_x86_isa ISAS[] = { ARM_NN_X86_ISA_SCALAR, ARM_NN_X86_ISA_SSE41, ARM_NN_X86_ISA_AVX2 };
+static const char *ISA_NAMES[] = { "scalar", "SSE4.1", "AVX2" };
+static const size_t ISA_COUNT = sizeof(ISAS) / sizeof(ISAS[0]);
+
+// us per call of `run` under `isa`, -1 if the CPU doesn't have it
+static double time_us(arm_nn_x86_isa isa, int runs, const std::function<arm_cmsis_nn_status()> &run) {
+    arm_nn_x86_set_isa(isa);
+    if (arm_nn_x86_get_isa() != isa) {
+        return -1;
+    }
+    run();
+    const uint64_t start = ei_read_timer_us();
+    for (int ix = 0; ix < runs; ix++) {
+        if (run() != ARM_CMSIS_NN_SUCCESS) {
+            ei_test_failures++;
+            return -1;
+        }
+    }
+    return (double)(ei_read_timer_us() - start) / runs;
+}
+
+static void bench_layer(int32_t depth, int32_t out_ch, int32_t block_size, int runs) {
+    cmsis_nn_fc_params params = { };
+    params.input_offset = 128;
+    params.activation = { -128, 127 };
+    cmsis_nn_per_tensor_quant_params quant = { 1 << 30, -8 };
+    const cmsis_nn_dims input_dims = { 1, 1, 1, depth };
+    const cmsis_nn_dims filter_dims = { depth, 1, 1, out_ch };
+    const cmsis_nn_dims bias_dims = { 1, 1, 1, out_ch };
+    const cmsis_nn_dims output_dims = { 1, 1, 1, out_ch };
+    std::vector<int8_t> input(depth), output(out_ch);
+    for (auto &x : input) {
+        x = (int8_t)(ei_test_rand() & 0xff);
+    }
+    std::vector<int32_t> bias(out_ch);
+    std::vector<int8_t> buffer(arm_fully_connected_s8_get_buffer_size(&filter_dims) + 16);
+    cmsis_nn_context ctx = { buffer.data(), (int32_t)buffer.size() };
+    cmsis_nn_context no_buffer = { nullptr, 0 };
+
+    const int32_t blocks = depth / block_size, bitmap_stride = (blocks + 7) / 8;
+    for (int zero_percent : { 50, 75, 90 }) {
+        std::vector<int8_t> dense(out_ch * depth, 0), sparse;
+        std::vector<uint8_t> bitmap(out_ch * bitmap_stride, 0);
+        for (int32_t oc = 0; oc < out_ch; oc++) {
+            for (int32_t block = 0; block < blocks; block++) {
+                if ((int)(ei_test_rand() % 100) < zero_percent) {
+                    continue;
+                }
+                bitmap[oc * bitmap_stride + block / 8] |= 1 << (block % 8);
+                for (int32_t ix = 0; ix < block_size; ix++) {
+                    const int8_t w = (int8_t)(ei_test_rand() & 0xff);
+                    dense[oc * depth + block * block_size + ix] = w;
+                    sparse.push_back(w);
+                }
+            }
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "%d -> %d, blocks of %d, %d%% zero", depth, out_ch, block_size, zero_percent);
+        printf("%-38s", name);
+        for (size_t isa = 0; isa < ISA_COUNT; isa++) {
+            const double dense_us = time_us(ISAS[isa], runs, [&]() {
+                return arm_fully_connected_s8(&ctx, &params, &quant, &input_dims, input.data(), &filter_dims,
+                    dense.data(), &bias_dims, bias.data(), &output_dims, output.data());
+            });
+            const double sparse_us = time_us(ISAS[isa], runs, [&]() {
+                return arm_fully_connected_block_sparse_s8(&no_buffer, &params, &quant, &input_dims, input.data(),
+                    &filter_dims, sparse.data(), bitmap.data(), block_size, &bias_dims, bias.data(), &output_dims,
+                    output.data());
+            });
+            if (dense_us < 0 || sparse_us < 0) {
+                printf(" %26s", "-");
+                continue;
+            }
+            printf(" %8.2f / %8.2f us %4.1fx", dense_us, sparse_us, dense_us / sparse_us);
+        }
+        printf("\n");
+    }
+    arm_nn_x86_set_isa(ARM_NN_X86_ISA_AVX2);
+}
+
+int main() {
+    printf("CPU supports up to %s\n", ISA_NAMES[arm_nn_x86_get_isa()]);
+    printf("%-38s", "layer (dense / block sparse)");
+    for (size_t isa = 0; isa < ISA_COUNT; isa++) {
+        printf(" %26s", ISA_NAMES[isa]);
+    }
+    printf("\n");
+
+    // the keyword model's FULLY_CONNECTED, and larger ones
+    bench_layer(208, 3, 8, 50000);
+    bench_layer(1024, 128, 4, 500);
+    bench_layer(1024, 128, 16, 500);
+    bench_layer(4096, 256, 16, 50);
+    return ei_test_result();
+}
@@ -0,0 +1,67 @@
+/* Windows per second of the keyword model: run_inference on every window, and run_classifier_batch at
+ * a few batch sizes. Each is the best of a few rounds, the host is noisy next to a setup of a few us */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include <algorithm>
+#include <vector>
+
+static const size_t WINDOWS = 256;
+static const int ROUNDS = 8;
+
+// us for all windows, `batch` at a time, run_inference on every window for a batch of 0
+static uint64_t run(const ei::matrix_t &features, size_t batch, uint64_t *setup_us) {
+    std::vector<ei_impulse_result_t> results(std::max(batch, (size_t)1));
+    *setup_us = 0;
+    uint64_t start = ei_read_timer_us();
+    for (size_t row = 0; row < features.rows; row += std::max(batch, (size_t)1)) {
+        if (batch == 0) {
+            ei::matrix_t window(1, features.cols, features.buffer + row * features.cols);
+            memset(&results[0], 0, sizeof(results[0]));
+            run_inference(&ei_default_impulse, &window, &results[0]);
+        }
+        else {
+            ei::matrix_t windows(batch, features.cols, features.buffer + row * features.cols);
+            run_classifier_batch(&windows, results.data());
+        }
+        for (const ei_impulse_result_t &result : results) {
+            *setup_us += result.timing.classification_setup_us;
+        }
+    }
+    return ei_read_timer_us() - start;
+}
+
+static void bench(const ei::matrix_t &features, size_t batch) {
+    uint64_t best = UINT64_MAX, setup_us = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        uint64_t round_setup_us;
+        const uint64_t us = run(features, batch, &round_setup_us);
+        if (us < best) {
+            best = us;
+            setup_us = round_setup_us;
+        }
+    }
+    char name[32];
+    if (batch == 0) {
+        snprintf(name, sizeof(name), "run_inference");
+    }
+    else {
+        snprintf(name, sizeof(name), "batch of %u", (unsigned)batch);
+    }
+    printf("%-16s %8.0f windows/s (%.1f us per window, %.2f us of it setting the model up)\n", name,
+        (double)features.rows * 1e6 / best, (double)best / features.rows, (double)setup_us / features.rows);
+}
+
+int main() {
+    ei::matrix_t features(WINDOWS, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    for (size_t ix = 0; ix < WINDOWS * EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; ix++) {
+        features.buffer[ix] = ei_test_uniform(-3.0f, 3.0f);
+    }
+
+    uint64_t setup_us;
+    run(features, 0, &setup_us);
+    for (size_t batch : { 0, 1, 8, 64, 256 }) {
+        bench(features, batch);
+    }
+    return 0;
+}
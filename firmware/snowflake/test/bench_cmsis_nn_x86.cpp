@@ -0,0 +1,186 @@
+/* The CMSIS-NN s8 kernels with the x86 inner loops (EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86), per
+ * instruction set: conv, depthwise conv, fully connected and max pool, at the size of the keyword
+ * model's layers and at a larger size */
+
+// test-flags: -DEI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86=1
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+#include <functional>
+#include <vector>
+
+static const arm_nn_x86_isa ISAS[] = { ARM_NN_X86_ISA_SCALAR, ARM_NN_X86_ISA_SSE41, ARM_NN_X86_ISA_AVX2 };
+static const char *ISA_NAMES[] = { "scalar", "SSE4.1", "AVX2" };
+static const size_t ISA_COUNT = sizeof(ISAS) / sizeof(ISAS[0]);
+
+static std::vector<int8_t> rand_s8(size_t size) {
+    std::vector<int8_t> v(size);
+    for (auto &x : v) {
+        x = (int8_t)(ei_test_rand() & 0xff);
+    }
+    return v;
+}
+
+// what a layer needs to run, kept alive for as long as it's timed
+struct layer_t {
+    std::vector<int8_t> input, filter, output, buffer;
+    std::vector<int32_t> bias, multiplier, shift;
+    cmsis_nn_dims input_dims, filter_dims, bias_dims, output_dims;
+    cmsis_nn_context ctx;
+
+    void alloc(int32_t buffer_size) {
+        input = rand_s8(input_dims.n * input_dims.h * input_dims.w * input_dims.c);
+        output.resize(output_dims.n * output_dims.h * output_dims.w * output_dims.c);
+        bias.resize(output_dims.c);
+        multiplier.assign(output_dims.c, 1 << 30);
+        shift.assign(output_dims.c, -8);
+        buffer.resize(buffer_size + 16);
+        ctx = { buffer.data(), (int32_t)buffer.size() };
+    }
+};
+
+// us per call of `run` under every instruction set the CPU has, against the scalar loops
+static void bench(const char *name, int runs, const std::function<arm_cmsis_nn_status()> &run) {
+    printf("%-34s", name);
+    double scalar_us = 0;
+    for (size_t isa = 0; isa < ISA_COUNT; isa++) {
+        arm_nn_x86_set_isa(ISAS[isa]);
+        if (arm_nn_x86_get_isa() != ISAS[isa]) {
+            printf(" %18s", "-");
+            continue;
+        }
+        run();
+        const uint64_t start = ei_read_timer_us();
+        for (int ix = 0; ix < runs; ix++) {
+            if (run() != ARM_CMSIS_NN_SUCCESS) {
+                printf("%s failed\n", name);
+                ei_test_failures++;
+                return;
+            }
+        }
+        const double us = (double)(ei_read_timer_us() - start) / runs;
+        if (isa == 0) {
+            scalar_us = us;
+            printf(" %10.2f us      ", us);
+        }
+        else {
+            printf(" %10.2f us %4.1fx", us, scalar_us / us);
+        }
+    }
+    printf("\n");
+    arm_nn_x86_set_isa(ARM_NN_X86_ISA_AVX2);
+}
+
+static void bench_convolve(const char *name, int32_t in_h, int32_t in_w, int32_t in_ch, int32_t out_ch, int32_t k_h,
+    int32_t k_w, int runs) {
+    layer_t layer;
+    cmsis_nn_conv_params params = { };
+    params.input_offset = 128;
+    params.stride = { 1, 1 };
+    params.padding = { k_w / 2, k_h / 2 };
+    params.dilation = { 1, 1 };
+    params.activation = { -128, 127 };
+    layer.input_dims = { 1, in_h, in_w, in_ch };
+    layer.filter_dims = { out_ch, k_h, k_w, in_ch };
+    layer.bias_dims = { 1, 1, 1, out_ch };
+    layer.output_dims = { 1, in_h, in_w, out_ch };
+    layer.filter = rand_s8(out_ch * k_h * k_w * in_ch);
+    layer.alloc(arm_convolve_wrapper_s8_get_buffer_size(&params, &layer.input_dims, &layer.filter_dims,
+        &layer.output_dims));
+    cmsis_nn_per_channel_quant_params quant = { layer.multiplier.data(), layer.shift.data() };
+
+    bench(name, runs, [&]() {
+        return arm_convolve_wrapper_s8(&layer.ctx, &params, &quant, &layer.input_dims, layer.input.data(),
+            &layer.filter_dims, layer.filter.data(), &layer.bias_dims, layer.bias.data(), &layer.output_dims,
+            layer.output.data());
+    });
+}
+
+static void bench_depthwise(const char *name, int32_t in_h, int32_t in_w, int32_t ch, int32_t k, int runs) {
+    layer_t layer;
+    cmsis_nn_dw_conv_params params = { };
+    params.input_offset = 128;
+    params.ch_mult = 1;
+    params.stride = { 1, 1 };
+    params.padding = { k / 2, k / 2 };
+    params.dilation = { 1, 1 };
+    params.activation = { -128, 127 };
+    layer.input_dims = { 1, in_h, in_w, ch };
+    layer.filter_dims = { 1, k, k, ch };
+    layer.bias_dims = { 1, 1, 1, ch };
+    layer.output_dims = { 1, in_h, in_w, ch };
+    layer.filter = rand_s8(k * k * ch);
+    layer.alloc(arm_depthwise_conv_wrapper_s8_get_buffer_size(&params, &layer.input_dims, &layer.filter_dims,
+        &layer.output_dims));
+    cmsis_nn_per_channel_quant_params quant = { layer.multiplier.data(), layer.shift.data() };
+
+    bench(name, runs, [&]() {
+        return arm_depthwise_conv_wrapper_s8(&layer.ctx, &params, &quant, &layer.input_dims, layer.input.data(),
+            &layer.filter_dims, layer.filter.data(), &layer.bias_dims, layer.bias.data(), &layer.output_dims,
+            layer.output.data());
+    });
+}
+
+static void bench_fully_connected(const char *name, int32_t depth, int32_t out_ch, int runs) {
+    layer_t layer;
+    cmsis_nn_fc_params params = { };
+    params.input_offset = 128;
+    params.activation = { -128, 127 };
+    cmsis_nn_per_tensor_quant_params quant = { 1 << 30, -8 };
+    layer.input_dims = { 1, 1, 1, depth };
+    layer.filter_dims = { depth, 1, 1, out_ch };
+    layer.bias_dims = { 1, 1, 1, out_ch };
+    layer.output_dims = { 1, 1, 1, out_ch };
+    layer.filter = rand_s8(depth * out_ch);
+    layer.alloc(arm_fully_connected_s8_get_buffer_size(&layer.filter_dims));
+
+    bench(name, runs, [&]() {
+        return arm_fully_connected_s8(&layer.ctx, &params, &quant, &layer.input_dims, layer.input.data(),
+            &layer.filter_dims, layer.filter.data(), &layer.bias_dims, layer.bias.data(), &layer.output_dims,
+            layer.output.data());
+    });
+}
+
+static void bench_max_pool(const char *name, int32_t in_h, int32_t in_w, int32_t ch, int32_t k_h, int32_t k_w,
+    int runs) {
+    layer_t layer;
+    cmsis_nn_pool_params params = { };
+    params.stride = { k_w, k_h };
+    params.activation = { -128, 127 };
+    layer.input_dims = { 1, in_h, in_w, ch };
+    layer.filter_dims = { 1, k_h, k_w, 1 };
+    layer.output_dims = { 1, in_h / k_h, in_w / k_w, ch };
+    layer.alloc(0);
+
+    bench(name, runs, [&]() {
+        return arm_max_pool_s8(&layer.ctx, &params, &layer.input_dims, layer.input.data(), &layer.filter_dims,
+            &layer.output_dims, layer.output.data());
+    });
+}
+
+int main() {
+    printf("CPU supports up to %s\n", ISA_NAMES[arm_nn_x86_get_isa()]);
+    printf("%-34s", "layer");
+    for (size_t isa = 0; isa < ISA_COUNT; isa++) {
+        printf(" %18s", ISA_NAMES[isa]);
+    }
+    printf("\n");
+
+    // the keyword model: 1D convolutions over 49 frames of 13 MFCC, 3 labels (it has no depthwise layer)
+    bench_convolve("conv 1x49x13 -> 8, 1x3", 1, 49, 13, 8, 1, 3, 5000);
+    bench_max_pool("max pool 1x49x8, 1x2", 1, 49, 8, 1, 2, 50000);
+    bench_convolve("conv 1x25x8 -> 16, 1x3", 1, 25, 8, 16, 1, 3, 5000);
+    bench_max_pool("max pool 1x25x16, 1x2", 1, 25, 16, 1, 2, 50000);
+    bench_fully_connected("fully connected 208 -> 3", 208, 3, 50000);
+
+    // a larger image-like network
+    bench_convolve("conv 32x32x16 -> 32, 3x3", 32, 32, 16, 32, 3, 3, 50);
+    bench_convolve("conv 32x32x32 -> 32, 1x1", 32, 32, 32, 32, 1, 1, 100);
+    bench_depthwise("depthwise 32x32x32, 3x3", 32, 32, 32, 3, 200);
+    bench_fully_connected("fully connected 1024 -> 128", 1024, 128, 500);
+    bench_max_pool("max pool 32x32x32, 2x2", 32, 32, 32, 2, 2, 2000);
+    return ei_test_result();
+}
@@ -0,0 +1,43 @@
+/* 512-point rfft per second, with the plan cache against a new kissfft plan per call (as before) */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+#include <vector>
+
+using namespace ei;
+
+int main() {
+    const size_t n_fft = 512;
+    const int runs = 20000;
+
+    std::vector<float> input(n_fft);
+    for (size_t ix = 0; ix < n_fft; ix++) {
+        input[ix] = ei_test_uniform(-1000.0f, 1000.0f);
+    }
+    std::vector<float> output(n_fft / 2 + 1);
+    std::vector<kiss_fft_cpx> complex(n_fft / 2 + 1);
+
+    uint64_t start = ei_read_timer_us();
+    for (int run = 0; run < runs; run++) {
+        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, NULL);
+        kiss_fftr(cfg, input.data(), complex.data());
+        for (size_t ix = 0; ix < complex.size(); ix++) {
+            output[ix] = sqrt(pow(complex[ix].r, 2) + pow(complex[ix].i, 2));
+        }
+        kiss_fftr_free(cfg);
+    }
+    uint64_t uncached_us = ei_read_timer_us() - start;
+
+    start = ei_read_timer_us();
+    for (int run = 0; run < runs; run++) {
+        numpy::rfft(input.data(), input.size(), output.data(), output.size(), n_fft);
+    }
+    uint64_t cached_us = ei_read_timer_us() - start;
+
+    fft_plan_cache_stats_t stats = numpy::fft_plan_cache_stats();
+    printf("%d-point rfft: %.0f FFTs/s with a plan per call, %.0f FFTs/s cached (%.2fx)\n", (int)n_fft,
+        runs * 1e6 / uncached_us, runs * 1e6 / cached_us, (double)uncached_us / cached_us);
+    printf("cache: %u hits, %u misses, %u plans, %u bytes\n", (unsigned)stats.hits, (unsigned)stats.misses,
+        (unsigned)stats.plans, (unsigned)stats.bytes);
+    return 0;
+}
@@ -0,0 +1,41 @@
+/* MFE frames per second on the keyword model's front end: mfe, mfe_v3 and mfe_batched */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
+#include <vector>
+
+using namespace ei;
+
+typedef int (*mfe_fn)(matrix_t *, matrix_t *, signal_t *, uint32_t, float, float, uint16_t, uint16_t,
+    uint32_t, uint32_t, uint16_t);
+
+static void bench(const char *name, mfe_fn fn, signal_t *signal, matrix_t *features, int runs) {
+    // warm up the FFT plan and DCT caches
+    fn(features, nullptr, signal, 16000, 0.025f, 0.02f, 32, 512, 80, 0, 4);
+
+    uint64_t start = ei_read_timer_us();
+    for (int run = 0; run < runs; run++) {
+        fn(features, nullptr, signal, 16000, 0.025f, 0.02f, 32, 512, 80, 0, 4);
+    }
+    uint64_t us = ei_read_timer_us() - start;
+    printf("%-12s %8.0f frames/s (%.1f us per 1 s window)\n", name,
+        (double)runs * features->rows * 1e6 / us, (double)us / runs);
+}
+
+int main() {
+    std::vector<float> audio(16000);
+    for (size_t ix = 0; ix < audio.size(); ix++) {
+        audio[ix] = 3000.0f * sinf(ix * 0.05f) + ei_test_uniform(-500.0f, 500.0f);
+    }
+    signal_t signal;
+    numpy::signal_from_buffer(audio.data(), audio.size(), &signal);
+
+    matrix_size_t size = speechpy::feature::calculate_mfe_buffer_size(audio.size(), 16000, 0.025f, 0.02f, 32, 4);
+    matrix_t features(size.rows, size.cols);
+
+    const int runs = 500;
+    bench("mfe", speechpy::feature::mfe, &signal, &features, runs);
+    bench("mfe_v3", speechpy::feature::mfe_v3, &signal, &features, runs);
+    bench("mfe_batched", speechpy::feature::mfe_batched, &signal, &features, runs);
+    return 0;
+}
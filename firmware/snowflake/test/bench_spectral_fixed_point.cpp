@@ -0,0 +1,65 @@
+/* Spectral analysis of 3 axes, 100 Hz, 2 s windows: the float extract_spec_features against the fixed
+ * point extract_spec_features_q, per filter and FFT length. On a host with a fast FPU the fixed point
+ * path comes out slower; the figures that matter are the device's, this only tracks the two relative
+ * to each other */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/dsp/spectral/spectral.hpp"
+#include <vector>
+
+using namespace ei;
+
+static const size_t AXES = 3;
+static const size_t SAMPLES = 200;
+static const float FREQUENCY = 100.0f;
+
+typedef size_t (*extract_fn)(matrix_t *, matrix_t *, ei_dsp_config_spectral_analysis_t *, const float, const bool,
+    const bool);
+
+// us per window, the input is transposed and filtered in place so it's copied in every run
+static double bench(extract_fn fn, const std::vector<float> &samples, ei_dsp_config_spectral_analysis_t *config,
+    int runs) {
+    std::vector<float> copy(samples);
+    matrix_t output(1, 1024);
+
+    uint64_t us = 0;
+    for (int run = 0; run < runs; run++) {
+        copy = samples;
+        matrix_t input(SAMPLES, AXES, copy.data());
+        const uint64_t start = ei_read_timer_us();
+        fn(&input, &output, config, FREQUENCY, true, true);
+        us += ei_read_timer_us() - start;
+    }
+    return (double)us / runs;
+}
+
+int main() {
+    // accelerometer like: gravity on one axis, a few tones and noise
+    std::vector<float> samples(SAMPLES * AXES);
+    for (size_t ix = 0; ix < SAMPLES; ix++) {
+        for (size_t axis = 0; axis < AXES; axis++) {
+            samples[ix * AXES + axis] = (axis == 2 ? 9.81f : 0.0f) + 3.0f * sinf(ix * (0.1f + axis * 0.2f)) +
+                ei_test_uniform(-0.5f, 0.5f);
+        }
+    }
+
+    const int runs = 2000;
+    const char *filters[][2] = { { "low", "3" }, { "high", "5" }, { "none", "0" } };
+    printf("%-6s %5s %3s %12s %12s\n", "filter", "FFT", "ver", "float us", "fixed us");
+    for (auto &filter : filters) {
+        for (int fft_length : { 16, 64, 128 }) {
+            for (int version : { 2, 4 }) {
+                ei_dsp_config_spectral_analysis_t config = { 1, (uint16_t)version, (int)AXES, 1.0f, 1, filter[0],
+                    (float)atof(filter[1]), 6, "FFT", fft_length, 3, 0.1f, "0.1, 0.5, 1.0, 2.0, 5.0", true, true, 1,
+                    "db4", false };
+                // warm up the FFT plans
+                bench(spectral::feature::extract_spec_features, samples, &config, 10);
+                bench(spectral::feature::extract_spec_features_q, samples, &config, 10);
+                printf("%-6s %5d %3d %12.1f %12.1f\n", filter[0], fft_length, version,
+                    bench(spectral::feature::extract_spec_features, samples, &config, runs),
+                    bench(spectral::feature::extract_spec_features_q, samples, &config, runs));
+            }
+        }
+    }
+    return 0;
+}
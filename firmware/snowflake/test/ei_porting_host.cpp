@@ -0,0 +1,61 @@
+/* Porting layer for the host tests: stdout, the monotonic clock and the heap */
+
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+EI_IMPULSE_ERROR ei_run_impulse_check_canceled() {
+    return EI_IMPULSE_OK;
+}
+
+EI_IMPULSE_ERROR ei_sleep(int32_t time_ms) {
+    struct timespec t = { time_ms / 1000, (time_ms % 1000) * 1000000L };
+    nanosleep(&t, nullptr);
+    return EI_IMPULSE_OK;
+}
+
+uint64_t ei_read_timer_us() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000ULL + t.tv_nsec / 1000;
+}
+
+uint64_t ei_read_timer_ms() {
+    return ei_read_timer_us() / 1000;
+}
+
+void ei_serial_set_baudrate(int baudrate) {
+}
+
+void ei_putchar(char c) {
+    putchar(c);
+}
+
+void ei_printf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+void ei_printf_float(float f) {
+    printf("%f", f);
+}
+
+void *ei_malloc(size_t size) {
+    return malloc(size);
+}
+
+void *ei_calloc(size_t nitems, size_t size) {
+    return calloc(nitems, size);
+}
+
+void ei_free(void *ptr) {
+    free(ptr);
+}
+
+extern "C" void DebugLog(const char *s) {
+    printf("%s", s);
+}
@@ -0,0 +1,65 @@
+/* Checks for the host tests (see run_tests.sh). A failed check is reported and the test goes on */
+
+#ifndef _EI_TEST_H_
+#define _EI_TEST_H_
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+
+static int ei_test_failures = 0;
+
+#define EI_TEST_EXPECT(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: expected %s\n", __FILE__, __LINE__, #cond); \
+            ei_test_failures++; \
+        } \
+    } while (0)
+
+#define EI_TEST_EXPECT_EQ(a, b) \
+    do { \
+        const double a_ = (double)(a), b_ = (double)(b); \
+        if (a_ != b_) { \
+            printf("%s:%d: expected %s == %s (%g vs %g)\n", __FILE__, __LINE__, #a, #b, a_, b_); \
+            ei_test_failures++; \
+        } \
+    } while (0)
+
+#define EI_TEST_EXPECT_NEAR(a, b, tolerance) \
+    do { \
+        const double a_ = (double)(a), b_ = (double)(b); \
+        if (!(fabs(a_ - b_) <= (tolerance))) { \
+            printf("%s:%d: expected %s near %s (%g vs %g, tolerance %g)\n", __FILE__, __LINE__, \
+                #a, #b, a_, b_, (double)(tolerance)); \
+            ei_test_failures++; \
+        } \
+    } while (0)
+
+#define EI_TEST_RUN(test) \
+    do { \
+        const int failures_before_ = ei_test_failures; \
+        test(); \
+        printf("%s %s\n", ei_test_failures == failures_before_ ? "ok  " : "FAIL", #test); \
+    } while (0)
+
+// exit code of the test program
+static inline int ei_test_result() {
+    return ei_test_failures == 0 ? 0 : 1;
+}
+
+// deterministic pseudo random numbers (xorshift), so failures reproduce
+static inline uint32_t ei_test_rand() {
+    static uint32_t state = 2463534242u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// uniform in [lo, hi)
+static inline float ei_test_uniform(float lo, float hi) {
+    return lo + (hi - lo) * (float)(ei_test_rand() >> 8) / (float)(1 << 24);
+}
+
+#endif // _EI_TEST_H_
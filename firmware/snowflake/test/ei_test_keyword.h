@@ -0,0 +1,58 @@
+/* Synthetic input for the tests of the keyword model, which has no labelled data in this repo:
+ * windows of noise, tones, chirps and bursts, which the model calls "unknown", and a search from
+ * them for inputs it calls something else. Include after the model parameters */
+
+#ifndef _EI_TEST_KEYWORD_H_
+#define _EI_TEST_KEYWORD_H_
+
+#include "ei_test.h"
+#include <algorithm>
+#include <vector>
+
+// one window of audio: noise, tones, chirps and bursts at a few levels, a different one per `ix`
+static std::vector<float> ei_test_keyword_audio(int ix) {
+    std::vector<float> audio(EI_CLASSIFIER_RAW_SAMPLE_COUNT);
+    const float level = 500.0f * (1 + ix % 8) * (1 + ix % 8);
+    const float f0 = 150.0f + 37.0f * ix;
+    for (size_t s = 0; s < audio.size(); s++) {
+        const float t = (float)s / EI_CLASSIFIER_FREQUENCY;
+        float v = 0;
+        switch (ix % 4) {
+            case 0: v = ei_test_uniform(-1.0f, 1.0f); break;
+            case 1: v = sinf(2 * (float)M_PI * f0 * t) + 0.5f * sinf(2 * (float)M_PI * 2.7f * f0 * t); break;
+            case 2: v = sinf(2 * (float)M_PI * (f0 + 1500.0f * t) * t); break;
+            default: {
+                // a 300 ms burst of a tone in noise, somewhere in the window
+                const float start = 0.1f * (ix % 7);
+                v = 0.05f * ei_test_uniform(-1.0f, 1.0f);
+                if (t >= start && t < start + 0.3f) {
+                    v += sinf(2 * (float)M_PI * f0 * t) * sinf((float)M_PI * (t - start) / 0.3f);
+                }
+            }
+        }
+        audio[s] = level * v;
+    }
+    return audio;
+}
+
+// `input` (a quantized model input) moved a byte at a time, while that raises `margin(input)`, until
+// the margin reaches `target` (or it gives up)
+template <typename margin_fn>
+static std::vector<int8_t> ei_test_keyword_search(std::vector<int8_t> input, margin_fn margin, float target) {
+    float best = margin(input);
+    for (int step = 0; step < 20000 && best < target; step++) {
+        const size_t ix = ei_test_rand() % input.size();
+        const int8_t before = input[ix];
+        input[ix] = (int8_t)std::min(std::max((int)before + (int)(ei_test_rand() % 65) - 32, -128), 127);
+        const float m = margin(input);
+        if (m > best) {
+            best = m;
+        }
+        else {
+            input[ix] = before;
+        }
+    }
+    return input;
+}
+
+#endif // _EI_TEST_KEYWORD_H_
@@ -0,0 +1,18 @@
+/* The gate of test_gate_cascade.cpp, in the place of the one exported next to the model: a linear gate
+ * over the MFCC features that the test fits at run time */
+
+#ifndef _EI_TEST_GATE_PARAMETERS_H_
+#define _EI_TEST_GATE_PARAMETERS_H_
+
+float ei_test_gate_weights[EI_CLASSIFIER_NN_INPUT_FRAME_SIZE];
+
+ei_learning_block_config_gate_linear_t ei_learning_block_config_gate = {
+    .implementation_version = 1,
+    .weights = ei_test_gate_weights,
+    .input_size = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE,
+    .bias = 0.0f,
+    .threshold = 0.5f,
+    .keyword_label_ix = 0,
+};
+
+#endif // _EI_TEST_GATE_PARAMETERS_H_
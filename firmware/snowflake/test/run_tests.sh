@@ -0,0 +1,109 @@
+#!/bin/bash
+# Host tests of the keyword pipeline: the edge-impulse-sdk DSP, the kernels and the compiled model,
+# built with the host compiler (CMSIS-DSP off, the CMSIS-NN kernels on their portable C paths).
+#
+#   test/run_tests.sh                       build and run every test_*.cpp
+#   test/run_tests.sh test_mfcc_dct ...     only these, also how the bench_*.cpp benchmarks are run
+#
+# A test can add build flags with a "// test-flags: -D..." line. The SDK is built once per set of
+# flags, into test/build.
+set -e
+
+TEST_DIR=$(cd "$(dirname "$0")" && pwd)
+SRC=$(cd "$TEST_DIR/../src" && pwd)
+BUILD=$TEST_DIR/build
+JOBS=${JOBS:-$(nproc)}
+
+CC=${CC:-gcc}
+CXX=${CXX:-g++}
+INCLUDES="-I$SRC -I$SRC/edge-impulse-sdk -I$SRC/edge-impulse-sdk/third_party/flatbuffers/include \
+    -I$SRC/edge-impulse-sdk/third_party/gemmlowp -I$SRC/edge-impulse-sdk/third_party/ruy \
+    -I$SRC/edge-impulse-sdk/CMSIS/DSP/Include -I$SRC/edge-impulse-sdk/CMSIS/DSP/PrivateInclude \
+    -I$SRC/edge-impulse-sdk/CMSIS/Core/Include -I$TEST_DIR"
+DEFINES="-DEIDSP_USE_CMSIS_DSP=0 -DEIDSP_LOAD_CMSIS_DSP_SOURCES=0 -DTF_LITE_STATIC_MEMORY"
+CFLAGS="-O2 -g -w -MMD"
+
+# out of date if the object is missing or older than its source or any header it included
+stale() {
+    local obj=$1
+    [ -f "$obj" ] && [ -f "${obj%.o}.d" ] || return 0
+    for dep in $(sed -e 's/^[^:]*://' -e 's/\\$//' "${obj%.o}.d"); do
+        [ "$dep" -nt "$obj" ] && return 0
+    done
+    return 1
+}
+
+compile() {
+    local src=$1 obj=$2 flags=$3
+    case $src in
+        *.c) echo "$CC -std=gnu11 $CFLAGS $INCLUDES $DEFINES $flags -c $src -o $obj" ;;
+        *) echo "$CXX -std=gnu++17 $CFLAGS $INCLUDES $DEFINES $flags -c $src -o $obj" ;;
+    esac
+}
+
+# build the SDK and the compiled model for a set of flags, prints the library
+build_sdk() {
+    local flags=$1
+    local dir=$BUILD/sdk-$(echo "$flags" | md5sum | cut -c1-8)
+    mkdir -p "$dir/obj"
+
+    local objs="" cmds=""
+    for src in $(cd "$SRC" && find edge-impulse-sdk tflite-model \( -name '*.c' -o -name '*.cc' -o -name '*.cpp' \) |
+            grep -v "CMSIS/DSP/\|porting/\|cmake" | sort); do
+        local obj=$dir/obj/$(echo "$src" | tr / _).o
+        objs="$objs $obj"
+        if stale "$obj"; then
+            cmds="$cmds$(compile "$SRC/$src" "$obj" "$flags")"$'\n'
+        fi
+    done
+
+    if [ -n "$cmds" ]; then
+        echo "building the SDK ($flags) ..." >&2
+        echo -n "$cmds" | xargs -P "$JOBS" -I{} sh -c "{}" >&2
+        rm -f "$dir/libsdk.a"
+    fi
+    if [ ! -f "$dir/libsdk.a" ]; then
+        ar rcs "$dir/libsdk.a" $objs
+    fi
+    echo "$dir/libsdk.a"
+}
+
+build_test() {
+    local name=$1
+    local flags=$(sed -n 's|^// test-flags:||p' "$TEST_DIR/$name.cpp")
+    local lib=$(build_sdk "$flags")
+    local dir=$(dirname "$lib")
+
+    local objs=""
+    for src in "$TEST_DIR/$name.cpp" "$TEST_DIR/ei_porting_host.cpp"; do
+        local obj=$dir/$(basename "$src" .cpp).o
+        objs="$objs $obj"
+        if stale "$obj"; then
+            $(compile "$src" "$obj" "$flags")
+        fi
+    done
+    $CXX -o "$dir/$name" $objs "$lib" -lpthread -lm
+    echo "$dir/$name"
+}
+
+if [ $# -gt 0 ]; then
+    TESTS="$@"
+else
+    TESTS=$(cd "$TEST_DIR" && ls test_*.cpp | sed 's/\.cpp$//')
+fi
+
+failed=""
+for name in $TESTS; do
+    name=${name%.cpp}
+    bin=$(build_test "$name")
+    echo "== $name"
+    if ! "$bin"; then
+        failed="$failed $name"
+    fi
+done
+
+if [ -n "$failed" ]; then
+    echo "FAILED:$failed"
+    exit 1
+fi
+echo "all passed"
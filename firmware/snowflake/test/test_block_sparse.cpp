@@ -0,0 +1,244 @@
+/* The block sparse fully connected kernels (EI_FILTER_LAYOUT_BLOCK_SPARSE in ei_packed_weights.h), on
+ * random layers with random blocks of zeros: arm_fully_connected_block_sparse_s8 under every x86
+ * instruction set, the reference FullyConnectedBlockSparse, and the FULLY_CONNECTED op of
+ * fully_connected.cpp given a block sparse descriptor, give what the dense kernels give on the same
+ * weights with the zeros stored */
+
+// test-flags: -DEI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86=1
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/fully_connected.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/kernels/kernel_runner.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/test_helpers.h"
+#include "edge-impulse-sdk/classifier/ei_packed_weights.h"
+#include <algorithm>
+#include <vector>
+
+static const int LAYERS = 300;
+
+static const arm_nn_x86_isa ISAS[] = { ARM_NN_X86_ISA_SCALAR, ARM_NN_X86_ISA_SSE41, ARM_NN_X86_ISA_AVX2 };
+static const char *ISA_NAMES[] = { "scalar", "SSE4.1", "AVX2" };
+
+static int32_t rand_int(int32_t lo, int32_t hi) {
+    return lo + (int32_t)(ei_test_rand() % (uint32_t)(hi - lo + 1));
+}
+
+struct layer_t {
+    int32_t batches, depth, out_ch, block_size;
+    std::vector<int8_t> input;
+    // [out_ch, depth] with the blocks that aren't stored set to 0
+    std::vector<int8_t> dense;
+    // the stored blocks, row by row, and a bit per block
+    std::vector<int8_t> sparse;
+    std::vector<uint8_t> bitmap;
+    std::vector<int32_t> bias;
+    cmsis_nn_fc_params params;
+    cmsis_nn_per_tensor_quant_params quant;
+};
+
+static layer_t rand_layer() {
+    layer_t l;
+    l.block_size = 4 * rand_int(1, 8);
+    l.batches = rand_int(1, 3);
+    l.depth = l.block_size * rand_int(1, 20);
+    l.out_ch = rand_int(1, 40);
+    // all blocks, none, or about 1/2, 1/4 or 1/10 of them stored
+    const int keep_percent = (const int[]){ 100, 0, 50, 25, 10 }[rand_int(0, 4)];
+
+    l.input.resize(l.batches * l.depth);
+    for (auto &x : l.input) {
+        x = (int8_t)rand_int(-128, 127);
+    }
+    const int32_t blocks = l.depth / l.block_size, bitmap_stride = (blocks + 7) / 8;
+    l.dense.assign(l.out_ch * l.depth, 0);
+    l.bitmap.assign(l.out_ch * bitmap_stride, 0);
+    for (int32_t oc = 0; oc < l.out_ch; oc++) {
+        for (int32_t block = 0; block < blocks; block++) {
+            if (rand_int(0, 99) >= keep_percent) {
+                continue;
+            }
+            l.bitmap[oc * bitmap_stride + block / 8] |= 1 << (block % 8);
+            for (int32_t ix = 0; ix < l.block_size; ix++) {
+                const int8_t w = (int8_t)rand_int(-128, 127);
+                l.dense[oc * l.depth + block * l.block_size + ix] = w;
+                l.sparse.push_back(w);
+            }
+        }
+    }
+    l.bias.resize(l.out_ch);
+    for (auto &b : l.bias) {
+        b = rand_int(-5000, 5000);
+    }
+
+    l.params.input_offset = rand_int(-127, 128);
+    l.params.filter_offset = 0;
+    l.params.output_offset = rand_int(-128, 127);
+    l.params.activation = { -128, 127 };
+    if (rand_int(0, 2) == 0) {
+        l.params.activation.min = rand_int(-128, 0);
+        l.params.activation.max = rand_int(l.params.activation.min, 127);
+    }
+    l.quant.multiplier = rand_int(1 << 30, 0x7fffffff);
+    l.quant.shift = -(int32_t)(7 + log2f((float)l.depth) / 2) + rand_int(-2, 1);
+    return l;
+}
+
+static bool expect_same(const std::vector<int8_t> &actual, const std::vector<int8_t> &expected, const char *name,
+    int layer) {
+    for (size_t ix = 0; ix < expected.size(); ix++) {
+        if (actual[ix] != expected[ix]) {
+            printf("%s, layer %d: output %u is %d, expected %d\n", name, layer, (unsigned)ix, actual[ix], expected[ix]);
+            ei_test_failures++;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_cmsis_nn_block_sparse() {
+    for (int layer = 0; layer < LAYERS; layer++) {
+        layer_t l = rand_layer();
+        cmsis_nn_dims input_dims = { l.batches, 1, 1, l.depth };
+        cmsis_nn_dims filter_dims = { l.depth, 1, 1, l.out_ch };
+        cmsis_nn_dims bias_dims = { 1, 1, 1, l.out_ch };
+        cmsis_nn_dims output_dims = { l.batches, 1, 1, l.out_ch };
+
+        std::vector<int8_t> buffer(arm_fully_connected_s8_get_buffer_size(&filter_dims) + 16);
+        cmsis_nn_context ctx = { buffer.data(), (int32_t)buffer.size() };
+        std::vector<int8_t> expected(l.batches * l.out_ch);
+        EI_TEST_EXPECT_EQ(arm_fully_connected_s8(&ctx, &l.params, &l.quant, &input_dims, l.input.data(), &filter_dims,
+            l.dense.data(), &bias_dims, l.bias.data(), &output_dims, expected.data()), ARM_CMSIS_NN_SUCCESS);
+
+        for (size_t isa = 0; isa < sizeof(ISAS) / sizeof(ISAS[0]); isa++) {
+            arm_nn_x86_set_isa(ISAS[isa]);
+            if (arm_nn_x86_get_isa() != ISAS[isa]) {
+                continue; // not supported by this CPU
+            }
+            std::vector<int8_t> actual(expected.size(), 0x55);
+            cmsis_nn_context no_buffer = { nullptr, 0 };
+            EI_TEST_EXPECT_EQ(arm_fully_connected_block_sparse_s8(&no_buffer, &l.params, &l.quant, &input_dims,
+                l.input.data(), &filter_dims, l.sparse.data(), l.bitmap.data(), l.block_size, &bias_dims,
+                l.bias.data(), &output_dims, actual.data()), ARM_CMSIS_NN_SUCCESS);
+            if (!expect_same(actual, expected, ISA_NAMES[isa], layer)) {
+                arm_nn_x86_set_isa(ARM_NN_X86_ISA_AVX2);
+                return;
+            }
+        }
+        arm_nn_x86_set_isa(ARM_NN_X86_ISA_AVX2);
+    }
+}
+
+static void test_reference_block_sparse() {
+    for (int layer = 0; layer < LAYERS; layer++) {
+        layer_t l = rand_layer();
+        tflite::FullyConnectedParams params = { };
+        params.input_offset = l.params.input_offset;
+        params.weights_offset = 0;
+        params.output_offset = l.params.output_offset;
+        params.output_multiplier = l.quant.multiplier;
+        params.output_shift = l.quant.shift;
+        params.quantized_activation_min = l.params.activation.min;
+        params.quantized_activation_max = l.params.activation.max;
+        const int32_t input_dims[] = { l.batches, l.depth }, filter_dims[] = { l.out_ch, l.depth };
+        const int32_t bias_dims[] = { l.out_ch }, output_dims[] = { l.batches, l.out_ch };
+        const tflite::RuntimeShape input_shape(2, input_dims), filter_shape(2, filter_dims);
+        const tflite::RuntimeShape bias_shape(1, bias_dims), output_shape(2, output_dims);
+
+        std::vector<int8_t> expected(l.batches * l.out_ch), actual(l.batches * l.out_ch, 0x55);
+        tflite::reference_integer_ops::FullyConnected(params, input_shape, l.input.data(), filter_shape,
+            l.dense.data(), bias_shape, l.bias.data(), output_shape, expected.data());
+        tflite::reference_integer_ops::FullyConnectedBlockSparse(params, input_shape, l.input.data(), filter_shape,
+            l.sparse.data(), l.bitmap.data(), l.block_size, bias_shape, l.bias.data(), output_shape, actual.data());
+        if (!expect_same(actual, expected, "reference", layer)) {
+            return;
+        }
+    }
+}
+
+// the FULLY_CONNECTED op on `filter`, with `packed_weights` as the node's custom_initial_data as a
+// compiled model sets it, nullptr for the dense filter
+static TfLiteStatus run_fully_connected_op(const layer_t &l, const std::vector<int8_t> &filter,
+    const ei_packed_weights_t *packed_weights, std::vector<int8_t> *output) {
+    int input_shape[] = { 2, l.batches, l.depth }, filter_shape[] = { 2, l.out_ch, l.depth };
+    int bias_shape[] = { 1, l.out_ch }, output_shape[] = { 2, l.batches, l.out_ch };
+    const float input_scale = 0.5f, filter_scale = 0.01f, output_scale = 0.5f * sqrtf((float)l.depth);
+
+    TfLiteTensor tensors[4] = {
+        tflite::testing::CreateQuantizedTensor(l.input.data(), tflite::testing::IntArrayFromInts(input_shape),
+            input_scale, -l.params.input_offset),
+        tflite::testing::CreateQuantizedTensor(filter.data(), tflite::testing::IntArrayFromInts(filter_shape),
+            filter_scale, 0),
+        tflite::testing::CreateQuantizedTensor(l.bias.data(), tflite::testing::IntArrayFromInts(bias_shape),
+            input_scale * filter_scale, 0),
+        tflite::testing::CreateQuantizedTensor(output->data(), tflite::testing::IntArrayFromInts(output_shape),
+            output_scale, l.params.output_offset),
+    };
+    // only the stored blocks
+    tensors[1].bytes = filter.size();
+    int inputs[] = { 3, 0, 1, 2 }, outputs[] = { 1, 3 };
+    TfLiteFullyConnectedParams params = { kTfLiteActNone, kTfLiteFullyConnectedWeightsFormatDefault, false, false };
+
+    const TfLiteRegistration registration = tflite::Register_FULLY_CONNECTED();
+    tflite::micro::KernelRunner runner(registration, tensors, 4, tflite::testing::IntArrayFromInts(inputs),
+        tflite::testing::IntArrayFromInts(outputs), &params);
+    if (packed_weights) {
+        runner.SetCustomInitialData(packed_weights, sizeof(ei_packed_weights_t));
+    }
+    TfLiteStatus status = runner.InitAndPrepare();
+    if (status == kTfLiteOk) {
+        status = runner.Invoke();
+    }
+    return status;
+}
+
+static void test_fully_connected_op_block_sparse() {
+    for (int layer = 0; layer < LAYERS; layer++) {
+        layer_t l = rand_layer();
+        std::vector<int8_t> expected(l.batches * l.out_ch), actual(l.batches * l.out_ch, 0x55);
+        EI_TEST_EXPECT_EQ(run_fully_connected_op(l, l.dense, nullptr, &expected), kTfLiteOk);
+
+        const ei_packed_weights_t packed_weights = { EI_FILTER_LAYOUT_BLOCK_SPARSE, nullptr, l.bitmap.data(),
+            (uint16_t)l.block_size };
+        EI_TEST_EXPECT_EQ(run_fully_connected_op(l, l.sparse, &packed_weights, &actual), kTfLiteOk);
+        if (!expect_same(actual, expected, "FULLY_CONNECTED", layer)) {
+            return;
+        }
+    }
+
+    // a block size that doesn't divide the depth is refused when the node is prepared
+    layer_t l = rand_layer();
+    std::vector<int8_t> output(l.batches * l.out_ch);
+    const ei_packed_weights_t packed_weights = { EI_FILTER_LAYOUT_BLOCK_SPARSE, nullptr, l.bitmap.data(),
+        (uint16_t)(l.depth + 4) };
+    EI_TEST_EXPECT_EQ(run_fully_connected_op(l, l.sparse, &packed_weights, &output), kTfLiteError);
+}
+
+static void test_block_size_checked() {
+    layer_t l = rand_layer();
+    cmsis_nn_dims input_dims = { l.batches, 1, 1, l.depth };
+    cmsis_nn_dims filter_dims = { l.depth, 1, 1, l.out_ch };
+    cmsis_nn_dims bias_dims = { 1, 1, 1, l.out_ch };
+    cmsis_nn_dims output_dims = { l.batches, 1, 1, l.out_ch };
+    cmsis_nn_context no_buffer = { nullptr, 0 };
+    std::vector<int8_t> output(l.batches * l.out_ch);
+    // not a multiple of 4
+    EI_TEST_EXPECT_EQ(arm_fully_connected_block_sparse_s8(&no_buffer, &l.params, &l.quant, &input_dims,
+        l.input.data(), &filter_dims, l.sparse.data(), l.bitmap.data(), l.block_size + 2, &bias_dims,
+        l.bias.data(), &output_dims, output.data()), ARM_CMSIS_NN_ARG_ERROR);
+    // doesn't divide the depth
+    EI_TEST_EXPECT_EQ(arm_fully_connected_block_sparse_s8(&no_buffer, &l.params, &l.quant, &input_dims,
+        l.input.data(), &filter_dims, l.sparse.data(), l.bitmap.data(), l.depth + 4, &bias_dims,
+        l.bias.data(), &output_dims, output.data()), ARM_CMSIS_NN_ARG_ERROR);
+}
+
+int main() {
+    EI_TEST_RUN(test_cmsis_nn_block_sparse);
+    EI_TEST_RUN(test_reference_block_sparse);
+    EI_TEST_RUN(test_fully_connected_op_block_sparse);
+    EI_TEST_RUN(test_block_size_checked);
+    return ei_test_result();
+}
@@ -0,0 +1,84 @@
+/* run_classifier_batch against run_inference on every window on its own: the same results, with the
+ * model set up once for the batch */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "ei_test_keyword.h"
+#include <vector>
+
+static const size_t WINDOWS = 48;
+
+// the features of the synthetic keyword windows, then random ones, a window per row
+static void fill_windows(ei::matrix_t *features) {
+    for (size_t row = 0; row < features->rows; row++) {
+        float *window = features->buffer + row * features->cols;
+        if (row < 8) {
+            std::vector<float> audio = ei_test_keyword_audio((int)row);
+            signal_t signal;
+            ei::numpy::signal_from_buffer(audio.data(), audio.size(), &signal);
+            ei::matrix_t matrix(1, features->cols, window);
+            const ei_model_dsp_t &block = ei_default_impulse.dsp_blocks[0];
+            EI_TEST_EXPECT_EQ(block.extract_fn(&signal, &matrix, block.config, EI_CLASSIFIER_FREQUENCY), 0);
+        }
+        else {
+            for (size_t ix = 0; ix < features->cols; ix++) {
+                window[ix] = ei_test_uniform(-3.0f, 3.0f);
+            }
+        }
+    }
+}
+
+static void test_batch_matches_single_windows() {
+    ei::matrix_t features(WINDOWS, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    fill_windows(&features);
+    // run_inference may change the features it's given
+    ei::matrix_t copy(WINDOWS, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    memcpy(copy.buffer, features.buffer, WINDOWS * EI_CLASSIFIER_NN_INPUT_FRAME_SIZE * sizeof(float));
+
+    std::vector<ei_impulse_result_t> results(WINDOWS);
+    EI_TEST_EXPECT_EQ(run_classifier_batch(&features, results.data()), EI_IMPULSE_OK);
+
+    for (size_t row = 0; row < WINDOWS; row++) {
+        ei::matrix_t window(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, copy.buffer + row * copy.cols);
+        ei_impulse_result_t expected;
+        memset(&expected, 0, sizeof(expected));
+        EI_TEST_EXPECT_EQ(run_inference(&ei_default_impulse, &window, &expected), EI_IMPULSE_OK);
+
+        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+            EI_TEST_EXPECT(strcmp(results[row].classification[ix].label, expected.classification[ix].label) == 0);
+            EI_TEST_EXPECT_EQ(results[row].classification[ix].value, expected.classification[ix].value);
+        }
+        // the setup is shared, the window's own invoke isn't
+        EI_TEST_EXPECT(results[row].timing.classification_setup_us <= results[row].timing.classification_us);
+    }
+}
+
+static void test_batch_sizes() {
+    ei::matrix_t features(3, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    fill_windows(&features);
+    ei_impulse_result_t results[3];
+
+    ei::matrix_t none(0, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, features.buffer);
+    EI_TEST_EXPECT_EQ(run_classifier_batch(&none, results), EI_IMPULSE_OK);
+
+    ei::matrix_t wrong(3, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE - 1, features.buffer);
+    EI_TEST_EXPECT_EQ(run_classifier_batch(&wrong, results), EI_IMPULSE_INVALID_SIZE);
+
+    // a batch of one is a single window
+    ei::matrix_t one(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, features.buffer);
+    ei::matrix_t one_copy(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    memcpy(one_copy.buffer, features.buffer, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE * sizeof(float));
+    ei_impulse_result_t expected;
+    memset(&expected, 0, sizeof(expected));
+    EI_TEST_EXPECT_EQ(run_classifier_batch(&one, results), EI_IMPULSE_OK);
+    EI_TEST_EXPECT_EQ(run_inference(&ei_default_impulse, &one_copy, &expected), EI_IMPULSE_OK);
+    for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+        EI_TEST_EXPECT_EQ(results[0].classification[ix].value, expected.classification[ix].value);
+    }
+}
+
+int main() {
+    EI_TEST_RUN(test_batch_matches_single_windows);
+    EI_TEST_RUN(test_batch_sizes);
+    return ei_test_result();
+}
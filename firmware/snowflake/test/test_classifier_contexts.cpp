@@ -0,0 +1,158 @@
+/* Two classifier contexts on two threads, with EIDSP_LOCK_SHARED_STATE and the firmware's DSP arena /
+ * memory plan: every slice scores the same as when each context runs on its own */
+
+// test-flags: -DEIDSP_LOCK_SHARED_STATE=1 -DEIDSP_ARENA_SIZE=32768 -DEI_CLASSIFIER_MEMORY_PLAN=1
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+static const size_t SLICES = 12;
+static const size_t ROUNDS = 4;
+
+// per slice: the scores, then the context's features window
+typedef std::vector<float> scores_t;
+
+static std::vector<float> test_audio(size_t length, float pitch) {
+    std::vector<float> audio(length);
+    for (size_t ix = 0; ix < length; ix++) {
+        audio[ix] = 6000.0f * sinf(ix * pitch + sinf(ix * 0.0005f) * 30) + ei_test_uniform(-800.0f, 800.0f);
+    }
+    return audio;
+}
+
+// the scores and features of every slice of `audio`, classified with `ctx` from a fresh start
+static std::vector<scores_t> classify(ei_classifier_context_t *ctx, std::vector<float> &audio, bool *ok) {
+    run_classifier_init(ctx, &ei_default_impulse);
+
+    std::vector<scores_t> scores;
+    for (size_t slice = 0; slice < SLICES; slice++) {
+        signal_t signal;
+        ei::numpy::signal_from_buffer(audio.data() + slice * EI_CLASSIFIER_SLICE_SIZE, EI_CLASSIFIER_SLICE_SIZE, &signal);
+
+        ei_impulse_result_t result;
+        if (run_classifier_continuous(ctx, &ei_default_impulse, &signal, &result) != EI_IMPULSE_OK) {
+            *ok = false;
+        }
+        scores_t values;
+        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+            values.push_back(result.classification[ix].value);
+        }
+        // (until the window is full the ring holds what the previous run left)
+        if (ctx->features_written >= ei_default_impulse.nn_input_frame_size) {
+            values.insert(values.end(), ctx->features->buffer, ctx->features->buffer + ctx->features->cols);
+        }
+        scores.push_back(values);
+    }
+    return scores;
+}
+
+static void expect_same_scores(const std::vector<scores_t> &expected, const std::vector<scores_t> &actual) {
+    EI_TEST_EXPECT_EQ(actual.size(), expected.size());
+    for (size_t slice = 0; slice < expected.size() && slice < actual.size(); slice++) {
+        EI_TEST_EXPECT_EQ(actual[slice].size(), expected[slice].size());
+        for (size_t ix = 0; ix < expected[slice].size() && ix < actual[slice].size(); ix++) {
+            if (actual[slice][ix] != expected[slice][ix]) {
+                EI_TEST_EXPECT_EQ(actual[slice][ix], expected[slice][ix]);
+                break;
+            }
+        }
+    }
+}
+
+static void test_two_threads() {
+    std::vector<float> audio[2] = {
+        test_audio(SLICES * EI_CLASSIFIER_SLICE_SIZE, 0.05f),
+        test_audio(SLICES * EI_CLASSIFIER_SLICE_SIZE, 0.17f),
+    };
+    ei_classifier_context_t ctx[2] = { };
+
+    // each context on its own, one after the other
+    std::vector<scores_t> expected[2];
+    bool ok = true;
+    for (size_t ix = 0; ix < 2; ix++) {
+        expected[ix] = classify(&ctx[ix], audio[ix], &ok);
+    }
+    EI_TEST_EXPECT(ok);
+
+    // the two audio streams have different features, so a mix-up between the contexts shows
+    EI_TEST_EXPECT(expected[0].back() != expected[1].back());
+
+    // and at the same time, from two threads
+    for (size_t round = 0; round < ROUNDS; round++) {
+        std::vector<scores_t> actual[2];
+        bool thread_ok[2] = { true, true };
+        std::thread threads[2];
+        for (size_t ix = 0; ix < 2; ix++) {
+            threads[ix] = std::thread([&, ix]() {
+                actual[ix] = classify(&ctx[ix], audio[ix], &thread_ok[ix]);
+            });
+        }
+        for (size_t ix = 0; ix < 2; ix++) {
+            threads[ix].join();
+            EI_TEST_EXPECT(thread_ok[ix]);
+            expect_same_scores(expected[ix], actual[ix]);
+        }
+    }
+
+    // nothing was left on the heap by a thread that allocated outside of its turn on the arena
+    EI_TEST_EXPECT_EQ(ei::memory::arena_stats().fallbacks, 0);
+
+    for (size_t ix = 0; ix < 2; ix++) {
+        run_classifier_deinit(&ctx[ix]);
+    }
+}
+
+// the DSP arena belongs to one thread at a time: the others get heap memory outside of a scope and
+// wait for their turn to open one
+static void test_arena_owner() {
+    std::atomic<int> step(0);
+    void *other_thread_block = nullptr;
+    bool other_thread_waited = false;
+
+    std::thread other([&]() {
+        while (step.load() < 1) {
+            std::this_thread::yield();
+        }
+        other_thread_block = ei::memory::arena_malloc(64);
+        ei::memory::arena_suspend();
+        step.store(2);
+        {
+            ei::memory::arena_scope scope;
+            other_thread_waited = step.load() == 3;
+            EI_TEST_EXPECT(ei::memory::arena_owns(ei::memory::arena_malloc(64)));
+        }
+        ei::memory::arena_resume();
+    });
+
+    {
+        ei::memory::arena_scope scope;
+        void *block = ei::memory::arena_malloc(64);
+        EI_TEST_EXPECT(ei::memory::arena_owns(block));
+        step.store(1);
+        while (step.load() < 2) {
+            std::this_thread::yield();
+        }
+        // the other thread's suspend doesn't count for this one
+        EI_TEST_EXPECT(ei::memory::arena_owns(ei::memory::arena_malloc(64)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        step.store(3);
+    }
+    other.join();
+
+    EI_TEST_EXPECT(other_thread_block != nullptr);
+    EI_TEST_EXPECT(!ei::memory::arena_owns(other_thread_block));
+    ei::memory::arena_free(other_thread_block);
+    EI_TEST_EXPECT(other_thread_waited);
+}
+
+int main() {
+    run_classifier_init();
+    EI_TEST_RUN(test_arena_owner);
+    EI_TEST_RUN(test_two_threads);
+    run_classifier_deinit();
+    return ei_test_result();
+}
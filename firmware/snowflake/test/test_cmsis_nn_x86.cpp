@@ -0,0 +1,315 @@
+/* The CMSIS-NN s8 kernels with the x86 inner loops (EI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86), on
+ * random layers: every instruction set gives exactly what a plain C implementation of the layer gives */
+
+// test-flags: -DEI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86=1
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+#include <algorithm>
+#include <vector>
+
+static const int LAYERS = 300;
+
+static const arm_nn_x86_isa ISAS[] = { ARM_NN_X86_ISA_SCALAR, ARM_NN_X86_ISA_SSE41, ARM_NN_X86_ISA_AVX2 };
+static const char *ISA_NAMES[] = { "scalar", "SSE4.1", "AVX2" };
+
+static int32_t rand_int(int32_t lo, int32_t hi) {
+    return lo + (int32_t)(ei_test_rand() % (uint32_t)(hi - lo + 1));
+}
+
+static std::vector<int8_t> rand_s8(size_t size) {
+    std::vector<int8_t> v(size);
+    for (auto &x : v) {
+        x = (int8_t)rand_int(-128, 127);
+    }
+    return v;
+}
+
+// a requantization that keeps most outputs in range for a dot product of `depth` s8 values
+static void rand_quant(int32_t depth, int32_t *multiplier, int32_t *shift) {
+    *multiplier = rand_int(1 << 30, 0x7fffffff);
+    *shift = -(int32_t)(7 + log2f((float)depth) / 2) + rand_int(-2, 1);
+}
+
+static int8_t requantize(int32_t acc, int32_t multiplier, int32_t shift, int32_t output_offset,
+    const cmsis_nn_activation &activation) {
+    int32_t out = arm_nn_requantize(acc, multiplier, shift) + output_offset;
+    return (int8_t)std::min(std::max(out, activation.min), activation.max);
+}
+
+static cmsis_nn_activation rand_activation() {
+    cmsis_nn_activation activation = { -128, 127 };
+    if (rand_int(0, 2) == 0) {
+        activation.min = rand_int(-128, 0);
+        activation.max = rand_int(activation.min, 127);
+    }
+    return activation;
+}
+
+// run `layer` under every instruction set and compare with `expected`
+template <typename Layer>
+static bool check_isas(const std::vector<int8_t> &expected, const char *name, int index, Layer layer) {
+    for (size_t isa = 0; isa < sizeof(ISAS) / sizeof(ISAS[0]); isa++) {
+        arm_nn_x86_set_isa(ISAS[isa]);
+        if (arm_nn_x86_get_isa() != ISAS[isa]) {
+            continue; // not supported by this CPU
+        }
+        std::vector<int8_t> actual(expected.size(), 0x55);
+        EI_TEST_EXPECT_EQ(layer(actual.data()), ARM_CMSIS_NN_SUCCESS);
+        for (size_t ix = 0; ix < expected.size(); ix++) {
+            if (actual[ix] != expected[ix]) {
+                printf("%s %d (%s): output %u is %d, expected %d\n", name, index, ISA_NAMES[isa], (unsigned)ix,
+                    actual[ix], expected[ix]);
+                ei_test_failures++;
+                return false;
+            }
+        }
+    }
+    arm_nn_x86_set_isa(ARM_NN_X86_ISA_AVX2);
+    return true;
+}
+
+static void test_convolve() {
+    for (int layer = 0; layer < LAYERS; layer++) {
+        const int32_t in_h = rand_int(1, 12), in_w = rand_int(1, 12), in_ch = rand_int(1, 24);
+        const int32_t out_ch = rand_int(1, 24);
+        // 1x1 (the 1x1 fast path), 1xN (the 1xN path) and generic kernels
+        const int kind = rand_int(0, 2);
+        const int32_t k_h = kind == 0 ? 1 : (kind == 1 ? 1 : rand_int(1, std::min(in_h, 5)));
+        const int32_t k_w = kind == 0 ? 1 : rand_int(1, std::min(in_w, 5));
+        const int32_t stride_h = kind == 0 ? 1 : rand_int(1, 2), stride_w = kind == 0 ? 1 : rand_int(1, 2);
+        const int32_t pad_h = kind == 0 ? 0 : rand_int(0, k_h / 2), pad_w = kind == 0 ? 0 : rand_int(0, k_w / 2);
+        const int32_t out_h = (in_h + 2 * pad_h - k_h) / stride_h + 1;
+        const int32_t out_w = (in_w + 2 * pad_w - k_w) / stride_w + 1;
+
+        cmsis_nn_conv_params params;
+        params.input_offset = rand_int(-127, 128);
+        params.output_offset = rand_int(-128, 127);
+        params.stride = { stride_w, stride_h };
+        params.padding = { pad_w, pad_h };
+        params.dilation = { 1, 1 };
+        params.activation = rand_activation();
+
+        std::vector<int32_t> multiplier(out_ch), shift(out_ch), bias(out_ch);
+        for (int32_t ch = 0; ch < out_ch; ch++) {
+            rand_quant(k_h * k_w * in_ch, &multiplier[ch], &shift[ch]);
+            bias[ch] = rand_int(-5000, 5000);
+        }
+        cmsis_nn_per_channel_quant_params quant = { multiplier.data(), shift.data() };
+
+        cmsis_nn_dims input_dims = { 1, in_h, in_w, in_ch };
+        cmsis_nn_dims filter_dims = { out_ch, k_h, k_w, in_ch };
+        cmsis_nn_dims bias_dims = { 1, 1, 1, out_ch };
+        cmsis_nn_dims output_dims = { 1, out_h, out_w, out_ch };
+        std::vector<int8_t> input = rand_s8(in_h * in_w * in_ch);
+        std::vector<int8_t> filter = rand_s8(out_ch * k_h * k_w * in_ch);
+
+        std::vector<int8_t> expected(out_h * out_w * out_ch);
+        for (int32_t oy = 0; oy < out_h; oy++) {
+            for (int32_t ox = 0; ox < out_w; ox++) {
+                for (int32_t oc = 0; oc < out_ch; oc++) {
+                    int32_t acc = bias[oc];
+                    for (int32_t ky = 0; ky < k_h; ky++) {
+                        for (int32_t kx = 0; kx < k_w; kx++) {
+                            const int32_t iy = oy * stride_h - pad_h + ky, ix = ox * stride_w - pad_w + kx;
+                            if (iy < 0 || iy >= in_h || ix < 0 || ix >= in_w) {
+                                continue;
+                            }
+                            for (int32_t ic = 0; ic < in_ch; ic++) {
+                                acc += (input[(iy * in_w + ix) * in_ch + ic] + params.input_offset) *
+                                    filter[((oc * k_h + ky) * k_w + kx) * in_ch + ic];
+                            }
+                        }
+                    }
+                    expected[(oy * out_w + ox) * out_ch + oc] =
+                        requantize(acc, multiplier[oc], shift[oc], params.output_offset, params.activation);
+                }
+            }
+        }
+
+        std::vector<int8_t> buffer(arm_convolve_wrapper_s8_get_buffer_size(&params, &input_dims, &filter_dims,
+            &output_dims) + 16);
+        cmsis_nn_context ctx = { buffer.data(), (int32_t)buffer.size() };
+        if (!check_isas(expected, "convolve", layer, [&](int8_t *output) {
+                return arm_convolve_wrapper_s8(&ctx, &params, &quant, &input_dims, input.data(), &filter_dims,
+                    filter.data(), &bias_dims, bias.data(), &output_dims, output);
+            })) {
+            return;
+        }
+    }
+}
+
+static void test_depthwise() {
+    for (int layer = 0; layer < LAYERS; layer++) {
+        const int32_t in_h = rand_int(1, 12), in_w = rand_int(1, 12), in_ch = rand_int(1, 40);
+        // ch_mult 1 takes the vectorized path (3x3 included), 2 the generic one
+        const int32_t ch_mult = rand_int(0, 3) == 0 ? 2 : 1;
+        const int32_t out_ch = in_ch * ch_mult;
+        const bool three = rand_int(0, 2) == 0;
+        const int32_t k_h = three ? std::min<int32_t>(3, in_h) : rand_int(1, std::min(in_h, 5));
+        const int32_t k_w = three ? std::min<int32_t>(3, in_w) : rand_int(1, std::min(in_w, 5));
+        const int32_t stride_h = rand_int(1, 2), stride_w = rand_int(1, 2);
+        const int32_t pad_h = rand_int(0, k_h / 2), pad_w = rand_int(0, k_w / 2);
+        const int32_t out_h = (in_h + 2 * pad_h - k_h) / stride_h + 1;
+        const int32_t out_w = (in_w + 2 * pad_w - k_w) / stride_w + 1;
+
+        cmsis_nn_dw_conv_params params;
+        params.input_offset = rand_int(-127, 128);
+        params.output_offset = rand_int(-128, 127);
+        params.ch_mult = ch_mult;
+        params.stride = { stride_w, stride_h };
+        params.padding = { pad_w, pad_h };
+        params.dilation = { 1, 1 };
+        params.activation = rand_activation();
+
+        std::vector<int32_t> multiplier(out_ch), shift(out_ch), bias(out_ch);
+        for (int32_t ch = 0; ch < out_ch; ch++) {
+            rand_quant(k_h * k_w, &multiplier[ch], &shift[ch]);
+            bias[ch] = rand_int(-2000, 2000);
+        }
+        cmsis_nn_per_channel_quant_params quant = { multiplier.data(), shift.data() };
+
+        cmsis_nn_dims input_dims = { 1, in_h, in_w, in_ch };
+        cmsis_nn_dims filter_dims = { 1, k_h, k_w, out_ch };
+        cmsis_nn_dims bias_dims = { 1, 1, 1, out_ch };
+        cmsis_nn_dims output_dims = { 1, out_h, out_w, out_ch };
+        std::vector<int8_t> input = rand_s8(in_h * in_w * in_ch);
+        std::vector<int8_t> filter = rand_s8(k_h * k_w * out_ch);
+
+        std::vector<int8_t> expected(out_h * out_w * out_ch);
+        for (int32_t oy = 0; oy < out_h; oy++) {
+            for (int32_t ox = 0; ox < out_w; ox++) {
+                for (int32_t oc = 0; oc < out_ch; oc++) {
+                    const int32_t ic = oc / ch_mult;
+                    int32_t acc = bias[oc];
+                    for (int32_t ky = 0; ky < k_h; ky++) {
+                        for (int32_t kx = 0; kx < k_w; kx++) {
+                            const int32_t iy = oy * stride_h - pad_h + ky, ix = ox * stride_w - pad_w + kx;
+                            if (iy < 0 || iy >= in_h || ix < 0 || ix >= in_w) {
+                                continue;
+                            }
+                            acc += (input[(iy * in_w + ix) * in_ch + ic] + params.input_offset) *
+                                filter[(ky * k_w + kx) * out_ch + oc];
+                        }
+                    }
+                    expected[(oy * out_w + ox) * out_ch + oc] =
+                        requantize(acc, multiplier[oc], shift[oc], params.output_offset, params.activation);
+                }
+            }
+        }
+
+        std::vector<int8_t> buffer(arm_depthwise_conv_wrapper_s8_get_buffer_size(&params, &input_dims, &filter_dims,
+            &output_dims) + 16);
+        cmsis_nn_context ctx = { buffer.data(), (int32_t)buffer.size() };
+        if (!check_isas(expected, "depthwise", layer, [&](int8_t *output) {
+                return arm_depthwise_conv_wrapper_s8(&ctx, &params, &quant, &input_dims, input.data(), &filter_dims,
+                    filter.data(), &bias_dims, bias.data(), &output_dims, output);
+            })) {
+            return;
+        }
+    }
+}
+
+static void test_fully_connected() {
+    for (int layer = 0; layer < LAYERS; layer++) {
+        const int32_t batches = rand_int(1, 3), depth = rand_int(1, 300), out_ch = rand_int(1, 40);
+
+        cmsis_nn_fc_params params;
+        params.input_offset = rand_int(-127, 128);
+        params.filter_offset = 0;
+        params.output_offset = rand_int(-128, 127);
+        params.activation = rand_activation();
+        cmsis_nn_per_tensor_quant_params quant;
+        rand_quant(depth, &quant.multiplier, &quant.shift);
+
+        cmsis_nn_dims input_dims = { batches, 1, 1, depth };
+        cmsis_nn_dims filter_dims = { depth, 1, 1, out_ch };
+        cmsis_nn_dims bias_dims = { 1, 1, 1, out_ch };
+        cmsis_nn_dims output_dims = { batches, 1, 1, out_ch };
+        std::vector<int8_t> input = rand_s8(batches * depth);
+        std::vector<int8_t> filter = rand_s8(out_ch * depth);
+        std::vector<int32_t> bias(out_ch);
+        for (auto &b : bias) {
+            b = rand_int(-5000, 5000);
+        }
+
+        std::vector<int8_t> expected(batches * out_ch);
+        for (int32_t batch = 0; batch < batches; batch++) {
+            for (int32_t oc = 0; oc < out_ch; oc++) {
+                int32_t acc = bias[oc];
+                for (int32_t ix = 0; ix < depth; ix++) {
+                    acc += (input[batch * depth + ix] + params.input_offset) * filter[oc * depth + ix];
+                }
+                expected[batch * out_ch + oc] =
+                    requantize(acc, quant.multiplier, quant.shift, params.output_offset, params.activation);
+            }
+        }
+
+        std::vector<int8_t> buffer(arm_fully_connected_s8_get_buffer_size(&filter_dims) + 16);
+        cmsis_nn_context ctx = { buffer.data(), (int32_t)buffer.size() };
+        if (!check_isas(expected, "fully connected", layer, [&](int8_t *output) {
+                return arm_fully_connected_s8(&ctx, &params, &quant, &input_dims, input.data(), &filter_dims,
+                    filter.data(), &bias_dims, bias.data(), &output_dims, output);
+            })) {
+            return;
+        }
+    }
+}
+
+static void test_max_pool() {
+    for (int layer = 0; layer < LAYERS; layer++) {
+        const int32_t in_h = rand_int(1, 12), in_w = rand_int(1, 12), ch = rand_int(1, 70);
+        const int32_t k_h = rand_int(1, std::min(in_h, 4)), k_w = rand_int(1, std::min(in_w, 4));
+        const int32_t stride_h = rand_int(1, 2), stride_w = rand_int(1, 2);
+        const int32_t pad_h = rand_int(0, k_h / 2), pad_w = rand_int(0, k_w / 2);
+        const int32_t out_h = (in_h + 2 * pad_h - k_h) / stride_h + 1;
+        const int32_t out_w = (in_w + 2 * pad_w - k_w) / stride_w + 1;
+
+        cmsis_nn_pool_params params;
+        params.stride = { stride_w, stride_h };
+        params.padding = { pad_w, pad_h };
+        params.activation = rand_activation();
+
+        cmsis_nn_dims input_dims = { 1, in_h, in_w, ch };
+        cmsis_nn_dims filter_dims = { 1, k_h, k_w, 1 };
+        cmsis_nn_dims output_dims = { 1, out_h, out_w, ch };
+        std::vector<int8_t> input = rand_s8(in_h * in_w * ch);
+
+        std::vector<int8_t> expected(out_h * out_w * ch);
+        for (int32_t oy = 0; oy < out_h; oy++) {
+            for (int32_t ox = 0; ox < out_w; ox++) {
+                for (int32_t c = 0; c < ch; c++) {
+                    int32_t max = -129;
+                    for (int32_t ky = 0; ky < k_h; ky++) {
+                        for (int32_t kx = 0; kx < k_w; kx++) {
+                            const int32_t iy = oy * stride_h - pad_h + ky, ix = ox * stride_w - pad_w + kx;
+                            if (iy >= 0 && iy < in_h && ix >= 0 && ix < in_w) {
+                                max = std::max<int32_t>(max, input[(iy * in_w + ix) * ch + c]);
+                            }
+                        }
+                    }
+                    expected[(oy * out_w + ox) * ch + c] =
+                        (int8_t)std::min(std::max(max, params.activation.min), params.activation.max);
+                }
+            }
+        }
+
+        cmsis_nn_context ctx = { nullptr, 0 };
+        if (!check_isas(expected, "max pool", layer, [&](int8_t *output) {
+                return arm_max_pool_s8(&ctx, &params, &input_dims, input.data(), &filter_dims, &output_dims, output);
+            })) {
+            return;
+        }
+    }
+}
+
+int main() {
+    printf("CPU supports up to %s\n", ISA_NAMES[arm_nn_x86_get_isa()]);
+    EI_TEST_RUN(test_convolve);
+    EI_TEST_RUN(test_depthwise);
+    EI_TEST_RUN(test_fully_connected);
+    EI_TEST_RUN(test_max_pool);
+    return ei_test_result();
+}
@@ -0,0 +1,89 @@
+/* run_classifier_continuous_multi only shares the DSP between impulses with the same front end:
+ * DSP block, parameters and input axes */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include <vector>
+
+// a copy of the keyword impulse with its own DSP block and config, to change
+struct impulse_copy_t {
+    ei_impulse_t impulse;
+    ei_model_dsp_t block;
+    ei_dsp_config_mfcc_t config;
+    uint8_t axes[2];
+
+    impulse_copy_t() : impulse(ei_default_impulse), block(ei_default_impulse.dsp_blocks[0]),
+        config(*(const ei_dsp_config_mfcc_t *)block.config)
+    {
+        axes[0] = block.axes[0];
+        axes[1] = 0;
+        block.config = &config;
+        block.axes = axes;
+        impulse.dsp_blocks = &block;
+    }
+};
+
+static EI_IMPULSE_ERROR run_multi(const ei_impulse_t *b) {
+    std::vector<float> audio(EI_CLASSIFIER_SLICE_SIZE, 0.0f);
+    signal_t signal;
+    ei::numpy::signal_from_buffer(audio.data(), audio.size(), &signal);
+
+    ei_classifier_context_t ctxs[2] = { };
+    const ei_impulse_t *impulses[2] = { &ei_default_impulse, b };
+    run_classifier_init(&ctxs[0], impulses[0]);
+    run_classifier_init(&ctxs[1], impulses[1]);
+
+    ei_impulse_result_t results[2];
+    EI_IMPULSE_ERROR res = run_classifier_continuous_multi(ctxs, impulses, 2, &signal, results);
+
+    run_classifier_deinit(&ctxs[0]);
+    run_classifier_deinit(&ctxs[1]);
+    return res;
+}
+
+static void test_same_front_end() {
+    impulse_copy_t copy;
+    EI_TEST_EXPECT(process_impulse_continuous_same_dsp(&ei_default_impulse, &ei_default_impulse));
+    EI_TEST_EXPECT(process_impulse_continuous_same_dsp(&ei_default_impulse, &copy.impulse));
+
+    // block ids differ between projects
+    copy.config.block_id = 1234;
+    EI_TEST_EXPECT(process_impulse_continuous_same_dsp(&ei_default_impulse, &copy.impulse));
+    EI_TEST_EXPECT_EQ(run_multi(&copy.impulse), EI_IMPULSE_OK);
+}
+
+static void test_different_parameters() {
+    impulse_copy_t copy;
+    copy.config.num_filters += 8;
+    EI_TEST_EXPECT(!process_impulse_continuous_same_dsp(&ei_default_impulse, &copy.impulse));
+    EI_TEST_EXPECT_EQ(run_multi(&copy.impulse), EI_IMPULSE_DSP_ERROR);
+}
+
+static void test_different_axes() {
+    // same number of axes, another one of the signal
+    impulse_copy_t copy;
+    copy.axes[0] = copy.block.axes[0] + 1;
+    EI_TEST_EXPECT(!process_impulse_continuous_same_dsp(&ei_default_impulse, &copy.impulse));
+    EI_TEST_EXPECT_EQ(run_multi(&copy.impulse), EI_IMPULSE_DSP_ERROR);
+
+    // more axes
+    impulse_copy_t more_axes;
+    more_axes.block.axes_size = 2;
+    more_axes.axes[1] = 1;
+    EI_TEST_EXPECT(!process_impulse_continuous_same_dsp(&ei_default_impulse, &more_axes.impulse));
+
+    // a signal with more values per frame
+    impulse_copy_t more_values;
+    more_values.impulse.raw_samples_per_frame = 2;
+    EI_TEST_EXPECT(!process_impulse_continuous_same_dsp(&ei_default_impulse, &more_values.impulse));
+    EI_TEST_EXPECT_EQ(run_multi(&more_values.impulse), EI_IMPULSE_DSP_ERROR);
+}
+
+int main() {
+    run_classifier_init();
+    EI_TEST_RUN(test_same_front_end);
+    EI_TEST_RUN(test_different_parameters);
+    EI_TEST_RUN(test_different_axes);
+    run_classifier_deinit();
+    return ei_test_result();
+}
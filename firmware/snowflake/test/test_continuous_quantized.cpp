@@ -0,0 +1,117 @@
+/* EI_CLASSIFIER_CONTINUOUS_QUANTIZED_FEATURES: the features window normalized straight into the int8
+ * input tensor against the float window it replaces, and the multi-model path taking it too */
+
+// test-flags: -DEI_CLASSIFIER_CONTINUOUS_QUANTIZED_FEATURES=1
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include <vector>
+
+static const size_t SLICES = 16;
+
+// a sweep and a few bursts, so the window has something else than steady noise in it
+static std::vector<float> test_audio(size_t length) {
+    std::vector<float> audio(length);
+    for (size_t ix = 0; ix < length; ix++) {
+        const float envelope = (ix / 3000) % 3 == 0 ? 1.0f : 0.1f;
+        audio[ix] = envelope * 8000.0f * sinf(ix * (0.02f + ix * 4e-7f)) + ei_test_uniform(-300.0f, 300.0f);
+    }
+    return audio;
+}
+
+static void input_params(float *scale, int32_t *zero_point) {
+    const ei_learning_block_config_tflite_graph_t *block_config =
+        (const ei_learning_block_config_tflite_graph_t *)ei_default_impulse.learning_blocks[0].config;
+    const ei_config_tflite_eon_graph_t *graph = (const ei_config_tflite_eon_graph_t *)block_config->graph_config;
+
+    TfLiteTensor input;
+    graph->model_init(ei_aligned_calloc);
+    graph->model_input(0, &input);
+    *scale = input.params.scale;
+    *zero_point = input.params.zero_point;
+    graph->model_reset(ei_aligned_free);
+}
+
+static void test_quantized_window_matches_float() {
+    EI_TEST_EXPECT_EQ(can_run_classifier_continuous_quantized(&ei_default_impulse), EI_IMPULSE_OK);
+
+    float scale;
+    int32_t zero_point;
+    input_params(&scale, &zero_point);
+
+    std::vector<float> audio = test_audio(SLICES * EI_CLASSIFIER_SLICE_SIZE);
+    ei_classifier_context_t quantized = { }, reference = { }, multi[2] = { };
+    run_classifier_init(&quantized, &ei_default_impulse);
+    run_classifier_init(&reference, &ei_default_impulse);
+    run_classifier_init(&multi[0], &ei_default_impulse);
+    run_classifier_init(&multi[1], &ei_default_impulse);
+    const ei_impulse_t *impulses[2] = { &ei_default_impulse, &ei_default_impulse };
+
+    size_t values = 0, off_by_one = 0, off_by_more = 0;
+    float max_score_diff = 0.0f;
+    for (size_t slice = 0; slice < SLICES; slice++) {
+        float *data = audio.data() + slice * EI_CLASSIFIER_SLICE_SIZE;
+        signal_t signal, reference_signal, multi_signal;
+        ei::numpy::signal_from_buffer(data, EI_CLASSIFIER_SLICE_SIZE, &signal);
+        ei::numpy::signal_from_buffer(data, EI_CLASSIFIER_SLICE_SIZE, &reference_signal);
+        ei::numpy::signal_from_buffer(data, EI_CLASSIFIER_SLICE_SIZE, &multi_signal);
+
+        ei_impulse_result_t result, reference_result, multi_results[2];
+        EI_TEST_EXPECT_EQ(run_classifier_continuous(&quantized, &ei_default_impulse, &signal, &result), EI_IMPULSE_OK);
+        EI_TEST_EXPECT_EQ(run_classifier_continuous_multi(multi, impulses, 2, &multi_signal, multi_results),
+            EI_IMPULSE_OK);
+
+        // the float path: DSP, float window, quantized by the engine on the way into the tensor
+        memset(&reference_result, 0, sizeof(reference_result));
+        EI_TEST_EXPECT_EQ(process_impulse_continuous_dsp(&reference, &ei_default_impulse, &reference_signal,
+            &reference_result, false), EI_IMPULSE_OK);
+        if (reference.features_written < ei_default_impulse.nn_input_frame_size) {
+            continue;
+        }
+
+        ei::matrix_t window(1, ei_default_impulse.nn_input_frame_size);
+        process_impulse_continuous_window(&reference, &ei_default_impulse, &window, &reference_result);
+        EI_TEST_EXPECT_EQ(process_impulse_continuous_inference(&reference, &ei_default_impulse, &window,
+            &reference_result, false, true), EI_IMPULSE_OK);
+
+        // the input tensor of both paths
+        ei::matrix_i8_t tensor(1, ei_default_impulse.nn_input_frame_size);
+        EI_TEST_EXPECT_EQ(ei_dsp_cont_features_quantize_mfcc(&quantized.dsp, quantized.features,
+            ei_default_impulse.dsp_blocks[0].config, scale, zero_point, &tensor), EIDSP_OK);
+        for (size_t ix = 0; ix < window.cols; ix++) {
+            const int32_t expected = pre_cast_quantize(window.buffer[ix], scale, zero_point, true);
+            const int32_t diff = abs(expected - tensor.buffer[ix]);
+            values++;
+            off_by_one += diff == 1;
+            off_by_more += diff > 1;
+        }
+
+        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+            const float diff = fabsf(result.classification[ix].value - reference_result.classification[ix].value);
+            max_score_diff = diff > max_score_diff ? diff : max_score_diff;
+
+            // the multi-model path runs the same quantized window for every model
+            EI_TEST_EXPECT_EQ(multi_results[0].classification[ix].value, result.classification[ix].value);
+            EI_TEST_EXPECT_EQ(multi_results[1].classification[ix].value, result.classification[ix].value);
+        }
+    }
+
+    // the sums of the window are kept in another order than cmvnw's, which moves values that sit on a
+    // rounding boundary by one step
+    printf("%u of %u input values off by one step, %u by more; scores differ by up to %g\n",
+        (unsigned)off_by_one, (unsigned)values, (unsigned)off_by_more, max_score_diff);
+    EI_TEST_EXPECT(values > 0);
+    EI_TEST_EXPECT_EQ(off_by_more, 0);
+    EI_TEST_EXPECT(off_by_one * 100 <= values);
+    EI_TEST_EXPECT(max_score_diff <= 4.0f / 256);
+
+    run_classifier_deinit(&quantized);
+    run_classifier_deinit(&reference);
+    run_classifier_deinit(&multi[0]);
+    run_classifier_deinit(&multi[1]);
+}
+
+int main() {
+    EI_TEST_RUN(test_quantized_window_matches_float);
+    return ei_test_result();
+}
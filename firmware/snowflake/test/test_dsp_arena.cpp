@@ -0,0 +1,129 @@
+/* ei::memory DSP arena: bump allocation, popping the latest block, heap fallback and nested arena_scopes */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/dsp/memory.hpp"
+#include <string.h>
+
+using namespace ei;
+
+static const size_t ARENA_SIZE = 4096;
+
+static void test_outside_scope_uses_heap() {
+    memory::arena_init(ARENA_SIZE);
+
+    void *ptr = memory::arena_malloc(64);
+    EI_TEST_EXPECT(ptr != nullptr);
+    EI_TEST_EXPECT(!memory::arena_owns(ptr));
+    memory::arena_free(ptr);
+
+    memory::arena_deinit();
+}
+
+static void test_scope_allocates_from_arena() {
+    memory::arena_init(ARENA_SIZE);
+    {
+        memory::arena_scope scope;
+        void *a = memory::arena_malloc(100);
+        void *b = memory::arena_calloc(10, 10);
+        EI_TEST_EXPECT(memory::arena_owns(a));
+        EI_TEST_EXPECT(memory::arena_owns(b));
+        EI_TEST_EXPECT((uintptr_t)a % 8 == 0);
+        EI_TEST_EXPECT((uintptr_t)b % 8 == 0);
+        EI_TEST_EXPECT(memory::arena_stats().used > 200);
+
+        // freeing the latest block pops it, the next allocation lands in the same place
+        memory::arena_free(b);
+        void *c = memory::arena_malloc(100);
+        EI_TEST_EXPECT(c == b);
+
+        // a block that doesn't fit goes to the heap
+        void *big = memory::arena_malloc(ARENA_SIZE * 2);
+        EI_TEST_EXPECT(big != nullptr);
+        EI_TEST_EXPECT(!memory::arena_owns(big));
+        EI_TEST_EXPECT_EQ(memory::arena_stats().fallbacks, 1);
+        memory::arena_free(big);
+    }
+
+    // the next outermost scope starts from an empty arena
+    {
+        memory::arena_scope scope;
+        EI_TEST_EXPECT_EQ(memory::arena_stats().used, 0);
+    }
+    memory::arena_deinit();
+}
+
+static void test_nested_scope_keeps_outer_allocations() {
+    memory::arena_init(ARENA_SIZE);
+    {
+        memory::arena_scope outer;
+        uint8_t *a = (uint8_t*)memory::arena_malloc(256);
+        EI_TEST_EXPECT(memory::arena_owns(a));
+        memset(a, 0xa5, 256);
+        const size_t used_outer = memory::arena_stats().used;
+
+        uint8_t *b;
+        {
+            memory::arena_scope inner;
+            EI_TEST_EXPECT_EQ(memory::arena_stats().used, used_outer);
+
+            b = (uint8_t*)memory::arena_malloc(512);
+            EI_TEST_EXPECT(memory::arena_owns(b));
+            EI_TEST_EXPECT(b >= a + 256);
+            memset(b, 0x5a, 512);
+
+            {
+                memory::arena_scope innermost;
+                void *d = memory::arena_malloc(128);
+                EI_TEST_EXPECT(memory::arena_owns(d));
+            }
+            EI_TEST_EXPECT(memory::arena_owns(memory::arena_malloc(8)));
+        }
+
+        // the inner scopes gave back their blocks only, the outer scope still allocates from the arena
+        EI_TEST_EXPECT_EQ(memory::arena_stats().used, used_outer);
+        for (size_t ix = 0; ix < 256; ix++) {
+            if (a[ix] != 0xa5) {
+                EI_TEST_EXPECT_EQ(a[ix], 0xa5);
+                break;
+            }
+        }
+
+        void *c = memory::arena_malloc(512);
+        EI_TEST_EXPECT(c == b);
+
+        // and the latest outer block can still be popped
+        memory::arena_free(c);
+        memory::arena_free(a);
+        EI_TEST_EXPECT_EQ(memory::arena_stats().used, 0);
+    }
+
+    // after the outermost scope allocations go to the heap again
+    void *ptr = memory::arena_malloc(64);
+    EI_TEST_EXPECT(!memory::arena_owns(ptr));
+    memory::arena_free(ptr);
+
+    memory::arena_deinit();
+}
+
+static void test_suspend_in_scope() {
+    memory::arena_init(ARENA_SIZE);
+    {
+        memory::arena_scope scope;
+        memory::arena_suspend();
+        void *ptr = memory::arena_malloc(64);
+        memory::arena_resume();
+        EI_TEST_EXPECT(!memory::arena_owns(ptr));
+        memory::arena_free(ptr);
+
+        EI_TEST_EXPECT(memory::arena_owns(memory::arena_malloc(64)));
+    }
+    memory::arena_deinit();
+}
+
+int main() {
+    EI_TEST_RUN(test_outside_scope_uses_heap);
+    EI_TEST_RUN(test_scope_allocates_from_arena);
+    EI_TEST_RUN(test_nested_scope_keeps_outer_allocations);
+    EI_TEST_RUN(test_suspend_in_scope);
+    return ei_test_result();
+}
@@ -0,0 +1,115 @@
+/* numpy::rfft with the FFT plan cache: same output as a fresh kissfft plan, hit / miss / eviction counters */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+#include <vector>
+
+using namespace ei;
+
+static std::vector<float> random_signal(size_t length) {
+    std::vector<float> signal(length);
+    for (size_t ix = 0; ix < length; ix++) {
+        signal[ix] = ei_test_uniform(-1000.0f, 1000.0f);
+    }
+    return signal;
+}
+
+// what rfft did before plans were cached: a new kissfft config per call
+static std::vector<kiss_fft_cpx> uncached_rfft(std::vector<float> input, size_t n_fft) {
+    input.resize(n_fft, 0.0f);
+    std::vector<kiss_fft_cpx> output(n_fft / 2 + 1);
+    kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, NULL);
+    kiss_fftr(cfg, input.data(), output.data());
+    kiss_fftr_free(cfg);
+    return output;
+}
+
+static void test_rfft_matches_uncached() {
+    const size_t lengths[] = { 64, 256, 512, 400, 512, 64 };
+    for (size_t n_fft : lengths) {
+        std::vector<float> input = random_signal(n_fft - 7);
+        std::vector<kiss_fft_cpx> expected = uncached_rfft(input, n_fft);
+
+        std::vector<float> magnitude(n_fft / 2 + 1);
+        std::vector<fft_complex_t> complex(n_fft / 2 + 1);
+        EI_TEST_EXPECT_EQ(numpy::rfft(input.data(), input.size(), magnitude.data(), magnitude.size(), n_fft), EIDSP_OK);
+        EI_TEST_EXPECT_EQ(numpy::rfft(input.data(), input.size(), complex.data(), complex.size(), n_fft), EIDSP_OK);
+
+        for (size_t ix = 0; ix < expected.size(); ix++) {
+            EI_TEST_EXPECT_EQ(complex[ix].r, expected[ix].r);
+            EI_TEST_EXPECT_EQ(complex[ix].i, expected[ix].i);
+            // rfft takes the magnitude in float
+            const double expected_magnitude = sqrt(pow(expected[ix].r, 2) + pow(expected[ix].i, 2));
+            EI_TEST_EXPECT_NEAR(magnitude[ix], expected_magnitude, expected_magnitude * 1e-6);
+        }
+    }
+}
+
+static void rfft_512(size_t n_fft) {
+    std::vector<float> input = random_signal(n_fft);
+    std::vector<float> output(n_fft / 2 + 1);
+    numpy::rfft(input.data(), input.size(), output.data(), output.size(), n_fft);
+}
+
+static void test_hits_and_misses() {
+    numpy::fft_plan_cache_clear();
+    fft_plan_cache_stats_t before = numpy::fft_plan_cache_stats();
+    EI_TEST_EXPECT_EQ(before.plans, 0);
+    EI_TEST_EXPECT_EQ(before.bytes, 0);
+
+    rfft_512(512);
+    fft_plan_cache_stats_t after_first = numpy::fft_plan_cache_stats();
+    EI_TEST_EXPECT_EQ(after_first.misses, before.misses + 1);
+    EI_TEST_EXPECT_EQ(after_first.hits, before.hits);
+    EI_TEST_EXPECT_EQ(after_first.plans, 1);
+    EI_TEST_EXPECT(after_first.bytes > 0);
+
+    // the 49 frames of a 1 s MFCC window share one plan
+    for (int frame = 0; frame < 49; frame++) {
+        rfft_512(512);
+    }
+    fft_plan_cache_stats_t after_window = numpy::fft_plan_cache_stats();
+    EI_TEST_EXPECT_EQ(after_window.misses, after_first.misses);
+    EI_TEST_EXPECT_EQ(after_window.hits, after_first.hits + 49);
+    EI_TEST_EXPECT_EQ(after_window.bytes, after_first.bytes);
+}
+
+static void test_eviction() {
+    numpy::fft_plan_cache_clear();
+    fft_plan_cache_stats_t before = numpy::fft_plan_cache_stats();
+
+    // one length more than there are slots, so the oldest plan goes
+    for (size_t ix = 0; ix <= EIDSP_FFT_PLAN_CACHE_SIZE; ix++) {
+        rfft_512(32 << ix);
+    }
+    fft_plan_cache_stats_t full = numpy::fft_plan_cache_stats();
+    EI_TEST_EXPECT_EQ(full.misses, before.misses + EIDSP_FFT_PLAN_CACHE_SIZE + 1);
+    EI_TEST_EXPECT_EQ(full.plans, EIDSP_FFT_PLAN_CACHE_SIZE);
+
+    // the newest is still there, the oldest has to be made again
+    rfft_512(32 << EIDSP_FFT_PLAN_CACHE_SIZE);
+    EI_TEST_EXPECT_EQ(numpy::fft_plan_cache_stats().hits, full.hits + 1);
+    rfft_512(32);
+    EI_TEST_EXPECT_EQ(numpy::fft_plan_cache_stats().misses, full.misses + 1);
+    EI_TEST_EXPECT_EQ(numpy::fft_plan_cache_stats().plans, EIDSP_FFT_PLAN_CACHE_SIZE);
+}
+
+static void test_clear_releases_plans() {
+    rfft_512(512);
+    rfft_512(256);
+    numpy::fft_plan_cache_clear();
+    fft_plan_cache_stats_t cleared = numpy::fft_plan_cache_stats();
+    EI_TEST_EXPECT_EQ(cleared.plans, 0);
+    EI_TEST_EXPECT_EQ(cleared.bytes, 0);
+
+    // and works as before afterwards
+    test_rfft_matches_uncached();
+}
+
+int main() {
+    EI_TEST_RUN(test_rfft_matches_uncached);
+    EI_TEST_RUN(test_hits_and_misses);
+    EI_TEST_RUN(test_eviction);
+    EI_TEST_RUN(test_clear_releases_plans);
+    return ei_test_result();
+}
@@ -0,0 +1,271 @@
+/* EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES and EI_CLASSIFIER_TFLITE_FUSED_OPS: the graphs of the compiled
+ * model written by hand for them against the one the EON compiler generated, byte for byte, and the
+ * kernels the fused CONV_2D_MAX_POOL_2D node runs against arm_convolve_s8 followed by arm_max_pool_s8.
+ * Built with the DSP extension emulated (EI_CLASSIFIER_TFLITE_EMULATE_ARM_DSP) for the variant on
+ * EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS, arm_convolve_s8_reordered_max_pool_1x2.
+ *
+ * tflite_learn_5_compiled.cpp is built once per graph in this file, each in its own namespace: the
+ * logits, the input of the SOFTMAX, are only reachable from in there */
+
+// test-flags: -DEI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86=1 -DEI_CLASSIFIER_TFLITE_EMULATE_ARM_DSP=1 -DEI_CLASSIFIER_TFLITE_PACKED_WEIGHTS=1 -DEI_CLASSIFIER_TFLITE_ELIDE_RESHAPES=1 -DEI_CLASSIFIER_TFLITE_FUSED_OPS=1
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "ei_test_keyword.h"
+#include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+// what the model includes, so that none of it lands in the namespaces below
+#include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
+#include "edge-impulse-sdk/tensorflow/lite/c/common.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/classifier/ei_packed_weights.h"
+#include <vector>
+
+namespace fused_packed_graph {
+#include "../src/tflite-model/tflite_learn_5_compiled.cpp"
+}
+
+#undef EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+#define EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS 0
+
+namespace fused_graph {
+#include "../src/tflite-model/tflite_learn_5_compiled.cpp"
+}
+
+#undef EI_CLASSIFIER_TFLITE_FUSED_OPS
+#define EI_CLASSIFIER_TFLITE_FUSED_OPS 0
+
+namespace elided_graph {
+#include "../src/tflite-model/tflite_learn_5_compiled.cpp"
+}
+
+#undef EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES
+#define EI_CLASSIFIER_TFLITE_ELIDE_RESHAPES 0
+
+namespace generated_graph {
+#include "../src/tflite-model/tflite_learn_5_compiled.cpp"
+}
+
+struct model_t {
+    const char *name;
+    size_t node_count;
+    TfLiteStatus (*init)(void *(*)(size_t, size_t));
+    TfLiteStatus (*input)(int, TfLiteTensor *);
+    TfLiteStatus (*invoke)();
+    TfLiteStatus (*reset)(void (*)(void *));
+    // the input tensor of the last node, the SOFTMAX
+    void (*logits)(TfLiteTensor *);
+};
+
+#define MODEL(ns) { #ns, ns::kNodeCount, ns::tflite_learn_5_init, ns::tflite_learn_5_input, \
+    ns::tflite_learn_5_invoke, ns::tflite_learn_5_reset, [](TfLiteTensor *t) { \
+        ns::init_tflite_tensor(ns::tflNodes[ns::kNodeCount - 1].inputs->data[0], t); } }
+
+static const model_t generated_model = MODEL(generated_graph);
+static const model_t variants[] = { MODEL(elided_graph), MODEL(fused_graph), MODEL(fused_packed_graph) };
+
+static const int WINDOWS = 32;
+static const int RANDOM_INPUTS = 32;
+
+static std::vector<int8_t> rand_s8(size_t size) {
+    std::vector<int8_t> v(size);
+    for (auto &x : v) {
+        x = (int8_t)(ei_test_rand() & 0xff);
+    }
+    return v;
+}
+
+static void expect_same(const char *what, const std::vector<int8_t> &actual, const std::vector<int8_t> &expected) {
+    EI_TEST_EXPECT_EQ(actual.size(), expected.size());
+    for (size_t ix = 0; ix < std::min(actual.size(), expected.size()); ix++) {
+        if (actual[ix] != expected[ix]) {
+            printf("%s: [%u] is %d, expected %d\n", what, (unsigned)ix, actual[ix], expected[ix]);
+            ei_test_failures++;
+            return;
+        }
+    }
+}
+
+struct conv_layer_t {
+    cmsis_nn_conv_params params;
+    cmsis_nn_dims input_dims, filter_dims, bias_dims, conv_output_dims, output_dims;
+    std::vector<int8_t> input, filter;
+    std::vector<int32_t> bias, multiplier, shift;
+};
+
+// SAME padding for the convolution, `same_pool` for the pooling (VALID drops the last pixel of an
+// odd row)
+static conv_layer_t conv_layer(int32_t in_h, int32_t in_w, int32_t in_ch, int32_t out_ch, int32_t k_w,
+    bool same_pool) {
+    conv_layer_t layer;
+    layer.params = { };
+    layer.params.input_offset = (int32_t)(ei_test_rand() % 256) - 127;
+    layer.params.output_offset = (int32_t)(ei_test_rand() % 256) - 128;
+    layer.params.stride = { 1, 1 };
+    layer.params.padding = { k_w / 2, 0 };
+    layer.params.dilation = { 1, 1 };
+    layer.params.activation = { -128, 127 };
+    layer.input_dims = { 1, in_h, in_w, in_ch };
+    layer.filter_dims = { out_ch, 1, k_w, in_ch };
+    layer.bias_dims = { 1, 1, 1, out_ch };
+    layer.conv_output_dims = { 1, in_h, in_w, out_ch };
+    layer.output_dims = { 1, in_h, same_pool ? (in_w + 1) / 2 : in_w / 2, out_ch };
+    layer.input = rand_s8(in_h * in_w * in_ch);
+    layer.filter = rand_s8(out_ch * k_w * in_ch);
+    for (int32_t ch = 0; ch < out_ch; ch++) {
+        layer.bias.push_back((int32_t)(ei_test_rand() % 20001) - 10000);
+        layer.multiplier.push_back((int32_t)((1u << 30) + ei_test_rand() % (1u << 30)));
+        layer.shift.push_back(-8 - (int32_t)(ei_test_rand() % 3));
+    }
+    return layer;
+}
+
+static size_t flat_size(const cmsis_nn_dims &dims) {
+    return dims.n * dims.h * dims.w * dims.c;
+}
+
+// arm_convolve_s8, then arm_max_pool_s8 with a 1x2 filter and stride
+static std::vector<int8_t> convolve_then_pool(const conv_layer_t &layer) {
+    std::vector<int8_t> buffer(arm_convolve_s8_get_buffer_size(&layer.input_dims, &layer.filter_dims));
+    std::vector<int8_t> conv_output(flat_size(layer.conv_output_dims)), output(flat_size(layer.output_dims));
+    std::vector<int32_t> multiplier(layer.multiplier), shift(layer.shift);
+    cmsis_nn_context ctx = { buffer.data(), (int32_t)buffer.size() };
+    cmsis_nn_per_channel_quant_params quant = { multiplier.data(), shift.data() };
+    EI_TEST_EXPECT_EQ(arm_convolve_s8(&ctx, &layer.params, &quant, &layer.input_dims, layer.input.data(),
+        &layer.filter_dims, layer.filter.data(), &layer.bias_dims, layer.bias.data(), &layer.conv_output_dims,
+        conv_output.data()), ARM_CMSIS_NN_SUCCESS);
+
+    cmsis_nn_pool_params pool_params = { };
+    pool_params.stride = { 2, 1 };
+    pool_params.activation = { -128, 127 };
+    const cmsis_nn_dims pool_filter_dims = { 1, 1, 2, 1 };
+    cmsis_nn_context pool_ctx = { nullptr, 0 };
+    EI_TEST_EXPECT_EQ(arm_max_pool_s8(&pool_ctx, &pool_params, &layer.conv_output_dims, conv_output.data(),
+        &pool_filter_dims, &layer.output_dims, output.data()), ARM_CMSIS_NN_SUCCESS);
+    return output;
+}
+
+static std::vector<int8_t> convolve_max_pool(const conv_layer_t &layer, bool reordered) {
+    std::vector<int8_t> filter(layer.filter);
+    if (reordered) {
+        arm_convolve_s8_reorder_filter(&layer.filter_dims, layer.filter.data(), filter.data());
+    }
+    std::vector<int8_t> buffer(arm_convolve_s8_max_pool_1x2_get_buffer_size(&layer.input_dims,
+        &layer.filter_dims));
+    std::vector<int8_t> output(flat_size(layer.output_dims));
+    std::vector<int32_t> multiplier(layer.multiplier), shift(layer.shift);
+    cmsis_nn_context ctx = { buffer.data(), (int32_t)buffer.size() };
+    cmsis_nn_per_channel_quant_params quant = { multiplier.data(), shift.data() };
+    const arm_cmsis_nn_status status = (reordered ? arm_convolve_s8_reordered_max_pool_1x2 :
+        arm_convolve_s8_max_pool_1x2)(&ctx, &layer.params, &quant, &layer.input_dims, layer.input.data(),
+        &layer.filter_dims, filter.data(), &layer.bias_dims, layer.bias.data(), &layer.conv_output_dims,
+        &layer.output_dims, output.data());
+    EI_TEST_EXPECT_EQ(status, ARM_CMSIS_NN_SUCCESS);
+    return output;
+}
+
+static void test_convolve_max_pool() {
+    // { in_h, in_w, in_ch, out_ch, k_w, same_pool }: odd and even widths with both paddings (only even
+    // ones over more than one row), row lengths (k_w * in_ch) that aren't a multiple of 4
+    const int32_t layers[][6] = {
+        { 1, 49, 13, 8, 3, 1 },  // the keyword model's conv + pool pairs
+        { 1, 25, 8, 16, 3, 1 },
+        { 1, 25, 8, 16, 3, 0 },
+        { 1, 10, 3, 5, 1, 1 },
+        { 1, 7, 5, 3, 3, 0 },
+        { 1, 2, 4, 4, 3, 1 },
+        { 1, 1, 6, 2, 1, 1 },
+        { 4, 8, 5, 7, 3, 1 },
+        { 3, 6, 16, 9, 3, 0 },
+    };
+    for (const auto &l : layers) {
+        const conv_layer_t layer = conv_layer(l[0], l[1], l[2], l[3], l[4], l[5]);
+        char what[64];
+        snprintf(what, sizeof(what), "%dx%dx%d -> %d, 1x%d, %s pool", l[0], l[1], l[2], l[3], l[4],
+            l[5] ? "SAME" : "VALID");
+        const std::vector<int8_t> expected = convolve_then_pool(layer);
+        expect_same(what, convolve_max_pool(layer, false), expected);
+        expect_same(what, convolve_max_pool(layer, true), expected);
+    }
+}
+
+static void test_convolve_max_pool_rejects_split_pairs() {
+    // over more than one row an odd width would pair the last pixel of a row with the next row's first
+    conv_layer_t layer = conv_layer(2, 5, 4, 4, 3, true);
+    std::vector<int8_t> buffer(arm_convolve_s8_max_pool_1x2_get_buffer_size(&layer.input_dims,
+        &layer.filter_dims));
+    std::vector<int8_t> output(flat_size(layer.output_dims));
+    cmsis_nn_context ctx = { buffer.data(), (int32_t)buffer.size() };
+    cmsis_nn_per_channel_quant_params quant = { layer.multiplier.data(), layer.shift.data() };
+    EI_TEST_EXPECT_EQ(arm_convolve_s8_max_pool_1x2(&ctx, &layer.params, &quant, &layer.input_dims,
+        layer.input.data(), &layer.filter_dims, layer.filter.data(), &layer.bias_dims, layer.bias.data(),
+        &layer.conv_output_dims, &layer.output_dims, output.data()), ARM_CMSIS_NN_ARG_ERROR);
+}
+
+static std::vector<int8_t> model_input(const std::vector<float> &audio) {
+    std::vector<float> audio_copy(audio);
+    signal_t signal;
+    ei::numpy::signal_from_buffer(audio_copy.data(), audio_copy.size(), &signal);
+    ei::matrix_t matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    const ei_model_dsp_t &block = ei_default_impulse.dsp_blocks[0];
+    EI_TEST_EXPECT_EQ(block.extract_fn(&signal, &matrix, block.config, EI_CLASSIFIER_FREQUENCY), 0);
+
+    TfLiteTensor input;
+    generated_model.input(0, &input);
+    std::vector<int8_t> res(EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    for (size_t ix = 0; ix < res.size(); ix++) {
+        const float q = roundf(matrix.buffer[ix] / input.params.scale) + input.params.zero_point;
+        res[ix] = (int8_t)std::min(std::max(q, -128.0f), 127.0f);
+    }
+    return res;
+}
+
+static std::vector<int8_t> logits(const model_t &model, const std::vector<int8_t> &input) {
+    TfLiteTensor tensor;
+    model.input(0, &tensor);
+    std::copy(input.begin(), input.end(), tensor.data.int8);
+    EI_TEST_EXPECT_EQ(model.invoke(), kTfLiteOk);
+    model.logits(&tensor);
+    return std::vector<int8_t>(tensor.data.int8, tensor.data.int8 + EI_CLASSIFIER_LABEL_COUNT);
+}
+
+static void test_graphs_match_generated() {
+    // 4 RESHAPE nodes elided, then 2 CONV_2D + MAX_POOL_2D pairs fused
+    EI_TEST_EXPECT_EQ(generated_model.node_count, 11);
+    EI_TEST_EXPECT_EQ(variants[0].node_count, 6);
+    EI_TEST_EXPECT_EQ(variants[1].node_count, 4);
+    EI_TEST_EXPECT_EQ(variants[2].node_count, 4);
+
+    std::vector<std::vector<int8_t>> inputs;
+    for (int ix = 0; ix < WINDOWS; ix++) {
+        inputs.push_back(model_input(ei_test_keyword_audio(ix)));
+    }
+    for (int ix = 0; ix < RANDOM_INPUTS; ix++) {
+        inputs.push_back(rand_s8(EI_CLASSIFIER_NN_INPUT_FRAME_SIZE));
+    }
+    for (size_t ix = 0; ix < inputs.size(); ix++) {
+        const std::vector<int8_t> expected = logits(generated_model, inputs[ix]);
+        for (const model_t &variant : variants) {
+            char what[64];
+            snprintf(what, sizeof(what), "%s, input %u", variant.name, (unsigned)ix);
+            expect_same(what, logits(variant, inputs[ix]), expected);
+        }
+    }
+}
+
+int main() {
+    EI_TEST_RUN(test_convolve_max_pool);
+    EI_TEST_RUN(test_convolve_max_pool_rejects_split_pairs);
+    EI_TEST_EXPECT_EQ(generated_model.init(ei_aligned_calloc), kTfLiteOk);
+    for (const model_t &variant : variants) {
+        EI_TEST_EXPECT_EQ(variant.init(ei_aligned_calloc), kTfLiteOk);
+    }
+    EI_TEST_RUN(test_graphs_match_generated);
+    generated_model.reset(ei_aligned_free);
+    for (const model_t &variant : variants) {
+        variant.reset(ei_aligned_free);
+    }
+    return ei_test_result();
+}
@@ -0,0 +1,257 @@
+/* The gate cascade (EI_CLASSIFIER_HAS_GATE): a linear gate over the MFCC features in front of the
+ * keyword network, which then only runs on the windows the gate passes. There's no trained gate and no
+ * labelled keyword data in this repo, so the gate (model-parameters/gate_parameters.h next to this
+ * file) is fitted here to what the network says on the synthetic windows of ei_test_keyword.h. What's
+ * measured, at a few thresholds, is the recall of the cascade against the network alone and what a
+ * window costs on the host. The "sparkle" windows here differ from the others by small changes a
+ * linear gate hardly sees, so the recall is the cascade's on this data, not what a gate trained on the
+ * project's audio would give.
+ *
+ * The windows the network calls "sparkle" are searched for a byte of the input at a time, on the
+ * logits, the input of the SOFTMAX: those are only reachable from a copy of tflite_learn_5_compiled.cpp
+ * built in its own namespace in this file */
+
+#define EI_CLASSIFIER_HAS_GATE 1
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+#include "ei_test_keyword.h"
+// what the model includes, so that none of it lands in the namespace below
+#include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
+#include "edge-impulse-sdk/tensorflow/lite/c/common.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/classifier/ei_packed_weights.h"
+#include <vector>
+
+namespace keyword_model {
+#include "../src/tflite-model/tflite_learn_5_compiled.cpp"
+}
+
+// per set of windows, one to fit the gate on and one to measure it on
+static const int WINDOWS = 64;
+static const int SPARKLE_WINDOWS = 32;
+static const float SPARKLE_MARGIN = 1.0f;
+
+struct window_t {
+    std::vector<float> features;
+    // what the network on its own says
+    bool sparkle;
+};
+
+static TfLiteTensor model_input() {
+    TfLiteTensor tensor;
+    keyword_model::tflite_learn_5_input(0, &tensor);
+    return tensor;
+}
+
+static std::vector<int8_t> quantize(const std::vector<float> &features) {
+    const TfLiteTensor input = model_input();
+    std::vector<int8_t> res(features.size());
+    for (size_t ix = 0; ix < res.size(); ix++) {
+        const float q = roundf(features[ix] / input.params.scale) + input.params.zero_point;
+        res[ix] = (int8_t)std::min(std::max(q, -128.0f), 127.0f);
+    }
+    return res;
+}
+
+static std::vector<float> dequantize(const std::vector<int8_t> &input) {
+    const TfLiteTensor tensor = model_input();
+    std::vector<float> res(input.size());
+    for (size_t ix = 0; ix < res.size(); ix++) {
+        res[ix] = (input[ix] - tensor.params.zero_point) * tensor.params.scale;
+    }
+    return res;
+}
+
+// how far the network's logit of "sparkle" (label 0) is above the others
+static float sparkle_margin(const std::vector<int8_t> &input) {
+    TfLiteTensor tensor = model_input();
+    std::copy(input.begin(), input.end(), tensor.data.int8);
+    EI_TEST_EXPECT_EQ(keyword_model::tflite_learn_5_invoke(), kTfLiteOk);
+    keyword_model::init_tflite_tensor(keyword_model::tflNodes[keyword_model::kNodeCount - 1].inputs->data[0],
+        &tensor);
+    float others = -INFINITY;
+    for (int ix = 1; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+        others = std::max(others, (float)tensor.data.int8[ix]);
+    }
+    return (tensor.data.int8[0] - others) * tensor.params.scale;
+}
+
+// the cascade, or the network on its own if `gated` is false
+static ei_impulse_result_t classify(bool gated, const std::vector<float> &features, uint64_t *us) {
+    std::vector<float> copy(features);
+    ei::matrix_t matrix(1, copy.size(), copy.data());
+    ei_impulse_result_t result;
+    memset(&result, 0, sizeof(result));
+    const uint64_t start = ei_read_timer_us();
+    if (gated) {
+        EI_TEST_EXPECT_EQ(run_inference(&ei_default_impulse, &matrix, &result), EI_IMPULSE_OK);
+    }
+    else {
+        const ei_learning_block_t &block = ei_default_impulse.learning_blocks[1];
+        EI_TEST_EXPECT_EQ(block.infer_fn(&ei_default_impulse, &matrix, &result, block.config, false),
+            EI_IMPULSE_OK);
+    }
+    *us += ei_read_timer_us() - start;
+    return result;
+}
+
+static bool says_sparkle(const ei_impulse_result_t &result) {
+    for (int ix = 1; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+        if (result.classification[ix].value >= result.classification[0].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the features of the synthetic windows `first` up, and windows the network calls "sparkle" searched
+// for from the first of them
+static std::vector<window_t> windows(int first) {
+    std::vector<window_t> res;
+    for (int ix = first; ix < first + WINDOWS; ix++) {
+        std::vector<float> audio = ei_test_keyword_audio(ix);
+        signal_t signal;
+        ei::numpy::signal_from_buffer(audio.data(), audio.size(), &signal);
+        ei::matrix_t matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+        const ei_model_dsp_t &block = ei_default_impulse.dsp_blocks[0];
+        EI_TEST_EXPECT_EQ(block.extract_fn(&signal, &matrix, block.config, EI_CLASSIFIER_FREQUENCY), 0);
+        res.push_back({ std::vector<float>(matrix.buffer, matrix.buffer + matrix.cols), false });
+    }
+    for (int ix = 0; ix < SPARKLE_WINDOWS; ix++) {
+        const std::vector<int8_t> input = ei_test_keyword_search(quantize(res[ix].features), sparkle_margin,
+            SPARKLE_MARGIN);
+        res.push_back({ dequantize(input), false });
+    }
+
+    uint64_t us = 0;
+    for (window_t &window : res) {
+        window.sparkle = says_sparkle(classify(false, window.features, &us));
+    }
+    return res;
+}
+
+static float gate_score(const std::vector<float> &features) {
+    float logit = ei_learning_block_config_gate.bias;
+    for (size_t ix = 0; ix < features.size(); ix++) {
+        logit += ei_test_gate_weights[ix] * features[ix];
+    }
+    return 1.0f / (1.0f + expf(-logit));
+}
+
+// logistic regression of what the network says, the "sparkle" windows weighted up to as many as the
+// others
+static void fit_gate(const std::vector<window_t> &windows) {
+    int sparkle = 0;
+    for (const window_t &window : windows) {
+        sparkle += window.sparkle;
+    }
+    EI_TEST_EXPECT(sparkle > 0);
+    const float sparkle_weight = (float)(windows.size() - sparkle) / std::max(sparkle, 1);
+
+    std::vector<float> gradient(EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    const float rate = 0.5f, decay = 0.01f;
+    for (int epoch = 0; epoch < 1000; epoch++) {
+        std::fill(gradient.begin(), gradient.end(), 0.0f);
+        float bias_gradient = 0;
+        for (const window_t &window : windows) {
+            const float error = (gate_score(window.features) - window.sparkle) *
+                (window.sparkle ? sparkle_weight : 1.0f);
+            for (size_t ix = 0; ix < gradient.size(); ix++) {
+                gradient[ix] += error * window.features[ix];
+            }
+            bias_gradient += error;
+        }
+        for (size_t ix = 0; ix < gradient.size(); ix++) {
+            ei_test_gate_weights[ix] -= rate * (gradient[ix] / windows.size() + decay * ei_test_gate_weights[ix]);
+        }
+        ei_learning_block_config_gate.bias -= rate * bias_gradient / windows.size();
+    }
+
+}
+
+static void test_gate_cascade() {
+    fit_gate(windows(0));
+    const std::vector<window_t> measured = windows(WINDOWS);
+    const int runs = (int)measured.size();
+
+    std::vector<ei_impulse_result_t> alone;
+    uint64_t network_us = 0;
+    int sparkle = 0;
+    for (const window_t &window : measured) {
+        alone.push_back(classify(false, window.features, &network_us));
+        sparkle += window.sparkle;
+    }
+    EI_TEST_EXPECT(sparkle > 0);
+    printf("the network alone: %.1f us per window on the host, says sparkle in %d of %d windows\n",
+        (double)network_us / runs, sparkle, runs);
+
+    // low thresholds, the gate is only meant to take out what clearly isn't the keyword
+    int last_missed = 0, last_rejected = 0;
+    for (float threshold : { 0.01f, 0.05f, 0.1f, 0.25f, 0.5f }) {
+        ei_learning_block_config_gate.threshold = threshold;
+
+        int missed = 0, rejected = 0;
+        uint64_t cascade_us = 0, gate_us = 0, classification_us = 0;
+        for (size_t w = 0; w < measured.size(); w++) {
+            const ei_impulse_result_t gated = classify(true, measured[w].features, &cascade_us);
+            gate_us += gated.timing.gate_us;
+            classification_us += gated.timing.classification_us;
+
+            if (gated.gate_rejected) {
+                // the network didn't run, the result is the gate's
+                EI_TEST_EXPECT_EQ(gated.timing.classification_us, 0);
+                EI_TEST_EXPECT(gated.classification[0].value < ei_learning_block_config_gate.threshold);
+                EI_TEST_EXPECT(!says_sparkle(gated));
+            }
+            else {
+                for (int label = 0; label < EI_CLASSIFIER_LABEL_COUNT; label++) {
+                    EI_TEST_EXPECT_EQ(gated.classification[label].value, alone[w].classification[label].value);
+                }
+            }
+            missed += measured[w].sparkle && gated.gate_rejected;
+            rejected += gated.gate_rejected;
+        }
+
+        printf("threshold %.4f: network runs on %3d of %d windows, recall %5.1f%% of the network's; "
+            "%.1f us per window (gate %.2f us, network %.1f us)\n", ei_learning_block_config_gate.threshold,
+            runs - rejected, runs, 100.0 * (sparkle - missed) / sparkle, (double)cascade_us / runs,
+            (double)gate_us / runs, (double)classification_us / runs);
+        // a higher threshold only ever rejects more
+        EI_TEST_EXPECT(missed >= last_missed);
+        EI_TEST_EXPECT(rejected >= last_rejected);
+        last_missed = missed;
+        last_rejected = rejected;
+    }
+    EI_TEST_EXPECT(last_rejected > 0);
+}
+
+static void test_gate_in_run_classifier() {
+    // a window the gate rejects: the network's timing stays 0
+    ei_learning_block_config_gate.threshold = 2.0f;
+    std::vector<float> audio = ei_test_keyword_audio(0);
+    signal_t signal;
+    ei::numpy::signal_from_buffer(audio.data(), audio.size(), &signal);
+    ei_impulse_result_t result;
+    EI_TEST_EXPECT_EQ(run_classifier(&signal, &result), EI_IMPULSE_OK);
+    EI_TEST_EXPECT(result.gate_rejected);
+    EI_TEST_EXPECT_EQ(result.timing.classification_us, 0);
+
+    // and a window it passes after it, in the same result
+    ei_learning_block_config_gate.threshold = 0.0f;
+    ei::numpy::signal_from_buffer(audio.data(), audio.size(), &signal);
+    EI_TEST_EXPECT_EQ(run_classifier(&signal, &result), EI_IMPULSE_OK);
+    EI_TEST_EXPECT(!result.gate_rejected);
+    EI_TEST_EXPECT(result.timing.classification_us > 0);
+}
+
+int main() {
+    EI_TEST_EXPECT(ei_default_impulse.learning_blocks[0].infer_fn == run_linear_gate);
+    EI_TEST_EXPECT_EQ(keyword_model::tflite_learn_5_init(ei_aligned_calloc), kTfLiteOk);
+    EI_TEST_RUN(test_gate_cascade);
+    EI_TEST_RUN(test_gate_in_run_classifier);
+    keyword_model::tflite_learn_5_reset(ei_aligned_free);
+    return ei_test_result();
+}
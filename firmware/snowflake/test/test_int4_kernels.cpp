@@ -0,0 +1,260 @@
+/* The CMSIS-NN kernels on packed s4 weights (EI_CLASSIFIER_TFLITE_INT4_WEIGHTS) against their s8
+ * counterparts on the same weights unpacked, byte for byte, on random layers: arm_convolve_s4 and
+ * arm_convolve_s4_max_pool_1x2, arm_fully_connected_s4, and the arm_nn_mat_mult_kernel_s4_s16 and
+ * arm_nn_vec_mat_mult_t_s4 they run on. The rows of the packed weights are back to back, so odd
+ * row lengths start every other row halfway through a byte.
+ *
+ * These are the plain C loops of the s4 kernels; test_int4_kernels_dsp.cpp runs the same with the
+ * DSP extension emulated */
+
+// test-flags: -DEI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86=1
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_classifier_config.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+#include <algorithm>
+#include <vector>
+
+static const int LAYERS = 200;
+
+static int32_t rand_int(int32_t lo, int32_t hi) {
+    return lo + (int32_t)(ei_test_rand() % (uint32_t)(hi - lo + 1));
+}
+
+static std::vector<int8_t> rand_s8(size_t size) {
+    std::vector<int8_t> v(size);
+    for (auto &x : v) {
+        x = (int8_t)rand_int(-128, 127);
+    }
+    return v;
+}
+
+// s4 weights, the full range of a nibble
+static std::vector<int8_t> rand_s4(size_t size) {
+    std::vector<int8_t> v(size);
+    for (auto &x : v) {
+        x = (int8_t)rand_int(-8, 7);
+    }
+    return v;
+}
+
+// two per byte, the even element in the low nibble, a zero nibble after an odd count
+static std::vector<int8_t> pack_s4(const std::vector<int8_t> &weights) {
+    std::vector<int8_t> packed((weights.size() + 1) / 2);
+    for (size_t ix = 0; ix < weights.size(); ix++) {
+        packed[ix / 2] |= (int8_t)((weights[ix] & 0x0f) << (ix % 2 == 0 ? 0 : 4));
+    }
+    return packed;
+}
+
+static void rand_quant(int32_t depth, int32_t *multiplier, int32_t *shift) {
+    *multiplier = rand_int(1 << 30, 0x7fffffff);
+    *shift = -(int32_t)(4 + log2f((float)depth) / 2) + rand_int(-2, 1);
+}
+
+static cmsis_nn_activation rand_activation() {
+    cmsis_nn_activation activation = { -128, 127 };
+    if (rand_int(0, 2) == 0) {
+        activation.min = rand_int(-128, 0);
+        activation.max = rand_int(activation.min, 127);
+    }
+    return activation;
+}
+
+static bool expect_same(const char *name, int index, const std::vector<int8_t> &actual,
+    const std::vector<int8_t> &expected) {
+    for (size_t ix = 0; ix < expected.size(); ix++) {
+        if (actual[ix] != expected[ix]) {
+            printf("%s %d: output %u is %d, expected %d\n", name, index, (unsigned)ix, actual[ix], expected[ix]);
+            ei_test_failures++;
+            return false;
+        }
+    }
+    return true;
+}
+
+struct conv_layer_t {
+    cmsis_nn_conv_params params;
+    cmsis_nn_dims input_dims, filter_dims, bias_dims, output_dims, pool_output_dims;
+    std::vector<int8_t> input, filter;
+    std::vector<int32_t> bias, multiplier, shift;
+};
+
+// with `pooled`, one the 1x2 max pool can follow: stride 1, SAME padding across, a single row or an
+// even width
+static conv_layer_t rand_conv_layer(bool pooled) {
+    conv_layer_t layer;
+    const int32_t in_h = pooled && rand_int(0, 1) ? 1 : rand_int(1, 8);
+    int32_t in_w = rand_int(1, 12);
+    if (pooled && in_h > 1) {
+        in_w += in_w % 2;
+    }
+    const int32_t in_ch = rand_int(1, 20), out_ch = rand_int(1, 20);
+    const int32_t k_h = pooled ? 1 : rand_int(1, std::min(in_h, 3)), k_w = rand_int(1, std::min(in_w, 5)) | 1;
+    const int32_t stride = pooled ? 1 : rand_int(1, 2);
+    const int32_t pad_h = k_h / 2, pad_w = k_w / 2;
+    const int32_t out_h = (in_h + 2 * pad_h - k_h) / stride + 1, out_w = (in_w + 2 * pad_w - k_w) / stride + 1;
+
+    layer.params.input_offset = rand_int(-127, 128);
+    layer.params.output_offset = rand_int(-128, 127);
+    layer.params.stride = { stride, stride };
+    layer.params.padding = { pad_w, pad_h };
+    layer.params.dilation = { 1, 1 };
+    layer.params.activation = rand_activation();
+    layer.input_dims = { 1, in_h, in_w, in_ch };
+    layer.filter_dims = { out_ch, k_h, k_w, in_ch };
+    layer.bias_dims = { 1, 1, 1, out_ch };
+    layer.output_dims = { 1, out_h, out_w, out_ch };
+    layer.pool_output_dims = { 1, out_h, rand_int(0, 1) ? (out_w + 1) / 2 : out_w / 2, out_ch };
+    layer.input = rand_s8(in_h * in_w * in_ch);
+    layer.filter = rand_s4(out_ch * k_h * k_w * in_ch);
+    for (int32_t ch = 0; ch < out_ch; ch++) {
+        layer.bias.push_back(rand_int(-2000, 2000));
+        layer.multiplier.push_back(0);
+        layer.shift.push_back(0);
+        rand_quant(k_h * k_w * in_ch, &layer.multiplier[ch], &layer.shift[ch]);
+    }
+    return layer;
+}
+
+static void test_convolve_s4() {
+    for (int ix = 0; ix < LAYERS; ix++) {
+        conv_layer_t layer = rand_conv_layer(false);
+        const std::vector<int8_t> packed = pack_s4(layer.filter);
+        std::vector<int8_t> buffer(arm_convolve_s8_get_buffer_size(&layer.input_dims, &layer.filter_dims));
+        cmsis_nn_context ctx = { buffer.data(), (int32_t)buffer.size() };
+        cmsis_nn_per_channel_quant_params quant = { layer.multiplier.data(), layer.shift.data() };
+        const size_t output_size = layer.output_dims.h * layer.output_dims.w * layer.output_dims.c;
+        std::vector<int8_t> expected(output_size), actual(output_size, 0x55);
+
+        EI_TEST_EXPECT_EQ(arm_convolve_s8(&ctx, &layer.params, &quant, &layer.input_dims, layer.input.data(),
+            &layer.filter_dims, layer.filter.data(), &layer.bias_dims, layer.bias.data(), &layer.output_dims,
+            expected.data()), ARM_CMSIS_NN_SUCCESS);
+        EI_TEST_EXPECT_EQ(arm_convolve_s4(&ctx, &layer.params, &quant, &layer.input_dims, layer.input.data(),
+            &layer.filter_dims, packed.data(), &layer.bias_dims, layer.bias.data(), &layer.output_dims,
+            actual.data()), ARM_CMSIS_NN_SUCCESS);
+        if (!expect_same("convolve_s4", ix, actual, expected)) {
+            return;
+        }
+    }
+}
+
+static void test_convolve_s4_max_pool_1x2() {
+    for (int ix = 0; ix < LAYERS; ix++) {
+        conv_layer_t layer = rand_conv_layer(true);
+        const std::vector<int8_t> packed = pack_s4(layer.filter);
+        std::vector<int8_t> buffer(arm_convolve_s8_max_pool_1x2_get_buffer_size(&layer.input_dims,
+            &layer.filter_dims));
+        cmsis_nn_context ctx = { buffer.data(), (int32_t)buffer.size() };
+        cmsis_nn_per_channel_quant_params quant = { layer.multiplier.data(), layer.shift.data() };
+        const size_t output_size = layer.pool_output_dims.h * layer.pool_output_dims.w * layer.pool_output_dims.c;
+        std::vector<int8_t> expected(output_size), actual(output_size, 0x55);
+
+        EI_TEST_EXPECT_EQ(arm_convolve_s8_max_pool_1x2(&ctx, &layer.params, &quant, &layer.input_dims,
+            layer.input.data(), &layer.filter_dims, layer.filter.data(), &layer.bias_dims, layer.bias.data(),
+            &layer.output_dims, &layer.pool_output_dims, expected.data()), ARM_CMSIS_NN_SUCCESS);
+        EI_TEST_EXPECT_EQ(arm_convolve_s4_max_pool_1x2(&ctx, &layer.params, &quant, &layer.input_dims,
+            layer.input.data(), &layer.filter_dims, packed.data(), &layer.bias_dims, layer.bias.data(),
+            &layer.output_dims, &layer.pool_output_dims, actual.data()), ARM_CMSIS_NN_SUCCESS);
+        if (!expect_same("convolve_s4_max_pool_1x2", ix, actual, expected)) {
+            return;
+        }
+    }
+}
+
+// two im2col columns against every row of weights, as the convolutions call it
+static void test_mat_mult_kernel_s4_s16() {
+    for (int ix = 0; ix < LAYERS; ix++) {
+        const uint16_t num_col = (uint16_t)rand_int(1, 70), rows = (uint16_t)rand_int(1, 20);
+        const std::vector<int8_t> filter = rand_s4(rows * num_col), packed = pack_s4(filter);
+        std::vector<int16_t> columns(2 * num_col);
+        for (auto &c : columns) {
+            c = (int16_t)rand_int(-255, 255);
+        }
+        std::vector<int32_t> bias(rows), multiplier(rows), shift(rows);
+        for (int32_t row = 0; row < rows; row++) {
+            bias[row] = rand_int(-2000, 2000);
+            rand_quant(num_col, &multiplier[row], &shift[row]);
+        }
+        const int32_t out_offset = rand_int(-128, 127);
+        const cmsis_nn_activation activation = rand_activation();
+
+        std::vector<int8_t> expected(2 * rows), actual(2 * rows, 0x55);
+        const int8_t *expected_end = arm_nn_mat_mult_kernel_s8_s16(filter.data(), columns.data(), rows,
+            shift.data(), multiplier.data(), out_offset, activation.min, activation.max, num_col, bias.data(),
+            expected.data());
+        const int8_t *actual_end = arm_nn_mat_mult_kernel_s4_s16(packed.data(), columns.data(), rows, shift.data(),
+            multiplier.data(), out_offset, activation.min, activation.max, num_col, bias.data(), actual.data());
+        EI_TEST_EXPECT(actual_end - actual.data() == expected_end - expected.data());
+        if (!expect_same("mat_mult_kernel_s4_s16", ix, actual, expected)) {
+            return;
+        }
+    }
+}
+
+static void test_vec_mat_mult_t_s4() {
+    for (int ix = 0; ix < LAYERS; ix++) {
+        const int32_t cols = rand_int(1, 300), rows = rand_int(1, 40);
+        const std::vector<int8_t> lhs = rand_s8(cols), rhs = rand_s4(rows * cols), packed = pack_s4(rhs);
+        std::vector<int32_t> bias(rows);
+        for (auto &b : bias) {
+            b = rand_int(-5000, 5000);
+        }
+        int32_t multiplier, shift;
+        rand_quant(cols, &multiplier, &shift);
+        const int32_t lhs_offset = rand_int(-127, 128), dst_offset = rand_int(-128, 127);
+        const cmsis_nn_activation activation = rand_activation();
+
+        std::vector<int8_t> expected(rows), actual(rows, 0x55);
+        EI_TEST_EXPECT_EQ(arm_nn_vec_mat_mult_t_s8(lhs.data(), rhs.data(), bias.data(), expected.data(), lhs_offset,
+            0, dst_offset, multiplier, shift, cols, rows, activation.min, activation.max, 1), ARM_CMSIS_NN_SUCCESS);
+        EI_TEST_EXPECT_EQ(arm_nn_vec_mat_mult_t_s4(lhs.data(), packed.data(), bias.data(), actual.data(), lhs_offset,
+            dst_offset, multiplier, shift, cols, rows, activation.min, activation.max), ARM_CMSIS_NN_SUCCESS);
+        if (!expect_same("vec_mat_mult_t_s4", ix, actual, expected)) {
+            return;
+        }
+    }
+}
+
+static void test_fully_connected_s4() {
+    for (int ix = 0; ix < LAYERS; ix++) {
+        const int32_t batches = rand_int(1, 3), depth = rand_int(1, 300), out_ch = rand_int(1, 40);
+        cmsis_nn_fc_params params = { };
+        params.input_offset = rand_int(-127, 128);
+        params.output_offset = rand_int(-128, 127);
+        params.activation = rand_activation();
+        cmsis_nn_per_tensor_quant_params quant;
+        rand_quant(depth, &quant.multiplier, &quant.shift);
+        const cmsis_nn_dims input_dims = { batches, 1, 1, depth };
+        const cmsis_nn_dims filter_dims = { depth, 1, 1, out_ch };
+        const cmsis_nn_dims bias_dims = { 1, 1, 1, out_ch };
+        const cmsis_nn_dims output_dims = { batches, 1, 1, out_ch };
+        const std::vector<int8_t> input = rand_s8(batches * depth);
+        const std::vector<int8_t> filter = rand_s4(depth * out_ch), packed = pack_s4(filter);
+        std::vector<int32_t> bias(out_ch);
+        for (auto &b : bias) {
+            b = rand_int(-5000, 5000);
+        }
+        std::vector<int8_t> buffer(arm_fully_connected_s8_get_buffer_size(&filter_dims) + 16);
+        cmsis_nn_context ctx = { buffer.data(), (int32_t)buffer.size() };
+
+        std::vector<int8_t> expected(batches * out_ch), actual(batches * out_ch, 0x55);
+        EI_TEST_EXPECT_EQ(arm_fully_connected_s8(&ctx, &params, &quant, &input_dims, input.data(), &filter_dims,
+            filter.data(), &bias_dims, bias.data(), &output_dims, expected.data()), ARM_CMSIS_NN_SUCCESS);
+        EI_TEST_EXPECT_EQ(arm_fully_connected_s4(&ctx, &params, &quant, &input_dims, input.data(), &filter_dims,
+            packed.data(), &bias_dims, bias.data(), &output_dims, actual.data()), ARM_CMSIS_NN_SUCCESS);
+        if (!expect_same("fully_connected_s4", ix, actual, expected)) {
+            return;
+        }
+    }
+}
+
+int main() {
+    EI_TEST_RUN(test_convolve_s4);
+    EI_TEST_RUN(test_convolve_s4_max_pool_1x2);
+    EI_TEST_RUN(test_mat_mult_kernel_s4_s16);
+    EI_TEST_RUN(test_vec_mat_mult_t_s4);
+    EI_TEST_RUN(test_fully_connected_s4);
+    return ei_test_result();
+}
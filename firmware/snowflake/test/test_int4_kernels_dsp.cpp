@@ -0,0 +1,6 @@
+/* test_int4_kernels.cpp on the DSP extension paths of the s4 kernels, the ones Cortex-M4 / M33
+ * devices run, with the extension emulated (EI_CLASSIFIER_TFLITE_EMULATE_ARM_DSP) */
+
+// test-flags: -DEI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86=1 -DEI_CLASSIFIER_TFLITE_EMULATE_ARM_DSP=1 -DEI_CLASSIFIER_TFLITE_PACKED_WEIGHTS=1
+
+#include "test_int4_kernels.cpp"
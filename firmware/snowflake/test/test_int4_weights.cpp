@@ -0,0 +1,168 @@
+/* EI_CLASSIFIER_TFLITE_INT4_WEIGHTS against the int8 model it's requantized from. The int4 tables
+ * are the int8 ones rounded to [-7, 7] by tools/eon_weight_tables.py, not retrained, and there's no
+ * labelled keyword data in this repo, so this is not an accuracy: only how often the int4 model
+ * picks the int8 model's label, how far its logits are, and what each costs on the host.
+ *
+ * The synthetic windows of ei_test_keyword.h are all "unknown" to the model, so windows the int8
+ * model calls "sparkle" are searched for from them, a byte of the input at a time.
+ *
+ * tflite_learn_5_compiled.cpp is built twice in this file, with and without int4 weights, each in
+ * its own namespace: the logits, the input of the SOFTMAX, are only reachable from in there */
+
+#define EI_CLASSIFIER_TFLITE_INT4_WEIGHTS 1
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "ei_test_keyword.h"
+#include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+// what the model includes, so that none of it lands in the namespaces below
+#include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
+#include "edge-impulse-sdk/tensorflow/lite/c/common.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/classifier/ei_packed_weights.h"
+#include <vector>
+
+namespace int4_weights {
+#include "../src/tflite-model/tflite_learn_5_compiled.cpp"
+}
+
+#undef EI_CLASSIFIER_TFLITE_INT4_WEIGHTS
+#define EI_CLASSIFIER_TFLITE_INT4_WEIGHTS 0
+
+namespace int8_weights {
+#include "../src/tflite-model/tflite_learn_5_compiled.cpp"
+}
+
+struct model_t {
+    const char *name;
+    TfLiteStatus (*init)(void *(*)(size_t, size_t));
+    TfLiteStatus (*input)(int, TfLiteTensor *);
+    TfLiteStatus (*invoke)();
+    TfLiteStatus (*reset)(void (*)(void *));
+    // the input tensor of the last node, the SOFTMAX
+    void (*logits)(TfLiteTensor *);
+};
+
+#define MODEL(ns) { #ns, ns::tflite_learn_5_init, ns::tflite_learn_5_input, ns::tflite_learn_5_invoke, \
+    ns::tflite_learn_5_reset, [](TfLiteTensor *t) { \
+        ns::init_tflite_tensor(ns::tflNodes[ns::kNodeCount - 1].inputs->data[0], t); } }
+
+static const model_t int8_model = MODEL(int8_weights);
+static const model_t int4_model = MODEL(int4_weights);
+
+static const int WINDOWS = 64;
+// "sparkle" windows searched for, and how far past the int8 model's decision they're taken
+static const int SPARKLE_WINDOWS = 16;
+static const float SPARKLE_MARGIN = 1.0f;
+
+// the window's MFCC features quantized to the model input, as run_classifier gives them
+static std::vector<int8_t> model_input(const std::vector<float> &audio) {
+    std::vector<float> audio_copy(audio);
+    signal_t signal;
+    ei::numpy::signal_from_buffer(audio_copy.data(), audio_copy.size(), &signal);
+    ei::matrix_t matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    const ei_model_dsp_t &block = ei_default_impulse.dsp_blocks[0];
+    EI_TEST_EXPECT_EQ(block.extract_fn(&signal, &matrix, block.config, EI_CLASSIFIER_FREQUENCY), 0);
+
+    TfLiteTensor input;
+    int8_model.input(0, &input);
+    std::vector<int8_t> res(EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    for (size_t ix = 0; ix < res.size(); ix++) {
+        const float q = roundf(matrix.buffer[ix] / input.params.scale) + input.params.zero_point;
+        res[ix] = (int8_t)std::min(std::max(q, -128.0f), 127.0f);
+    }
+    return res;
+}
+
+// dequantized logits of `model` on `input`
+static std::vector<float> logits(const model_t &model, const std::vector<int8_t> &input) {
+    TfLiteTensor tensor;
+    model.input(0, &tensor);
+    std::copy(input.begin(), input.end(), tensor.data.int8);
+    EI_TEST_EXPECT_EQ(model.invoke(), kTfLiteOk);
+    model.logits(&tensor);
+    std::vector<float> res(EI_CLASSIFIER_LABEL_COUNT);
+    for (size_t ix = 0; ix < res.size(); ix++) {
+        res[ix] = (tensor.data.int8[ix] - tensor.params.zero_point) * tensor.params.scale;
+    }
+    return res;
+}
+
+static size_t top1(const std::vector<float> &scores) {
+    return std::max_element(scores.begin(), scores.end()) - scores.begin();
+}
+
+// how far the int8 model's logit of "sparkle" (label 0) is above the others
+static float sparkle_margin(const std::vector<int8_t> &input) {
+    const std::vector<float> l = logits(int8_model, input);
+    return l[0] - *std::max_element(l.begin() + 1, l.end());
+}
+
+static void test_int4_arena() {
+    // the int4 filters go to int8 scratch buffers on the reference kernels: all in the arena
+    using namespace int4_weights;
+    EI_TEST_EXPECT_EQ(overflow_buffers_ix, 0);
+    const size_t used = (tensor_boundary - tensor_arena) + (tensor_arena + kTensorArenaSize - current_location);
+    printf("int4 arena %u of %d bytes\n", (unsigned)used, kTensorArenaSize);
+    EI_TEST_EXPECT(used <= (size_t)kTensorArenaSize);
+    EI_TEST_EXPECT(kTensorArenaSize <= EI_CLASSIFIER_TFLITE_LARGEST_ARENA_SIZE);
+}
+
+static void test_int4_agrees_with_int8() {
+    std::vector<std::vector<int8_t>> inputs;
+    for (int ix = 0; ix < WINDOWS; ix++) {
+        inputs.push_back(model_input(ei_test_keyword_audio(ix)));
+    }
+    for (int ix = 0; ix < SPARKLE_WINDOWS; ix++) {
+        inputs.push_back(ei_test_keyword_search(inputs[ix], sparkle_margin, SPARKLE_MARGIN));
+    }
+
+    std::vector<int> int8_labels(EI_CLASSIFIER_LABEL_COUNT), agree(EI_CLASSIFIER_LABEL_COUNT);
+    float max_diff = 0, sum_diff = 0;
+    for (const std::vector<int8_t> &input : inputs) {
+        const std::vector<float> int8_logits = logits(int8_model, input);
+        const std::vector<float> int4_logits = logits(int4_model, input);
+        int8_labels[top1(int8_logits)]++;
+        agree[top1(int8_logits)] += top1(int8_logits) == top1(int4_logits);
+        for (size_t label = 0; label < int8_logits.size(); label++) {
+            const float diff = fabsf(int8_logits[label] - int4_logits[label]);
+            max_diff = std::max(max_diff, diff);
+            sum_diff += diff;
+        }
+    }
+
+    const float mean_diff = sum_diff / (inputs.size() * EI_CLASSIFIER_LABEL_COUNT);
+    printf("logit difference mean %.3f max %.3f\n", mean_diff, max_diff);
+    for (size_t label = 0; label < int8_labels.size(); label++) {
+        printf("  int8 says %s in %d windows, int4 agrees in %d\n", ei_classifier_inferencing_categories[label],
+            int8_labels[label], agree[label]);
+        EI_TEST_EXPECT(int8_labels[label] > 0);
+        EI_TEST_EXPECT(agree[label] >= int8_labels[label] * 9 / 10);
+    }
+    EI_TEST_EXPECT(mean_diff <= 0.5f);
+}
+
+static void test_int4_latency() {
+    const std::vector<int8_t> input = model_input(ei_test_keyword_audio(1));
+    const int runs = 2000;
+    for (const model_t *model : { &int8_model, &int4_model }) {
+        logits(*model, input);
+        const uint64_t start = ei_read_timer_us();
+        for (int run = 0; run < runs; run++) {
+            model->invoke();
+        }
+        printf("%s invoke %.1f us on the host\n", model->name, (double)(ei_read_timer_us() - start) / runs);
+    }
+}
+
+int main() {
+    EI_TEST_EXPECT_EQ(int8_model.init(ei_aligned_calloc), kTfLiteOk);
+    EI_TEST_EXPECT_EQ(int4_model.init(ei_aligned_calloc), kTfLiteOk);
+    EI_TEST_RUN(test_int4_arena);
+    EI_TEST_RUN(test_int4_agrees_with_int8);
+    EI_TEST_RUN(test_int4_latency);
+    int8_model.reset(ei_aligned_free);
+    int4_model.reset(ei_aligned_free);
+    return ei_test_result();
+}
@@ -0,0 +1,60 @@
+/* EI_CLASSIFIER_MEMORY_PLAN with the firmware's settings (build.mk): the keyword model's DSP and
+ * tensor arena fit in the plan, and a tensor arena that doesn't goes to the heap */
+
+// test-flags: -DEIDSP_ARENA_SIZE=32768 -DEI_CLASSIFIER_MEMORY_PLAN=1
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include <vector>
+
+static void test_keyword_model_fits() {
+    std::vector<float> audio(EI_CLASSIFIER_SLICE_SIZE * 8);
+    for (size_t ix = 0; ix < audio.size(); ix++) {
+        audio[ix] = 6000.0f * sinf(ix * 0.05f + sinf(ix * 0.0005f) * 30) + ei_test_uniform(-800.0f, 800.0f);
+    }
+
+    ei_classifier_context_t ctx = { };
+    run_classifier_init(&ctx, &ei_default_impulse);
+    for (size_t slice = 0; slice < audio.size() / EI_CLASSIFIER_SLICE_SIZE; slice++) {
+        signal_t signal;
+        ei::numpy::signal_from_buffer(audio.data() + slice * EI_CLASSIFIER_SLICE_SIZE, EI_CLASSIFIER_SLICE_SIZE, &signal);
+        ei_impulse_result_t result;
+        EI_TEST_EXPECT_EQ(run_classifier_continuous(&ctx, &ei_default_impulse, &signal, &result), EI_IMPULSE_OK);
+    }
+    run_classifier_deinit(&ctx);
+
+    // EIDSP_ARENA_SIZE is set by hand: the DSP has to fit in it, and so does the tensor arena
+    const ei::memory::arena_stats_t stats = ei::memory::arena_stats();
+    printf("plan %u bytes, peak %u bytes (DSP phase %u, inference phase %u)\n", (unsigned)stats.size,
+        (unsigned)stats.peak, (unsigned)ei::memory_plan::dsp_phase_size,
+        (unsigned)ei::memory_plan::inference_phase_size);
+    EI_TEST_EXPECT_EQ(stats.size, ei::memory_plan::total_size);
+    EI_TEST_EXPECT_EQ(stats.fallbacks, 0);
+    EI_TEST_EXPECT(stats.peak <= (size_t)EIDSP_ARENA_SIZE);
+}
+
+static void test_tensor_arena_spill() {
+    ei::memory::arena_scope scope;
+
+    void *fits = ei_tensor_arena_calloc(16, 1024);
+    EI_TEST_EXPECT(ei::memory::arena_owns(fits));
+    EI_TEST_EXPECT((uintptr_t)fits % 16 == 0);
+
+    // too large for the plan: on the heap, with a warning
+    const size_t fallbacks = ei::memory::arena_stats().fallbacks;
+    void *spilled = ei_tensor_arena_calloc(16, ei::memory_plan::total_size);
+    EI_TEST_EXPECT(spilled != nullptr);
+    EI_TEST_EXPECT(!ei::memory::arena_owns(spilled));
+    EI_TEST_EXPECT_EQ(ei::memory::arena_stats().fallbacks, fallbacks + 1);
+
+    ei_tensor_arena_free(spilled);
+    ei_tensor_arena_free(fits);
+}
+
+int main() {
+    run_classifier_init();
+    EI_TEST_RUN(test_keyword_model_fits);
+    EI_TEST_RUN(test_tensor_arena_spill);
+    run_classifier_deinit();
+    return ei_test_result();
+}
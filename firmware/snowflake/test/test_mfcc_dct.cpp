@@ -0,0 +1,104 @@
+/* numpy::dct2_truncated (the precomputed DCT-II basis MFCC uses) against the full FFT based dct2 */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+#include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
+#include <vector>
+
+using namespace ei;
+
+// dct2_truncated against dct2 over the full row, cut to the first K coefficients
+static void check_truncated(size_t rows, size_t N, size_t K, DCT_NORMALIZATION_MODE normalization) {
+    matrix_t input(rows, N);
+    matrix_t full(rows, N);
+    matrix_t truncated(rows, K);
+    for (size_t ix = 0; ix < rows * N; ix++) {
+        input.buffer[ix] = full.buffer[ix] = ei_test_uniform(-10.0f, 10.0f);
+    }
+
+    EI_TEST_EXPECT_EQ(numpy::dct2(&full, normalization), EIDSP_OK);
+    EI_TEST_EXPECT_EQ(numpy::dct2_truncated(&input, &truncated, normalization), EIDSP_OK);
+
+    // the FFT based dct2 runs in float, the basis is calculated in double
+    const float tolerance = normalization == DCT_NORMALIZATION_ORTHO ? 1e-4f : 1e-3f;
+    for (size_t row = 0; row < rows; row++) {
+        for (size_t k = 0; k < K; k++) {
+            EI_TEST_EXPECT_NEAR(truncated.buffer[row * K + k], full.buffer[row * N + k], tolerance);
+        }
+    }
+}
+
+static void test_dct2_truncated_ortho() {
+    check_truncated(49, 32, 13, DCT_NORMALIZATION_ORTHO);
+    check_truncated(1, 40, 13, DCT_NORMALIZATION_ORTHO);
+    check_truncated(7, 16, 16, DCT_NORMALIZATION_ORTHO);
+    check_truncated(3, 32, 1, DCT_NORMALIZATION_ORTHO);
+}
+
+static void test_dct2_truncated_unnormalized() {
+    check_truncated(49, 32, 13, DCT_NORMALIZATION_NONE);
+    check_truncated(5, 64, 20, DCT_NORMALIZATION_NONE);
+}
+
+// the basis is cached, so switching between sizes and normalizations has to rebuild it
+static void test_dct2_basis_follows_config() {
+    for (int round = 0; round < 3; round++) {
+        check_truncated(4, 32, 13, DCT_NORMALIZATION_ORTHO);
+        check_truncated(4, 32, 13, DCT_NORMALIZATION_NONE);
+        check_truncated(4, 40, 13, DCT_NORMALIZATION_ORTHO);
+        check_truncated(4, 40, 10, DCT_NORMALIZATION_ORTHO);
+    }
+}
+
+static void test_dct2_truncated_size_mismatch() {
+    matrix_t input(4, 32);
+    matrix_t wider(4, 33);
+    matrix_t other_rows(5, 13);
+    EI_TEST_EXPECT_EQ(numpy::dct2_truncated(&input, &wider), EIDSP_MATRIX_SIZE_MISMATCH);
+    EI_TEST_EXPECT_EQ(numpy::dct2_truncated(&input, &other_rows), EIDSP_MATRIX_SIZE_MISMATCH);
+}
+
+// MFCC of the keyword model against the path it replaced: mfe, log, full dct2 per row, keep the
+// first num_cepstral and put the log energy in coefficient 0
+static void test_mfcc_matches_full_dct() {
+    const uint32_t frequency = 16000;
+    const float frame_length = 0.025f, frame_stride = 0.02f;
+    const uint16_t num_filters = 32, fft_length = 512, version = 4;
+    const uint8_t num_cepstral = 13;
+
+    std::vector<float> audio(frequency);
+    for (size_t ix = 0; ix < audio.size(); ix++) {
+        audio[ix] = 3000.0f * sinf(ix * 0.05f + sinf(ix * 0.0003f) * 20) + ei_test_uniform(-500.0f, 500.0f);
+    }
+    signal_t signal;
+    numpy::signal_from_buffer(audio.data(), audio.size(), &signal);
+
+    matrix_size_t size = speechpy::feature::calculate_mfcc_buffer_size(audio.size(), frequency,
+        frame_length, frame_stride, num_cepstral, version);
+    matrix_t mfcc(size.rows, size.cols);
+    EI_TEST_EXPECT_EQ(speechpy::feature::mfcc(&mfcc, &signal, frequency, frame_length, frame_stride,
+        num_cepstral, num_filters, fft_length, 80, 0, true, version), EIDSP_OK);
+
+    matrix_t mfe(size.rows, num_filters);
+    matrix_t energy(size.rows, 1);
+    EI_TEST_EXPECT_EQ(speechpy::feature::mfe(&mfe, &energy, &signal, frequency, frame_length,
+        frame_stride, num_filters, fft_length, 80, 0, version), EIDSP_OK);
+    EI_TEST_EXPECT_EQ(numpy::log(&mfe), EIDSP_OK);
+    EI_TEST_EXPECT_EQ(numpy::dct2(&mfe, DCT_NORMALIZATION_ORTHO), EIDSP_OK);
+
+    for (size_t row = 0; row < size.rows; row++) {
+        EI_TEST_EXPECT_NEAR(mfcc.buffer[row * num_cepstral], numpy::log(energy.buffer[row]), 1e-4);
+        for (size_t k = 1; k < num_cepstral; k++) {
+            EI_TEST_EXPECT_NEAR(mfcc.buffer[row * num_cepstral + k], mfe.buffer[row * num_filters + k], 1e-3);
+        }
+    }
+}
+
+int main() {
+    EI_TEST_RUN(test_dct2_truncated_ortho);
+    EI_TEST_RUN(test_dct2_truncated_unnormalized);
+    EI_TEST_RUN(test_dct2_basis_follows_config);
+    EI_TEST_RUN(test_dct2_truncated_size_mismatch);
+    EI_TEST_RUN(test_mfcc_matches_full_dct);
+    return ei_test_result();
+}
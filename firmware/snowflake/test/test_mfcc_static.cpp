@@ -0,0 +1,89 @@
+/* speechpy::mfcc_static, which ei_dsp_mfcc runs for the EI_DSP_PARAMS_MFCC_* block of model_metadata.h,
+ * against the generic speechpy::feature::mfcc: bit for bit, over whole windows and the slices of
+ * continuous classification. And the EI_DSP_PARAMS_MFCC_* against the block in model_variables.h, which
+ * a re-export changes: if they don't agree the firmware silently runs the generic MFCC */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include <vector>
+
+using namespace ei;
+
+static const ei_dsp_config_mfcc_t *model_config() {
+    return (const ei_dsp_config_mfcc_t *)ei_default_impulse.dsp_blocks[0].config;
+}
+
+static void test_params_match_model() {
+    const ei_dsp_config_mfcc_t *config = model_config();
+    EI_TEST_EXPECT(ei_default_impulse.dsp_blocks[0].extract_fn == extract_mfcc_features);
+    EI_TEST_EXPECT_EQ(ei_default_impulse.frequency, EI_CLASSIFIER_FREQUENCY);
+    EI_TEST_EXPECT_EQ(config->implementation_version, EI_DSP_PARAMS_MFCC_IMPLEMENTATION_VERSION);
+    EI_TEST_EXPECT_EQ(config->num_cepstral, EI_DSP_PARAMS_MFCC_NUM_CEPSTRAL);
+    EI_TEST_EXPECT_EQ(config->frame_length, EI_DSP_PARAMS_MFCC_FRAME_LENGTH);
+    EI_TEST_EXPECT_EQ(config->frame_stride, EI_DSP_PARAMS_MFCC_FRAME_STRIDE);
+    EI_TEST_EXPECT_EQ(config->num_filters, EI_DSP_PARAMS_MFCC_NUM_FILTERS);
+    EI_TEST_EXPECT_EQ(config->fft_length, EI_DSP_PARAMS_MFCC_FFT_LENGTH);
+    EI_TEST_EXPECT_EQ(config->win_size, EI_DSP_PARAMS_MFCC_WIN_SIZE);
+    EI_TEST_EXPECT_EQ(config->low_frequency, EI_DSP_PARAMS_MFCC_LOW_FREQUENCY);
+    EI_TEST_EXPECT_EQ(config->high_frequency, EI_DSP_PARAMS_MFCC_HIGH_FREQUENCY);
+    EI_TEST_EXPECT_EQ(config->pre_cof, EI_DSP_PARAMS_MFCC_PRE_COF);
+    EI_TEST_EXPECT_EQ(config->pre_shift, EI_DSP_PARAMS_MFCC_PRE_SHIFT);
+}
+
+// the MFCC of `length` samples of audio, both ways, bit for bit
+static void check_mfcc(size_t length) {
+    std::vector<float> audio(length);
+    for (size_t ix = 0; ix < length; ix++) {
+        audio[ix] = 5000.0f * sinf(ix * (0.03f + ix * 1e-6f)) + ei_test_uniform(-1000.0f, 1000.0f);
+    }
+    const ei_dsp_config_mfcc_t *config = model_config();
+    signal_t signal;
+    numpy::signal_from_buffer(audio.data(), audio.size(), &signal);
+
+    const matrix_size_t size = speechpy::feature::calculate_mfcc_buffer_size(length, EI_CLASSIFIER_FREQUENCY,
+        config->frame_length, config->frame_stride, config->num_cepstral, config->implementation_version);
+    EI_TEST_EXPECT_EQ(ei_dsp_mfcc_static_t::frame_count(length), size.rows);
+    matrix_t expected(size.rows, size.cols), actual(size.rows, size.cols);
+
+    EI_TEST_EXPECT_EQ(speechpy::feature::mfcc(&expected, &signal, EI_CLASSIFIER_FREQUENCY, config->frame_length,
+        config->frame_stride, config->num_cepstral, config->num_filters, config->fft_length, config->low_frequency,
+        config->high_frequency, true, config->implementation_version), EIDSP_OK);
+    EI_TEST_EXPECT_EQ(ei_dsp_mfcc_static_t::mfcc(&actual, &signal), EIDSP_OK);
+    // and what ei_dsp_mfcc picks for the model's block
+    matrix_t picked(size.rows, size.cols);
+    EI_TEST_EXPECT_EQ(ei_dsp_mfcc(&picked, &signal, EI_CLASSIFIER_FREQUENCY, config,
+        config->implementation_version), EIDSP_OK);
+
+    size_t mismatches = 0;
+    for (size_t ix = 0; ix < size.rows * size.cols; ix++) {
+        mismatches += actual.buffer[ix] != expected.buffer[ix] || picked.buffer[ix] != expected.buffer[ix];
+    }
+    if (mismatches) {
+        printf("%u samples: %u of %u values differ\n", (unsigned)length, (unsigned)mismatches,
+            (unsigned)(size.rows * size.cols));
+    }
+    EI_TEST_EXPECT_EQ(mismatches, 0);
+}
+
+static void test_window() {
+    check_mfcc(EI_CLASSIFIER_RAW_SAMPLE_COUNT);
+}
+
+static void test_slices() {
+    // a slice, a slice with the overlap of the frame before it, and lengths that don't end on a frame
+    const size_t overlap =
+        speechpy::mfcc_static_frame_samples(EI_CLASSIFIER_FREQUENCY, EI_DSP_PARAMS_MFCC_FRAME_LENGTH) -
+        speechpy::mfcc_static_frame_samples(EI_CLASSIFIER_FREQUENCY, EI_DSP_PARAMS_MFCC_FRAME_STRIDE);
+    check_mfcc(EI_CLASSIFIER_SLICE_SIZE);
+    check_mfcc(EI_CLASSIFIER_SLICE_SIZE + overlap);
+    check_mfcc(EI_CLASSIFIER_SLICE_SIZE + 123);
+    check_mfcc(1000);
+    check_mfcc(400);
+}
+
+int main() {
+    EI_TEST_RUN(test_params_match_model);
+    EI_TEST_RUN(test_window);
+    EI_TEST_RUN(test_slices);
+    return ei_test_result();
+}
@@ -0,0 +1,85 @@
+/* speechpy::feature::mfe_batched against the frame by frame mfe it replaces (mfe_v3, with its own
+ * filterbank, stays in use for implementation versions 1 and 2) */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
+#include <vector>
+
+using namespace ei;
+
+static std::vector<float> test_audio(size_t length) {
+    std::vector<float> audio(length);
+    for (size_t ix = 0; ix < length; ix++) {
+        audio[ix] = 3000.0f * sinf(ix * 0.05f + sinf(ix * 0.0003f) * 20) + ei_test_uniform(-500.0f, 500.0f);
+    }
+    return audio;
+}
+
+static void check_mfe(size_t signal_length, uint32_t frequency, float frame_length,
+    float frame_stride, uint16_t num_filters, uint16_t fft_length, uint32_t low_frequency,
+    uint32_t high_frequency, uint16_t version)
+{
+    // stack_frames cuts total_length down to the frames it takes, so a signal per call
+    std::vector<float> audio = test_audio(signal_length);
+    signal_t signal, batched_signal;
+    numpy::signal_from_buffer(audio.data(), audio.size(), &signal);
+    numpy::signal_from_buffer(audio.data(), audio.size(), &batched_signal);
+
+    matrix_size_t size = speechpy::feature::calculate_mfe_buffer_size(signal_length, frequency,
+        frame_length, frame_stride, num_filters, version);
+    matrix_t expected(size.rows, size.cols), expected_energy(size.rows, 1);
+    matrix_t batched(size.rows, size.cols), batched_energy(size.rows, 1);
+
+    EI_TEST_EXPECT_EQ(speechpy::feature::mfe(&expected, &expected_energy, &signal, frequency, frame_length,
+        frame_stride, num_filters, fft_length, low_frequency, high_frequency, version), EIDSP_OK);
+    EI_TEST_EXPECT_EQ(speechpy::feature::mfe_batched(&batched, &batched_energy, &batched_signal, frequency,
+        frame_length, frame_stride, num_filters, fft_length, low_frequency, high_frequency, version), EIDSP_OK);
+
+    // the mel weighting adds up in a different order
+    for (size_t ix = 0; ix < size.rows * size.cols; ix++) {
+        EI_TEST_EXPECT_NEAR(batched.buffer[ix], expected.buffer[ix], fabs(expected.buffer[ix]) * 1e-4 + 1e-6);
+    }
+    for (size_t ix = 0; ix < size.rows; ix++) {
+        EI_TEST_EXPECT_NEAR(batched_energy.buffer[ix], expected_energy.buffer[ix], fabs(expected_energy.buffer[ix]) * 1e-4);
+    }
+}
+
+// the MFCC front end of the keyword model: 49 frames of 400 samples, 512-point FFT, 32 filters
+static void test_keyword_config() {
+    check_mfe(16000, 16000, 0.025f, 0.02f, 32, 512, 80, 0, 4);
+}
+
+// frame counts that aren't a multiple of EIDSP_MFE_BLOCK_FRAMES, fewer frames than a block
+static void test_partial_blocks() {
+    check_mfe(16000 + 320 * 3, 16000, 0.02f, 0.02f, 40, 256, 0, 0, 4);
+    check_mfe(960, 16000, 0.02f, 0.02f, 40, 512, 0, 0, 4);
+    check_mfe(320, 16000, 0.02f, 0.02f, 40, 512, 0, 0, 4);
+}
+
+// older implementation versions (frame count, default low frequency) and other rates
+static void test_versions() {
+    for (uint16_t version = 1; version <= 4; version++) {
+        check_mfe(8000, 8000, 0.032f, 0.016f, 24, 256, 0, 0, version);
+        check_mfe(11025, 11025, 0.025f, 0.01f, 40, 512, 100, 4000, version);
+    }
+}
+
+static void test_size_mismatch() {
+    std::vector<float> audio = test_audio(16000);
+    signal_t signal;
+    numpy::signal_from_buffer(audio.data(), audio.size(), &signal);
+
+    matrix_t wrong_rows(48, 32), wrong_cols(49, 31);
+    EI_TEST_EXPECT_EQ(speechpy::feature::mfe_batched(&wrong_rows, nullptr, &signal, 16000, 0.025f, 0.02f,
+        32, 512, 80, 0, 4), EIDSP_MATRIX_SIZE_MISMATCH);
+    EI_TEST_EXPECT_EQ(speechpy::feature::mfe_batched(&wrong_cols, nullptr, &signal, 16000, 0.025f, 0.02f,
+        32, 512, 80, 0, 4), EIDSP_MATRIX_SIZE_MISMATCH);
+}
+
+int main() {
+    EI_TEST_RUN(test_keyword_config);
+    EI_TEST_RUN(test_partial_blocks);
+    EI_TEST_RUN(test_versions);
+    EI_TEST_RUN(test_size_mismatch);
+    return ei_test_result();
+}
@@ -0,0 +1,275 @@
+/* OptimalMemoryPlanner against the GreedyMemoryPlanner: the arena it plans for the test_helpers.cpp
+ * models through the MicroAllocator, the search budget (kDefaultMaxSearchSteps placements) and the
+ * graphs past kMaxSearchBuffers online buffers, which keep the greedy plan */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_planner/optimal_memory_planner.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_allocator.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/test_helpers.h"
+#include <algorithm>
+#include <vector>
+
+using tflite::testing::NodeConnection;
+
+struct buffer_t {
+    int size;
+    int first_time_used;
+    int last_time_used;
+    int offline_offset;
+};
+
+// a graph the greedy plan isn't the smallest for: greedy places the 96 byte buffer first, at 0, which
+// leaves no gap for the 16 byte one next to the three 64 byte ones (greedy 192, smallest 160 bytes)
+static const std::vector<buffer_t> greedy_suboptimal = {
+    { 16, 0, 0, -1 }, { 64, 1, 3, -1 }, { 96, 2, 2, -1 }, { 64, 3, 5, -1 }, { 64, 4, 4, -1 },
+};
+
+// `count` buffers of random size and lifetime, over about count / 2 nodes
+static std::vector<buffer_t> random_buffers(int count) {
+    std::vector<buffer_t> buffers;
+    for (int ix = 0; ix < count; ix++) {
+        const int first = ei_test_rand() % (count / 2 + 1);
+        buffers.push_back({ (int)(1 + ei_test_rand() % 32) * 16, first, first + (int)(ei_test_rand() % 4), -1 });
+    }
+    return buffers;
+}
+
+// planners keep their plan in the scratch they're given, so each one gets its own
+static void add_buffers(tflite::MicroMemoryPlanner *planner, const std::vector<buffer_t> &buffers) {
+    static std::vector<std::vector<unsigned char>> scratch;
+    scratch.emplace_back(4096);
+    planner->Init(scratch.back().data(), scratch.back().size());
+    for (const buffer_t &b : buffers) {
+        if (b.offline_offset >= 0) {
+            planner->AddBuffer(b.size, b.first_time_used, b.last_time_used, b.offline_offset);
+        }
+        else {
+            planner->AddBuffer(b.size, b.first_time_used, b.last_time_used);
+        }
+    }
+}
+
+static std::vector<int> offsets(tflite::MicroMemoryPlanner *planner) {
+    std::vector<int> res(planner->GetBufferCount());
+    for (size_t ix = 0; ix < res.size(); ix++) {
+        planner->GetOffsetForBuffer(ix, &res[ix]);
+    }
+    return res;
+}
+
+// whether an online planned buffer shares memory with another one while both are in use. Offline
+// planned buffers can overlap each other, when the model says so
+static bool online_buffers_overlap(const std::vector<buffer_t> &buffers, const std::vector<int> &offsets) {
+    for (size_t a = 0; a < buffers.size(); a++) {
+        for (size_t b = 0; b < buffers.size(); b++) {
+            if (a == b || buffers[a].offline_offset >= 0) {
+                continue;
+            }
+            const bool in_time = buffers[a].first_time_used <= buffers[b].last_time_used &&
+                buffers[b].first_time_used <= buffers[a].last_time_used;
+            const bool in_memory = offsets[a] < offsets[b] + buffers[b].size &&
+                offsets[b] < offsets[a] + buffers[a].size;
+            if (in_time && in_memory) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// the buffers the MicroAllocator plans for a model. The planner works in the arena, which is handed
+// on once the plan is committed, so they're planned again with add_buffers() to be looked at
+class recording_planner_t : public tflite::GreedyMemoryPlanner {
+public:
+    std::vector<buffer_t> buffers;
+
+    TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used) override {
+        buffers.push_back({ size, first_time_used, last_time_used, -1 });
+        return tflite::GreedyMemoryPlanner::AddBuffer(size, first_time_used, last_time_used);
+    }
+
+    // the greedy planner adds an offline planned buffer through the online AddBuffer() above
+    TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used, int offline_offset) override {
+        const TfLiteStatus status =
+            tflite::GreedyMemoryPlanner::AddBuffer(size, first_time_used, last_time_used, offline_offset);
+        buffers.back().offline_offset = offline_offset;
+        return status;
+    }
+};
+
+alignas(16) static uint8_t arena[32768];
+
+static std::vector<buffer_t> model_buffers(const tflite::Model *model) {
+    recording_planner_t planner;
+    tflite::MicroAllocator *allocator = tflite::MicroAllocator::Create(arena, sizeof(arena), &planner);
+    tflite::SubgraphAllocations *allocations = allocator->StartModelAllocation(model);
+    tflite::ScratchBufferHandle *scratch_buffer_handles = nullptr;
+    EI_TEST_EXPECT(allocations != nullptr);
+    if (!allocations) {
+        return { };
+    }
+    EI_TEST_EXPECT_EQ(allocator->FinishModelAllocation(model, allocations, &scratch_buffer_handles), kTfLiteOk);
+    return planner.buffers;
+}
+
+// the model gets an arena through the MicroAllocator with the OptimalMemoryPlanner too
+static bool allocates_with_optimal_planner(const tflite::Model *model) {
+    tflite::OptimalMemoryPlanner planner;
+    tflite::MicroAllocator *allocator = tflite::MicroAllocator::Create(arena, sizeof(arena), &planner);
+    tflite::SubgraphAllocations *allocations = allocator->StartModelAllocation(model);
+    tflite::ScratchBufferHandle *scratch_buffer_handles = nullptr;
+    return allocations &&
+        allocator->FinishModelAllocation(model, allocations, &scratch_buffer_handles) == kTfLiteOk;
+}
+
+static const tflite::Model *offline_planned_model(const std::vector<int32_t> &offsets,
+        std::vector<NodeConnection> nodes) {
+    std::vector<int32_t> metadata = { 1, 0, (int32_t)offsets.size() };
+    metadata.insert(metadata.end(), offsets.begin(), offsets.end());
+    // the builder keeps a pointer to the metadata until the model is built
+    static std::vector<std::vector<int32_t>> keep;
+    keep.push_back(metadata);
+    return tflite::testing::GetModelWithOfflinePlanning(offsets.size(), keep.back().data(), nodes.data(),
+        nodes.size());
+}
+
+static void test_test_helpers_models() {
+    struct {
+        const char *name;
+        const tflite::Model *model;
+    } models[] = {
+        { "simple mock", tflite::testing::GetSimpleMockModel() },
+        { "complex mock", tflite::testing::GetComplexMockModel() },
+        { "simple with branch", tflite::testing::GetSimpleModelWithBranch() },
+        { "simple multiple inputs", tflite::testing::GetSimpleMultipleInputsModel() },
+        { "unused inputs", tflite::testing::GetModelWithUnusedInputs() },
+        { "unused operator outputs", tflite::testing::GetModelWithUnusedOperatorOutputs() },
+        { "simple stateful", tflite::testing::GetSimpleStatefulModel() },
+        { "subgraphs and if", tflite::testing::GetSimpleModelWithSubgraphsAndIf() },
+        // the offline planned graphs of micro_allocator_test: each tensor 48 bytes, -1 is planned online
+        { "offline, branches all online",
+            offline_planned_model({ -1, -1, -1, -1 }, { { { 0 }, { 1 } }, { { 0 }, { 2 } }, { { 1, 2 }, { 3 } } }) },
+        { "offline, basic",
+            offline_planned_model({ 0, 48, 0 }, { { { 0 }, { 1 } }, { { 1 }, { 2 } } }) },
+        { "offline, overlapping",
+            offline_planned_model({ 0, 0, 48, 0 }, { { { 0, 1 }, { 2 } }, { { 2 }, { 3 } } }) },
+        { "offline and online",
+            offline_planned_model({ 0, 48, -1, 0, -1 }, { { { 0, 1 }, { 2 } }, { { 1, 2 }, { 3 } }, { { 3 }, { 4 } } }) },
+    };
+
+    size_t greedy_total = 0, optimal_total = 0;
+    for (const auto &m : models) {
+        const std::vector<buffer_t> buffers = model_buffers(m.model);
+        EI_TEST_EXPECT(allocates_with_optimal_planner(m.model));
+
+        tflite::GreedyMemoryPlanner greedy;
+        tflite::OptimalMemoryPlanner optimal;
+        add_buffers(&greedy, buffers);
+        const size_t greedy_size = greedy.GetMaximumMemorySize();
+        add_buffers(&optimal, buffers);
+        const size_t optimal_size = optimal.GetMaximumMemorySize();
+        printf("%-30s greedy %5u, optimal %5u bytes%s\n", m.name, (unsigned)greedy_size, (unsigned)optimal_size,
+            optimal.IsPlanOptimal() ? "" : " (search cut short)");
+        EI_TEST_EXPECT(greedy_size > 0);
+        EI_TEST_EXPECT(optimal_size <= greedy_size);
+        EI_TEST_EXPECT_EQ(optimal.GetGreedyMemorySize(), greedy_size);
+        EI_TEST_EXPECT(!online_buffers_overlap(buffers, offsets(&greedy)));
+        EI_TEST_EXPECT(!online_buffers_overlap(buffers, offsets(&optimal)));
+        for (size_t ix = 0; ix < buffers.size(); ix++) {
+            if (buffers[ix].offline_offset >= 0) {
+                EI_TEST_EXPECT_EQ(offsets(&optimal)[ix], buffers[ix].offline_offset);
+            }
+        }
+        greedy_total += greedy_size;
+        optimal_total += optimal_size;
+    }
+    printf("total: greedy %u, optimal %u bytes\n", (unsigned)greedy_total, (unsigned)optimal_total);
+}
+
+static void test_finds_smaller_plan() {
+    tflite::GreedyMemoryPlanner greedy;
+    tflite::OptimalMemoryPlanner optimal;
+    add_buffers(&greedy, greedy_suboptimal);
+    add_buffers(&optimal, greedy_suboptimal);
+    EI_TEST_EXPECT_EQ(greedy.GetMaximumMemorySize(), 192);
+    EI_TEST_EXPECT_EQ(optimal.GetMaximumMemorySize(), 160);
+    EI_TEST_EXPECT(optimal.IsPlanOptimal());
+    EI_TEST_EXPECT(optimal.GetSearchSteps() > 0);
+    EI_TEST_EXPECT(!optimal.DoAnyBuffersOverlap());
+}
+
+// the search stops after max_search_steps placements, with the best plan so far and the same plan on
+// every run
+static void test_search_budget() {
+    for (int max_steps = 1; max_steps < 64; max_steps++) {
+        tflite::OptimalMemoryPlanner optimal(max_steps);
+        add_buffers(&optimal, greedy_suboptimal);
+        const size_t size = optimal.GetMaximumMemorySize();
+        EI_TEST_EXPECT(optimal.GetSearchSteps() <= max_steps);
+        EI_TEST_EXPECT(size <= 192);
+        EI_TEST_EXPECT(size >= 160);
+        EI_TEST_EXPECT(!optimal.DoAnyBuffersOverlap());
+        if (!optimal.IsPlanOptimal()) {
+            EI_TEST_EXPECT_EQ(optimal.GetSearchSteps(), max_steps);
+        }
+        else {
+            EI_TEST_EXPECT_EQ(size, 160);
+        }
+    }
+    tflite::OptimalMemoryPlanner cut_short(1);
+    add_buffers(&cut_short, greedy_suboptimal);
+    EI_TEST_EXPECT(!cut_short.IsPlanOptimal());
+
+    // small graphs are searched to completion within the default budget
+    int max_small_graph_steps = 0;
+    for (int graph = 0; graph < 500; graph++) {
+        tflite::OptimalMemoryPlanner optimal;
+        add_buffers(&optimal, random_buffers(8));
+        optimal.GetMaximumMemorySize();
+        EI_TEST_EXPECT(optimal.IsPlanOptimal());
+        max_small_graph_steps = std::max(max_small_graph_steps, optimal.GetSearchSteps());
+    }
+    printf("8 buffers: at most %d steps\n", max_small_graph_steps);
+
+    // kMaxSearchBuffers buffers, which the default budget doesn't search to completion
+    const std::vector<buffer_t> buffers = random_buffers(tflite::OptimalMemoryPlanner::kMaxSearchBuffers);
+    tflite::GreedyMemoryPlanner greedy;
+    tflite::OptimalMemoryPlanner a, b;
+    add_buffers(&greedy, buffers);
+    add_buffers(&a, buffers);
+    add_buffers(&b, buffers);
+    const uint64_t start = ei_read_timer_us();
+    const size_t size = a.GetMaximumMemorySize();
+    const uint64_t search_us = ei_read_timer_us() - start;
+    printf("%u buffers: greedy %u, optimal %u bytes in %d steps (%u us)%s\n", (unsigned)buffers.size(),
+        (unsigned)greedy.GetMaximumMemorySize(), (unsigned)size, a.GetSearchSteps(), (unsigned)search_us,
+        a.IsPlanOptimal() ? "" : ", search cut short");
+    EI_TEST_EXPECT(a.GetSearchSteps() > 0);
+    EI_TEST_EXPECT(a.GetSearchSteps() <= tflite::OptimalMemoryPlanner::kDefaultMaxSearchSteps);
+    EI_TEST_EXPECT(a.GetMaximumMemorySize() <= greedy.GetMaximumMemorySize());
+    EI_TEST_EXPECT(!a.DoAnyBuffersOverlap());
+    EI_TEST_EXPECT(offsets(&a) == offsets(&b));
+}
+
+// past kMaxSearchBuffers online buffers there's no search, the plan is the greedy one
+static void test_many_buffers_keep_greedy() {
+    const std::vector<buffer_t> buffers = random_buffers(tflite::OptimalMemoryPlanner::kMaxSearchBuffers + 1);
+
+    tflite::GreedyMemoryPlanner greedy;
+    tflite::OptimalMemoryPlanner optimal;
+    add_buffers(&greedy, buffers);
+    add_buffers(&optimal, buffers);
+    EI_TEST_EXPECT_EQ(optimal.GetSearchSteps(), 0);
+    EI_TEST_EXPECT_EQ(optimal.GetMaximumMemorySize(), greedy.GetMaximumMemorySize());
+    EI_TEST_EXPECT(offsets(&optimal) == offsets(&greedy));
+}
+
+int main() {
+    EI_TEST_RUN(test_test_helpers_models);
+    EI_TEST_RUN(test_finds_smaller_plan);
+    EI_TEST_RUN(test_search_budget);
+    EI_TEST_RUN(test_many_buffers_keep_greedy);
+    return ei_test_result();
+}
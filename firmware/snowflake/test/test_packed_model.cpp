@@ -0,0 +1,281 @@
+/* EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS on the host: the kernels it runs (arm_convolve_s8_reordered and
+ * the folded bias of fully_connected.cpp) only exist with the DSP extension, so this is built with it
+ * emulated (EI_CLASSIFIER_TFLITE_EMULATE_ARM_DSP). The reordered kernels against arm_convolve_s8 and
+ * a plain C convolution on the weights they're reordered from, and the packed model against the
+ * unpacked one, byte for byte.
+ *
+ * tflite_learn_5_compiled.cpp is built twice in this file, with and without packed weights, each in
+ * its own namespace: the logits, the input of the SOFTMAX, are only reachable from in there */
+
+// test-flags: -DEI_CLASSIFIER_TFLITE_ENABLE_CMSIS_NN_X86=1 -DEI_CLASSIFIER_TFLITE_EMULATE_ARM_DSP=1 -DEI_CLASSIFIER_TFLITE_PACKED_WEIGHTS=1
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "ei_test_keyword.h"
+#include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "edge-impulse-sdk/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+// what the model includes, so that none of it lands in the namespaces below
+#include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
+#include "edge-impulse-sdk/tensorflow/lite/c/common.h"
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "edge-impulse-sdk/classifier/ei_packed_weights.h"
+#include <vector>
+
+namespace packed_weights {
+#include "../src/tflite-model/tflite_learn_5_compiled.cpp"
+}
+
+#undef EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+#define EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS 0
+
+namespace unpacked_weights {
+#include "../src/tflite-model/tflite_learn_5_compiled.cpp"
+}
+
+struct model_t {
+    const char *name;
+    TfLiteStatus (*init)(void *(*)(size_t, size_t));
+    TfLiteStatus (*input)(int, TfLiteTensor *);
+    TfLiteStatus (*invoke)();
+    TfLiteStatus (*reset)(void (*)(void *));
+    // the input tensor of the last node, the SOFTMAX
+    void (*logits)(TfLiteTensor *);
+};
+
+#define MODEL(ns) { #ns, ns::tflite_learn_5_init, ns::tflite_learn_5_input, ns::tflite_learn_5_invoke, \
+    ns::tflite_learn_5_reset, [](TfLiteTensor *t) { \
+        ns::init_tflite_tensor(ns::tflNodes[ns::kNodeCount - 1].inputs->data[0], t); } }
+
+static const model_t unpacked_model = MODEL(unpacked_weights);
+static const model_t packed_model = MODEL(packed_weights);
+
+static const int WINDOWS = 32;
+static const int RANDOM_INPUTS = 32;
+
+static std::vector<int8_t> rand_s8(size_t size) {
+    std::vector<int8_t> v(size);
+    for (auto &x : v) {
+        x = (int8_t)(ei_test_rand() & 0xff);
+    }
+    return v;
+}
+
+struct conv_layer_t {
+    cmsis_nn_conv_params params;
+    cmsis_nn_dims input_dims, filter_dims, bias_dims, output_dims;
+    std::vector<int8_t> input, filter;
+    std::vector<int32_t> bias, multiplier, shift;
+};
+
+static conv_layer_t conv_layer(int32_t in_h, int32_t in_w, int32_t in_ch, int32_t out_ch, int32_t k_h, int32_t k_w,
+    int32_t stride) {
+    conv_layer_t layer;
+    layer.params = { };
+    layer.params.input_offset = (int32_t)(ei_test_rand() % 256) - 127;
+    layer.params.output_offset = (int32_t)(ei_test_rand() % 256) - 128;
+    layer.params.stride = { stride, stride };
+    layer.params.padding = { k_w / 2, k_h / 2 };
+    layer.params.dilation = { 1, 1 };
+    layer.params.activation = { -128, 127 };
+    layer.input_dims = { 1, in_h, in_w, in_ch };
+    layer.filter_dims = { out_ch, k_h, k_w, in_ch };
+    layer.bias_dims = { 1, 1, 1, out_ch };
+    layer.output_dims = { 1, (in_h + 2 * (k_h / 2) - k_h) / stride + 1, (in_w + 2 * (k_w / 2) - k_w) / stride + 1,
+        out_ch };
+    layer.input = rand_s8(in_h * in_w * in_ch);
+    layer.filter = rand_s8(out_ch * k_h * k_w * in_ch);
+    for (int32_t ch = 0; ch < out_ch; ch++) {
+        layer.bias.push_back((int32_t)(ei_test_rand() % 20001) - 10000);
+        layer.multiplier.push_back((int32_t)((1u << 30) + ei_test_rand() % (1u << 30)));
+        layer.shift.push_back(-8 - (int32_t)(ei_test_rand() % 3));
+    }
+    return layer;
+}
+
+// the convolution as arm_convolve_s8 documents it, one output at a time
+static std::vector<int8_t> reference_convolve(const conv_layer_t &layer) {
+    const cmsis_nn_dims &in = layer.input_dims, &k = layer.filter_dims, &out = layer.output_dims;
+    std::vector<int8_t> res;
+    for (int32_t y = 0; y < out.h; y++) {
+        for (int32_t x = 0; x < out.w; x++) {
+            for (int32_t oc = 0; oc < out.c; oc++) {
+                int32_t sum = layer.bias[oc];
+                for (int32_t ky = 0; ky < k.h; ky++) {
+                    for (int32_t kx = 0; kx < k.w; kx++) {
+                        const int32_t iy = y * layer.params.stride.h - layer.params.padding.h + ky;
+                        const int32_t ix = x * layer.params.stride.w - layer.params.padding.w + kx;
+                        if (iy < 0 || iy >= in.h || ix < 0 || ix >= in.w) {
+                            continue;
+                        }
+                        for (int32_t ic = 0; ic < in.c; ic++) {
+                            sum += (layer.input[(iy * in.w + ix) * in.c + ic] + layer.params.input_offset) *
+                                layer.filter[((oc * k.h + ky) * k.w + kx) * k.c + ic];
+                        }
+                    }
+                }
+                sum = arm_nn_requantize(sum, layer.multiplier[oc], layer.shift[oc]) + layer.params.output_offset;
+                res.push_back((int8_t)std::min(std::max(sum, (int32_t)-128), (int32_t)127));
+            }
+        }
+    }
+    return res;
+}
+
+static std::vector<int8_t> convolve(const conv_layer_t &layer, bool reordered) {
+    std::vector<int8_t> filter(layer.filter.size());
+    if (reordered) {
+        arm_convolve_s8_reorder_filter(&layer.filter_dims, layer.filter.data(), filter.data());
+    }
+    else {
+        filter = layer.filter;
+    }
+    std::vector<int8_t> buffer(arm_convolve_s8_get_buffer_size(&layer.input_dims, &layer.filter_dims));
+    std::vector<int8_t> output(layer.output_dims.h * layer.output_dims.w * layer.output_dims.c);
+    std::vector<int32_t> multiplier(layer.multiplier), shift(layer.shift);
+    cmsis_nn_context ctx = { buffer.data(), (int32_t)buffer.size() };
+    cmsis_nn_per_channel_quant_params quant = { multiplier.data(), shift.data() };
+    const arm_cmsis_nn_status status = (reordered ? arm_convolve_s8_reordered : arm_convolve_s8)(&ctx,
+        &layer.params, &quant, &layer.input_dims, layer.input.data(), &layer.filter_dims, filter.data(),
+        &layer.bias_dims, layer.bias.data(), &layer.output_dims, output.data());
+    EI_TEST_EXPECT_EQ(status, ARM_CMSIS_NN_SUCCESS);
+    return output;
+}
+
+static void expect_same(const char *what, const std::vector<int8_t> &actual, const std::vector<int8_t> &expected) {
+    EI_TEST_EXPECT_EQ(actual.size(), expected.size());
+    for (size_t ix = 0; ix < std::min(actual.size(), expected.size()); ix++) {
+        if (actual[ix] != expected[ix]) {
+            printf("%s: [%u] is %d, expected %d\n", what, (unsigned)ix, actual[ix], expected[ix]);
+            ei_test_failures++;
+            return;
+        }
+    }
+}
+
+static void test_reordered_convolve() {
+    // { in_h, in_w, in_ch, out_ch, k_h, k_w, stride }: row lengths (k_h * k_w * in_ch) that are and
+    // aren't a multiple of 4 or shorter than 4, odd output channels and odd output pixel counts (the
+    // last pixel then goes through the left-over loop, not the matrix multiplication)
+    const int32_t layers[][7] = {
+        { 1, 49, 13, 8, 1, 3, 1 },  // the keyword model's conv layers
+        { 1, 25, 8, 16, 1, 3, 1 },
+        { 1, 9, 1, 3, 1, 3, 1 },
+        { 1, 10, 3, 5, 1, 1, 1 },
+        { 5, 7, 5, 7, 3, 3, 1 },
+        { 8, 8, 4, 6, 3, 3, 2 },
+        { 6, 5, 11, 9, 2, 2, 1 },
+        { 4, 4, 16, 1, 3, 3, 1 },
+    };
+    for (const auto &l : layers) {
+        const conv_layer_t layer = conv_layer(l[0], l[1], l[2], l[3], l[4], l[5], l[6]);
+        char what[64];
+        snprintf(what, sizeof(what), "%dx%dx%d -> %d, %dx%d", l[0], l[1], l[2], l[3], l[4], l[5]);
+        const std::vector<int8_t> expected = reference_convolve(layer);
+        expect_same(what, convolve(layer, false), expected);
+        expect_same(what, convolve(layer, true), expected);
+    }
+}
+
+// arm_nn_mat_mult_kernel_s8_s16_reordered on its own, two columns against every row, as the im2col
+// of the convolutions gives them
+static void test_reordered_mat_mult_kernel() {
+    for (uint16_t num_col : { 1, 3, 4, 7, 8, 13, 39, 64 }) {
+        for (uint16_t rows : { 1, 2, 3, 8 }) {
+            const cmsis_nn_dims filter_dims = { rows, 1, 1, num_col };
+            const std::vector<int8_t> filter = rand_s8(rows * num_col);
+            std::vector<int8_t> reordered(filter.size());
+            arm_convolve_s8_reorder_filter(&filter_dims, filter.data(), reordered.data());
+            std::vector<int16_t> columns(2 * num_col);
+            for (auto &c : columns) {
+                c = (int16_t)((int32_t)(ei_test_rand() & 0xff) - 128 + 100);
+            }
+            std::vector<int32_t> bias(rows), multiplier(rows, 1 << 30), shift(rows, -7);
+            for (auto &b : bias) {
+                b = (int32_t)(ei_test_rand() % 2001) - 1000;
+            }
+
+            std::vector<int8_t> expected(2 * rows), actual(2 * rows);
+            const int8_t *end = arm_nn_mat_mult_kernel_s8_s16(filter.data(), columns.data(), rows, shift.data(),
+                multiplier.data(), 5, -128, 127, num_col, bias.data(), expected.data());
+            const int8_t *reordered_end = arm_nn_mat_mult_kernel_s8_s16_reordered(reordered.data(),
+                columns.data(), rows, shift.data(), multiplier.data(), 5, -128, 127, num_col, bias.data(),
+                actual.data());
+            EI_TEST_EXPECT(reordered_end - actual.data() == end - expected.data());
+            char what[64];
+            snprintf(what, sizeof(what), "%d rows of %d", rows, num_col);
+            expect_same(what, actual, expected);
+        }
+    }
+}
+
+static std::vector<int8_t> model_input(const std::vector<float> &audio) {
+    std::vector<float> audio_copy(audio);
+    signal_t signal;
+    ei::numpy::signal_from_buffer(audio_copy.data(), audio_copy.size(), &signal);
+    ei::matrix_t matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    const ei_model_dsp_t &block = ei_default_impulse.dsp_blocks[0];
+    EI_TEST_EXPECT_EQ(block.extract_fn(&signal, &matrix, block.config, EI_CLASSIFIER_FREQUENCY), 0);
+
+    TfLiteTensor input;
+    unpacked_model.input(0, &input);
+    std::vector<int8_t> res(EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    for (size_t ix = 0; ix < res.size(); ix++) {
+        const float q = roundf(matrix.buffer[ix] / input.params.scale) + input.params.zero_point;
+        res[ix] = (int8_t)std::min(std::max(q, -128.0f), 127.0f);
+    }
+    return res;
+}
+
+static std::vector<int8_t> logits(const model_t &model, const std::vector<int8_t> &input) {
+    TfLiteTensor tensor;
+    model.input(0, &tensor);
+    std::copy(input.begin(), input.end(), tensor.data.int8);
+    EI_TEST_EXPECT_EQ(model.invoke(), kTfLiteOk);
+    model.logits(&tensor);
+    return std::vector<int8_t>(tensor.data.int8, tensor.data.int8 + EI_CLASSIFIER_LABEL_COUNT);
+}
+
+static void test_packed_model_nodes() {
+    // the two CONV_2D take reordered weights, the FULLY_CONNECTED a folded bias
+    int reordered = 0, folded = 0;
+    for (size_t ix = 0; ix < packed_weights::kNodeCount; ix++) {
+        const ei_packed_weights_t *weights = ei_get_packed_weights(packed_weights::tflNodes[ix].custom_initial_data,
+            packed_weights::tflNodes[ix].custom_initial_data_size);
+        reordered += weights && weights->filter_layout == EI_FILTER_LAYOUT_OHWI_REORDERED;
+        folded += weights && weights->folded_bias != nullptr;
+    }
+    EI_TEST_EXPECT_EQ(reordered, 2);
+    EI_TEST_EXPECT_EQ(folded, 1);
+    for (size_t ix = 0; ix < unpacked_weights::kNodeCount; ix++) {
+        EI_TEST_EXPECT(unpacked_weights::tflNodes[ix].custom_initial_data == nullptr);
+    }
+}
+
+static void test_packed_model_matches() {
+    std::vector<std::vector<int8_t>> inputs;
+    for (int ix = 0; ix < WINDOWS; ix++) {
+        inputs.push_back(model_input(ei_test_keyword_audio(ix)));
+    }
+    for (int ix = 0; ix < RANDOM_INPUTS; ix++) {
+        inputs.push_back(rand_s8(EI_CLASSIFIER_NN_INPUT_FRAME_SIZE));
+    }
+    for (size_t ix = 0; ix < inputs.size(); ix++) {
+        char what[32];
+        snprintf(what, sizeof(what), "input %u", (unsigned)ix);
+        expect_same(what, logits(packed_model, inputs[ix]), logits(unpacked_model, inputs[ix]));
+    }
+}
+
+int main() {
+    EI_TEST_RUN(test_reordered_convolve);
+    EI_TEST_RUN(test_reordered_mat_mult_kernel);
+    EI_TEST_EXPECT_EQ(unpacked_model.init(ei_aligned_calloc), kTfLiteOk);
+    EI_TEST_EXPECT_EQ(packed_model.init(ei_aligned_calloc), kTfLiteOk);
+    EI_TEST_RUN(test_packed_model_nodes);
+    EI_TEST_RUN(test_packed_model_matches);
+    unpacked_model.reset(ei_aligned_free);
+    packed_model.reset(ei_aligned_free);
+    return ei_test_result();
+}
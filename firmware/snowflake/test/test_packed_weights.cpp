@@ -0,0 +1,56 @@
+/* The EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS and EI_CLASSIFIER_TFLITE_INT4_WEIGHTS tables of the compiled
+ * model are written by tools/eon_weight_tables.py from the generated ones: its --check, on the model
+ * and on a copy with one derived value changed. What the packed tables compute is checked against
+ * the unpacked model in test_packed_model.cpp */
+
+#include "ei_test.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+
+static std::string snowflake_dir() {
+    const std::string test_file = __FILE__;
+    return test_file.substr(0, test_file.rfind('/')) + "/..";
+}
+
+// exit code of eon_weight_tables.py --check on `model`, -1 if it didn't run
+static int check_tables(const std::string &model) {
+    const std::string command = "python3 " + snowflake_dir() + "/tools/eon_weight_tables.py --check " + model;
+    const int status = system(command.c_str());
+    if (status == -1 || !WIFEXITED(status)) {
+        return -1;
+    }
+    return WEXITSTATUS(status);
+}
+
+static void test_tables_up_to_date() {
+    EI_TEST_EXPECT_EQ(check_tables(snowflake_dir() + "/src/tflite-model/tflite_learn_5_compiled.cpp"), 0);
+}
+
+static void test_check_finds_stale_table() {
+    std::ifstream file(snowflake_dir() + "/src/tflite-model/tflite_learn_5_compiled.cpp");
+    std::stringstream source;
+    source << file.rdbuf();
+    std::string text = source.str();
+
+    // the first digit of the folded bias of the FULLY_CONNECTED node
+    const size_t table = text.find("folded_bias6[");
+    EI_TEST_EXPECT(table != std::string::npos);
+    if (table == std::string::npos) {
+        return;
+    }
+    const size_t digit = text.find_first_of("0123456789", text.find('{', table));
+    text[digit] = text[digit] == '9' ? '1' : text[digit] + 1;
+
+    const std::string copy = "/tmp/test_packed_weights_model.cpp";
+    std::ofstream(copy) << text;
+    EI_TEST_EXPECT_EQ(check_tables(copy), 1);
+    remove(copy.c_str());
+}
+
+int main() {
+    EI_TEST_RUN(test_tables_up_to_date);
+    EI_TEST_RUN(test_check_finds_stale_table);
+    return ei_test_result();
+}
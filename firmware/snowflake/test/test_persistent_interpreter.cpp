@@ -0,0 +1,91 @@
+/* EI_CLASSIFIER_PERSISTENT_INTERPRETER: the compiled model is initialized on the first run and kept
+ * for the next ones, until run_classifier_deinit. The results don't change between runs, only the first
+ * run after a deinit pays for the setup, and the model comes back after a deinit */
+
+// test-flags: -DEI_CLASSIFIER_PERSISTENT_INTERPRETER=1
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "ei_test_keyword.h"
+#include <vector>
+
+static const int WINDOWS = 6;
+static const int RUNS = 5;
+
+static ei_eon_persistent_t *slot() {
+    return &inference_tflite_persistent()[0];
+}
+
+static ei_impulse_result_t classify(int window) {
+    std::vector<float> audio = ei_test_keyword_audio(window);
+    signal_t signal;
+    ei::numpy::signal_from_buffer(audio.data(), audio.size(), &signal);
+    ei_impulse_result_t result;
+    EI_TEST_EXPECT_EQ(run_classifier(&signal, &result), EI_IMPULSE_OK);
+    return result;
+}
+
+static void expect_same(const ei_impulse_result_t &actual, const ei_impulse_result_t &expected) {
+    for (int ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+        EI_TEST_EXPECT_EQ(actual.classification[ix].value, expected.classification[ix].value);
+    }
+}
+
+// the first run sets the model up, the others only read its tensors: within the resolution of the
+// microsecond timer
+static void check_runs(std::vector<ei_impulse_result_t> *expected) {
+    EI_TEST_EXPECT(slot()->model_init == nullptr);
+    for (int run = 0; run < RUNS; run++) {
+        for (int window = 0; window < WINDOWS; window++) {
+            const ei_impulse_result_t result = classify(window);
+            if (run == 0 && window == 0) {
+                EI_TEST_EXPECT(result.timing.classification_setup_us > 0);
+            }
+            else {
+                EI_TEST_EXPECT(result.timing.classification_setup_us <= 1);
+            }
+            EI_TEST_EXPECT(slot()->model_init != nullptr);
+
+            if ((int)expected->size() <= window) {
+                expected->push_back(result);
+            }
+            else {
+                expect_same(result, (*expected)[window]);
+            }
+        }
+    }
+}
+
+static void test_repeated_runs() {
+    std::vector<ei_impulse_result_t> expected;
+    check_runs(&expected);
+
+    // the first of them again after a deinit, set up once more
+    run_classifier_deinit();
+    EI_TEST_EXPECT(slot()->model_init == nullptr);
+    check_runs(&expected);
+    run_classifier_deinit();
+    EI_TEST_EXPECT(slot()->model_init == nullptr);
+}
+
+static void test_setup_cost() {
+    // what the setup the later runs skip costs on the host
+    int64_t first_us = 0, later_us = 0;
+    for (int run = 0; run < RUNS; run++) {
+        const ei_impulse_result_t first = classify(0);
+        first_us += first.timing.classification_setup_us;
+        for (int window = 1; window < WINDOWS; window++) {
+            later_us += classify(window).timing.classification_setup_us;
+        }
+        run_classifier_deinit();
+    }
+    printf("setup: %.1f us on the first run, %.2f us on the others\n", (double)first_us / RUNS,
+        (double)later_us / (RUNS * (WINDOWS - 1)));
+    EI_TEST_EXPECT(first_us > later_us);
+}
+
+int main() {
+    EI_TEST_RUN(test_repeated_runs);
+    EI_TEST_RUN(test_setup_cost);
+    return ei_test_result();
+}
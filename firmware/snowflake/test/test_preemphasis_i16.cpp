@@ -0,0 +1,157 @@
+/* int16 PCM signals (numpy::signal_from_int16_buffer), which preemphasis reads straight from the
+ * samples with get_data_i16, against the same samples as a float signal read through get_data: the
+ * same preemphasized audio, the same MFCC of a window and the same features slice by slice */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include <vector>
+
+using namespace ei;
+
+static const size_t SLICES = 8;
+
+// speech-like levels: a sweep, bursts, noise and a few clipped samples
+static std::vector<int16_t> test_pcm(size_t length) {
+    std::vector<int16_t> pcm(length);
+    for (size_t ix = 0; ix < length; ix++) {
+        const float envelope = (ix / 2500) % 3 == 0 ? 1.0f : 0.15f;
+        float v = envelope * 9000.0f * sinf(ix * (0.01f + ix * 3e-7f)) + ei_test_uniform(-600.0f, 600.0f);
+        if (ix % 997 == 0) {
+            v = ix % 2 ? 32767.0f : -32768.0f;
+        }
+        pcm[ix] = (int16_t)std::min(std::max(v, -32768.0f), 32767.0f);
+    }
+    return pcm;
+}
+
+static std::vector<float> to_float(const std::vector<int16_t> &pcm) {
+    return std::vector<float>(pcm.begin(), pcm.end());
+}
+
+// reads of `length` samples `stride` apart, overlapping when stride < length, and reads the MFCC
+// doesn't do: the first samples (offset < shift) on their own and straddling the shift. Both paths
+// against speechpy::processing::preemphasis over the whole signal; the float path keeps the history
+// of the read before when one starts under the shift but not at 0, so it's only compared on the others
+static void check_reads(size_t signal_length, int shift, float cof, bool rescale, size_t length,
+    size_t stride) {
+    std::vector<int16_t> pcm = test_pcm(signal_length);
+    std::vector<float> audio = to_float(pcm);
+    signal_t pcm_signal, float_signal;
+    numpy::signal_from_int16_buffer(pcm.data(), pcm.size(), &pcm_signal);
+    numpy::signal_from_buffer(audio.data(), audio.size(), &float_signal);
+    EI_TEST_EXPECT(pcm_signal.raw_i16 != nullptr);
+    EI_TEST_EXPECT(float_signal.raw_i16 == nullptr);
+
+    std::vector<float> reference = to_float(pcm);
+    EI_TEST_EXPECT_EQ(speechpy::processing::preemphasis(reference.data(), reference.size(), shift, cof), EIDSP_OK);
+    if (rescale) {
+        for (float &v : reference) {
+            v *= 1.0f / 32768.0f;
+        }
+    }
+
+    class speechpy::processing::preemphasis direct(&pcm_signal, shift, cof, rescale);
+    class speechpy::processing::preemphasis callback(&float_signal, shift, cof, rescale);
+
+    std::vector<size_t> offsets = { 0, 1, (size_t)shift - 1, (size_t)shift };
+    for (size_t offset = 0; offset + length <= signal_length; offset += stride) {
+        offsets.push_back(offset);
+    }
+
+    std::vector<float> actual(length);
+    size_t direct_mismatches = 0, callback_mismatches = 0;
+    for (size_t offset : offsets) {
+        const size_t n = std::min(length, signal_length - offset);
+        EI_TEST_EXPECT_EQ(direct.get_data(offset, n, actual.data()), EIDSP_OK);
+        for (size_t ix = 0; ix < n; ix++) {
+            direct_mismatches += actual[ix] != reference[offset + ix];
+        }
+        if (offset == 0 || offset >= (size_t)shift) {
+            EI_TEST_EXPECT_EQ(callback.get_data(offset, n, actual.data()), EIDSP_OK);
+            for (size_t ix = 0; ix < n; ix++) {
+                callback_mismatches += actual[ix] != reference[offset + ix];
+            }
+        }
+    }
+    if (direct_mismatches || callback_mismatches) {
+        printf("shift %d, cof %g, rescale %d, reads of %u every %u: %u (int16) and %u (float) samples differ\n",
+            shift, cof, rescale, (unsigned)length, (unsigned)stride, (unsigned)direct_mismatches,
+            (unsigned)callback_mismatches);
+    }
+    EI_TEST_EXPECT_EQ(direct_mismatches, 0);
+    EI_TEST_EXPECT_EQ(callback_mismatches, 0);
+
+    // past the end of the signal
+    EI_TEST_EXPECT(direct.get_data(signal_length - 1, 2, actual.data()) != EIDSP_OK);
+}
+
+static void test_preemphasis_reads() {
+    // the keyword model's frames, 400 samples every 320
+    check_reads(16000, 1, 0.98f, false, 400, 320);
+    check_reads(EI_CLASSIFIER_SLICE_SIZE, 1, 0.98f, false, 400, 320);
+    check_reads(16000, 1, 0.98f, true, 400, 320);
+    // a longer shift, the first reads come from the end of the signal
+    check_reads(4000, 3, 0.9f, false, 256, 100);
+    check_reads(4000, 7, 0.97f, true, 5, 3);
+    check_reads(1000, 1, 0.0f, false, 64, 64);
+}
+
+static void mfcc_features(signal_t *signal, matrix_t *features) {
+    const ei_model_dsp_t &block = ei_default_impulse.dsp_blocks[0];
+    EI_TEST_EXPECT_EQ(block.extract_fn(signal, features, block.config, EI_CLASSIFIER_FREQUENCY), EIDSP_OK);
+}
+
+static void test_mfcc_window() {
+    std::vector<int16_t> pcm = test_pcm(EI_CLASSIFIER_RAW_SAMPLE_COUNT);
+    std::vector<float> audio = to_float(pcm);
+    signal_t pcm_signal, float_signal;
+    numpy::signal_from_int16_buffer(pcm.data(), pcm.size(), &pcm_signal);
+    numpy::signal_from_buffer(audio.data(), audio.size(), &float_signal);
+
+    matrix_t expected(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE), actual(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    mfcc_features(&float_signal, &expected);
+    mfcc_features(&pcm_signal, &actual);
+    for (size_t ix = 0; ix < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; ix++) {
+        EI_TEST_EXPECT_EQ(actual.buffer[ix], expected.buffer[ix]);
+    }
+}
+
+static void test_mfcc_slices() {
+    std::vector<int16_t> pcm = test_pcm(SLICES * EI_CLASSIFIER_SLICE_SIZE);
+    std::vector<float> audio = to_float(pcm);
+    ei_classifier_context_t direct = { }, callback = { };
+    run_classifier_init(&direct, &ei_default_impulse);
+    run_classifier_init(&callback, &ei_default_impulse);
+
+    for (size_t slice = 0; slice < SLICES; slice++) {
+        signal_t pcm_signal, float_signal;
+        numpy::signal_from_int16_buffer(pcm.data() + slice * EI_CLASSIFIER_SLICE_SIZE, EI_CLASSIFIER_SLICE_SIZE,
+            &pcm_signal);
+        numpy::signal_from_buffer(audio.data() + slice * EI_CLASSIFIER_SLICE_SIZE, EI_CLASSIFIER_SLICE_SIZE,
+            &float_signal);
+
+        ei_impulse_result_t actual, expected;
+        EI_TEST_EXPECT_EQ(run_classifier_continuous(&direct, &ei_default_impulse, &pcm_signal, &actual),
+            EI_IMPULSE_OK);
+        EI_TEST_EXPECT_EQ(run_classifier_continuous(&callback, &ei_default_impulse, &float_signal, &expected),
+            EI_IMPULSE_OK);
+
+        // the features ring, then what the window classified as
+        for (size_t ix = 0; ix < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; ix++) {
+            EI_TEST_EXPECT_EQ(direct.features->buffer[ix], callback.features->buffer[ix]);
+        }
+        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+            EI_TEST_EXPECT_EQ(actual.classification[ix].value, expected.classification[ix].value);
+        }
+    }
+
+    run_classifier_deinit(&direct);
+    run_classifier_deinit(&callback);
+}
+
+int main() {
+    EI_TEST_RUN(test_preemphasis_reads);
+    EI_TEST_RUN(test_mfcc_window);
+    EI_TEST_RUN(test_mfcc_slices);
+    return ei_test_result();
+}
@@ -0,0 +1,144 @@
+/* spectral::feature::extract_spec_features_q (EIDSP_SPECTRAL_FIXED_POINT) against the float
+ * extract_spec_features. The fixed point path is not bit exact: these are the tolerances it is held to */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/dsp/spectral/spectral.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace ei;
+
+static const size_t AXES = 3;
+static const size_t SAMPLES = 200;
+static const float FREQUENCY = 100.0f;
+static const size_t WINDOWS = 20;
+
+// relative tolerance of the time domain features (RMS, kurtosis) and absolute one of the skew,
+// which is close to 0 for these signals
+static const float RMS_TOLERANCE = 1e-3f;
+static const float SKEW_TOLERANCE = 2e-3f;
+static const float KURTOSIS_TOLERANCE = 2e-3f;
+// power bins relative to the largest bin of the axis (quiet bins are at the Q15 FFT's noise floor),
+// the spectral skew / kurtosis of v4 relative, and the log10 of the bins in absolute terms. The
+// largest differences seen are printed, about a third of these
+static const float BIN_TOLERANCE = 1e-2f;
+static const float SPECTRAL_SHAPE_TOLERANCE = 2e-2f;
+static const float LOG_BIN_TOLERANCE = 5e-2f;
+
+static float max_error[4] = { };
+
+// accelerometer like: gravity on one axis, a few tones and noise
+static std::vector<float> test_window(size_t window) {
+    std::vector<float> samples(SAMPLES * AXES);
+    for (size_t ix = 0; ix < SAMPLES; ix++) {
+        const float t = ix / FREQUENCY;
+        for (size_t axis = 0; axis < AXES; axis++) {
+            float value = axis == 2 ? 9.81f : 0.0f;
+            value += (2.0f + axis) * sinf(2 * M_PI * (1.5f + window * 0.3f + axis) * t);
+            value += 0.8f * sinf(2 * M_PI * (12.0f + axis * 7) * t + window);
+            value += ei_test_uniform(-0.5f, 0.5f);
+            samples[ix * AXES + axis] = value;
+        }
+    }
+    return samples;
+}
+
+// |actual - expected| / scale within tolerance, keeps the largest one per kind of feature
+static bool within(float actual, float expected, float tolerance, float scale, size_t kind) {
+    const float error = fabsf(actual - expected) / scale;
+    if (error > max_error[kind]) {
+        max_error[kind] = error;
+    }
+    return error <= tolerance;
+}
+
+static void check_config(const char *filter_type, float cutoff, int fft_length, int version, bool do_log) {
+    ei_dsp_config_spectral_analysis_t config = { 1, (uint16_t)version, (int)AXES, 1.0f, 1, filter_type, cutoff,
+        6, "FFT", fft_length, 3, 0.1f, "0.1, 0.5, 1.0, 2.0, 5.0", do_log, true, 1, "db4", false };
+
+    for (size_t window = 0; window < WINDOWS; window++) {
+        std::vector<float> samples = test_window(window);
+        std::vector<float> samples_q = samples;
+        matrix_t input(SAMPLES, AXES, samples.data());
+        matrix_t input_q(SAMPLES, AXES, samples_q.data());
+        matrix_t expected(1, 1024), actual(1, 1024);
+
+        const size_t count = spectral::feature::extract_spec_features(&input, &expected, &config, FREQUENCY);
+        const size_t count_q = spectral::feature::extract_spec_features_q(&input_q, &actual, &config, FREQUENCY);
+        EI_TEST_EXPECT_EQ(count_q, count);
+        if (count != count_q) {
+            return;
+        }
+
+        const size_t per_axis = count / AXES;
+        const size_t first_bin = version == 4 ? 5 : 3;
+        for (size_t axis = 0; axis < AXES; axis++) {
+            const float *e = expected.buffer + axis * per_axis;
+            const float *a = actual.buffer + axis * per_axis;
+
+            bool ok = within(a[0], e[0], RMS_TOLERANCE, fabsf(e[0]), 0) &&
+                within(a[1], e[1], SKEW_TOLERANCE, 1, 0) &&
+                within(a[2], e[2], KURTOSIS_TOLERANCE, 1 + fabsf(e[2]), 0);
+            if (version == 4) {
+                ok = ok && within(a[3], e[3], SPECTRAL_SHAPE_TOLERANCE, 1 + fabsf(e[3]), 1) &&
+                    within(a[4], e[4], SPECTRAL_SHAPE_TOLERANCE, 1 + fabsf(e[4]), 1);
+            }
+
+            const float largest_bin = *std::max_element(e + first_bin, e + per_axis);
+            for (size_t ix = first_bin; ix < per_axis; ix++) {
+                if (do_log) {
+                    // quiet bins are near the Q15 noise floor, compare the ones within 40 dB of the peak
+                    if (e[ix] > largest_bin - 4) {
+                        ok = ok && within(a[ix], e[ix], LOG_BIN_TOLERANCE, 1, 3);
+                    }
+                }
+                else {
+                    ok = ok && within(a[ix], e[ix], BIN_TOLERANCE, largest_bin, 2);
+                }
+            }
+
+            if (!ok) {
+                printf("%s filter, FFT %d, v%d, log %d, window %u, axis %u:\n", filter_type, fft_length,
+                    version, (int)do_log, (unsigned)window, (unsigned)axis);
+                for (size_t ix = 0; ix < per_axis; ix++) {
+                    printf("  %2u: %g vs %g\n", (unsigned)ix, a[ix], e[ix]);
+                }
+                ei_test_failures++;
+                return;
+            }
+        }
+    }
+}
+
+static void test_within_tolerance() {
+    const char *filters[][2] = { { "low", "3" }, { "high", "5" }, { "none", "0" } };
+    const int fft_lengths[] = { 16, 64, 128 };
+    for (auto &filter : filters) {
+        for (int fft_length : fft_lengths) {
+            for (int version : { 2, 4 }) {
+                for (bool do_log : { false, true }) {
+                    check_config(filter[0], atof(filter[1]), fft_length, version, do_log);
+                }
+            }
+        }
+    }
+    printf("largest differences: time domain %g (relative), spectral shape %g (relative), bins %g (of the peak bin), "
+        "log10 bins %g\n",
+        max_error[0], max_error[1], max_error[2], max_error[3]);
+}
+
+static void test_not_power_of_2() {
+    ei_dsp_config_spectral_analysis_t config = { 1, 2, (int)AXES, 1.0f, 1, "none", 0.0f,
+        6, "FFT", 100, 3, 0.1f, "0.1, 0.5, 1.0, 2.0, 5.0", false, true, 1, "db4", false };
+    std::vector<float> samples = test_window(0);
+    matrix_t input(SAMPLES, AXES, samples.data());
+    matrix_t output(1, 1024);
+    EI_TEST_EXPECT_EQ((int)spectral::feature::extract_spec_features_q(&input, &output, &config, FREQUENCY),
+        EIDSP_PARAMETER_INVALID);
+}
+
+int main() {
+    EI_TEST_RUN(test_within_tolerance);
+    EI_TEST_RUN(test_not_power_of_2);
+    return ei_test_result();
+}
@@ -0,0 +1,256 @@
+/* The streaming filters of dsp/spectral/stream_filter.hpp keep their delay line between calls: fed a
+ * stream in blocks of random sizes, in place, they give exactly what they give on the whole stream in
+ * one go, in float, Q15 and Q31. The one-shot output is held to the same filter in double, and a filter
+ * set on a classifier context with run_classifier_set_stream_filter gives the features of the stream
+ * filtered up front */
+
+#include "ei_test.h"
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include <type_traits>
+#include <vector>
+
+using namespace ei;
+using namespace ei::spectral;
+
+static_assert(!std::is_copy_constructible<stream_fir<float>>::value, "stream_fir can't be copied");
+static_assert(!std::is_copy_assignable<stream_fir<EIDSP_i16>>::value, "stream_fir can't be copied");
+static_assert(!std::is_copy_constructible<stream_biquad_f32>::value, "stream_biquad_f32 can't be copied");
+static_assert(!std::is_copy_assignable<stream_biquad_f32>::value, "stream_biquad_f32 can't be copied");
+static_assert(!std::is_copy_constructible<stream_biquad_q31>::value, "stream_biquad_q31 can't be copied");
+static_assert(!std::is_copy_assignable<stream_biquad_q31>::value, "stream_biquad_q31 can't be copied");
+
+static const size_t LENGTH = 5000;
+static const size_t SLICES = 8;
+
+// int16 PCM levels: two tones, a chirp and noise, the same on every call
+static std::vector<float> test_signal(size_t length) {
+    static std::vector<float> signal;
+    while (signal.size() < length) {
+        const size_t ix = signal.size();
+        signal.push_back(6000.0f * sinf(ix * 0.05f) + 3000.0f * sinf(ix * 1.9f) +
+            2000.0f * sinf(ix * (0.2f + ix * 1e-4f)) + ei_test_uniform(-1500.0f, 1500.0f));
+    }
+    return std::vector<float>(signal.begin(), signal.begin() + length);
+}
+
+// the whole input in one call, or in place in blocks of 0 up to 3 * EIDSP_STREAM_FILTER_BLOCK samples
+static std::vector<float> filter_stream(stream_filter &filter, const std::vector<float> &input, bool one_shot) {
+    std::vector<float> output(input);
+    if (one_shot) {
+        EI_TEST_EXPECT_EQ(filter.run(input.data(), output.data(), input.size()), EIDSP_OK);
+        return output;
+    }
+    for (size_t offset = 0; offset < output.size(); ) {
+        const size_t block = std::min((size_t)(ei_test_rand() % (3 * EIDSP_STREAM_FILTER_BLOCK + 1)),
+            output.size() - offset);
+        EI_TEST_EXPECT_EQ(filter.run(output.data() + offset, output.data() + offset, block), EIDSP_OK);
+        offset += block;
+    }
+    return output;
+}
+
+// one filter on the stream in one go, the other in blocks, then again after a reset;
+// returns the one-shot output
+static std::vector<float> check_blocks(stream_filter &one_shot, stream_filter &blocks, const char *name) {
+    const std::vector<float> input = test_signal(LENGTH);
+    const std::vector<float> expected = filter_stream(one_shot, input, true);
+
+    for (int pass = 0; pass < 2; pass++) {
+        const std::vector<float> actual = filter_stream(blocks, input, false);
+        size_t mismatches = 0;
+        for (size_t ix = 0; ix < LENGTH; ix++) {
+            mismatches += actual[ix] != expected[ix];
+        }
+        if (mismatches) {
+            printf("%s, pass %d: %u of %u samples differ\n", name, pass, (unsigned)mismatches, (unsigned)LENGTH);
+        }
+        EI_TEST_EXPECT_EQ(mismatches, 0);
+        blocks.reset();
+    }
+    return expected;
+}
+
+static void expect_near(const std::vector<float> &actual, const std::vector<double> &expected, double tolerance,
+    const char *name) {
+    double max_error = 0;
+    for (size_t ix = 0; ix < actual.size(); ix++) {
+        max_error = std::max(max_error, fabs(actual[ix] - expected[ix]));
+    }
+    printf("%s: max error %g against the double filter\n", name, max_error);
+    EI_TEST_EXPECT(max_error <= tolerance);
+}
+
+// a windowed sinc low pass, b[0] first
+static std::vector<float> lowpass_taps(size_t num_taps) {
+    std::vector<float> taps(num_taps);
+    float sum = 0;
+    for (size_t ix = 0; ix < num_taps; ix++) {
+        const float t = ix - (num_taps - 1) / 2.0f;
+        const float sinc = t == 0 ? 1.0f : sinf((float)M_PI * 0.25f * t) / ((float)M_PI * 0.25f * t);
+        const float window = num_taps == 1 ? 1.0f : 0.54f - 0.46f * cosf(2 * (float)M_PI * ix / (num_taps - 1));
+        taps[ix] = sinc * window;
+        sum += taps[ix];
+    }
+    for (float &tap : taps) {
+        tap *= 0.9f / sum;
+    }
+    return taps;
+}
+
+static std::vector<double> reference_fir(const std::vector<float> &taps, const std::vector<float> &input) {
+    std::vector<double> output(input.size());
+    for (size_t n = 0; n < input.size(); n++) {
+        for (size_t k = 0; k < taps.size() && k <= n; k++) {
+            output[n] += (double)taps[k] * input[n - k];
+        }
+    }
+    return output;
+}
+
+template<typename T>
+static void check_fir(size_t num_taps, double tolerance, const char *name) {
+    const std::vector<float> taps = lowpass_taps(num_taps);
+    stream_fir<T> one_shot(taps.data(), taps.size()), blocks(taps.data(), taps.size());
+    EI_TEST_EXPECT(one_shot.is_valid() && blocks.is_valid());
+    const std::vector<float> output = check_blocks(one_shot, blocks, name);
+    expect_near(output, reference_fir(taps, test_signal(LENGTH)), tolerance, name);
+}
+
+static void test_fir() {
+    // odd tap counts are padded for Q15, one tap is a gain
+    check_fir<float>(31, 0.05, "FIR f32, 31 taps");
+    check_fir<float>(1, 0.01, "FIR f32, 1 tap");
+    check_fir<EIDSP_i16>(31, 8.0, "FIR Q15, 31 taps");
+    check_fir<EIDSP_i16>(5, 4.0, "FIR Q15, 5 taps");
+    check_fir<EIDSP_i32>(31, 0.05, "FIR Q31, 31 taps");
+    check_fir<EIDSP_i32>(2, 0.01, "FIR Q31, 2 taps");
+}
+
+static void test_fir_q15_native() {
+    // int16 samples straight in, without the float conversion
+    const std::vector<float> taps = lowpass_taps(31);
+    stream_fir<EIDSP_i16> one_shot(taps.data(), taps.size()), blocks(taps.data(), taps.size());
+    const std::vector<float> signal = test_signal(LENGTH);
+    std::vector<EIDSP_i16> input(signal.begin(), signal.end());
+
+    std::vector<EIDSP_i16> expected(LENGTH), actual(input);
+    EI_TEST_EXPECT_EQ(one_shot.run_native(input.data(), expected.data(), LENGTH), EIDSP_OK);
+    for (size_t offset = 0; offset < LENGTH; ) {
+        const size_t block = std::min((size_t)(1 + ei_test_rand() % 200), LENGTH - offset);
+        EI_TEST_EXPECT_EQ(blocks.run_native(actual.data() + offset, actual.data() + offset, block), EIDSP_OK);
+        offset += block;
+    }
+    size_t mismatches = 0;
+    for (size_t ix = 0; ix < LENGTH; ix++) {
+        mismatches += actual[ix] != expected[ix];
+    }
+    EI_TEST_EXPECT_EQ(mismatches, 0);
+}
+
+// the Butterworth sections of filters::butterworth_biquad_q31, {b0, b1, b2, a0, a1, a2} per section
+static std::vector<float> butterworth_sos(int order, float sampling_freq, float cutoff, bool high_pass) {
+    std::vector<float> sos;
+    const double a = tan(M_PI * cutoff / sampling_freq), a2 = a * a;
+    for (int ix = 0; ix < order / 2; ix++) {
+        const double r = sin(M_PI * (2.0 * ix + 1.0) / (2.0 * order));
+        const double s = a2 + 2.0 * a * r + 1.0;
+        const double gain = high_pass ? 1.0 / s : a2 / s;
+        const double d1 = 2.0 * (1 - a2) / s, d2 = -(a2 - 2.0 * a * r + 1.0) / s;
+        const float section[6] = { (float)gain, (float)(high_pass ? -2.0 * gain : 2.0 * gain), (float)gain, 1.0f,
+            (float)-d1, (float)-d2 };
+        sos.insert(sos.end(), section, section + 6);
+    }
+    return sos;
+}
+
+static std::vector<double> reference_sos(const std::vector<float> &sos, const std::vector<float> &input) {
+    std::vector<double> output(input.begin(), input.end());
+    for (size_t section = 0; section < sos.size() / 6; section++) {
+        const float *c = sos.data() + section * 6;
+        double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+        for (double &v : output) {
+            const double y = (c[0] * v + c[1] * x1 + c[2] * x2 - c[4] * y1 - c[5] * y2) / c[3];
+            x2 = x1;
+            x1 = v;
+            y2 = y1;
+            y1 = y;
+            v = y;
+        }
+    }
+    return output;
+}
+
+static void check_biquads(int order, float cutoff, bool high_pass, const char *name) {
+    const std::vector<float> sos = butterworth_sos(order, 16000.0f, cutoff, high_pass);
+    const std::vector<double> expected = reference_sos(sos, test_signal(LENGTH));
+
+    stream_biquad_f32 one_shot(sos.data(), sos.size() / 6), blocks(sos.data(), sos.size() / 6);
+    EI_TEST_EXPECT(one_shot.is_valid() && blocks.is_valid());
+    expect_near(check_blocks(one_shot, blocks, name), expected, 0.1, name);
+
+    EIDSP_i32 coeffs[5 * 4];
+    size_t stages = 0;
+    EI_TEST_EXPECT_EQ(filters::butterworth_biquad_q31(order, 16000.0f, cutoff, high_pass, coeffs, 4, &stages),
+        EIDSP_OK);
+    EI_TEST_EXPECT_EQ(stages, sos.size() / 6);
+    stream_biquad_q31 one_shot_q(coeffs, stages), blocks_q(coeffs, stages);
+    EI_TEST_EXPECT(one_shot_q.is_valid() && blocks_q.is_valid());
+    expect_near(check_blocks(one_shot_q, blocks_q, name), expected, 0.5, name);
+}
+
+static void test_biquads() {
+    check_biquads(4, 1000.0f, false, "Butterworth low pass, order 4");
+    check_biquads(8, 300.0f, false, "Butterworth low pass, order 8");
+    check_biquads(2, 200.0f, true, "Butterworth high pass, order 2");
+    check_biquads(6, 2500.0f, true, "Butterworth high pass, order 6");
+}
+
+// slices through a context with the filter, against the stream filtered in one go through one without
+static void test_classifier_stream_filter() {
+    EIDSP_i32 coeffs[5 * 2];
+    size_t stages = 0;
+    EI_TEST_EXPECT_EQ(filters::butterworth_biquad_q31(4, EI_CLASSIFIER_FREQUENCY, 100.0f, true, coeffs, 2, &stages),
+        EIDSP_OK);
+    stream_biquad_q31 filter(coeffs, stages), up_front(coeffs, stages);
+
+    const std::vector<float> audio = test_signal(SLICES * EI_CLASSIFIER_SLICE_SIZE);
+    std::vector<float> filtered(audio.size());
+    EI_TEST_EXPECT_EQ(up_front.run(audio.data(), filtered.data(), audio.size()), EIDSP_OK);
+
+    ei_classifier_context_t with_filter = { }, without = { };
+    run_classifier_init(&with_filter, &ei_default_impulse);
+    run_classifier_init(&without, &ei_default_impulse);
+    run_classifier_set_stream_filter(&with_filter, &filter);
+
+    for (size_t slice = 0; slice < SLICES; slice++) {
+        signal_t signal, filtered_signal;
+        numpy::signal_from_buffer(audio.data() + slice * EI_CLASSIFIER_SLICE_SIZE, EI_CLASSIFIER_SLICE_SIZE,
+            &signal);
+        numpy::signal_from_buffer(filtered.data() + slice * EI_CLASSIFIER_SLICE_SIZE, EI_CLASSIFIER_SLICE_SIZE,
+            &filtered_signal);
+
+        ei_impulse_result_t actual, expected;
+        EI_TEST_EXPECT_EQ(run_classifier_continuous(&with_filter, &ei_default_impulse, &signal, &actual),
+            EI_IMPULSE_OK);
+        EI_TEST_EXPECT_EQ(run_classifier_continuous(&without, &ei_default_impulse, &filtered_signal, &expected),
+            EI_IMPULSE_OK);
+        for (size_t ix = 0; ix < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; ix++) {
+            EI_TEST_EXPECT_EQ(with_filter.features->buffer[ix], without.features->buffer[ix]);
+        }
+        for (size_t ix = 0; ix < EI_CLASSIFIER_LABEL_COUNT; ix++) {
+            EI_TEST_EXPECT_EQ(actual.classification[ix].value, expected.classification[ix].value);
+        }
+    }
+
+    run_classifier_set_stream_filter(&with_filter, nullptr);
+    run_classifier_deinit(&with_filter);
+    run_classifier_deinit(&without);
+}
+
+int main() {
+    EI_TEST_RUN(test_fir);
+    EI_TEST_RUN(test_fir_q15_native);
+    EI_TEST_RUN(test_biquads);
+    EI_TEST_RUN(test_classifier_stream_filter);
+    return ei_test_result();
+}
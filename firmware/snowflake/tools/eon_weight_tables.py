@@ -0,0 +1,286 @@
+#!/usr/bin/env python3
+"""Write the weight tables of a compiled (EON) model that are derived from the generated ones.
+
+tflite_learn_5_compiled.cpp carries some of its weights twice, the table the EON compiler generated
+and, under a build flag, the same weights reworked for a kernel. This rewrites the values of the
+reworked tables from the generated ones, so they're never edited by hand:
+
+  EI_CLASSIFIER_TFLITE_INT4_WEIGHTS
+    - the CONV_2D and FULLY_CONNECTED filters requantized to [-7, 7], w * 7 / max|w| rounded half
+      away from zero, per output channel if the filter is (per tensor otherwise), and packed two per
+      byte. The scale of the filter and of its bias grow by max|w| / 7 and the bias is requantized
+      the same way. Made from the tables under neither flag: the weights are not retrained
+  EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS (see ei_packed_weights.h)
+    - the CONV_2D filters, reordered per group of 4 for arm_convolve_s8_reordered: the table under
+      EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS is made from the one under its #else
+    - folded_biasN of each FULLY_CONNECTED node, its bias tensor_dataN minus the input zero point
+      times the sum of each filter row, for every variant of the filter (int8, int4)
+
+The conv and fully connected nodes, and which tensors are their input, filter and bias, are read
+from the node tables of the file. Only the values between the braces are rewritten; the
+declarations and the #if regions they sit in have to be there already.
+
+    python3 tools/eon_weight_tables.py src/tflite-model/tflite_learn_5_compiled.cpp
+    python3 tools/eon_weight_tables.py --check src/tflite-model/tflite_learn_5_compiled.cpp
+
+test/test_packed_weights.cpp runs --check in the host tests.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+PACKED = 'EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS'
+INT4 = 'EI_CLASSIFIER_TFLITE_INT4_WEIGHTS'
+
+DIRECTIVE = re.compile(r'^#(if|ifdef|ifndef|elif|else|endif)\b\s*(.*?)\s*(//.*)?$')
+DEFINITION = re.compile(r'^const [^=]*?\b(\w+)(\[[^\]]*\])? = \{')
+NUMBER = re.compile(r'-?\d+(?:\.\d*)?(?:[eE][-+]?\d+)?')
+COMMENT = re.compile(r'/\*.*?\*/')
+
+
+class Table:
+    """A `const ... name[...] = { ... };` definition: where its values are and the flags it's under."""
+
+    def __init__(self, name, conditions, start, end, text):
+        self.name = name
+        # the declared type, e.g. TfLiteConvParams for the op data of a conv node
+        self.type = re.match(r'const (?:ALIGN\(\d+\) )?(\w+)', text).group(1)
+        self.conditions = conditions
+        # line range of the definition, [start, end]
+        self.start = start
+        self.end = end
+        body = text[text.index('= {') + 3:text.rindex('};')]
+        self.values = [float(v) if '.' in v or 'e' in v.lower() else int(v)
+                       for v in NUMBER.findall(COMMENT.sub(' ', body))]
+
+
+def parse(lines):
+    """Every table of the file, with the EI_CLASSIFIER_TFLITE_* conditions it's under ("!X" for an #else)."""
+    tables = []
+    branches = []
+    ix = 0
+    while ix < len(lines):
+        line = lines[ix]
+        m = DIRECTIVE.match(line)
+        if m:
+            kind, condition = m.group(1), m.group(2)
+            if kind == 'if':
+                branches.append(([], condition))
+            elif kind in ('ifdef', 'ifndef'):
+                branches.append(([], ('!' if kind == 'ifndef' else '') + 'defined(' + condition + ')'))
+            elif kind == 'endif':
+                branches.pop()
+            else:
+                not_taken, taken = branches.pop()
+                branches.append((not_taken + [taken], condition if kind == 'elif' else ''))
+            ix += 1
+            continue
+
+        m = DEFINITION.match(line)
+        if not m:
+            ix += 1
+            continue
+        start = ix
+        while '};' not in lines[ix]:
+            ix += 1
+        conditions = []
+        for not_taken, taken in branches:
+            conditions += ['!' + c for c in not_taken] + ([taken] if taken else [])
+        conditions = [c for c in conditions if 'EI_CLASSIFIER_TFLITE_' in c]
+        tables.append(Table(m.group(1), conditions, start, ix, '\n'.join(lines[start:ix + 1])))
+        ix += 1
+    return tables
+
+
+def find(tables, name, conditions=None):
+    """The table `name` under exactly these conditions, or under any if None (it must be unique then)."""
+    found = [t for t in tables if t.name == name and (conditions is None or t.conditions == conditions)]
+    if len(found) != 1:
+        raise ValueError('%d definitions of %s under %s' % (len(found), name, conditions))
+    return found[0]
+
+
+def nodes(tables, params_types):
+    """(input, filter, bias) tensor indices of the nodes whose op data is one of `params_types`."""
+    res = set()
+    for t in tables:
+        m = re.match(r'opdata(\d+)$', t.name)
+        if not m:
+            continue
+        if t.type not in params_types:
+            continue
+        inputs = [i for i in tables if i.name == 'inputs' + m.group(1) and i.conditions == t.conditions]
+        if len(inputs) == 1 and inputs[0].values[0] == 3:
+            res.add(tuple(inputs[0].values[1:4]))
+    return sorted(res)
+
+
+def reorder(filter_dims, weights):
+    """arm_convolve_s8_reorder_filter(): (w0, w1, w2, w3) -> (w0, w2, w1, w3) per output channel."""
+    row_length = filter_dims[1] * filter_dims[2] * filter_dims[3]
+    out = []
+    for ch in range(filter_dims[0]):
+        row = weights[ch * row_length:(ch + 1) * row_length]
+        for i in range(0, row_length - row_length % 4, 4):
+            row[i + 1], row[i + 2] = row[i + 2], row[i + 1]
+        out.append(row)
+    return out
+
+
+def int4_values(packed, count):
+    """Two per byte, element 2k in the low nibble of byte k."""
+    out = []
+    for ix in range(count):
+        nibble = (packed[ix // 2] & 0xff) >> (4 * (ix % 2)) & 0xf
+        out.append(nibble - 16 if nibble >= 8 else nibble)
+    return out
+
+
+def row_sums(tables, filter_table, conditions):
+    """Sum of each row of a FULLY_CONNECTED filter under `conditions`, as the kernel sees it."""
+    rows, depth = find(tables, 'tensor_dimension%d' % filter_table, conditions).values[1:3]
+    weights = find(tables, 'tensor_data%d' % filter_table, conditions).values
+    if INT4 in conditions:
+        weights = int4_values(weights, rows * depth)
+    return [sum(weights[r * depth:(r + 1) * depth]) for r in range(rows)]
+
+
+def round_away(x):
+    """Round half away from zero, as TFLite quantizes."""
+    return int(x + 0.5) if x >= 0 else -int(-x + 0.5)
+
+
+def float32(x):
+    return struct.unpack('f', struct.pack('f', x))[0]
+
+
+def requantize_int4(weights, scales, bias, bias_scales):
+    """(weights, scales, bias, bias scales) of an int8 filter requantized to int4, one scale per
+    output channel (the rows of `weights`) or a single one for the whole tensor."""
+    rows = len(bias)
+    row_length = len(weights) // rows
+    if len(scales) == 1:
+        maxima = [max(abs(w) for w in weights)] * rows
+    else:
+        maxima = [max(abs(w) for w in weights[r * row_length:(r + 1) * row_length]) for r in range(rows)]
+    out = [round_away(w * 7 / maxima[ix // row_length]) for ix, w in enumerate(weights)]
+    out_bias = [round_away(b * 7 / maxima[r]) for r, b in enumerate(bias)]
+    out_scales = [float32(s * maxima[ix * (rows // len(scales))] / 7) for ix, s in enumerate(scales)]
+    out_bias_scales = [float32(s * maxima[ix * (rows // len(bias_scales))] / 7)
+                       for ix, s in enumerate(bias_scales)]
+    return out, out_scales, out_bias, out_bias_scales
+
+
+def int4_packed(values):
+    """Two per byte, element 2k in the low nibble of byte k."""
+    out = []
+    for ix in range(0, len(values), 2):
+        byte = (values[ix] & 0xf) | (values[ix + 1] & 0xf) << 4
+        out.append(byte - 256 if byte >= 128 else byte)
+    return out
+
+
+def tf_array_body(values):
+    """The values of a TfArray<N, float> initializer, { N, { ... } }."""
+    return ' %d, { %s} ' % (len(values), ''.join('%r, ' % v for v in values))
+
+
+def write_values(lines, table, body_lines):
+    """Replace the values of `table`, keeping its declaration line."""
+    header = lines[table.start]
+    if table.start == table.end:
+        lines[table.start] = header[:header.index('= {') + 3] + body_lines[0] + '};'
+    else:
+        lines[table.start:table.end + 1] = [header] + body_lines + ['};']
+
+
+def generate(lines):
+    """`lines` with the derived tables rewritten."""
+    tables = parse(lines)
+
+    # int4 filters and their biases, from the tables under no flag: conv filters one line per
+    # output channel and row, a group of bytes per column, fully connected ones one line per row
+    for _, f, b in nodes(tables, ('TfLiteConvParams', 'EiConvMaxPoolParams', 'TfLiteFullyConnectedParams')):
+        for int4 in [t for t in tables if t.name == 'tensor_data%d' % f and INT4 in t.conditions]:
+            conditions = int4.conditions
+
+            def original(name):
+                found = [t for t in tables if t.name == name and t.conditions
+                         and all(c.startswith('!') for c in t.conditions)]
+                if len(found) != 1:
+                    raise ValueError('%d definitions of %s under no flag' % (len(found), name))
+                return found[0].values
+
+            dims = find(tables, 'tensor_dimension%d' % f, conditions).values[1:]
+            weights, scales, bias, bias_scales = requantize_int4(
+                original('tensor_data%d' % f), original('quant%d_scale' % f)[1:],
+                original('tensor_data%d' % b), original('quant%d_scale' % b)[1:])
+            packed = int4_packed(weights)
+            if len(dims) == 4:
+                if dims[3] % 2:
+                    raise ValueError('tensor_data%d: odd input depth, the rows do not split in bytes' % f)
+                group = dims[3] // 2
+                groups = [packed[ix:ix + group] for ix in range(0, len(packed), group)]
+                body = ['  /* [%d][%d][][] */ %s, ' % (line // dims[1], line % dims[1], ', '.join(
+                    ','.join(str(v) for v in g) for g in groups[line * dims[2]:(line + 1) * dims[2]]))
+                    for line in range(dims[0] * dims[1])]
+            else:
+                row = len(packed) // dims[0]
+                body = ['  ' + ''.join('%d, ' % v for v in packed[r * row:(r + 1) * row])
+                        for r in range(dims[0])]
+            write_values(lines, int4, body)
+            write_values(lines, find(tables, 'quant%d_scale' % f, conditions), [tf_array_body(scales)])
+            write_values(lines, find(tables, 'tensor_data%d' % b, conditions),
+                         [' ' + ''.join('%d, ' % v for v in bias)])
+            write_values(lines, find(tables, 'quant%d_scale' % b, conditions), [tf_array_body(bias_scales)])
+            tables = parse(lines)
+
+    # reordered conv filters, from the table under the #else of EI_CLASSIFIER_TFLITE_PACKED_WEIGHTS
+    conv_filters = sorted({f for _, f, _ in nodes(tables, ('TfLiteConvParams', 'EiConvMaxPoolParams'))})
+    for f in conv_filters:
+        for packed in [t for t in tables if t.name == 'tensor_data%d' % f and PACKED in t.conditions]:
+            base = packed.conditions[:-1]
+            original = find(tables, packed.name, base + ['!' + PACKED])
+            dims = find(tables, 'tensor_dimension%d' % f, base).values[1:]
+            rows = reorder(dims, list(original.values))
+            body = ['  /* [%d] */ %s, ' % (ch, ','.join(str(v) for v in row)) for ch, row in enumerate(rows)]
+            write_values(lines, packed, body)
+
+    # folded fully connected biases, for each variant of the filter (the line numbers moved if a
+    # table above changed its number of lines)
+    tables = parse(lines)
+    for input_tensor, f, b in nodes(tables, ('TfLiteFullyConnectedParams',)):
+        zero_point = find(tables, 'quant%d_zero' % input_tensor).values[1]
+        for folded in [t for t in tables if t.name == 'folded_bias%d' % b]:
+            base = folded.conditions[:-1]
+            bias = find(tables, 'tensor_data%d' % b, base).values
+            sums = row_sums(tables, f, base)
+            values = [bias[r] - zero_point * sums[r] for r in range(len(bias))]
+            write_values(lines, folded, [' ' + ''.join('%d, ' % v for v in values)])
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('model', help='tflite_learn_5_compiled.cpp')
+    parser.add_argument('--check', action='store_true',
+                        help="don't write, exit with 1 if the tables are not what they'd be written as")
+    args = parser.parse_args()
+
+    with open(args.model) as f:
+        lines = f.read().split('\n')
+    out = generate(list(lines))
+    if args.check:
+        changed = [ix + 1 for ix, (a, b) in enumerate(zip(lines, out)) if a != b]
+        if changed or len(lines) != len(out):
+            print('%s: derived tables out of date (line %d)' % (args.model, (changed or [len(out)])[0]))
+            sys.exit(1)
+        return
+    with open(args.model, 'w') as f:
+        f.write('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""Pull a Tracer::dump() out of a serial log and write it as a Chrome trace file.
+
+The firmware prints the trace in Chrome trace_event JSON, one event per line, but log lines from the
+other threads can land in the middle of it. This keeps only the event lines, puts them in time order and
+drops the begin / end events that lost their other half when the ring buffers wrapped.
+
+    particle serial monitor --follow | tee serial.log
+    (double click the button)
+    python3 tools/trace_to_json.py serial.log trace.json
+
+Open trace.json in chrome://tracing or https://ui.perfetto.dev
+"""
+
+import argparse
+import json
+import sys
+
+START = '{"traceEvents":['
+END = ']'
+
+
+def read_dumps(lines):
+    """Events of every dump in the log, a list per dump."""
+    dumps = []
+    events = None
+    for line in lines:
+        line = line.strip()
+        if line.endswith(START):
+            events = []
+            dumps.append(events)
+            continue
+        if events is None:
+            continue
+        if line.startswith(END):
+            events = None
+            continue
+
+        line = line.strip(',')
+        if not line.startswith('{'):
+            continue
+        try:
+            event = json.loads(line)
+        except ValueError:
+            # a log line that got printed into the middle of an event
+            continue
+        if isinstance(event, dict) and 'ph' in event:
+            events.append(event)
+    return dumps
+
+
+def pair_events(events):
+    """Sort by time, drop an E without its B and close a B that never ended."""
+    metadata = [e for e in events if e['ph'] == 'M']
+    timed = sorted((e for e in events if e['ph'] != 'M'), key=lambda e: e['ts'])
+
+    out = []
+    open_scopes = {}
+    for event in timed:
+        stack = open_scopes.setdefault(event['tid'], [])
+        if event['ph'] == 'B':
+            stack.append(event)
+        elif event['ph'] == 'E':
+            names = [begin['name'] for begin in stack]
+            if event['name'] not in names:
+                continue
+            # close what was opened inside it and lost its end
+            while stack[-1]['name'] != event['name']:
+                begin = stack.pop()
+                out.append({'name': begin['name'], 'ph': 'E', 'pid': begin['pid'], 'tid': begin['tid'], 'ts': event['ts']})
+            stack.pop()
+        out.append(event)
+
+    if timed:
+        last = timed[-1]['ts']
+        for tid, stack in open_scopes.items():
+            for begin in reversed(stack):
+                out.append({'name': begin['name'], 'ph': 'E', 'pid': begin['pid'], 'tid': tid, 'ts': last})
+
+    return metadata + out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('log', nargs='?', help='serial log, stdin if not given')
+    parser.add_argument('output', nargs='?', default='trace.json', help='trace file to write (default trace.json)')
+    parser.add_argument('--all', action='store_true', help='merge every dump in the log, not only the last one')
+    args = parser.parse_args()
+
+    if args.log:
+        with open(args.log, errors='replace') as f:
+            dumps = read_dumps(f)
+    else:
+        dumps = read_dumps(sys.stdin)
+
+    if not dumps:
+        sys.exit('no trace found, is the firmware built with TRACE_ENABLED=1?')
+
+    if args.all:
+        events = []
+        names = set()
+        for dump in dumps:
+            for event in dump:
+                # every dump names its threads again
+                if event['ph'] == 'M':
+                    key = (event['name'], event.get('tid'))
+                    if key in names:
+                        continue
+                    names.add(key)
+                events.append(event)
+    else:
+        events = dumps[-1]
+
+    events = pair_events(events)
+    with open(args.output, 'w') as f:
+        json.dump({'traceEvents': events, 'displayTimeUnit': 'ms'}, f)
+
+    print('%d events from %d dump(s) written to %s' % (len(events), len(dumps) if args.all else 1, args.output))
+
+
+if __name__ == '__main__':
+    main()